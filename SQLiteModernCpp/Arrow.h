@@ -0,0 +1,556 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// The structures of the Arrow C Data Interface, as the specification defines them, so that no Arrow
+// library is needed to produce or consume them.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray
+{
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif
+
+namespace ModernCppSQLite
+{
+  // One record batch: a struct array with a child array per result column. A consumer takes the
+  // schema or the array the Arrow way, copying the structure and clearing the original's release
+  // member; whatever is still owned when the batch is destroyed is released then.
+  class SQLiteArrowBatch
+  {
+  public:
+    ArrowSchema Schema{ };
+    ArrowArray Array{ };
+
+    SQLiteArrowBatch() noexcept = default;
+
+    SQLiteArrowBatch(SQLiteArrowBatch&& other) noexcept : Schema(other.Schema), Array(other.Array)
+    {
+      other.Schema.release = nullptr;
+      other.Array.release = nullptr;
+    }
+
+    SQLiteArrowBatch& operator=(SQLiteArrowBatch&& other) noexcept
+    {
+      if (this != &other)
+      {
+        Release();
+        Schema = other.Schema;
+        Array = other.Array;
+        other.Schema.release = nullptr;
+        other.Array.release = nullptr;
+      }
+
+      return *this;
+    }
+
+    ~SQLiteArrowBatch()
+    {
+      Release();
+    }
+
+    void Release() noexcept
+    {
+      if (Schema.release)
+      {
+        Schema.release(&Schema);
+      }
+
+      if (Array.release)
+      {
+        Array.release(&Array);
+      }
+    }
+
+    int64_t Length() const noexcept
+    {
+      return Array.release ? Array.length : 0;
+    }
+
+  private:
+    enum class Type
+    {
+      Integer,
+      Real,
+      Text,
+      Blob,
+    };
+
+    // The buffers of one child array, freed by its own release so the child can be moved out alone.
+    struct Column
+    {
+      std::vector<uint8_t> Validity;
+      std::vector<int32_t> Offsets{ 0 };
+      std::vector<int64_t> Integers;
+      std::vector<double> Reals;
+      std::vector<char> Bytes;
+      void const* Buffers[3]{ };
+    };
+
+    struct Columns
+    {
+      std::vector<ArrowArray> Children;
+      std::vector<ArrowArray*> Pointers;
+      void const* Buffers[1]{ };
+    };
+
+    struct Field
+    {
+      std::string Name;
+    };
+
+    struct Fields
+    {
+      std::vector<ArrowSchema> Children;
+      std::vector<ArrowSchema*> Pointers;
+    };
+
+    struct ConnectionLock
+    {
+      sqlite3_mutex* const Mutex;
+
+      explicit ConnectionLock(sqlite3* const connection) noexcept : Mutex(sqlite3_db_mutex(connection))
+      {
+        sqlite3_mutex_enter(Mutex);
+      }
+
+      ~ConnectionLock()
+      {
+        sqlite3_mutex_leave(Mutex);
+      }
+    };
+
+    static void ReleaseColumn(ArrowArray* const array) noexcept
+    {
+      delete static_cast<Column*>(array->private_data);
+      array->release = nullptr;
+    }
+
+    static void ReleaseColumns(ArrowArray* const array) noexcept
+    {
+      auto* const columns = static_cast<Columns*>(array->private_data);
+
+      for (ArrowArray& child : columns->Children)
+      {
+        if (child.release)
+        {
+          child.release(&child);
+        }
+      }
+
+      delete columns;
+      array->release = nullptr;
+    }
+
+    static void ReleaseField(ArrowSchema* const schema) noexcept
+    {
+      delete static_cast<Field*>(schema->private_data);
+      schema->release = nullptr;
+    }
+
+    static void ReleaseFields(ArrowSchema* const schema) noexcept
+    {
+      auto* const fields = static_cast<Fields*>(schema->private_data);
+
+      for (ArrowSchema& child : fields->Children)
+      {
+        if (child.release)
+        {
+          child.release(&child);
+        }
+      }
+
+      delete fields;
+      schema->release = nullptr;
+    }
+
+    static char const* Format(Type const type) noexcept
+    {
+      switch (type)
+      {
+        case Type::Integer: return "l";
+        case Type::Real: return "g";
+        case Type::Text: return "u";
+        default: return "z";
+      }
+    }
+
+    // The type the affinity rules give a declared column type; none for numeric affinity.
+    static std::optional<Type> DeclaredType(sqlite3_stmt* const statement, int32_t const column)
+    {
+      char const* const declared = sqlite3_column_decltype(statement, column);
+      std::string type(declared ? declared : "");
+      std::transform(type.begin(), type.end(), type.begin(), [](char const c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+
+      if (type.find("INT") != std::string::npos) return Type::Integer;
+      if (type.find("CHAR") != std::string::npos || type.find("CLOB") != std::string::npos || type.find("TEXT") != std::string::npos) return Type::Text;
+      if (type.find("BLOB") != std::string::npos) return Type::Blob;
+      if (type.find("REAL") != std::string::npos || type.find("FLOA") != std::string::npos || type.find("DOUB") != std::string::npos) return Type::Real;
+      return std::nullopt;
+    }
+
+    // Columns without a declared type, or with numeric affinity, take the storage class of the first row.
+    static Type TypeOf(sqlite3_stmt* const statement, int32_t const column, bool const hasRow)
+    {
+      if (std::optional<Type> const type = DeclaredType(statement, column))
+      {
+        return *type;
+      }
+
+      switch (hasRow ? sqlite3_column_type(statement, column) : SQLITE_NULL)
+      {
+        case SQLITE_INTEGER: return Type::Integer;
+        case SQLITE_FLOAT: return Type::Real;
+        case SQLITE_BLOB: return Type::Blob;
+        default: return Type::Text;
+      }
+    }
+
+    static void Reserve(Column& column, Type const type, int64_t const batchRows)
+    {
+      size_t const rows = static_cast<size_t>(std::min<int64_t>(batchRows, 65536));
+
+      column.Validity.reserve(rows / 8 + 1);
+
+      switch (type)
+      {
+        case Type::Integer: column.Integers.reserve(rows); break;
+        case Type::Real: column.Reals.reserve(rows); break;
+        default: column.Offsets.reserve(rows + 1); break;
+      }
+    }
+
+    static void Append(Column& column, std::string_view const value)
+    {
+      if (column.Bytes.size() + value.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+      {
+        throw SQLiteException(SQLITE_TOOBIG, "arrow: a batch column holds more than 2 GB of text or blobs");
+      }
+
+      column.Bytes.insert(column.Bytes.end(), value.begin(), value.end());
+      column.Offsets.push_back(static_cast<int32_t>(column.Bytes.size()));
+    }
+
+    template <SQLiteThreadingPolicy ThreadingPolicy>
+    friend SQLiteArrowBatch ExportArrow(BasicSQLiteStatement<ThreadingPolicy> const& statement, int64_t const batchRows);
+  };
+
+  // Steps the statement up to batchRows times and returns the rows read as one batch; a batch
+  // shorter than batchRows is the last. Values are converted to each column's type, so integers
+  // in a Real column arrive as doubles, and so on.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  SQLiteArrowBatch ExportArrow(BasicSQLiteStatement<ThreadingPolicy> const& statement, int64_t const batchRows)
+  {
+    using Batch = SQLiteArrowBatch;
+
+    sqlite3_stmt* const handle = statement.GetAbi();
+    size_t const count = static_cast<size_t>(sqlite3_column_count(handle));
+
+    // With the connection mutex held for the whole batch the column values are protected, so they
+    // are read through the sqlite3_value functions rather than locking it again for every value.
+    Batch::ConnectionLock const lock(sqlite3_db_handle(handle));
+
+    std::vector<std::unique_ptr<Batch::Column>> columns(count);
+    std::vector<Batch::Type> types(count);
+    std::vector<uint8_t> inferred(count);
+    std::vector<int64_t> nulls(count);
+    int64_t rows = 0;
+
+    for (auto& column : columns)
+    {
+      column = std::make_unique<Batch::Column>();
+    }
+
+    for (; rows < batchRows && statement.Step(); ++rows)
+    {
+      if (rows == 0)
+      {
+        for (size_t column = 0; column < count; ++column)
+        {
+          types[column] = Batch::TypeOf(handle, static_cast<int32_t>(column), true);
+          inferred[column] = !Batch::DeclaredType(handle, static_cast<int32_t>(column));
+          Batch::Reserve(*columns[column], types[column], batchRows);
+        }
+      }
+
+      for (size_t index = 0; index < count; ++index)
+      {
+        Batch::Column& column = *columns[index];
+        int32_t const position = static_cast<int32_t>(index);
+        sqlite3_value* const value = sqlite3_column_value(handle, position);
+        int32_t const storage = sqlite3_value_type(value);
+        bool const valid = storage != SQLITE_NULL;
+
+        if (rows % 8 == 0)
+        {
+          column.Validity.push_back(0);
+        }
+
+        column.Validity.back() |= static_cast<uint8_t>(valid << (rows % 8));
+        nulls[index] += !valid;
+
+        // An inferred integer column becomes a real one at its first real value.
+        if (types[index] == Batch::Type::Integer && inferred[index] && storage == SQLITE_FLOAT)
+        {
+          column.Reals.assign(column.Integers.begin(), column.Integers.end());
+          column.Integers.clear();
+          types[index] = Batch::Type::Real;
+        }
+
+        switch (types[index])
+        {
+          case Batch::Type::Integer:
+            column.Integers.push_back(sqlite3_value_int64(value));
+            break;
+
+          case Batch::Type::Real:
+            column.Reals.push_back(sqlite3_value_double(value));
+            break;
+
+          case Batch::Type::Text:
+          {
+            char const* const text = reinterpret_cast<char const*>(sqlite3_value_text(value));
+            Batch::Append(column, std::string_view(text ? text : "", sqlite3_value_bytes(value)));
+            break;
+          }
+
+          default:
+          {
+            char const* const blob = static_cast<char const*>(sqlite3_value_blob(value));
+            Batch::Append(column, std::string_view(blob ? blob : "", sqlite3_value_bytes(value)));
+            break;
+          }
+        }
+      }
+    }
+
+    if (rows == 0)
+    {
+      for (size_t column = 0; column < count; ++column)
+      {
+        types[column] = Batch::TypeOf(handle, static_cast<int32_t>(column), false);
+      }
+    }
+
+    Batch batch;
+    auto fields = std::make_unique<Batch::Fields>();
+    auto arrays = std::make_unique<Batch::Columns>();
+
+    fields->Children.resize(count);
+    arrays->Children.resize(count);
+
+    // Each child takes ownership of its buffers as soon as its release is set.
+    for (size_t index = 0; index < count; ++index)
+    {
+      auto field = std::make_unique<Batch::Field>();
+      char const* const name = sqlite3_column_name(handle, static_cast<int32_t>(index));
+      field->Name = name ? name : "";
+
+      ArrowSchema& schema = fields->Children[index];
+      schema.format = Batch::Format(types[index]);
+      schema.name = field->Name.c_str();
+      schema.flags = ARROW_FLAG_NULLABLE;
+      schema.release = Batch::ReleaseField;
+      schema.private_data = field.release();
+
+      Batch::Column& column = *columns[index];
+      bool const variable = types[index] == Batch::Type::Text || types[index] == Batch::Type::Blob;
+
+      column.Buffers[0] = nulls[index] ? column.Validity.data() : nullptr;
+      column.Buffers[1] = variable ? static_cast<void const*>(column.Offsets.data())
+        : types[index] == Batch::Type::Integer ? static_cast<void const*>(column.Integers.data()) : static_cast<void const*>(column.Reals.data());
+      column.Buffers[2] = column.Bytes.data();
+
+      ArrowArray& array = arrays->Children[index];
+      array.length = rows;
+      array.null_count = nulls[index];
+      array.n_buffers = variable ? 3 : 2;
+      array.buffers = column.Buffers;
+      array.release = Batch::ReleaseColumn;
+      array.private_data = columns[index].release();
+    }
+
+    for (size_t index = 0; index < count; ++index)
+    {
+      fields->Pointers.push_back(&fields->Children[index]);
+      arrays->Pointers.push_back(&arrays->Children[index]);
+    }
+
+    batch.Schema.format = "+s";
+    batch.Schema.name = "";
+    batch.Schema.n_children = static_cast<int64_t>(count);
+    batch.Schema.children = fields->Pointers.data();
+    batch.Schema.release = Batch::ReleaseFields;
+    batch.Schema.private_data = fields.release();
+
+    batch.Array.length = rows;
+    batch.Array.n_buffers = 1;
+    batch.Array.n_children = static_cast<int64_t>(count);
+    batch.Array.buffers = arrays->Buffers;
+    batch.Array.children = arrays->Pointers.data();
+    batch.Array.release = Batch::ReleaseColumns;
+    batch.Array.private_data = arrays.release();
+
+    return batch;
+  }
+
+  // Inserts every row of a struct array into the table, matching children to columns by name, in
+  // one transaction or in the caller's if one is open. The caller keeps ownership of both
+  // structures. Integer, floating point, boolean, string and binary children are supported.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  void ImportArrow(BasicSQLiteConnection<ThreadingPolicy> const& connection, std::string_view const table, ArrowSchema const& schema, ArrowArray const& array)
+  {
+    if (std::strcmp(schema.format, "+s") != 0 || schema.n_children != array.n_children || schema.n_children == 0)
+    {
+      throw SQLiteException(SQLITE_MISMATCH, "arrow: ImportArrow expects a struct array with at least one child");
+    }
+
+    std::string names;
+    std::string values;
+
+    for (int64_t child = 0; child < schema.n_children; ++child)
+    {
+      ArrowSchema const& field = *schema.children[child];
+      std::string_view const format(field.format);
+
+      if (field.dictionary || format.size() != 1 || std::string_view("nbcCsSiIlLfguUzZ").find(format[0]) == std::string_view::npos)
+      {
+        throw SQLiteException(SQLITE_MISMATCH, "arrow: column '" + std::string(field.name ? field.name : "") + "' has the unsupported format '" + std::string(format) + "'");
+      }
+
+      names += (child ? ", " : "") + SQLiteQuoteIdentifier(field.name ? field.name : "");
+      values += child ? ", ?" : "?";
+    }
+
+    std::optional<SQLiteTransaction<ThreadingPolicy>> transaction;
+
+    if (sqlite3_get_autocommit(connection.GetAbi()))
+    {
+      transaction.emplace(connection, SQLiteTransactionType::Immediate);
+    }
+
+    BasicSQLiteStatement<ThreadingPolicy> insert(connection, ("Insert Into " + SQLiteQuoteIdentifier(table) + " ( " + names + " ) Values ( " + values + " )").c_str());
+
+    auto const bit = [](void const* const bits, int64_t const index) noexcept
+    {
+      return (static_cast<uint8_t const*>(bits)[index / 8] >> (index % 8)) & 1;
+    };
+
+    for (int64_t row = 0; row < array.length; ++row)
+    {
+      int64_t const parent = array.offset + row;
+      bool const rowValid = !array.buffers[0] || bit(array.buffers[0], parent);
+
+      for (int64_t child = 0; child < array.n_children; ++child)
+      {
+        ArrowArray const& column = *array.children[child];
+        int32_t const index = static_cast<int32_t>(child + 1);
+        int64_t const at = column.offset + parent;
+        char const format = *schema.children[child]->format;
+
+        if (!rowValid || format == 'n' || (column.buffers[0] && !bit(column.buffers[0], at)))
+        {
+          insert.Bind(index, nullptr);
+          continue;
+        }
+
+        void const* const data = column.buffers[1];
+
+        switch (format)
+        {
+          case 'b': insert.Bind(index, static_cast<int32_t>(bit(data, at))); break;
+          case 'c': insert.Bind(index, static_cast<int32_t>(static_cast<int8_t const*>(data)[at])); break;
+          case 'C': insert.Bind(index, static_cast<int32_t>(static_cast<uint8_t const*>(data)[at])); break;
+          case 's': insert.Bind(index, static_cast<int32_t>(static_cast<int16_t const*>(data)[at])); break;
+          case 'S': insert.Bind(index, static_cast<int32_t>(static_cast<uint16_t const*>(data)[at])); break;
+          case 'i': insert.Bind(index, static_cast<int32_t const*>(data)[at]); break;
+          case 'I': insert.Bind(index, static_cast<int64_t>(static_cast<uint32_t const*>(data)[at])); break;
+          case 'l': insert.Bind(index, static_cast<int64_t const*>(data)[at]); break;
+          case 'L': insert.Bind(index, static_cast<uint64_t const*>(data)[at]); break;
+          case 'f': insert.Bind(index, static_cast<double>(static_cast<float const*>(data)[at])); break;
+          case 'g': insert.Bind(index, static_cast<double const*>(data)[at]); break;
+
+          case 'u':
+          case 'z':
+          {
+            int32_t const* const offsets = static_cast<int32_t const*>(data);
+            char const* const bytes = static_cast<char const*>(column.buffers[2]) + offsets[at];
+            int32_t const size = offsets[at + 1] - offsets[at];
+
+            if (format == 'u') insert.Bind(index, bytes ? bytes : "", size);
+            else insert.Bind(index, std::as_bytes(std::span(bytes ? bytes : "", static_cast<size_t>(size))));
+            break;
+          }
+
+          default:
+          {
+            int64_t const* const offsets = static_cast<int64_t const*>(data);
+            char const* const bytes = static_cast<char const*>(column.buffers[2]) + offsets[at];
+            int64_t const size = offsets[at + 1] - offsets[at];
+
+            if (size > std::numeric_limits<int32_t>::max())
+            {
+              throw SQLiteException(SQLITE_TOOBIG, "arrow: a value is larger than SQLite accepts");
+            }
+
+            if (format == 'U') insert.Bind(index, bytes ? bytes : "", static_cast<int32_t>(size));
+            else insert.Bind(index, std::as_bytes(std::span(bytes ? bytes : "", static_cast<size_t>(size))));
+            break;
+          }
+        }
+      }
+
+      insert.Execute();
+      insert.Reset();
+    }
+
+    if (transaction)
+    {
+      transaction->Commit();
+    }
+  }
+}
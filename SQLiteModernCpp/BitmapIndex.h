@@ -0,0 +1,773 @@
+#pragma once
+
+#include "VirtualTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  // A set of rowids split, roaring style, into chunks of 65536 keyed by the high bits. Stored, a
+  // chunk with fewer than 4096 members is a sorted array of 16-bit offsets and any other is a
+  // 1024-word bitset; the length tells them apart. In memory every chunk is a bitset, so unions
+  // and intersections are plain loops over words that the compiler vectorizes.
+  class BitmapIndexSet
+  {
+  public:
+    static constexpr size_t ChunkWords = 1024;
+    static constexpr size_t ChunkBytes = ChunkWords * sizeof(uint64_t);
+    static constexpr size_t ArrayLimit = 4096;
+
+  private:
+    std::vector<int64_t> m_Keys;
+    std::vector<uint64_t> m_Words;
+
+    static uint16_t Offset(std::byte const* const data, size_t const index) noexcept
+    {
+      uint16_t offset;
+      std::memcpy(&offset, data + index * sizeof(offset), sizeof(offset));
+      return offset;
+    }
+
+    static std::vector<uint16_t> Offsets(std::span<std::byte const> const data)
+    {
+      std::vector<uint16_t> offsets(data.size() / sizeof(uint16_t));
+
+      for (size_t index = 0; index < offsets.size(); ++index)
+      {
+        offsets[index] = Offset(data.data(), index);
+      }
+
+      return offsets;
+    }
+
+    static std::string Bytes(std::vector<uint16_t> const& offsets)
+    {
+      return std::string(reinterpret_cast<char const*>(offsets.data()), offsets.size() * sizeof(uint16_t));
+    }
+
+  public:
+    // Ors a stored chunk into the bitset words.
+    static void Decode(std::span<std::byte const> const data, uint64_t* const words) noexcept
+    {
+      if (data.size() == ChunkBytes)
+      {
+        for (size_t word = 0; word < ChunkWords; ++word)
+        {
+          uint64_t bits;
+          std::memcpy(&bits, data.data() + word * sizeof(bits), sizeof(bits));
+          words[word] |= bits;
+        }
+
+        return;
+      }
+
+      for (size_t index = 0; index < data.size() / sizeof(uint16_t); ++index)
+      {
+        uint16_t const offset = Offset(data.data(), index);
+        words[offset / 64] |= uint64_t(1) << (offset % 64);
+      }
+    }
+
+    static std::string Encode(uint64_t const* const words)
+    {
+      size_t count = 0;
+
+      for (size_t word = 0; word < ChunkWords; ++word)
+      {
+        count += std::popcount(words[word]);
+      }
+
+      if (count >= ArrayLimit)
+      {
+        return std::string(reinterpret_cast<char const*>(words), ChunkBytes);
+      }
+
+      std::vector<uint16_t> offsets;
+      offsets.reserve(count);
+
+      for (size_t word = 0; word < ChunkWords; ++word)
+      {
+        for (uint64_t bits = words[word]; bits; bits &= bits - 1)
+        {
+          offsets.push_back(static_cast<uint16_t>(word * 64 + std::countr_zero(bits)));
+        }
+      }
+
+      return Bytes(offsets);
+    }
+
+    // The stored chunk with one offset added or removed, switching representation at the limit.
+    static std::string Change(std::span<std::byte const> const data, uint16_t const offset, bool const add)
+    {
+      if (data.size() == ChunkBytes)
+      {
+        std::vector<uint64_t> words(ChunkWords);
+        std::memcpy(words.data(), data.data(), ChunkBytes);
+
+        uint64_t const bit = uint64_t(1) << (offset % 64);
+        words[offset / 64] = add ? words[offset / 64] | bit : words[offset / 64] & ~bit;
+        return Encode(words.data());
+      }
+
+      std::vector<uint16_t> offsets = Offsets(data);
+      auto const position = std::lower_bound(offsets.begin(), offsets.end(), offset);
+      bool const present = position != offsets.end() && *position == offset;
+
+      if (add && !present)
+      {
+        offsets.insert(position, offset);
+
+        if (offsets.size() == ArrayLimit)
+        {
+          std::vector<uint64_t> words(ChunkWords);
+
+          for (uint16_t const member : offsets)
+          {
+            words[member / 64] |= uint64_t(1) << (member % 64);
+          }
+
+          return Encode(words.data());
+        }
+      }
+      else if (!add && present)
+      {
+        offsets.erase(position);
+      }
+
+      return Bytes(offsets);
+    }
+
+    // Ors a stored chunk into the set.
+    void Add(int64_t const key, std::span<std::byte const> const data)
+    {
+      auto const position = std::lower_bound(m_Keys.begin(), m_Keys.end(), key);
+      size_t const chunk = position - m_Keys.begin();
+
+      if (position == m_Keys.end() || *position != key)
+      {
+        m_Keys.insert(position, key);
+        m_Words.insert(m_Words.begin() + chunk * ChunkWords, ChunkWords, 0);
+      }
+
+      Decode(data, m_Words.data() + chunk * ChunkWords);
+    }
+
+    // Keeps only the rowids also in other, dropping chunks left empty.
+    void Intersect(BitmapIndexSet const& other)
+    {
+      size_t kept = 0;
+      size_t position = 0;
+
+      for (size_t chunk = 0; chunk < m_Keys.size(); ++chunk)
+      {
+        while (position < other.m_Keys.size() && other.m_Keys[position] < m_Keys[chunk])
+        {
+          ++position;
+        }
+
+        if (position == other.m_Keys.size() || other.m_Keys[position] != m_Keys[chunk])
+        {
+          continue;
+        }
+
+        uint64_t* const target = m_Words.data() + kept * ChunkWords;
+        uint64_t const* const source = m_Words.data() + chunk * ChunkWords;
+        uint64_t const* const mask = other.m_Words.data() + position * ChunkWords;
+        uint64_t any = 0;
+
+        for (size_t word = 0; word < ChunkWords; ++word)
+        {
+          target[word] = source[word] & mask[word];
+          any |= target[word];
+        }
+
+        if (any)
+        {
+          m_Keys[kept++] = m_Keys[chunk];
+        }
+      }
+
+      m_Keys.resize(kept);
+      m_Words.resize(kept * ChunkWords);
+    }
+
+    void Clear() noexcept
+    {
+      m_Keys.clear();
+      m_Words.clear();
+    }
+
+    bool Empty() const noexcept
+    {
+      return m_Keys.empty();
+    }
+
+    size_t Chunks() const noexcept
+    {
+      return m_Keys.size();
+    }
+
+    int64_t Key(size_t const chunk) const noexcept
+    {
+      return m_Keys[chunk];
+    }
+
+    uint64_t Word(size_t const chunk, size_t const word) const noexcept
+    {
+      return m_Words[chunk * ChunkWords + word];
+    }
+
+    size_t Count() const noexcept
+    {
+      size_t count = 0;
+
+      for (uint64_t const word : m_Words)
+      {
+        count += std::popcount(word);
+      }
+
+      return count;
+    }
+  };
+
+  // A secondary index over low-cardinality columns of an ordinary rowid table:
+  //
+  //   Create Virtual Table OrdersByStatus Using bitmapindex ( Orders, Status, Region, Type )
+  //   Select Count(*) From OrdersByStatus Where Status = 'open' And Region In ( 'east', 'west' )
+  //
+  // Every non-null value of every indexed column has one rowid set, stored by chunk in the
+  // <name>_bitmaps shadow table, which triggers on the base table keep up to date; every
+  // connection that writes the base table must register the module for the triggers to run.
+  // Equality and In constraints are answered from the sets alone: the sets of an In list are
+  // united, those of separate constraints intersected, and the rowids left are the rows of
+  // the scan, which reads the base table only for the columns a query returns. A replacing
+  // insert into the base table needs recursive_triggers on to remove the replaced row.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class BitmapIndexTable : public SQLiteVirtualTable
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    enum class Affinity
+    {
+      Integer,
+      Real,
+      Numeric,
+      Text,
+      Blob,
+    };
+
+    enum Kind
+    {
+      Value = 0,
+      List = 1,
+    };
+
+    static std::string Unquote(std::string_view name)
+    {
+      if (char const quote = name.empty() ? 0 : name[0] == '[' ? ']' : name[0]; name.size() >= 2 && (quote == '"' || quote == '`' || quote == ']' || quote == '\''))
+      {
+        std::string result;
+
+        for (size_t index = 1; index + 1 < name.size(); ++index)
+        {
+          result += name[index];
+          index += name[index] == quote && name[index + 1] == quote;
+        }
+
+        return result;
+      }
+
+      return std::string(name);
+    }
+
+    // The affinity rules of "Determination Of Column Affinity".
+    static Affinity AffinityOf(std::string type)
+    {
+      std::transform(type.begin(), type.end(), type.begin(), [](char const c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+
+      if (type.find("INT") != std::string::npos) return Affinity::Integer;
+      if (type.find("CHAR") != std::string::npos || type.find("CLOB") != std::string::npos || type.find("TEXT") != std::string::npos) return Affinity::Text;
+      if (type.find("BLOB") != std::string::npos || type.empty()) return Affinity::Blob;
+      if (type.find("REAL") != std::string::npos || type.find("FLOA") != std::string::npos || type.find("DOUB") != std::string::npos) return Affinity::Real;
+      return Affinity::Numeric;
+    }
+
+    static bool Binary([[maybe_unused]] sqlite3_index_info& info, [[maybe_unused]] int32_t const index)
+    {
+#if SQLITE_VERSION_NUMBER >= 3022000
+      char const* const collation = sqlite3_vtab_collation(&info, index);
+      return !collation || sqlite3_stricmp(collation, "BINARY") == 0;
+#else
+      return false;
+#endif
+    }
+
+    Statement const& Prepared(Statement& statement, std::string const& text) const
+    {
+      // Prepared on first use rather than while SQLite is connecting the table.
+      if (!statement)
+      {
+        statement.Prepare(*m_Connection, text.c_str());
+      }
+
+      return statement;
+    }
+
+    // Binds a constant the way the base table column would compare it.
+    void BindValue(Statement const& statement, int32_t const index, size_t const column, sqlite3_value* const value) const
+    {
+      int32_t const type = sqlite3_value_type(value);
+
+      if (m_Affinities[column] == Affinity::Text && (type == SQLITE_INTEGER || type == SQLITE_FLOAT))
+      {
+        statement.Bind(index, std::string(reinterpret_cast<char const*>(sqlite3_value_text(value))));
+        return;
+      }
+
+      if (m_Affinities[column] != Affinity::Text && m_Affinities[column] != Affinity::Blob && type == SQLITE_TEXT)
+      {
+        sqlite3_value_numeric_type(value);
+      }
+
+      statement.Bind(index, value);
+    }
+
+    // Adds one value's rowid set to result.
+    void Lookup(size_t const column, sqlite3_value* const value, BitmapIndexSet& result) const
+    {
+      if (sqlite3_value_type(value) == SQLITE_NULL)
+      {
+        return;
+      }
+
+      Statement const& lookup = Prepared(m_Lookup, "Select Chunk, Data From " + m_Bitmaps + " Where Column = ? And Value = ?");
+      lookup.Bind(1, static_cast<int64_t>(column));
+      BindValue(lookup, 2, column, value);
+
+      while (lookup.Step())
+      {
+        result.Add(lookup.GetInt64(0), std::span(lookup.GetBlob(1), lookup.GetBlobLength(1)));
+      }
+
+      lookup.Reset();
+    }
+
+    // The trigger statements that move row's rowid into the set of its value of column.
+    std::string Insert(size_t const column, std::string_view const row, std::string_view const condition) const
+    {
+      std::string const index = std::to_string(column);
+      std::string const value = std::string(row) + "." + m_Columns[column];
+      std::string const key = "Column = " + index + " And Value = " + value + " And Chunk = " + std::string(row) + ".RowId >> 16";
+
+      return "Insert Into " + m_TriggerBitmaps + " Select " + index + ", " + value + ", " + std::string(row) + ".RowId >> 16, X''"
+        + " Where " + value + " Is Not Null" + std::string(condition) + " And Not Exists ( Select 1 From " + m_TriggerBitmaps + " Where " + key + " ); "
+        + "Update " + m_TriggerBitmaps + " Set Data = bitmapindex_add(Data, " + std::string(row) + ".RowId & 65535) Where " + key + std::string(condition) + "; ";
+    }
+
+    std::string Remove(size_t const column, std::string_view const row, std::string_view const condition) const
+    {
+      std::string const key = "Column = " + std::to_string(column) + " And Value = " + std::string(row) + "." + m_Columns[column] + " And Chunk = " + std::string(row) + ".RowId >> 16";
+
+      return "Update " + m_TriggerBitmaps + " Set Data = bitmapindex_remove(Data, " + std::string(row) + ".RowId & 65535) Where " + key + std::string(condition) + "; "
+        + "Delete From " + m_TriggerBitmaps + " Where " + key + " And Length(Data) = 0; ";
+    }
+
+    std::string Trigger(char const* const suffix) const
+    {
+      return m_Schema + SQLiteQuoteIdentifier(m_Name + suffix);
+    }
+
+    template <bool Add>
+    static void ChangeFunction(sqlite3_context* const context, int, sqlite3_value** const arguments) noexcept
+    {
+      try
+      {
+        std::span const chunk(reinterpret_cast<std::byte const*>(sqlite3_value_blob(arguments[0])), static_cast<size_t>(sqlite3_value_bytes(arguments[0])));
+        std::string const data = BitmapIndexSet::Change(chunk, static_cast<uint16_t>(sqlite3_value_int64(arguments[1])), Add);
+        sqlite3_result_blob(context, data.data(), static_cast<int32_t>(data.size()), SQLITE_TRANSIENT);
+      }
+      catch (std::bad_alloc const&)
+      {
+        sqlite3_result_error_nomem(context);
+      }
+    }
+
+    // SQLite zeroes the aggregate context, which is the chunk's bitset.
+    static void BuildStep(sqlite3_context* const context, int, sqlite3_value** const arguments) noexcept
+    {
+      if (auto* const words = static_cast<uint64_t*>(sqlite3_aggregate_context(context, BitmapIndexSet::ChunkBytes)))
+      {
+        uint16_t const offset = static_cast<uint16_t>(sqlite3_value_int64(arguments[0]));
+        words[offset / 64] |= uint64_t(1) << (offset % 64);
+      }
+      else
+      {
+        sqlite3_result_error_nomem(context);
+      }
+    }
+
+    static void BuildFinal(sqlite3_context* const context) noexcept
+    {
+      try
+      {
+        auto const* const words = static_cast<uint64_t const*>(sqlite3_aggregate_context(context, 0));
+        std::string const data = words ? BitmapIndexSet::Encode(words) : std::string();
+        sqlite3_result_blob(context, data.data(), static_cast<int32_t>(data.size()), SQLITE_TRANSIENT);
+      }
+      catch (std::bad_alloc const&)
+      {
+        sqlite3_result_error_nomem(context);
+      }
+    }
+
+  public:
+    // The functions the shadow table is built and maintained with.
+    static void CreateFunctions(Connection const& connection)
+    {
+      int32_t constexpr flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC;
+
+      if (SQLITE_OK != sqlite3_create_function_v2(connection.GetAbi(), "bitmapindex_add", 2, flags, nullptr, ChangeFunction<true>, nullptr, nullptr, nullptr)
+        || SQLITE_OK != sqlite3_create_function_v2(connection.GetAbi(), "bitmapindex_remove", 2, flags, nullptr, ChangeFunction<false>, nullptr, nullptr, nullptr)
+        || SQLITE_OK != sqlite3_create_function_v2(connection.GetAbi(), "bitmapindex_build", 1, flags, nullptr, nullptr, BuildStep, BuildFinal, nullptr))
+      {
+        connection.ThrowLastError();
+      }
+    }
+
+    class Cursor : public SQLiteVirtualCursor
+    {
+    private:
+      void Skip() noexcept
+      {
+        while (!m_Bits)
+        {
+          if (++m_Word == BitmapIndexSet::ChunkWords)
+          {
+            m_Word = 0;
+
+            if (++m_Chunk == m_Set.Chunks())
+            {
+              m_Eof = true;
+              return;
+            }
+          }
+
+          m_Bits = m_Set.Word(m_Chunk, m_Word);
+        }
+      }
+
+    public:
+      explicit Cursor(BitmapIndexTable& table) : m_Table(table)
+      {
+      }
+
+      void Filter(int32_t, char const* const plan, std::span<sqlite3_value* const> const arguments)
+      {
+        m_Scan = arguments.empty();
+        m_Eof = false;
+        m_Loaded = false;
+
+        if (m_Scan)
+        {
+          Statement const& scan = m_Table.Prepared(m_Rows, "Select RowId From " + m_Table.m_Base + " Order By RowId");
+          scan.Reset();
+          m_Eof = !scan.Step();
+          return;
+        }
+
+        // The plan lists "column:kind;" for each argument, in order.
+        char const* position = plan ? plan : "";
+        BitmapIndexSet values;
+        m_Set.Clear();
+
+        for (size_t argument = 0; *position && argument < arguments.size(); ++argument)
+        {
+          char* end = nullptr;
+          size_t const column = std::strtoul(position, &end, 10);
+          int32_t const kind = static_cast<int32_t>(std::strtol(end + 1, &end, 10));
+          position = *end ? end + 1 : end;
+
+          values.Clear();
+
+#if SQLITE_VERSION_NUMBER >= 3038000
+          if (kind == List)
+          {
+            sqlite3_value* value = nullptr;
+
+            for (int32_t code = sqlite3_vtab_in_first(arguments[argument], &value); code == SQLITE_OK && value; code = sqlite3_vtab_in_next(arguments[argument], &value))
+            {
+              m_Table.Lookup(column, value, values);
+            }
+          }
+          else
+#endif
+          {
+            m_Table.Lookup(column, arguments[argument], values);
+          }
+
+          if (argument == 0)
+          {
+            std::swap(m_Set, values);
+          }
+          else
+          {
+            m_Set.Intersect(values);
+          }
+
+          if (m_Set.Empty())
+          {
+            break;
+          }
+        }
+
+        m_Chunk = 0;
+        m_Word = 0;
+        m_Bits = m_Set.Empty() ? 0 : m_Set.Word(0, 0);
+        m_Eof = m_Set.Empty();
+
+        if (!m_Eof)
+        {
+          Skip();
+        }
+      }
+
+      void Next()
+      {
+        m_Loaded = false;
+
+        if (m_Scan)
+        {
+          m_Eof = !m_Rows.Step();
+          return;
+        }
+
+        m_Bits &= m_Bits - 1;
+        Skip();
+      }
+
+      bool Eof() const noexcept
+      {
+        return m_Eof;
+      }
+
+      void Column(sqlite3_context* const context, int32_t const column)
+      {
+        if (!m_Row)
+        {
+          std::string columns;
+
+          for (std::string const& name : m_Table.m_Columns)
+          {
+            columns += (columns.empty() ? "" : ", ") + name;
+          }
+
+          m_Row.Prepare(*m_Table.m_Connection, ("Select " + columns + " From " + m_Table.m_Base + " Where RowId = ?").c_str());
+        }
+
+        if (!m_Loaded)
+        {
+          m_Row.Reset();
+          m_Row.Bind(1, static_cast<int64_t>(RowId()));
+          m_Found = m_Row.Step();
+          m_Loaded = true;
+        }
+
+        if (m_Found)
+        {
+          sqlite3_result_value(context, sqlite3_column_value(m_Row.GetAbi(), column));
+        }
+      }
+
+      sqlite3_int64 RowId() const noexcept
+      {
+        if (m_Scan)
+        {
+          return m_Rows.GetInt64();
+        }
+
+        return m_Set.Key(m_Chunk) * 65536 + static_cast<sqlite3_int64>(m_Word * 64 + std::countr_zero(m_Bits));
+      }
+
+    private:
+      BitmapIndexTable& m_Table;
+
+      BitmapIndexSet m_Set;
+      size_t m_Chunk = 0;
+      size_t m_Word = 0;
+      uint64_t m_Bits = 0;
+      bool m_Scan = false;
+      bool m_Eof = true;
+
+      Statement m_Rows;
+      Statement m_Row;
+      bool m_Loaded = false;
+      bool m_Found = false;
+    };
+
+    // The context is the connection the module was registered on.
+    BitmapIndexTable(sqlite3*, void* const context, std::span<char const* const> const arguments)
+      : m_Connection(static_cast<Connection const*>(context))
+    {
+      if (arguments.size() < 5)
+      {
+        throw SQLiteException(SQLITE_ERROR, "bitmapindex: a base table and at least one column are required");
+      }
+
+      m_Schema = SQLiteQuoteIdentifier(arguments[1]) + ".";
+      m_Name = arguments[2];
+      m_Table = Unquote(arguments[3]);
+      m_Base = m_Schema + SQLiteQuoteIdentifier(m_Table);
+      m_Bitmaps = m_Schema + SQLiteQuoteIdentifier(m_Name + "_bitmaps");
+      m_TriggerBitmaps = SQLiteQuoteIdentifier(m_Name + "_bitmaps");
+
+      if (SQLITE_OK != sqlite3_table_column_metadata(m_Connection->GetAbi(), arguments[1], m_Table.c_str(), "RowId", nullptr, nullptr, nullptr, nullptr, nullptr))
+      {
+        throw SQLiteException(SQLITE_ERROR, "bitmapindex: " + m_Table + " is not a table with rowids");
+      }
+
+      for (char const* const argument : arguments.subspan(4))
+      {
+        std::string const name = Unquote(argument);
+        char const* type = nullptr;
+        char const* collation = nullptr;
+
+        if (SQLITE_OK != sqlite3_table_column_metadata(m_Connection->GetAbi(), arguments[1], m_Table.c_str(), name.c_str(), &type, &collation, nullptr, nullptr, nullptr))
+        {
+          throw SQLiteException(SQLITE_ERROR, "bitmapindex: no such column: " + m_Table + "." + name);
+        }
+
+        // The index answers only binary comparisons; declaring the base collation keeps others from reaching it.
+        std::string const declared = type ? type : "";
+        std::string const sequence = collation ? collation : "BINARY";
+
+        m_Columns.push_back(SQLiteQuoteIdentifier(name));
+        m_Types.push_back(declared + " Collate " + SQLiteQuoteIdentifier(sequence));
+        m_Affinities.push_back(AffinityOf(declared));
+      }
+    }
+
+    // Builds the sets of the rows already in the base table, then installs the triggers.
+    static void Create(sqlite3* const connection, void* const context, std::span<char const* const> const arguments)
+    {
+      BitmapIndexTable const table(connection, context, arguments);
+      Connection const& database = *table.m_Connection;
+
+      Execute(database, ("Create Table " + table.m_Bitmaps + " ( Column Integer, Value, Chunk Integer, Data Blob, Primary Key ( Column, Value, Chunk ) )").c_str());
+
+      std::string inserted;
+      std::string deleted;
+      std::string updated;
+
+      for (size_t column = 0; column < table.m_Columns.size(); ++column)
+      {
+        std::string const& name = table.m_Columns[column];
+        std::string const changed = " And ( Old." + name + " Is Not New." + name + " Or Old.RowId <> New.RowId )";
+
+        Execute(database, ("Insert Into " + table.m_Bitmaps + " Select " + std::to_string(column) + ", " + name + ", RowId >> 16, bitmapindex_build(RowId & 65535) From " + table.m_Base
+          + " Where " + name + " Is Not Null Group By " + name + " Collate Binary, RowId >> 16").c_str());
+
+        inserted += table.Insert(column, "New", "");
+        deleted += table.Remove(column, "Old", "");
+        updated += table.Remove(column, "Old", changed) + table.Insert(column, "New", changed);
+      }
+
+      std::string const base = SQLiteQuoteIdentifier(table.m_Table);
+
+      Execute(database, ("Create Trigger " + table.Trigger("_insert") + " After Insert On " + base + " Begin " + inserted + "End").c_str());
+      Execute(database, ("Create Trigger " + table.Trigger("_delete") + " After Delete On " + base + " Begin " + deleted + "End").c_str());
+      Execute(database, ("Create Trigger " + table.Trigger("_update") + " After Update On " + base + " Begin " + updated + "End").c_str());
+    }
+
+    void Destroy()
+    {
+      Execute(*m_Connection, ("Drop Trigger If Exists " + Trigger("_insert")).c_str());
+      Execute(*m_Connection, ("Drop Trigger If Exists " + Trigger("_delete")).c_str());
+      Execute(*m_Connection, ("Drop Trigger If Exists " + Trigger("_update")).c_str());
+      Execute(*m_Connection, ("Drop Table If Exists " + m_Bitmaps).c_str());
+    }
+
+    std::string Declaration() const
+    {
+      std::string columns;
+
+      for (size_t column = 0; column < m_Columns.size(); ++column)
+      {
+        columns += (columns.empty() ? "" : ", ") + m_Columns[column] + " " + m_Types[column];
+      }
+
+      return "Create Table x ( " + columns + " )";
+    }
+
+    void BestIndex(sqlite3_index_info& info) const
+    {
+      std::string plan;
+      int32_t argument = 0;
+
+      for (int32_t index = 0; index < info.nConstraint; ++index)
+      {
+        sqlite3_index_info::sqlite3_index_constraint const& constraint = info.aConstraint[index];
+
+        // The sets hold exact values, so only binary equality can be answered from them.
+        if (!constraint.usable || constraint.iColumn < 0 || constraint.op != SQLITE_INDEX_CONSTRAINT_EQ || !Binary(info, index))
+        {
+          continue;
+        }
+
+        int32_t kind = Value;
+
+#if SQLITE_VERSION_NUMBER >= 3038000
+        if (sqlite3_vtab_in(&info, index, -1))
+        {
+          sqlite3_vtab_in(&info, index, 1);
+          kind = List;
+        }
+#endif
+
+        info.aConstraintUsage[index].argvIndex = ++argument;
+        info.aConstraintUsage[index].omit = 1;
+        plan += std::to_string(constraint.iColumn) + ":" + std::to_string(kind) + ";";
+      }
+
+      info.idxStr = sqlite3_mprintf("%s", plan.c_str());
+      info.needToFreeIdxStr = 1;
+      info.estimatedCost = argument ? 1e3 / argument : 1e7;
+      info.estimatedRows = argument ? 1000 / argument : 1000000;
+
+      // Both the sets and the fallback scan produce rowids in ascending order.
+      if (info.nOrderBy == 1 && info.aOrderBy[0].iColumn < 0 && !info.aOrderBy[0].desc)
+      {
+        info.orderByConsumed = 1;
+      }
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+    std::string m_Schema;
+    std::string m_Name;
+    std::string m_Table;
+    std::string m_Base;
+    std::string m_Bitmaps;
+    std::string m_TriggerBitmaps;
+    std::vector<std::string> m_Columns;
+    std::vector<std::string> m_Types;
+    std::vector<Affinity> m_Affinities;
+
+    mutable Statement m_Lookup;
+  };
+
+  // Registers the bitmapindex module along with the bitmapindex_add, bitmapindex_remove and
+  // bitmapindex_build functions its triggers use. The connection must stay where it is while the
+  // module is in use.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  inline void CreateBitmapIndexModule(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const name = "bitmapindex")
+  {
+    BitmapIndexTable<ThreadingPolicy>::CreateFunctions(connection);
+    CreateModule<BitmapIndexTable<ThreadingPolicy>>(connection, name, const_cast<void*>(static_cast<void const*>(&connection)));
+  }
+}
@@ -0,0 +1,564 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <queue>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct BulkLoaderOptions
+  {
+    // Rows are sorted in memory up to this many bytes in total, then spilled to sorted runs in
+    // temporary files that are merged when the load finishes.
+    size_t MemoryLimit = 256 * 1024 * 1024;
+
+    // Runs are sorted and written on this many threads while rows keep being added.
+    int32_t Threads = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+
+    // Rows inserted per transaction.
+    int64_t TransactionRows = 500'000;
+
+    // Drops the table's indexes, other than those of its primary key and unique constraints,
+    // before inserting and creates them again afterwards.
+    bool RebuildIndexes = true;
+  };
+
+  // Loads rows into a table in primary key order, so that the table's B-tree is filled from
+  // left to right instead of being split at random. Rows are given in the order of the table's
+  // columns and are inserted by Finish.
+  //
+  //   BulkLoader loader(connection, "Orders");
+  //   for (...) loader.Add(id, customer, amount);
+  //   loader.Finish();
+  //
+  // Keys are ordered as SQLite orders them with the binary collation. A table without a primary
+  // key is loaded in the order the rows were added.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class BulkLoader
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    struct FileHandleTraits : SQLiteHandleTraits<FILE*>
+    {
+      static void Close(Type value) noexcept
+      {
+        fclose(value);
+      }
+    };
+
+    using File = SQLiteHandle<FileHandleTraits>;
+
+    struct Value
+    {
+      SQLiteType Type = SQLiteType::Null;
+      int64_t Integer = 0;
+      double Float = 0;
+      std::string_view Bytes;
+    };
+
+    // Rows are encoded one after another as a 32-bit length followed by their fields, key fields
+    // first. A field is its type followed by 8 bytes of number or a 32-bit length and its bytes.
+    struct Run
+    {
+      std::vector<char> Rows;
+      std::vector<size_t> Offsets;
+
+      size_t Size() const noexcept
+      {
+        return Rows.size() + Offsets.size() * sizeof(size_t);
+      }
+    };
+
+    template <typename T>
+    static Value View(T const& value)
+    {
+      if constexpr (std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, std::nullopt_t>) return { };
+      else if constexpr (std::is_integral_v<T>) return { SQLiteType::Integer, static_cast<int64_t>(value), 0, { } };
+      else if constexpr (std::is_floating_point_v<T>) return { SQLiteType::Float, 0, static_cast<double>(value), { } };
+      else if constexpr (std::is_convertible_v<T const&, std::string_view>) return { SQLiteType::Text, 0, 0, std::string_view(value) };
+      else if constexpr (std::is_convertible_v<T const&, std::span<std::byte const>>)
+      {
+        std::span<std::byte const> const bytes(value);
+        return { SQLiteType::Blob, 0, 0, std::string_view(reinterpret_cast<char const*>(bytes.data()), bytes.size()) };
+      }
+      else return value ? View(*value) : Value();
+    }
+
+    static void Append(std::vector<char>& rows, void const* const data, size_t const size)
+    {
+      rows.insert(rows.end(), static_cast<char const*>(data), static_cast<char const*>(data) + size);
+    }
+
+    static void Encode(std::vector<char>& rows, Value const& value)
+    {
+      rows.push_back(static_cast<char>(value.Type));
+
+      switch (value.Type)
+      {
+        case SQLiteType::Integer: Append(rows, &value.Integer, sizeof(value.Integer)); break;
+        case SQLiteType::Float: Append(rows, &value.Float, sizeof(value.Float)); break;
+
+        case SQLiteType::Text:
+        case SQLiteType::Blob:
+        {
+          uint32_t const size = static_cast<uint32_t>(value.Bytes.size());
+          Append(rows, &size, sizeof(size));
+          Append(rows, value.Bytes.data(), size);
+          break;
+        }
+
+        default: break;
+      }
+    }
+
+    static Value Decode(char const*& field) noexcept
+    {
+      Value value;
+      value.Type = static_cast<SQLiteType>(*field++);
+
+      switch (value.Type)
+      {
+        case SQLiteType::Integer: std::memcpy(&value.Integer, field, sizeof(value.Integer)); field += sizeof(value.Integer); break;
+        case SQLiteType::Float: std::memcpy(&value.Float, field, sizeof(value.Float)); field += sizeof(value.Float); break;
+
+        case SQLiteType::Text:
+        case SQLiteType::Blob:
+        {
+          uint32_t size = 0;
+          std::memcpy(&size, field, sizeof(size));
+          value.Bytes = std::string_view(field + sizeof(size), size);
+          field += sizeof(size) + size;
+          break;
+        }
+
+        default: break;
+      }
+
+      return value;
+    }
+
+    static int32_t Compare(Value const& left, Value const& right) noexcept
+    {
+      auto const rank = [](SQLiteType const type)
+      {
+        switch (type)
+        {
+          case SQLiteType::Null: return 0;
+          case SQLiteType::Integer: case SQLiteType::Float: return 1;
+          case SQLiteType::Text: return 2;
+          default: return 3;
+        }
+      };
+
+      if (int32_t const order = rank(left.Type) - rank(right.Type); order != 0 || left.Type == SQLiteType::Null)
+      {
+        return order;
+      }
+
+      if (left.Type == SQLiteType::Integer && right.Type == SQLiteType::Integer)
+      {
+        return (left.Integer > right.Integer) - (left.Integer < right.Integer);
+      }
+
+      if (rank(left.Type) == 1)
+      {
+        double const x = left.Type == SQLiteType::Integer ? static_cast<double>(left.Integer) : left.Float;
+        double const y = right.Type == SQLiteType::Integer ? static_cast<double>(right.Integer) : right.Float;
+        return (x > y) - (x < y);
+      }
+
+      return left.Bytes.compare(right.Bytes);
+    }
+
+    // Orders two encoded rows by their key fields; the pointers are at the rows' lengths.
+    bool Less(char const* left, char const* right) const noexcept
+    {
+      left += sizeof(uint32_t);
+      right += sizeof(uint32_t);
+
+      for (size_t key = 0; key < m_KeyCount; ++key)
+      {
+        if (int32_t const order = Compare(Decode(left), Decode(right)); order != 0)
+        {
+          return order < 0;
+        }
+      }
+
+      return false;
+    }
+
+    void Sort(Run& run) const
+    {
+      if (m_KeyCount != 0)
+      {
+        std::stable_sort(run.Offsets.begin(), run.Offsets.end(), [&](size_t const left, size_t const right) { return Less(run.Rows.data() + left, run.Rows.data() + right); });
+      }
+    }
+
+    File Spill(Run run) const
+    {
+      Sort(run);
+
+      File file(std::tmpfile());
+
+      if (!file)
+      {
+        throw SQLiteException(SQLITE_CANTOPEN, "BulkLoader: cannot create a temporary file");
+      }
+
+      for (size_t const offset : run.Offsets)
+      {
+        uint32_t size = 0;
+        std::memcpy(&size, run.Rows.data() + offset, sizeof(size));
+
+        if (fwrite(run.Rows.data() + offset, sizeof(size) + size, 1, file.Get()) != 1)
+        {
+          throw SQLiteException(SQLITE_IOERR_WRITE, "BulkLoader: cannot write a temporary file");
+        }
+      }
+
+      rewind(file.Get());
+      return file;
+    }
+
+    void StartSpill()
+    {
+      if (m_Threads <= 1)
+      {
+        m_Files.push_back(Spill(std::move(m_Run)));
+      }
+      else
+      {
+        // Bounds the runs held in memory to one per thread.
+        if (static_cast<int32_t>(m_Pending.size()) >= m_Threads - 1)
+        {
+          std::future<File> spill = std::move(m_Pending.front());
+          m_Pending.pop_front();
+          m_Files.push_back(spill.get());
+        }
+
+        m_Pending.push_back(std::async(std::launch::async, [this, run = std::move(m_Run)]() mutable { return Spill(std::move(run)); }));
+      }
+
+      m_Run = Run();
+    }
+
+    void Insert(char const* row)
+    {
+      row += sizeof(uint32_t);
+
+      for (int32_t index = 1; index <= static_cast<int32_t>(m_Order.size()); ++index)
+      {
+        Value const value = Decode(row);
+
+        switch (value.Type)
+        {
+          case SQLiteType::Integer: m_Insert.Bind(index, value.Integer); break;
+          case SQLiteType::Float: m_Insert.Bind(index, value.Float); break;
+          case SQLiteType::Text: m_Insert.Bind(index, value.Bytes.data(), static_cast<int32_t>(value.Bytes.size())); break;
+          case SQLiteType::Blob: m_Insert.Bind(index, std::as_bytes(std::span(value.Bytes.data(), value.Bytes.size()))); break;
+          default: m_Insert.Bind(index, nullptr); break;
+        }
+      }
+
+      m_Insert.Execute();
+      m_Insert.Reset();
+
+      if (++m_Loaded % m_TransactionRows == 0)
+      {
+        m_Transaction->Commit();
+        m_Transaction.emplace(*m_Connection, SQLiteTransactionType::Immediate);
+      }
+    }
+
+    template <typename F>
+    void Merge(F&& insert)
+    {
+      struct Cursor
+      {
+        FILE* File = nullptr;
+        std::vector<char> Row;
+      };
+
+      auto const read = [](Cursor& cursor)
+      {
+        uint32_t size = 0;
+
+        if (fread(&size, sizeof(size), 1, cursor.File) != 1)
+        {
+          return false;
+        }
+
+        cursor.Row.resize(sizeof(size) + size);
+        std::memcpy(cursor.Row.data(), &size, sizeof(size));
+
+        if (fread(cursor.Row.data() + sizeof(size), size, 1, cursor.File) != 1 && size != 0)
+        {
+          throw SQLiteException(SQLITE_IOERR_READ, "BulkLoader: cannot read a temporary file");
+        }
+
+        return true;
+      };
+
+      std::vector<Cursor> cursors(m_Files.size());
+      // Equal keys come out in the order their runs were written, which keeps rows without keys in order.
+      auto const later = [&](size_t const left, size_t const right)
+      {
+        return Less(cursors[right].Row.data(), cursors[left].Row.data()) || (!Less(cursors[left].Row.data(), cursors[right].Row.data()) && left > right);
+      };
+
+      std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+
+      for (size_t index = 0; index < m_Files.size(); ++index)
+      {
+        cursors[index].File = m_Files[index].Get();
+        setvbuf(cursors[index].File, nullptr, _IOFBF, 1024 * 1024);
+
+        if (read(cursors[index]))
+        {
+          heap.push(index);
+        }
+      }
+
+      while (!heap.empty())
+      {
+        size_t const index = heap.top();
+        heap.pop();
+        insert(cursors[index].Row.data());
+
+        if (read(cursors[index]))
+        {
+          heap.push(index);
+        }
+      }
+    }
+
+  public:
+    BulkLoader(BulkLoader const&) = delete;
+    BulkLoader& operator=(BulkLoader const&) = delete;
+
+    BulkLoader(Connection const& connection, std::string_view const table, BulkLoaderOptions const& options = {})
+      : m_Connection(&connection)
+      , m_Table(table)
+      , m_MemoryLimit(options.MemoryLimit / std::max(1, options.Threads))
+      , m_Threads(std::max(1, options.Threads))
+      , m_TransactionRows(std::max<int64_t>(1, options.TransactionRows))
+      , m_RebuildIndexes(options.RebuildIndexes)
+    {
+      std::vector<std::string> names;
+      std::vector<int32_t> keys;
+
+      for (Statement columns(connection, ("PRAGMA table_info(" + SQLiteQuoteIdentifier(table) + ")").c_str()); columns.Step();)
+      {
+        names.emplace_back(columns.GetString(1));
+        keys.push_back(columns.GetInt32(5));
+      }
+
+      if (names.empty())
+      {
+        throw SQLiteException(SQLITE_ERROR, "BulkLoader: no such table: " + m_Table);
+      }
+
+      // Key columns in key order, then the rest in table order.
+      for (int32_t key = 1; key <= static_cast<int32_t>(names.size()); ++key)
+      {
+        if (auto const found = std::find(keys.begin(), keys.end(), key); found != keys.end())
+        {
+          m_Order.push_back(found - keys.begin());
+        }
+      }
+
+      m_KeyCount = m_Order.size();
+
+      for (size_t column = 0; column < names.size(); ++column)
+      {
+        if (keys[column] == 0)
+        {
+          m_Order.push_back(column);
+        }
+      }
+
+      std::string columns;
+      std::string parameters;
+
+      for (size_t const column : m_Order)
+      {
+        columns += (columns.empty() ? "" : ", ") + SQLiteQuoteIdentifier(names[column]);
+        parameters += parameters.empty() ? "?" : ", ?";
+      }
+
+      m_Insert.Prepare(connection, ("Insert Into " + SQLiteQuoteIdentifier(table) + " ( " + columns + " ) Values ( " + parameters + " )").c_str());
+    }
+
+    // Adds a row, one value per column of the table in the table's order. Values may be integers,
+    // floating point numbers, strings, byte spans, nullptr, or optionals of those.
+    template <typename ... Values>
+    void Add(Values const& ... values)
+    {
+      Value const row[] = { View(values) ... };
+
+      if (sizeof...(values) != m_Order.size())
+      {
+        throw SQLiteException(SQLITE_MISUSE, "BulkLoader: " + m_Table + " has " + std::to_string(m_Order.size()) + " columns");
+      }
+
+      size_t const offset = m_Run.Rows.size();
+      m_Run.Rows.resize(offset + sizeof(uint32_t));
+
+      for (size_t const column : m_Order)
+      {
+        Encode(m_Run.Rows, row[column]);
+      }
+
+      uint32_t const size = static_cast<uint32_t>(m_Run.Rows.size() - offset - sizeof(uint32_t));
+      std::memcpy(m_Run.Rows.data() + offset, &size, sizeof(size));
+      m_Run.Offsets.push_back(offset);
+
+      if (m_Run.Size() >= m_MemoryLimit)
+      {
+        StartSpill();
+      }
+    }
+
+    // Inserts the rows and returns how many there were.
+    int64_t Finish()
+    {
+      try
+      {
+        for (auto& pending : m_Pending)
+        {
+          m_Files.push_back(pending.get());
+        }
+      }
+      catch (...)
+      {
+        // Clearing waits for the other spills, whose files are dropped with the rows.
+        m_Pending.clear();
+        m_Run = Run();
+        m_Files.clear();
+        m_Loaded = 0;
+        throw;
+      }
+
+      m_Pending.clear();
+
+      std::vector<std::string> names;
+      std::vector<std::string> indexes;
+
+      // Dropped in the first transaction and created again in the last, or after a failed load.
+      m_Transaction.emplace(*m_Connection, SQLiteTransactionType::Immediate);
+
+      if (m_RebuildIndexes)
+      {
+        Statement select(*m_Connection, "Select Name, Sql From sqlite_master Where Type = 'index' And Tbl_Name = ? And Sql Is Not Null");
+        select.Bind(1, m_Table);
+
+        while (select.Step())
+        {
+          names.emplace_back(select.GetString(0));
+          indexes.emplace_back(select.GetString(1));
+        }
+      }
+
+      try
+      {
+        for (std::string const& name : names)
+        {
+          Execute(*m_Connection, ("Drop Index " + SQLiteQuoteIdentifier(name)).c_str());
+        }
+
+        if (m_Files.empty())
+        {
+          Sort(m_Run);
+
+          for (size_t const offset : m_Run.Offsets)
+          {
+            Insert(m_Run.Rows.data() + offset);
+          }
+        }
+        else
+        {
+          if (!m_Run.Offsets.empty())
+          {
+            m_Files.push_back(Spill(std::move(m_Run)));
+          }
+
+          Merge([&](char const* const row) { Insert(row); });
+        }
+
+        for (std::string const& index : indexes)
+        {
+          Execute(*m_Connection, index.c_str());
+        }
+
+        m_Transaction->Commit();
+      }
+      catch (...)
+      {
+        sqlite3_reset(m_Insert.GetAbi());
+        m_Transaction.reset();
+        m_Run = Run();
+        m_Files.clear();
+        m_Loaded = 0;
+
+        // The transactions committed before the failure may have dropped the indexes for good.
+        RestoreIndexes(names, indexes);
+        throw;
+      }
+
+      m_Transaction.reset();
+      m_Run = Run();
+      m_Files.clear();
+
+      return std::exchange(m_Loaded, 0);
+    }
+
+  private:
+    // Creates again those of the indexes that no longer exist, as far as the rows loaded allow.
+    void RestoreIndexes(std::vector<std::string> const& names, std::vector<std::string> const& indexes) const noexcept
+    {
+      for (size_t index = 0; index < names.size(); ++index)
+      {
+        try
+        {
+          Statement exists(*m_Connection, "Select 1 From sqlite_master Where Type = 'index' And Name = ?");
+          exists.Bind(1, names[index]);
+
+          if (!exists.Step())
+          {
+            Execute(*m_Connection, indexes[index].c_str());
+          }
+        }
+        catch (SQLiteException const&)
+        {
+        }
+      }
+    }
+
+    Connection const* m_Connection = nullptr;
+    std::string m_Table;
+    size_t m_MemoryLimit = 0;
+    int32_t m_Threads = 1;
+    int64_t m_TransactionRows = 0;
+    bool m_RebuildIndexes = true;
+
+    Statement m_Insert;
+    std::vector<size_t> m_Order;
+    size_t m_KeyCount = 0;
+
+    Run m_Run;
+    std::deque<std::future<File>> m_Pending;
+    std::vector<File> m_Files;
+
+    std::optional<SQLiteTransaction<ThreadingPolicy>> m_Transaction;
+    int64_t m_Loaded = 0;
+  };
+}
@@ -0,0 +1,1102 @@
+#pragma once
+
+#include "VirtualTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  enum class ColumnStoreType
+  {
+    Integer,
+    Real,
+    Text,
+  };
+
+  // A constraint pushed down to a column store scan, already converted to the column's type.
+  struct ColumnStoreBound
+  {
+    int32_t Column = 0;
+    int32_t Operator = 0;
+    bool IsInteger = false;
+    int64_t Integer = 0;
+    double Real = 0;
+    std::string Text;
+  };
+
+  // The values of one column within one segment. Integers live in Codes; text always, and reals
+  // when few are distinct, live in a dictionary that Codes index. Encoded, the codes are either
+  // run-length pairs or bit-packed offsets from their minimum, whichever is smaller.
+  class ColumnSegment
+  {
+  private:
+    enum Flags : uint8_t
+    {
+      HasNulls = 1,
+      HasDictionary = 2,
+      RunLength = 4,
+    };
+
+    template <typename T>
+    static void Put(std::string& output, T const value)
+    {
+      output.append(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static T Take(std::span<std::byte const>& input)
+    {
+      if (input.size() < sizeof(T))
+      {
+        throw SQLiteException(SQLITE_CORRUPT);
+      }
+
+      T value;
+      std::memcpy(&value, input.data(), sizeof(T));
+      input = input.subspan(sizeof(T));
+      return value;
+    }
+
+    template <typename T, typename V>
+    static void Compare(int32_t const op, T const* const values, V const constant, uint8_t* const selected, size_t const count) noexcept
+    {
+      // One branch-free loop per operator so each one vectorizes.
+      switch (op)
+      {
+        case SQLITE_INDEX_CONSTRAINT_EQ: for (size_t index = 0; index < count; ++index) selected[index] &= values[index] == constant; break;
+        case SQLITE_INDEX_CONSTRAINT_GT: for (size_t index = 0; index < count; ++index) selected[index] &= values[index] > constant; break;
+        case SQLITE_INDEX_CONSTRAINT_GE: for (size_t index = 0; index < count; ++index) selected[index] &= values[index] >= constant; break;
+        case SQLITE_INDEX_CONSTRAINT_LT: for (size_t index = 0; index < count; ++index) selected[index] &= values[index] < constant; break;
+        case SQLITE_INDEX_CONSTRAINT_LE: for (size_t index = 0; index < count; ++index) selected[index] &= values[index] <= constant; break;
+      }
+    }
+
+    int64_t Intern(std::string_view const text)
+    {
+      auto const [position, inserted] = m_Index.try_emplace(std::string(text), static_cast<int64_t>(m_Strings.size()));
+
+      if (inserted)
+      {
+        m_Strings.emplace_back(text);
+      }
+
+      return position->second;
+    }
+
+    void EncodeCodes(std::string& output, std::vector<int64_t> const& codes, uint8_t& flags) const
+    {
+      size_t runs = codes.empty() ? 0 : 1;
+      int64_t minimum = codes.empty() ? 0 : codes[0];
+      int64_t maximum = minimum;
+
+      for (size_t index = 1; index < codes.size(); ++index)
+      {
+        runs += codes[index] != codes[index - 1];
+        minimum = std::min(minimum, codes[index]);
+        maximum = std::max(maximum, codes[index]);
+      }
+
+      int32_t const width = 64 - std::countl_zero(static_cast<uint64_t>(maximum) - static_cast<uint64_t>(minimum));
+      size_t const words = (codes.size() * width + 63) / 64;
+
+      if (runs * (sizeof(int64_t) + sizeof(uint32_t)) < words * sizeof(uint64_t))
+      {
+        flags |= RunLength;
+        Put(output, static_cast<uint32_t>(runs));
+
+        for (size_t index = 0; index < codes.size(); )
+        {
+          size_t end = index + 1;
+
+          while (end < codes.size() && codes[end] == codes[index])
+          {
+            ++end;
+          }
+
+          Put(output, codes[index]);
+          Put(output, static_cast<uint32_t>(end - index));
+          index = end;
+        }
+
+        return;
+      }
+
+      std::vector<uint64_t> packed(words + 1);
+
+      for (size_t index = 0; index < codes.size() && width != 0; ++index)
+      {
+        uint64_t const value = static_cast<uint64_t>(codes[index]) - static_cast<uint64_t>(minimum);
+        size_t const bit = index * width;
+
+        packed[bit / 64] |= value << (bit % 64);
+
+        if (bit % 64 + width > 64)
+        {
+          packed[bit / 64 + 1] |= value >> (64 - bit % 64);
+        }
+      }
+
+      Put(output, minimum);
+      Put(output, static_cast<uint8_t>(width));
+      output.append(reinterpret_cast<char const*>(packed.data()), words * sizeof(uint64_t));
+    }
+
+    void DecodeCodes(std::span<std::byte const>& input, uint8_t const flags)
+    {
+      m_Codes.resize(m_Count);
+
+      if (flags & RunLength)
+      {
+        uint32_t const runs = Take<uint32_t>(input);
+        size_t index = 0;
+
+        for (uint32_t run = 0; run < runs; ++run)
+        {
+          int64_t const value = Take<int64_t>(input);
+          uint32_t const length = Take<uint32_t>(input);
+
+          if (length > m_Count - index)
+          {
+            throw SQLiteException(SQLITE_CORRUPT);
+          }
+
+          std::fill_n(m_Codes.begin() + index, length, value);
+          index += length;
+        }
+
+        if (index != m_Count)
+        {
+          throw SQLiteException(SQLITE_CORRUPT);
+        }
+
+        return;
+      }
+
+      int64_t const minimum = Take<int64_t>(input);
+      int32_t const width = Take<uint8_t>(input);
+      size_t const words = (m_Count * width + 63) / 64;
+
+      if (width > 64 || input.size() < words * sizeof(uint64_t))
+      {
+        throw SQLiteException(SQLITE_CORRUPT);
+      }
+
+      // Spare words let every value be read from two words without a branch.
+      std::vector<uint64_t> packed(words + 2);
+      std::memcpy(packed.data(), input.data(), words * sizeof(uint64_t));
+      input = input.subspan(words * sizeof(uint64_t));
+
+      uint64_t const mask = width == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << width) - 1;
+      uint64_t const* const word = packed.data();
+      int64_t* const code = m_Codes.data();
+
+      for (size_t index = 0; index < m_Count; ++index)
+      {
+        size_t const bit = index * width;
+        uint64_t const low = word[bit / 64] >> (bit % 64);
+        uint64_t const high = (word[bit / 64 + 1] << (63 - bit % 64)) << 1;
+        code[index] = static_cast<int64_t>(static_cast<uint64_t>(minimum) + ((low | high) & mask));
+      }
+    }
+
+  public:
+    explicit ColumnSegment(ColumnStoreType const type = ColumnStoreType::Integer) noexcept : m_Type(type)
+    {
+    }
+
+    void Clear() noexcept
+    {
+      m_Count = 0;
+      m_Dictionary = m_Type == ColumnStoreType::Text;
+      m_Codes.clear();
+      m_Reals.clear();
+      m_Strings.clear();
+      m_Nulls.clear();
+      m_Index.clear();
+    }
+
+    // Appends a value converted to the column type, as the column affinity would.
+    void Append(sqlite3_value* const value)
+    {
+      if (m_Count % 64 == 0)
+      {
+        m_Nulls.push_back(0);
+      }
+
+      bool const null = sqlite3_value_type(value) == SQLITE_NULL;
+      m_Nulls.back() |= uint64_t{ null } << (m_Count % 64);
+
+      switch (m_Type)
+      {
+        case ColumnStoreType::Integer:
+          m_Codes.push_back(null ? 0 : sqlite3_value_int64(value));
+          break;
+
+        case ColumnStoreType::Real:
+          m_Reals.push_back(null ? 0 : sqlite3_value_double(value));
+          break;
+
+        case ColumnStoreType::Text:
+          m_Dictionary = true;
+          m_Codes.push_back(null ? Intern({ }) : Intern({ reinterpret_cast<char const*>(sqlite3_value_text(value)), static_cast<size_t>(sqlite3_value_bytes(value)) }));
+          break;
+      }
+
+      ++m_Count;
+    }
+
+    size_t Count() const noexcept
+    {
+      return m_Count;
+    }
+
+    bool IsNull(size_t const row) const noexcept
+    {
+      return !m_Nulls.empty() && (m_Nulls[row / 64] >> (row % 64)) & 1;
+    }
+
+    double Real(size_t const row) const noexcept
+    {
+      return m_Dictionary ? m_Reals[m_Codes[row]] : m_Reals[row];
+    }
+
+    void Result(sqlite3_context* const context, size_t const row) const noexcept
+    {
+      if (IsNull(row))
+      {
+        sqlite3_result_null(context);
+        return;
+      }
+
+      switch (m_Type)
+      {
+        case ColumnStoreType::Integer: sqlite3_result_int64(context, m_Codes[row]); break;
+        case ColumnStoreType::Real: sqlite3_result_double(context, Real(row)); break;
+        case ColumnStoreType::Text:
+        {
+          std::string const& text = m_Strings[m_Codes[row]];
+          sqlite3_result_text(context, text.data(), static_cast<int32_t>(text.size()), SQLITE_TRANSIENT);
+          break;
+        }
+      }
+    }
+
+    // Binds the smallest and largest non-null values, the segment's zone map.
+    template <typename Statement>
+    void BindBounds(Statement const& statement, int32_t const index) const
+    {
+      std::optional<size_t> minimum;
+      std::optional<size_t> maximum;
+
+      auto const less = [&](size_t const left, size_t const right)
+        {
+          switch (m_Type)
+          {
+            case ColumnStoreType::Integer: return m_Codes[left] < m_Codes[right];
+            case ColumnStoreType::Real: return Real(left) < Real(right);
+            default: return m_Strings[m_Codes[left]] < m_Strings[m_Codes[right]];
+          }
+        };
+
+      for (size_t row = 0; row < m_Count; ++row)
+      {
+        if (!IsNull(row))
+        {
+          minimum = !minimum || less(row, *minimum) ? row : *minimum;
+          maximum = !maximum || less(*maximum, row) ? row : *maximum;
+        }
+      }
+
+      for (auto const& [bound, offset] : { std::pair(minimum, 0), std::pair(maximum, 1) })
+      {
+        if (!bound) statement.Bind(index + offset, nullptr);
+        else if (m_Type == ColumnStoreType::Integer) statement.Bind(index + offset, m_Codes[*bound]);
+        else if (m_Type == ColumnStoreType::Real) statement.Bind(index + offset, Real(*bound));
+        else statement.Bind(index + offset, m_Strings[m_Codes[*bound]].c_str(), static_cast<int32_t>(m_Strings[m_Codes[*bound]].size()));
+      }
+    }
+
+    // Clears selected[row] for the rows that do not satisfy the bound; nulls satisfy nothing.
+    void Select(ColumnStoreBound const& bound, std::vector<uint8_t>& selected) const
+    {
+      std::vector<uint8_t> matches;
+
+      switch (m_Type)
+      {
+        case ColumnStoreType::Integer:
+          if (bound.IsInteger) Compare(bound.Operator, m_Codes.data(), bound.Integer, selected.data(), m_Count);
+          else Compare(bound.Operator, m_Codes.data(), bound.Real, selected.data(), m_Count);
+          break;
+
+        case ColumnStoreType::Real:
+        {
+          double const constant = bound.IsInteger ? static_cast<double>(bound.Integer) : bound.Real;
+
+          if (!m_Dictionary)
+          {
+            Compare(bound.Operator, m_Reals.data(), constant, selected.data(), m_Count);
+            break;
+          }
+
+          matches.assign(m_Reals.size(), 1);
+          Compare(bound.Operator, m_Reals.data(), constant, matches.data(), m_Reals.size());
+          break;
+        }
+
+        case ColumnStoreType::Text:
+        {
+          // Compare each distinct string once, then look the result up per row.
+          std::vector<std::string_view> const views(m_Strings.begin(), m_Strings.end());
+          matches.assign(views.size(), 1);
+          Compare(bound.Operator, views.data(), std::string_view(bound.Text), matches.data(), views.size());
+          break;
+        }
+      }
+
+      if (!matches.empty())
+      {
+        for (size_t row = 0; row < m_Count; ++row)
+        {
+          selected[row] &= matches[m_Codes[row]];
+        }
+      }
+
+      for (size_t row = 0; row < m_Count && !m_Nulls.empty(); ++row)
+      {
+        selected[row] &= static_cast<uint8_t>(~(m_Nulls[row / 64] >> (row % 64)) & 1);
+      }
+    }
+
+    std::string Encode() const
+    {
+      std::string output;
+      uint8_t flags = 0;
+
+      bool const nulls = std::any_of(m_Nulls.begin(), m_Nulls.end(), [](uint64_t const word) { return word != 0; });
+      std::vector<int64_t> codes;
+      std::vector<double> dictionary;
+
+      if (m_Type == ColumnStoreType::Real)
+      {
+        std::unordered_map<uint64_t, int64_t> distinct;
+
+        for (size_t row = 0; row < m_Count && distinct.size() <= m_Count / 2; ++row)
+        {
+          distinct.try_emplace(std::bit_cast<uint64_t>(Real(row)), static_cast<int64_t>(distinct.size()));
+        }
+
+        if (m_Count != 0 && distinct.size() <= m_Count / 2)
+        {
+          dictionary.resize(distinct.size());
+
+          for (auto const& [bits, code] : distinct)
+          {
+            dictionary[code] = std::bit_cast<double>(bits);
+          }
+
+          for (size_t row = 0; row < m_Count; ++row)
+          {
+            codes.push_back(distinct[std::bit_cast<uint64_t>(Real(row))]);
+          }
+        }
+      }
+
+      flags |= nulls ? HasNulls : 0;
+      flags |= m_Type == ColumnStoreType::Text || !dictionary.empty() ? HasDictionary : 0;
+
+      output += '\0';
+      Put(output, static_cast<uint32_t>(m_Count));
+
+      if (nulls)
+      {
+        output.append(reinterpret_cast<char const*>(m_Nulls.data()), m_Nulls.size() * sizeof(uint64_t));
+      }
+
+      switch (m_Type)
+      {
+        case ColumnStoreType::Integer:
+          EncodeCodes(output, m_Codes, flags);
+          break;
+
+        case ColumnStoreType::Real:
+          if (dictionary.empty())
+          {
+            for (size_t row = 0; row < m_Count; ++row)
+            {
+              Put(output, Real(row));
+            }
+
+            break;
+          }
+
+          Put(output, static_cast<uint32_t>(dictionary.size()));
+          output.append(reinterpret_cast<char const*>(dictionary.data()), dictionary.size() * sizeof(double));
+          EncodeCodes(output, codes, flags);
+          break;
+
+        case ColumnStoreType::Text:
+          Put(output, static_cast<uint32_t>(m_Strings.size()));
+
+          for (std::string const& text : m_Strings)
+          {
+            Put(output, static_cast<uint32_t>(text.size()));
+            output += text;
+          }
+
+          EncodeCodes(output, m_Codes, flags);
+          break;
+      }
+
+      output[0] = static_cast<char>(flags);
+      return output;
+    }
+
+    void Decode(std::span<std::byte const> input)
+    {
+      Clear();
+
+      uint8_t const flags = Take<uint8_t>(input);
+      m_Count = Take<uint32_t>(input);
+      m_Dictionary = flags & HasDictionary;
+
+      if (flags & HasNulls)
+      {
+        m_Nulls.resize((m_Count + 63) / 64);
+
+        for (uint64_t& word : m_Nulls)
+        {
+          word = Take<uint64_t>(input);
+        }
+      }
+
+      if (m_Type == ColumnStoreType::Integer)
+      {
+        DecodeCodes(input, flags);
+      }
+      else if (m_Type == ColumnStoreType::Real && !m_Dictionary)
+      {
+        if (input.size() < m_Count * sizeof(double))
+        {
+          throw SQLiteException(SQLITE_CORRUPT);
+        }
+
+        m_Reals.resize(m_Count);
+        std::memcpy(m_Reals.data(), input.data(), m_Count * sizeof(double));
+      }
+      else
+      {
+        uint32_t const size = Take<uint32_t>(input);
+
+        for (uint32_t index = 0; index < size; ++index)
+        {
+          if (m_Type == ColumnStoreType::Real)
+          {
+            m_Reals.push_back(Take<double>(input));
+            continue;
+          }
+
+          uint32_t const length = Take<uint32_t>(input);
+
+          if (input.size() < length)
+          {
+            throw SQLiteException(SQLITE_CORRUPT);
+          }
+
+          m_Strings.emplace_back(reinterpret_cast<char const*>(input.data()), length);
+          input = input.subspan(length);
+        }
+
+        DecodeCodes(input, flags);
+
+        if (std::any_of(m_Codes.begin(), m_Codes.end(), [&](int64_t const code) { return code < 0 || static_cast<uint64_t>(code) >= size; }))
+        {
+          throw SQLiteException(SQLITE_CORRUPT);
+        }
+      }
+    }
+
+  private:
+    ColumnStoreType m_Type;
+    size_t m_Count = 0;
+    bool m_Dictionary = false;
+
+    std::vector<int64_t> m_Codes;
+    std::vector<double> m_Reals;
+    std::vector<std::string> m_Strings;
+    std::vector<uint64_t> m_Nulls;
+    std::unordered_map<std::string, int64_t> m_Index;
+  };
+
+  // Create Virtual Table Facts Using columnstore ( Region Text, Quantity Integer, Price Real, ... )
+  //
+  // Insert-only. New rows go to a row-store tail table; every SegmentSize rows the tail is
+  // compacted into one encoded segment per column in the <name>_segments shadow table, along
+  // with the column's min/max for that segment. A scan reads a column's segment only when the
+  // column is used, skips segments whose zone map rules out a pushed-down comparison, and tests
+  // the remaining rows against the comparisons before returning them.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class ColumnStoreTable : public SQLiteVirtualTable
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    // The length of the column name, quotes included, at the start of a column definition.
+    static size_t NameLength(std::string_view const definition)
+    {
+      if (definition.empty())
+      {
+        throw SQLiteException(SQLITE_ERROR, "columnstore: empty column definition");
+      }
+
+      if (char const quote = definition[0] == '[' ? ']' : definition[0]; quote == '"' || quote == '`' || quote == ']')
+      {
+        size_t const end = definition.find(quote, 1);
+        return end == std::string_view::npos ? definition.size() : end + 1;
+      }
+
+      return std::min(definition.find_first_of(" \t\r\n"), definition.size());
+    }
+
+    static ColumnStoreType TypeOf(std::string_view const definition)
+    {
+      std::string type(definition.substr(NameLength(definition)));
+      std::transform(type.begin(), type.end(), type.begin(), [](char const c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+
+      if (type.find("INT") != std::string::npos) return ColumnStoreType::Integer;
+      if (type.find("CHAR") != std::string::npos || type.find("CLOB") != std::string::npos || type.find("TEXT") != std::string::npos) return ColumnStoreType::Text;
+      if (type.find("BLOB") != std::string::npos || type.find_first_not_of(" \t\r\n") == std::string::npos)
+      {
+        throw SQLiteException(SQLITE_ERROR, "columnstore: column '" + std::string(definition) + "' needs an Integer, Real or Text type");
+      }
+
+      return ColumnStoreType::Real;
+    }
+
+    // Converts a comparison constant to the column type; returns false when it cannot be pushed down.
+    static bool MakeBound(ColumnStoreType const type, sqlite3_value* const value, ColumnStoreBound& bound)
+    {
+      int32_t const valueType = sqlite3_value_type(value);
+
+      if (type == ColumnStoreType::Text)
+      {
+        if (valueType != SQLITE_TEXT)
+        {
+          return false;
+        }
+
+        bound.Text.assign(reinterpret_cast<char const*>(sqlite3_value_text(value)), sqlite3_value_bytes(value));
+        return true;
+      }
+
+      if (valueType == SQLITE_INTEGER)
+      {
+        bound.IsInteger = true;
+        bound.Integer = sqlite3_value_int64(value);
+        return true;
+      }
+
+      if (valueType == SQLITE_FLOAT)
+      {
+        bound.Real = sqlite3_value_double(value);
+        return bound.Real == bound.Real;
+      }
+
+      if (valueType == SQLITE_TEXT)
+      {
+        // Numeric affinity applies to text that looks like a number.
+        char const* const text = reinterpret_cast<char const*>(sqlite3_value_text(value));
+        char* end = nullptr;
+        errno = 0;
+
+        if (bound.Integer = std::strtoll(text, &end, 10); *text && !*end && errno == 0)
+        {
+          bound.IsInteger = true;
+          return true;
+        }
+
+        if (bound.Real = std::strtod(text, &end); *text && !*end)
+        {
+          return bound.Real == bound.Real;
+        }
+      }
+
+      return false;
+    }
+
+    template <typename T>
+    static bool Overlaps(int32_t const op, T const& minimum, T const& maximum, T const& constant) noexcept
+    {
+      switch (op)
+      {
+        case SQLITE_INDEX_CONSTRAINT_EQ: return minimum <= constant && constant <= maximum;
+        case SQLITE_INDEX_CONSTRAINT_GT: return maximum > constant;
+        case SQLITE_INDEX_CONSTRAINT_GE: return maximum >= constant;
+        case SQLITE_INDEX_CONSTRAINT_LT: return minimum < constant;
+        default: return minimum <= constant;
+      }
+    }
+
+    template <typename Reader>
+    bool Overlaps(ColumnStoreBound const& bound, Reader const& zone) const
+    {
+      if (zone.GetType(1) == SQLiteType::Null)
+      {
+        return false;
+      }
+
+      switch (m_Types[bound.Column])
+      {
+        case ColumnStoreType::Integer:
+          if (bound.IsInteger) return Overlaps<int64_t>(bound.Operator, zone.GetInt64(1), zone.GetInt64(2), bound.Integer);
+          return Overlaps<double>(bound.Operator, static_cast<double>(zone.GetInt64(1)), static_cast<double>(zone.GetInt64(2)), bound.Real);
+
+        case ColumnStoreType::Real:
+          return Overlaps<double>(bound.Operator, zone.GetDouble(1), zone.GetDouble(2), bound.IsInteger ? static_cast<double>(bound.Integer) : bound.Real);
+
+        default:
+          return Overlaps<std::string_view>(bound.Operator,
+            { reinterpret_cast<char const*>(zone.GetBlob(1)), static_cast<size_t>(zone.GetBlobLength(1)) },
+            { reinterpret_cast<char const*>(zone.GetBlob(2)), static_cast<size_t>(zone.GetBlobLength(2)) }, bound.Text);
+      }
+    }
+
+    Statement const& Prepared(Statement& statement, std::string const& text) const
+    {
+      // Prepared on first use rather than while SQLite is connecting the table.
+      if (!statement)
+      {
+        statement.Prepare(*m_Connection, text.c_str());
+      }
+
+      return statement;
+    }
+
+    void Compact(sqlite3_int64 const segment)
+    {
+      std::vector<ColumnSegment> columns(m_Types.begin(), m_Types.end());
+      Statement const& tail = Prepared(m_ReadTail, "Select * From " + m_Tail + " Order By RowId");
+
+      while (tail.Step())
+      {
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+          columns[column].Append(sqlite3_column_value(tail.GetAbi(), static_cast<int32_t>(column)));
+        }
+      }
+
+      tail.Reset();
+
+      Statement const& insert = Prepared(m_InsertSegment, "Insert Into " + m_Segments + " Values ( ?, ?, ?, ?, ?, ? )");
+
+      for (size_t column = 0; column < columns.size(); ++column)
+      {
+        std::string const data = columns[column].Encode();
+
+        insert.Bind(1, static_cast<int64_t>(column));
+        insert.Bind(2, static_cast<int64_t>(segment));
+        insert.Bind(3, static_cast<int64_t>(columns[column].Count()));
+        columns[column].BindBounds(insert, 4);
+        insert.Bind(6, std::as_bytes(std::span(data.data(), data.size())));
+        insert.Execute();
+        insert.Reset();
+      }
+
+      Execute(*m_Connection, ("Delete From " + m_Tail).c_str());
+    }
+
+  public:
+    static constexpr int64_t SegmentSize = 16384;
+
+    class Cursor : public SQLiteVirtualCursor
+    {
+    private:
+      void Load(int32_t const column)
+      {
+        if (m_Loaded[column])
+        {
+          return;
+        }
+
+        m_Loaded[column] = 1;
+
+        if (m_Segment == -1)
+        {
+          LoadTail(column);
+          return;
+        }
+
+        Statement const& data = m_Table.Prepared(m_Data, "Select Data From " + m_Table.m_Segments + " Where Column = ? And Segment = ?");
+        data.Bind(1, static_cast<int64_t>(column));
+        data.Bind(2, static_cast<int64_t>(m_Segment));
+
+        if (!data.Step())
+        {
+          data.Reset();
+          throw SQLiteException(SQLITE_CORRUPT, "columnstore: missing segment");
+        }
+
+        m_Columns[column].Decode(std::span(data.GetBlob(), data.GetBlobLength()));
+        data.Reset();
+      }
+
+      // Tail columns are read one at a time too, so a scan only pays for the columns it uses.
+      void LoadTail(int32_t const column)
+      {
+        Statement const& tail = m_Table.Prepared(m_Tail[column], "Select " + m_Table.m_Names[column] + " From " + m_Table.m_Tail + " Order By RowId");
+        m_Columns[column].Clear();
+
+        while (tail.Step())
+        {
+          m_Columns[column].Append(sqlite3_column_value(tail.GetAbi(), 0));
+        }
+
+        tail.Reset();
+      }
+
+      // Moves to the next segment with a selected row, the tail last.
+      bool NextSegment()
+      {
+        while (true)
+        {
+          if (m_Next < m_Candidates.size())
+          {
+            m_Segment = m_Candidates[m_Next++];
+            m_Count = SegmentSize;
+          }
+          else if (m_Segment != -1)
+          {
+            Statement const& count = m_Table.Prepared(m_TailCount, "Select Count(*) From " + m_Table.m_Tail);
+            m_Segment = -1;
+            m_Count = count.Step() ? count.GetInt64() : 0;
+            count.Reset();
+          }
+          else
+          {
+            return false;
+          }
+
+          std::fill(m_Loaded.begin(), m_Loaded.end(), 0);
+          m_Selected.assign(m_Count, 1);
+
+          for (ColumnStoreBound const& bound : m_Bounds)
+          {
+            Load(bound.Column);
+            m_Columns[bound.Column].Select(bound, m_Selected);
+          }
+
+          m_Row = std::find(m_Selected.begin(), m_Selected.end(), 1) - m_Selected.begin();
+
+          if (m_Row < m_Count)
+          {
+            return true;
+          }
+        }
+      }
+
+    public:
+      explicit Cursor(ColumnStoreTable& table)
+        : m_Table(table)
+        , m_Columns(table.m_Types.begin(), table.m_Types.end())
+        , m_Loaded(table.m_Types.size())
+        , m_Tail(table.m_Types.size())
+      {
+      }
+
+      void Filter(int32_t, char const* const plan, std::span<sqlite3_value* const> const arguments)
+      {
+        m_Bounds.clear();
+
+        // The plan lists "column:operator;" for each argument, in order.
+        char const* position = plan ? plan : "";
+
+        for (size_t argument = 0; *position && argument < arguments.size(); ++argument)
+        {
+          char* end = nullptr;
+          ColumnStoreBound bound;
+          bound.Column = static_cast<int32_t>(std::strtol(position, &end, 10));
+          bound.Operator = static_cast<int32_t>(std::strtol(end + 1, &end, 10));
+          position = *end ? end + 1 : end;
+
+          if (MakeBound(m_Table.m_Types[bound.Column], arguments[argument], bound))
+          {
+            m_Bounds.push_back(std::move(bound));
+          }
+        }
+
+        Statement const& count = m_Table.Prepared(m_Segments, "Select Count(*) From " + m_Table.m_Segments + " Where Column = 0");
+        m_SegmentCount = count.Step() ? count.GetInt64() : 0;
+        count.Reset();
+
+        std::vector<uint8_t> keep(m_SegmentCount, 1);
+
+        Statement const& zones = m_Table.Prepared(m_Zones, "Select Segment, Min, Max From " + m_Table.m_Segments + " Where Column = ?");
+
+        for (ColumnStoreBound const& bound : m_Bounds)
+        {
+          zones.Bind(1, static_cast<int64_t>(bound.Column));
+
+          while (zones.Step())
+          {
+            if (sqlite3_int64 const segment = zones.GetInt64(0); segment >= 0 && static_cast<size_t>(segment) < keep.size())
+            {
+              keep[segment] &= m_Table.Overlaps(bound, zones);
+            }
+          }
+
+          zones.Reset();
+        }
+
+        m_Candidates.clear();
+
+        for (size_t segment = 0; segment < keep.size(); ++segment)
+        {
+          if (keep[segment])
+          {
+            m_Candidates.push_back(static_cast<int64_t>(segment));
+          }
+        }
+
+        m_Next = 0;
+        m_Segment = 0;
+        m_Eof = !NextSegment();
+      }
+
+      void Next()
+      {
+        m_Row = std::find(m_Selected.begin() + m_Row + 1, m_Selected.end(), 1) - m_Selected.begin();
+
+        if (m_Row == m_Count)
+        {
+          m_Eof = !NextSegment();
+        }
+      }
+
+      bool Eof() const noexcept
+      {
+        return m_Eof;
+      }
+
+      void Column(sqlite3_context* const context, int32_t const column)
+      {
+        Load(column);
+        m_Columns[column].Result(context, m_Row);
+      }
+
+      sqlite3_int64 RowId() const noexcept
+      {
+        // Tail rows follow the last segment; both are numbered without gaps.
+        return (m_Segment == -1 ? m_SegmentCount : m_Segment) * SegmentSize + static_cast<sqlite3_int64>(m_Row) + 1;
+      }
+
+    private:
+      ColumnStoreTable& m_Table;
+
+      std::vector<ColumnStoreBound> m_Bounds;
+      std::vector<int64_t> m_Candidates;
+      size_t m_Next = 0;
+
+      int64_t m_SegmentCount = 0;
+      int64_t m_Segment = -1;
+      std::vector<ColumnSegment> m_Columns;
+      std::vector<uint8_t> m_Loaded;
+      std::vector<uint8_t> m_Selected;
+      size_t m_Row = 0;
+      size_t m_Count = 0;
+      bool m_Eof = true;
+
+      Statement m_Data;
+      Statement m_Segments;
+      Statement m_TailCount;
+      std::vector<Statement> m_Tail;
+      Statement m_Zones;
+    };
+
+    // The context is the connection the module was registered on.
+    ColumnStoreTable(sqlite3*, void* const context, std::span<char const* const> const arguments)
+      : m_Connection(static_cast<Connection const*>(context))
+    {
+      if (arguments.size() < 4)
+      {
+        throw SQLiteException(SQLITE_ERROR, "columnstore: at least one column is required");
+      }
+
+      std::string const schema = SQLiteQuoteIdentifier(arguments[1]) + ".";
+      m_Segments = schema + SQLiteQuoteIdentifier(std::string(arguments[2]) + "_segments");
+      m_Tail = schema + SQLiteQuoteIdentifier(std::string(arguments[2]) + "_tail");
+
+      for (char const* const definition : arguments.subspan(3))
+      {
+        m_Definitions.emplace_back(definition);
+        m_Names.push_back(m_Definitions.back().substr(0, NameLength(definition)));
+        m_Types.push_back(TypeOf(definition));
+      }
+    }
+
+    static void Create(sqlite3* const connection, void* const context, std::span<char const* const> const arguments)
+    {
+      ColumnStoreTable const table(connection, context, arguments);
+
+      Execute(*table.m_Connection, ("Create Table " + table.m_Segments + " ( Column Integer, Segment Integer, Count Integer, Min, Max, Data Blob, Primary Key ( Column, Segment ) )").c_str());
+      Execute(*table.m_Connection, ("Create Table " + table.m_Tail + " ( " + table.Columns() + " )").c_str());
+    }
+
+    void Destroy()
+    {
+      Execute(*m_Connection, ("Drop Table If Exists " + m_Segments).c_str());
+      Execute(*m_Connection, ("Drop Table If Exists " + m_Tail).c_str());
+    }
+
+    std::string Columns() const
+    {
+      std::string columns;
+
+      for (std::string const& definition : m_Definitions)
+      {
+        columns += (columns.empty() ? "" : ", ") + definition;
+      }
+
+      return columns;
+    }
+
+    std::string Declaration() const
+    {
+      return "Create Table x ( " + Columns() + " )";
+    }
+
+    void BestIndex(sqlite3_index_info& info) const
+    {
+      std::string plan;
+      int32_t argument = 0;
+
+      for (int32_t index = 0; index < info.nConstraint; ++index)
+      {
+        sqlite3_index_info::sqlite3_index_constraint const& constraint = info.aConstraint[index];
+
+        switch (constraint.op)
+        {
+          case SQLITE_INDEX_CONSTRAINT_EQ:
+          case SQLITE_INDEX_CONSTRAINT_GT:
+          case SQLITE_INDEX_CONSTRAINT_GE:
+          case SQLITE_INDEX_CONSTRAINT_LT:
+          case SQLITE_INDEX_CONSTRAINT_LE:
+            break;
+
+          default:
+            continue;
+        }
+
+        if (!constraint.usable || constraint.iColumn < 0)
+        {
+          continue;
+        }
+
+        // Text is compared with memcmp, so only binary collations can be pushed down.
+        if (m_Types[constraint.iColumn] == ColumnStoreType::Text)
+        {
+#if SQLITE_VERSION_NUMBER >= 3022000
+          if (char const* const collation = sqlite3_vtab_collation(&info, index); collation && sqlite3_stricmp(collation, "BINARY") != 0)
+          {
+            continue;
+          }
+#else
+          continue;
+#endif
+        }
+
+        // SQLite still checks every row: the scan only uses the comparison to skip work.
+        info.aConstraintUsage[index].argvIndex = ++argument;
+        plan += std::to_string(constraint.iColumn) + ":" + std::to_string(constraint.op) + ";";
+      }
+
+      double columns = static_cast<double>(m_Types.size());
+
+#if SQLITE_VERSION_NUMBER >= 3010000
+      columns = std::min<double>(columns, std::popcount(static_cast<uint64_t>(info.colUsed)));
+#endif
+
+      info.idxStr = sqlite3_mprintf("%s", plan.c_str());
+      info.needToFreeIdxStr = 1;
+      info.estimatedCost = 1e6 * std::max(columns, 1.0) / (1 + argument);
+    }
+
+    void Update(std::span<sqlite3_value* const> const arguments, sqlite3_int64& rowId)
+    {
+      if (arguments.size() == 1 || sqlite3_value_type(arguments[0]) != SQLITE_NULL)
+      {
+        throw SQLiteException(SQLITE_CONSTRAINT, "columnstore: tables are insert-only");
+      }
+
+      if (sqlite3_value_type(arguments[1]) != SQLITE_NULL)
+      {
+        throw SQLiteException(SQLITE_CONSTRAINT, "columnstore: rowids are assigned by the table");
+      }
+
+      Statement const& count = Prepared(m_SegmentCount, "Select Count(*) From " + m_Segments + " Where Column = 0");
+      sqlite3_int64 const segments = count.Step() ? count.GetInt64() : 0;
+      count.Reset();
+
+      if (!m_InsertTail)
+      {
+        std::string text = "Insert Into " + m_Tail + " Values ( ?";
+
+        for (size_t column = 1; column < m_Types.size(); ++column)
+        {
+          text += ", ?";
+        }
+
+        m_InsertTail.Prepare(*m_Connection, (text + " )").c_str());
+      }
+
+      for (size_t column = 0; column < m_Types.size(); ++column)
+      {
+        sqlite3_value* const value = arguments[column + 2];
+        int32_t const index = static_cast<int32_t>(column + 1);
+
+        if (sqlite3_value_type(value) == SQLITE_NULL) m_InsertTail.Bind(index, nullptr);
+        else if (m_Types[column] == ColumnStoreType::Integer) m_InsertTail.Bind(index, static_cast<int64_t>(sqlite3_value_int64(value)));
+        else if (m_Types[column] == ColumnStoreType::Real) m_InsertTail.Bind(index, sqlite3_value_double(value));
+        else m_InsertTail.Bind(index, reinterpret_cast<char const*>(sqlite3_value_text(value)), sqlite3_value_bytes(value));
+      }
+
+      m_InsertTail.Execute();
+      m_InsertTail.Reset();
+
+      // The tail is emptied by each compaction, so its rowids restart at 1.
+      sqlite3_int64 const tailRowId = m_Connection->RowId();
+      rowId = segments * SegmentSize + tailRowId;
+
+      if (tailRowId == SegmentSize)
+      {
+        Compact(segments);
+      }
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+    std::string m_Segments;
+    std::string m_Tail;
+    std::vector<std::string> m_Definitions;
+    std::vector<std::string> m_Names;
+    std::vector<ColumnStoreType> m_Types;
+
+    mutable Statement m_SegmentCount;
+    mutable Statement m_InsertTail;
+    mutable Statement m_ReadTail;
+    mutable Statement m_InsertSegment;
+  };
+
+  // Registers the columnstore module. The connection must stay where it is while the module is in use.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  inline void CreateColumnStoreModule(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const name = "columnstore")
+  {
+    CreateModule<ColumnStoreTable<ThreadingPolicy>>(connection, name, const_cast<void*>(static_cast<void const*>(&connection)));
+  }
+}
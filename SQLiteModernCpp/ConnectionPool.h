@@ -0,0 +1,206 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct ConnectionPoolOptions
+  {
+    int32_t Size = 4;
+    int32_t Flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    std::chrono::milliseconds BusyTimeout{ 5000 };
+
+    // Statements cached per connection by Lease::Prepare. When the cache is full, the least
+    // recently used statement that the current lease has not been given is finalized.
+    size_t StatementCacheSize = 64;
+  };
+
+  // A fixed set of connections to one database, each leased to one thread at a time together
+  // with the statements prepared on it. A connection comes back with its statements reset and
+  // the transaction left open on it rolled back. Every connection has its own page cache, so a pool of a
+  // ":memory:" database is that many separate databases; use a file.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class SQLiteConnectionPool
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    struct Cached
+    {
+      Statement Prepared;
+
+      // The lease that last used it, and when, counted in uses of the connection's cache.
+      uint64_t Lease = 0;
+      uint64_t Use = 0;
+    };
+
+    struct Entry
+    {
+      Connection Database;
+      std::unordered_map<std::string, Cached> Statements;
+      uint64_t Leases = 0;
+      uint64_t Uses = 0;
+    };
+
+  public:
+    // Returns its connection to the pool on destruction.
+    class Lease
+    {
+    public:
+      Lease(Lease const&) = delete;
+      Lease& operator=(Lease const&) = delete;
+
+      Lease(Lease&& other) noexcept
+        : m_Pool(std::exchange(other.m_Pool, nullptr))
+        , m_Entry(std::exchange(other.m_Entry, nullptr))
+      {
+      }
+
+      ~Lease() noexcept
+      {
+        if (m_Pool)
+        {
+          m_Pool->Release(m_Entry);
+        }
+      }
+
+      Connection& GetConnection() const noexcept
+      {
+        return m_Entry->Database;
+      }
+
+      // Prepares sql on the leased connection, or returns the statement prepared for it before.
+      // Statements returned to a lease stay valid until it ends.
+      Statement& Prepare(std::string const& sql)
+      {
+        auto found = m_Entry->Statements.find(sql);
+
+        if (found == m_Entry->Statements.end())
+        {
+          while (m_Entry->Statements.size() >= m_Pool->m_Options.StatementCacheSize && Evict());
+
+          Statement statement(m_Entry->Database, sql.c_str());
+          found = m_Entry->Statements.emplace(sql, Cached{ std::move(statement) }).first;
+        }
+        else
+        {
+          found->second.Prepared.AttachThread();
+        }
+
+        found->second.Lease = m_Entry->Leases;
+        found->second.Use = ++m_Entry->Uses;
+        return found->second.Prepared;
+      }
+
+    private:
+      friend class SQLiteConnectionPool;
+
+      // Returns false if the current lease was given every statement in the cache, which then
+      // outgrows its size until a later lease.
+      bool Evict() noexcept
+      {
+        auto oldest = m_Entry->Statements.end();
+
+        for (auto cached = m_Entry->Statements.begin(); cached != m_Entry->Statements.end(); ++cached)
+        {
+          if (cached->second.Lease != m_Entry->Leases && (oldest == m_Entry->Statements.end() || cached->second.Use < oldest->second.Use))
+          {
+            oldest = cached;
+          }
+        }
+
+        if (oldest == m_Entry->Statements.end())
+        {
+          return false;
+        }
+
+        m_Entry->Statements.erase(oldest);
+        return true;
+      }
+
+      Lease(SQLiteConnectionPool* const pool, Entry* const entry) noexcept
+        : m_Pool(pool)
+        , m_Entry(entry)
+      {
+      }
+
+      SQLiteConnectionPool* m_Pool;
+      Entry* m_Entry;
+    };
+
+    SQLiteConnectionPool(SQLiteConnectionPool const&) = delete;
+    SQLiteConnectionPool& operator=(SQLiteConnectionPool const&) = delete;
+
+    explicit SQLiteConnectionPool(char const* const filename, ConnectionPoolOptions const& options = {})
+      : m_Options(options)
+    {
+      for (int32_t index = 0; index < std::max(options.Size, 1); ++index)
+      {
+        Entry& entry = m_Entries.emplace_back();
+        entry.Database.Open(filename, options.Flags);
+        entry.Database.SetBusyTimeout(options.BusyTimeout);
+        m_Free.push_back(&entry);
+      }
+    }
+
+    // Waits until a connection is free. Destroy every lease before the pool.
+    Lease Acquire()
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Condition.wait(lock, [this] { return !m_Free.empty(); });
+
+      Entry* const entry = m_Free.back();
+      m_Free.pop_back();
+      lock.unlock();
+
+      entry->Database.AttachThread();
+      ++entry->Leases;
+      return Lease(this, entry);
+    }
+
+    int32_t Size() const noexcept
+    {
+      return static_cast<int32_t>(m_Entries.size());
+    }
+
+  private:
+    void Release(Entry* const entry) noexcept
+    {
+      sqlite3* const database = entry->Database.GetAbi();
+
+      for (sqlite3_stmt* statement = sqlite3_next_stmt(database, nullptr); statement; statement = sqlite3_next_stmt(database, statement))
+      {
+        if (sqlite3_stmt_busy(statement))
+        {
+          sqlite3_reset(statement);
+        }
+      }
+
+      if (!sqlite3_get_autocommit(database))
+      {
+        sqlite3_exec(database, "Rollback", nullptr, nullptr, nullptr);
+      }
+
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Free.push_back(entry);
+      }
+
+      m_Condition.notify_one();
+    }
+
+    ConnectionPoolOptions m_Options;
+    std::list<Entry> m_Entries;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::vector<Entry*> m_Free;
+  };
+}
@@ -1,11 +1,20 @@
 #pragma once
 
+#if defined(_MSC_VER)
 #ifdef _DEBUG
 #include <crtdbg.h>
 #define ASSERT _ASSERTE
 #else
 #define ASSERT __noop
 #endif
+#else
+#ifdef _DEBUG
+#include <cassert>
+#define ASSERT assert
+#else
+#define ASSERT(expression) ((void)0)
+#endif
+#endif
 
 #include <concepts>
 
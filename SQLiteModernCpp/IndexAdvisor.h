@@ -0,0 +1,729 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct IndexAdvisorOptions
+  {
+    // Statement texts kept per distinct statement for replay, with their parameters inlined.
+    size_t MaxSamples = 8;
+
+    // Each timing is the fastest of this many replays.
+    int32_t Repeat = 3;
+
+    // Proposals that do not make the whole workload at least this many times faster are dropped.
+    double MinimumGain = 1.1;
+  };
+
+  struct IndexProposal
+  {
+    std::string Sql;
+    std::string Table;
+    std::string Reason;
+
+    // Estimated workload time in milliseconds: each statement's replay time times its count.
+    double Before = 0;
+    double After = 0;
+  };
+
+  // Suggests indexes for the statements a connection runs. While an advisor is attached it
+  // replaces the connection's trace and profile callbacks and records each statement with how
+  // long it took; Record adds statements measured elsewhere.
+  //
+  // Advise copies the database into memory with SQLiteBackup and looks for full scans and temporary
+  // sorts in the plan of each statement. For each it considers an index on the columns the statement
+  // constrains and orders by, the same index covering every column the statement reads, and an
+  // index partial on the constants the statement compares with. Candidates are built on the copy
+  // and timed by replaying the workload there, writes included and rolled back; the copy is not
+  // analyzed, so plans are the ones the database would get.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class IndexAdvisor
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+
+    struct Recorded
+    {
+      int64_t Count = 0;
+      double Milliseconds = 0;
+      std::vector<std::string> Samples;
+    };
+
+    struct Token
+    {
+      enum Kind { Word, Quoted, Literal, Parameter, Symbol } Type;
+      std::string Text;
+    };
+
+    // What one statement does with one table.
+    struct Usage
+    {
+      std::vector<std::string> Equal;
+      std::vector<std::string> Range;
+      std::vector<std::string> Order;
+      std::set<std::string> Referenced;
+      std::vector<std::pair<std::string, std::string>> Constants;
+      bool All = false;
+    };
+
+    static std::string Upper(std::string_view const text)
+    {
+      std::string result(text);
+      std::transform(result.begin(), result.end(), result.begin(), [](char const c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+      return result;
+    }
+
+    static std::vector<Token> Tokenize(std::string_view const sql)
+    {
+      std::vector<Token> tokens;
+      size_t position = 0;
+
+      auto const quoted = [&](char const close)
+      {
+        size_t end = position + 1;
+
+        while (end < sql.size() && !(sql[end] == close && (end + 1 == sql.size() || sql[end + 1] != close || close == ']')))
+        {
+          end += sql[end] == close ? 2 : 1;
+        }
+
+        std::string text;
+
+        for (size_t index = position + 1; index < std::min(end, sql.size()); ++index)
+        {
+          text += sql[index];
+          index += sql[index] == close && close != ']';
+        }
+
+        position = std::min(end + 1, sql.size());
+        return text;
+      };
+
+      while (position < sql.size())
+      {
+        char const c = sql[position];
+
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+          ++position;
+        }
+        else if (c == '-' && position + 1 < sql.size() && sql[position + 1] == '-')
+        {
+          position = std::min(sql.find('\n', position), sql.size());
+        }
+        else if (c == '\'')
+        {
+          size_t const start = position;
+          quoted('\'');
+          tokens.push_back({ Token::Literal, std::string(sql.substr(start, position - start)) });
+        }
+        else if (c == '"' || c == '`' || c == '[')
+        {
+          tokens.push_back({ Token::Quoted, quoted(c == '[' ? ']' : c) });
+        }
+        else if (c == '?' || c == ':' || c == '@' || c == '$')
+        {
+          size_t const start = position++;
+
+          while (position < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[position])) || sql[position] == '_'))
+          {
+            ++position;
+          }
+
+          tokens.push_back({ Token::Parameter, std::string(sql.substr(start, position - start)) });
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && position + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[position + 1]))))
+        {
+          size_t const start = position;
+
+          while (position < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[position])) || sql[position] == '.'))
+          {
+            ++position;
+          }
+
+          tokens.push_back({ Token::Literal, std::string(sql.substr(start, position - start)) });
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_' || static_cast<unsigned char>(c) >= 0x80)
+        {
+          size_t const start = position;
+
+          while (position < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[position])) || sql[position] == '_' || static_cast<unsigned char>(sql[position]) >= 0x80))
+          {
+            ++position;
+          }
+
+          tokens.push_back({ Token::Word, std::string(sql.substr(start, position - start)) });
+        }
+        else
+        {
+          static constexpr std::string_view pairs[] = { "<=", ">=", "!=", "==", "<>", "||" };
+          std::string_view const pair = sql.substr(position, 2);
+          size_t const length = std::find(std::begin(pairs), std::end(pairs), pair) != std::end(pairs) ? 2 : 1;
+          tokens.push_back({ Token::Symbol, std::string(sql.substr(position, length)) });
+          position += length;
+        }
+      }
+
+      return tokens;
+    }
+
+    static bool Is(Token const& token, char const* const word)
+    {
+      return token.Type == Token::Word && sqlite3_stricmp(token.Text.c_str(), word) == 0;
+    }
+
+    static bool IsKeyword(Token const& token)
+    {
+      static constexpr char const* keywords[] =
+      {
+        "WHERE", "ON", "JOIN", "INNER", "LEFT", "RIGHT", "FULL", "CROSS", "NATURAL", "OUTER", "ORDER", "GROUP", "LIMIT", "SET", "USING",
+        "INDEXED", "NOT", "UNION", "EXCEPT", "INTERSECT", "HAVING", "WINDOW", "VALUES", "SELECT", "DEFAULT", "RETURNING", "AS",
+      };
+
+      return token.Type == Token::Word && std::any_of(std::begin(keywords), std::end(keywords), [&](char const* const keyword) { return Is(token, keyword); });
+    }
+
+    static std::vector<std::string> Columns(SQLiteConnection const& connection, std::string const& table)
+    {
+      std::vector<std::string> columns;
+
+      for (SQLiteStatement select(connection, ("PRAGMA table_info(" + SQLiteQuoteIdentifier(table) + ")").c_str()); select.Step();)
+      {
+        columns.emplace_back(select.GetString(1));
+      }
+
+      return columns;
+    }
+
+    static std::vector<std::string> Plan(SQLiteConnection const& connection, std::string const& sql)
+    {
+      std::vector<std::string> details;
+
+      try
+      {
+        for (SQLiteStatement explain(connection, ("Explain Query Plan " + sql).c_str()); explain.Step();)
+        {
+          details.emplace_back(explain.GetString(3));
+        }
+      }
+      catch (SQLiteException const&)
+      {
+      }
+
+      return details;
+    }
+
+    // The columns of table that one statement constrains, orders by, or reads; names is the
+    // table's name and aliases in upper case.
+    static Usage Use(std::vector<Token> const& tokens, std::set<std::string> const& names, std::vector<std::string> const& columns)
+    {
+      Usage usage;
+      enum { Other, Condition, Order } clause = Other;
+
+      auto const column = [&](size_t const index) -> std::string const*
+      {
+        Token const& token = tokens[index];
+
+        if (token.Type != Token::Word && token.Type != Token::Quoted)
+        {
+          return nullptr;
+        }
+
+        // A qualified name must be qualified by the table.
+        if (index >= 2 && tokens[index - 1].Text == "." && !names.contains(Upper(tokens[index - 2].Text)))
+        {
+          return nullptr;
+        }
+
+        if (index + 1 < tokens.size() && (tokens[index + 1].Text == "." || tokens[index + 1].Text == "("))
+        {
+          return nullptr;
+        }
+
+        auto const found = std::find_if(columns.begin(), columns.end(), [&](std::string const& name) { return sqlite3_stricmp(name.c_str(), token.Text.c_str()) == 0; });
+        return found == columns.end() ? nullptr : &*found;
+      };
+
+      auto const add = [](std::vector<std::string>& list, std::string const& name)
+      {
+        if (std::find(list.begin(), list.end(), name) == list.end())
+        {
+          list.push_back(name);
+        }
+      };
+
+      for (size_t index = 0; index < tokens.size(); ++index)
+      {
+        Token const& token = tokens[index];
+
+        if (Is(token, "WHERE") || Is(token, "ON") || Is(token, "HAVING")) clause = Condition;
+        else if (Is(token, "ORDER") || Is(token, "GROUP")) clause = Order;
+        else if (Is(token, "LIMIT") || Is(token, "SELECT") || Is(token, "SET") || Is(token, "RETURNING") || Is(token, "WINDOW")) clause = Other;
+        else if (token.Text == "*" && (index == 0 || Is(tokens[index - 1], "SELECT") || tokens[index - 1].Text == "," || tokens[index - 1].Text == ".")) usage.All = true;
+
+        std::string const* const name = column(index);
+
+        if (!name)
+        {
+          continue;
+        }
+
+        usage.Referenced.insert(*name);
+
+        if (clause == Order)
+        {
+          add(usage.Order, *name);
+          continue;
+        }
+
+        if (clause != Condition || index + 1 >= tokens.size())
+        {
+          continue;
+        }
+
+        Token const& next = tokens[index + 1];
+        Token const* const value = index + 2 < tokens.size() ? &tokens[index + 2] : nullptr;
+
+        if (next.Text == "=" || next.Text == "==" || Is(next, "IN") || Is(next, "IS"))
+        {
+          add(usage.Equal, *name);
+
+          if (value && (next.Text == "=" || next.Text == "==" || Is(next, "IS")) && (value->Type == Token::Literal || Is(*value, "NULL")))
+          {
+            usage.Constants.emplace_back(*name, next.Text + " " + value->Text);
+          }
+          else if (value && Is(next, "IS") && Is(*value, "NOT") && index + 3 < tokens.size() && Is(tokens[index + 3], "NULL"))
+          {
+            usage.Constants.emplace_back(*name, "Is Not Null");
+          }
+        }
+        else if (next.Text == "<" || next.Text == "<=" || next.Text == ">" || next.Text == ">=" || Is(next, "BETWEEN"))
+        {
+          add(usage.Range, *name);
+        }
+      }
+
+      return usage;
+    }
+
+    // The workload time, or infinity once a pass takes longer than limit milliseconds; slowest is
+    // the longest pass.
+    static double Replay(SQLiteConnection const& connection, std::vector<Recorded const*> const& statements, int32_t const repeat, double const limit, double& slowest)
+    {
+      using Clock = std::chrono::steady_clock;
+
+      std::vector<double> times(statements.size(), std::numeric_limits<double>::max());
+      Clock::time_point deadline;
+      bool expired = false;
+      slowest = 0;
+
+      sqlite3_progress_handler(connection.GetAbi(), 10'000, [](void* const context)
+        {
+          return static_cast<int>(Clock::now() > *static_cast<Clock::time_point*>(context));
+        }, &deadline);
+
+      for (int32_t pass = 0; pass < repeat && !expired; ++pass)
+      {
+        auto const start = Clock::now();
+        deadline = limit < 1e12 ? start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(limit)) : Clock::time_point::max();
+        Execute(connection, "Begin");
+
+        for (size_t index = 0; index < statements.size(); ++index)
+        {
+          auto const first = Clock::now();
+
+          for (std::string const& sample : statements[index]->Samples)
+          {
+            try
+            {
+              SQLiteStatement statement(connection, sample.c_str());
+              while (statement.Step());
+            }
+            catch (SQLiteException const&)
+            {
+            }
+          }
+
+          double const elapsed = std::chrono::duration<double, std::milli>(Clock::now() - first).count();
+          times[index] = std::min(times[index], elapsed / statements[index]->Samples.size());
+        }
+
+        Execute(connection, "Rollback");
+
+        double const elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        expired = elapsed > limit;
+        slowest = std::max(slowest, elapsed);
+      }
+
+      sqlite3_progress_handler(connection.GetAbi(), 0, nullptr, nullptr);
+
+      if (expired)
+      {
+        return std::numeric_limits<double>::infinity();
+      }
+
+      double total = 0;
+
+      for (size_t index = 0; index < statements.size(); ++index)
+      {
+        total += times[index] * statements[index]->Count;
+      }
+
+      return total;
+    }
+
+    template <typename Text>
+    void Add(std::string_view const sql, Text&& sample, double const milliseconds)
+    {
+      std::lock_guard lock(m_Mutex);
+      Recorded& recorded = m_Statements[std::string(sql)];
+      ++recorded.Count;
+      recorded.Milliseconds += milliseconds;
+
+      if (recorded.Samples.size() < m_Options.MaxSamples)
+      {
+        recorded.Samples.emplace_back(sample());
+      }
+    }
+
+#if SQLITE_VERSION_NUMBER >= 3014000
+    static int32_t OnTrace(uint32_t, void* const context, void* const statement, void* const nanoseconds) noexcept
+    {
+      sqlite3_stmt* const handle = static_cast<sqlite3_stmt*>(statement);
+
+      if (char const* const sql = sqlite3_sql(handle))
+      {
+        static_cast<IndexAdvisor*>(context)->Add(sql, [&]
+          {
+            char* const expanded = sqlite3_expanded_sql(handle);
+            std::string text(expanded ? expanded : sql);
+            sqlite3_free(expanded);
+            return text;
+          }, *static_cast<sqlite3_int64 const*>(nanoseconds) / 1e6);
+      }
+
+      return 0;
+    }
+#else
+    // Without sqlite3_expanded_sql the samples keep their parameters, which replay as nulls.
+    static void OnProfile(void* const context, char const* const sql, sqlite3_uint64 const nanoseconds) noexcept
+    {
+      static_cast<IndexAdvisor*>(context)->Add(sql, [&] { return std::string(sql); }, nanoseconds / 1e6);
+    }
+#endif
+
+  public:
+    IndexAdvisor(IndexAdvisor const&) = delete;
+    IndexAdvisor& operator=(IndexAdvisor const&) = delete;
+
+    explicit IndexAdvisor(Connection const& connection, IndexAdvisorOptions const& options = {})
+      : m_Connection(&connection)
+      , m_Options(options)
+    {
+      // Every statement needs a sample to be replayed, and every replay a timing.
+      if (m_Options.MaxSamples == 0 || m_Options.Repeat < 1)
+      {
+        throw SQLiteException(SQLITE_MISUSE, "IndexAdvisor: MaxSamples and Repeat must be at least 1");
+      }
+    }
+
+    ~IndexAdvisor()
+    {
+      Detach();
+    }
+
+    void Attach()
+    {
+#if SQLITE_VERSION_NUMBER >= 3014000
+      sqlite3_trace_v2(m_Connection->GetAbi(), SQLITE_TRACE_PROFILE, OnTrace, this);
+#else
+      sqlite3_profile(m_Connection->GetAbi(), OnProfile, this);
+#endif
+      m_Attached = true;
+    }
+
+    void Detach() noexcept
+    {
+      if (std::exchange(m_Attached, false))
+      {
+#if SQLITE_VERSION_NUMBER >= 3014000
+        sqlite3_trace_v2(m_Connection->GetAbi(), 0, nullptr, nullptr);
+#else
+        sqlite3_profile(m_Connection->GetAbi(), nullptr, nullptr);
+#endif
+      }
+    }
+
+    // Records a statement run elsewhere; sample is its text with parameter values inlined.
+    void Record(std::string_view const sql, std::string_view const sample, double const milliseconds = 0)
+    {
+      Add(sql, [&] { return std::string(sample); }, milliseconds);
+    }
+
+    std::vector<IndexProposal> Advise() const
+    {
+      std::map<std::string, Recorded> statements;
+
+      {
+        std::lock_guard lock(m_Mutex);
+        statements = m_Statements;
+      }
+
+      // Only statements that can be replayed inside a transaction and rolled back.
+      std::erase_if(statements, [](auto const& statement)
+        {
+          std::vector<Token> const tokens = Tokenize(statement.first);
+          return tokens.empty() || !(Is(tokens[0], "SELECT") || Is(tokens[0], "WITH") || Is(tokens[0], "INSERT") || Is(tokens[0], "UPDATE") || Is(tokens[0], "DELETE") || Is(tokens[0], "REPLACE") || Is(tokens[0], "VALUES"));
+        });
+
+      SQLiteConnection scratch(":memory:");
+
+      {
+        SQLiteBackup backup(scratch, *m_Connection);
+        backup.Step();
+      }
+
+      std::vector<std::string> tables;
+
+      for (SQLiteStatement select(scratch, "Select Name From sqlite_master Where Type = 'table' And Name Not Like 'sqlite%'"); select.Step();)
+      {
+        tables.emplace_back(select.GetString(0));
+      }
+
+      // Candidate index text, with its table and reason.
+      struct Candidate
+      {
+        std::string Table;
+        std::string Reason;
+      };
+
+      std::map<std::string, Candidate> candidates;
+
+      for (auto const& [sql, recorded] : statements)
+      {
+        std::vector<Token> const tokens = Tokenize(sql);
+
+        for (std::string const& detail : Plan(scratch, recorded.Samples.front()))
+        {
+          bool const scan = detail.starts_with("SCAN ") && detail.find("VIRTUAL TABLE") == std::string::npos && detail.find("SUBQUERY") == std::string::npos && detail.find("COVERING INDEX") == std::string::npos;
+          bool const sort = detail.starts_with("USE TEMP B-TREE FOR");
+
+          if (!scan && !sort)
+          {
+            continue;
+          }
+
+          // "SCAN TABLE Name AS Alias" before 3.36, "SCAN Name" or "SCAN Alias" since.
+          std::vector<Token> const words = Tokenize(detail);
+          size_t const at = words.size() > 2 && Is(words[1], "TABLE") ? 2 : 1;
+          std::string target = scan && words.size() > at ? Upper(words[at].Text) : std::string();
+          std::set<std::string> names;
+          std::string table;
+
+          for (std::string const& candidate : tables)
+          {
+            std::string const upper = Upper(candidate);
+
+            for (size_t index = 0; index < tokens.size(); ++index)
+            {
+              if ((tokens[index].Type == Token::Word || tokens[index].Type == Token::Quoted) && Upper(tokens[index].Text) == upper && (index + 1 == tokens.size() || tokens[index + 1].Text != "("))
+              {
+                std::string alias;
+                size_t next = index + 1;
+
+                if (next < tokens.size() && Is(tokens[next], "AS")) ++next;
+                if (next < tokens.size() && (tokens[next].Type == Token::Quoted || (tokens[next].Type == Token::Word && !IsKeyword(tokens[next])))) alias = Upper(tokens[next].Text);
+
+                if (target.empty() || target == upper || target == alias)
+                {
+                  table = candidate;
+                  names.insert(upper);
+
+                  if (!alias.empty())
+                  {
+                    names.insert(alias);
+                  }
+                }
+              }
+            }
+
+            if (!table.empty())
+            {
+              break;
+            }
+          }
+
+          if (table.empty())
+          {
+            continue;
+          }
+
+          std::vector<std::string> const columns = Columns(scratch, table);
+          Usage const usage = Use(tokens, names, columns);
+
+          std::vector<std::string> key = usage.Equal;
+
+          if (!usage.Range.empty() && std::find(key.begin(), key.end(), usage.Range.front()) == key.end())
+          {
+            key.push_back(usage.Range.front());
+          }
+
+          if (usage.Range.empty() || (!usage.Order.empty() && usage.Order.front() == usage.Range.front()))
+          {
+            for (std::string const& column : usage.Order)
+            {
+              if (std::find(key.begin(), key.end(), column) == key.end())
+              {
+                key.push_back(column);
+              }
+            }
+          }
+
+          if (key.empty())
+          {
+            continue;
+          }
+
+          auto const propose = [&](std::vector<std::string> const& columns, std::string const& where, std::string const& reason)
+          {
+            std::string list;
+            std::string name = "advisor_" + table;
+
+            for (std::string const& column : columns)
+            {
+              list += (list.empty() ? "" : ", ") + SQLiteQuoteIdentifier(column);
+              name += "_" + column;
+            }
+
+            if (!where.empty())
+            {
+              name += "_partial";
+            }
+
+            std::string const index = "Create Index " + SQLiteQuoteIdentifier(name) + " On " + SQLiteQuoteIdentifier(table) + " ( " + list + " )" + (where.empty() ? "" : " Where " + where);
+            Candidate& candidate = candidates[index];
+            candidate.Table = table;
+            candidate.Reason = reason + ": " + detail;
+          };
+
+          propose(key, { }, "index");
+
+          // Covering: every column the statement reads, after the key.
+          if (!usage.All && usage.Referenced.size() > key.size() && usage.Referenced.size() <= 8)
+          {
+            std::vector<std::string> covering = key;
+
+            for (std::string const& column : usage.Referenced)
+            {
+              if (std::find(covering.begin(), covering.end(), column) == covering.end())
+              {
+                covering.push_back(column);
+              }
+            }
+
+            propose(covering, { }, "covering index");
+          }
+
+          // Partial: the columns compared with constants move from the key to the condition.
+          if (!usage.Constants.empty())
+          {
+            std::vector<std::string> rest;
+            std::string where;
+
+            for (auto const& [column, condition] : usage.Constants)
+            {
+              where += (where.empty() ? "" : " And ") + SQLiteQuoteIdentifier(column) + " " + condition;
+            }
+
+            for (std::string const& column : key)
+            {
+              if (std::none_of(usage.Constants.begin(), usage.Constants.end(), [&](auto const& constant) { return constant.first == column; }))
+              {
+                rest.push_back(column);
+              }
+            }
+
+            if (!rest.empty())
+            {
+              propose(rest, where, "partial index");
+            }
+          }
+        }
+      }
+
+      // Proposals are chosen greedily: each round adds the one that speeds up the workload most
+      // to those already chosen, so that indexes that only help alone are not proposed together.
+      std::vector<Recorded const*> workload;
+
+      for (auto const& [sql, recorded] : statements)
+      {
+        workload.push_back(&recorded);
+      }
+
+      // A candidate is given up on once a replay takes twice as long as one without it.
+      double pass = 0;
+      double current = Replay(scratch, workload, m_Options.Repeat, std::numeric_limits<double>::infinity(), pass);
+      std::vector<IndexProposal> proposals;
+
+      while (!candidates.empty())
+      {
+        auto best = candidates.end();
+        double fastest = current;
+
+        for (auto candidate = candidates.begin(); candidate != candidates.end();)
+        {
+          try
+          {
+            Execute(scratch, candidate->first.c_str());
+          }
+          catch (SQLiteException const&)
+          {
+            candidate = candidates.erase(candidate);
+            continue;
+          }
+
+          double ignored = 0;
+
+          if (double const after = Replay(scratch, workload, m_Options.Repeat, 2 * pass + 10, ignored); after < fastest)
+          {
+            fastest = after;
+            best = candidate;
+          }
+
+          Execute(scratch, ("Drop Index " + SQLiteQuoteIdentifier(Tokenize(candidate->first)[2].Text)).c_str());
+          ++candidate;
+        }
+
+        if (best == candidates.end() || fastest * m_Options.MinimumGain > current)
+        {
+          break;
+        }
+
+        Execute(scratch, best->first.c_str());
+        Replay(scratch, workload, 1, std::numeric_limits<double>::infinity(), pass);
+        proposals.push_back({ best->first, best->second.Table, best->second.Reason, current, fastest });
+        candidates.erase(best);
+        current = fastest;
+      }
+
+      return proposals;
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+    IndexAdvisorOptions m_Options;
+    bool m_Attached = false;
+
+    mutable std::mutex m_Mutex;
+    std::map<std::string, Recorded> m_Statements;
+  };
+}
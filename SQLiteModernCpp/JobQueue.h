@@ -0,0 +1,293 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct JobQueueOptions
+  {
+    std::string Table = "Jobs";
+  };
+
+  struct Job
+  {
+    int64_t Id = 0;
+    int64_t Claim = 0;
+    int32_t Attempts = 0;
+    std::string Payload;
+  };
+
+  // Durable work queue. A job is Ready (Status 0) or Leased (Status 1) and is deleted when
+  // acknowledged; a lease that is not acknowledged in time makes the job visible again.
+  //
+  // One JobQueue is meant to be shared by all the workers of a process: it serializes its
+  // transactions on an in-process mutex instead of letting workers fight over the database
+  // lock, and it keeps a count of ready jobs so idle workers sleep instead of polling.
+  // Jobs enqueued by other processes are noticed when a wait times out.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class JobQueue
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    static constexpr int64_t Never = std::numeric_limits<int64_t>::max();
+
+    static int64_t Now() noexcept
+    {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // A default-constructed view has no data, which would bind NULL instead of the empty payload.
+    static std::span<std::byte const> Bytes(std::string_view const value) noexcept
+    {
+      static constexpr char Empty[1] = {};
+      return std::as_bytes(std::span(value.data() ? value.data() : Empty, value.size()));
+    }
+
+    // Runs statement once and leaves it ready for the next call.
+    static void Run(Statement const& statement)
+    {
+      try
+      {
+        statement.Execute();
+      }
+      catch (...)
+      {
+        sqlite3_reset(statement.GetAbi());
+        throw;
+      }
+
+      statement.Reset();
+    }
+
+    std::vector<Job> InternalClaim(int32_t const count, std::chrono::milliseconds const lease)
+    {
+      std::vector<Job> jobs;
+      SQLiteTransaction<ThreadingPolicy> transaction(*m_Connection, SQLiteTransactionType::Immediate);
+
+      int64_t const now = Now();
+      int64_t const until = now + lease.count();
+      int64_t const claim = static_cast<int64_t>(m_Random() >> 1);
+
+      m_Requeue.Bind(1, now);
+      Run(m_Requeue);
+
+      m_Claim.BindAll(until, claim, count);
+      Run(m_Claim);
+
+      m_Claimed.BindAll(until, claim);
+
+      try
+      {
+        while (m_Claimed.Step())
+        {
+          jobs.push_back({ m_Claimed.GetInt64(0), claim, m_Claimed.GetInt32(1), std::string(reinterpret_cast<char const*>(m_Claimed.GetBlob(2)), m_Claimed.GetBlobLength(2)) });
+        }
+      }
+      catch (...)
+      {
+        sqlite3_reset(m_Claimed.GetAbi());
+        throw;
+      }
+
+      m_Claimed.Reset();
+
+      try
+      {
+        m_NextExpiry = m_Expiry.Step() && m_Expiry.GetType() != SQLiteType::Null ? m_Expiry.GetInt64() : Never;
+      }
+      catch (...)
+      {
+        sqlite3_reset(m_Expiry.GetAbi());
+        throw;
+      }
+
+      m_Expiry.Reset();
+
+      transaction.Commit();
+
+      // A short batch means the queue has been drained, whatever the count said.
+      m_Ready = static_cast<int32_t>(jobs.size()) < count ? 0 : std::max<int64_t>(m_Ready - count, 1);
+      return jobs;
+    }
+
+    template <typename F>
+    void InternalForEach(std::span<Job const> const jobs, Statement const& statement, F&& bind)
+    {
+      SQLiteTransaction<ThreadingPolicy> transaction(*m_Connection, SQLiteTransactionType::Immediate);
+
+      for (Job const& job : jobs)
+      {
+        bind(job);
+        Run(statement);
+      }
+
+      transaction.Commit();
+    }
+
+  public:
+    JobQueue(JobQueue const&) = delete;
+    JobQueue& operator=(JobQueue const&) = delete;
+
+    explicit JobQueue(Connection const& connection, JobQueueOptions const& options = {})
+      : m_Connection(&connection)
+      , m_Random(std::random_device{ }())
+    {
+      std::string const table = SQLiteQuoteIdentifier(options.Table);
+
+      Execute(connection, ("Create Table If Not Exists " + table +
+        " ( Id Integer Primary Key, Status Integer Not Null, VisibleAt Integer Not Null, Claim Integer, Attempts Integer Not Null Default 0, Payload Blob )").c_str());
+      Execute(connection, ("Create Index If Not Exists " + SQLiteQuoteIdentifier(options.Table + "_Status") + " On " + table + " ( Status, VisibleAt )").c_str());
+
+      m_Enqueue.Prepare(connection, ("Insert Into " + table + " ( Status, VisibleAt, Payload ) Values ( 0, ?, ? )").c_str());
+      // A job that is ready again belongs to no worker, so a late Ack or Release of its old claim does nothing.
+      m_Requeue.Prepare(connection, ("Update " + table + " Set Status = 0, Claim = Null Where Status = 1 And VisibleAt <= ?").c_str());
+      m_Claim.Prepare(connection, ("Update " + table + " Set Status = 1, VisibleAt = ?1, Claim = ?2, Attempts = Attempts + 1"
+        " Where Id In ( Select Id From " + table + " Where Status = 0 Order By VisibleAt Limit ?3 )").c_str());
+      m_Claimed.Prepare(connection, ("Select Id, Attempts, Payload From " + table + " Where Status = 1 And VisibleAt = ? And Claim = ?").c_str());
+      m_Expiry.Prepare(connection, ("Select Min(VisibleAt) From " + table + " Where Status = 1").c_str());
+      m_Ack.Prepare(connection, ("Delete From " + table + " Where Id = ? And Claim = ?").c_str());
+      m_Release.Prepare(connection, ("Update " + table + " Set Status = ?1, VisibleAt = ?2, Claim = Case ?1 When 0 Then Null Else Claim End"
+        " Where Id = ?3 And Claim = ?4").c_str());
+
+      Statement count(connection, ("Select Count(*) From " + table + " Where Status = 0").c_str());
+      m_Ready = count.Step() ? count.GetInt64() : 0;
+
+      m_NextExpiry = m_Expiry.Step() && m_Expiry.GetType() != SQLiteType::Null ? m_Expiry.GetInt64() : Never;
+      m_Expiry.Reset();
+    }
+
+    void Enqueue(std::span<std::string_view const> const payloads)
+    {
+      {
+        std::lock_guard lock(m_Mutex);
+        SQLiteTransaction<ThreadingPolicy> transaction(*m_Connection, SQLiteTransactionType::Immediate);
+
+        int64_t const now = Now();
+
+        for (std::string_view const payload : payloads)
+        {
+          m_Enqueue.Bind(1, now);
+          m_Enqueue.Bind(2, Bytes(payload));
+          Run(m_Enqueue);
+        }
+
+        transaction.Commit();
+        m_Ready += static_cast<int64_t>(payloads.size());
+      }
+
+      m_Condition.notify_all();
+    }
+
+    void Enqueue(std::string_view const payload)
+    {
+      Enqueue(std::span(&payload, 1));
+    }
+
+    // Leases up to count jobs, oldest first, in one transaction. Returns immediately.
+    std::vector<Job> ClaimBatch(int32_t const count, std::chrono::milliseconds const lease)
+    {
+      std::lock_guard lock(m_Mutex);
+      return InternalClaim(count, lease);
+    }
+
+    // Sleeps until jobs are enqueued in this process, a lease expires, or the timeout elapses.
+    std::vector<Job> WaitClaimBatch(int32_t const count, std::chrono::milliseconds const lease, std::chrono::milliseconds const timeout)
+    {
+      auto const deadline = std::chrono::steady_clock::now() + timeout;
+      std::unique_lock lock(m_Mutex);
+
+      while (true)
+      {
+        if (m_Ready > 0 || Now() >= m_NextExpiry)
+        {
+          if (std::vector<Job> jobs = InternalClaim(count, lease); !jobs.empty())
+          {
+            return jobs;
+          }
+        }
+
+        auto wake = deadline;
+
+        if (m_NextExpiry != Never)
+        {
+          wake = std::min(wake, std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max<int64_t>(m_NextExpiry - Now(), 0)));
+        }
+
+        if (m_Condition.wait_until(lock, wake) == std::cv_status::timeout && std::chrono::steady_clock::now() >= deadline)
+        {
+          return InternalClaim(count, lease);
+        }
+      }
+    }
+
+    // Deletes the jobs in one transaction. Jobs whose lease was lost to another worker are left alone.
+    void Ack(std::span<Job const> const jobs)
+    {
+      std::lock_guard lock(m_Mutex);
+
+      InternalForEach(jobs, m_Ack, [this](Job const& job)
+        {
+          m_Ack.BindAll(job.Id, job.Claim);
+        });
+    }
+
+    // Makes the jobs visible again after the delay, without waiting for their lease to expire.
+    void Release(std::span<Job const> const jobs, std::chrono::milliseconds const delay = {})
+    {
+      {
+        std::lock_guard lock(m_Mutex);
+        int64_t const visibleAt = Now() + delay.count();
+
+        // A delayed job stays leased until then, so that claims do not pick it up early.
+        int32_t const status = delay.count() > 0 ? 1 : 0;
+
+        InternalForEach(jobs, m_Release, [&](Job const& job)
+          {
+            m_Release.BindAll(status, visibleAt, job.Id, job.Claim);
+          });
+
+        if (delay.count() > 0)
+        {
+          m_NextExpiry = std::min(m_NextExpiry, visibleAt);
+        }
+        else
+        {
+          m_Ready += static_cast<int64_t>(jobs.size());
+        }
+      }
+
+      m_Condition.notify_all();
+    }
+
+    int64_t ReadyCount() const
+    {
+      std::lock_guard lock(m_Mutex);
+      return m_Ready;
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::mt19937_64 m_Random;
+    int64_t m_Ready = 0;
+    int64_t m_NextExpiry = Never;
+
+    Statement m_Enqueue;
+    Statement m_Requeue;
+    Statement m_Claim;
+    Statement m_Claimed;
+    Statement m_Expiry;
+    Statement m_Ack;
+    Statement m_Release;
+  };
+}
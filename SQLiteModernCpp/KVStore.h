@@ -0,0 +1,325 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <type_traits>
+
+namespace ModernCppSQLite
+{
+  struct KVStoreOptions
+  {
+    std::string Table = "KeyValues";
+
+    // Writes are buffered and committed together once this many keys are pending.
+    size_t GroupCommitSize = 256;
+  };
+
+  // Key-value facade over a WITHOUT ROWID table of (Key BLOB PRIMARY KEY, Value BLOB).
+  // Keys are compared as bytes, so Scan returns them in memcmp order.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class KVStore
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    static constexpr int32_t BatchSize = 64;
+
+    // A default-constructed view has no data, which would bind NULL instead of the empty key.
+    static std::span<std::byte const> Bytes(std::string_view const value) noexcept
+    {
+      static constexpr char Empty[1] = {};
+      return std::as_bytes(std::span(value.data() ? value.data() : Empty, value.size()));
+    }
+
+    // Runs statement once and leaves it ready for the next call.
+    static void Run(Statement const& statement)
+    {
+      try
+      {
+        statement.Execute();
+      }
+      catch (...)
+      {
+        sqlite3_reset(statement.GetAbi());
+        throw;
+      }
+
+      statement.Reset();
+    }
+
+    template <typename Reader>
+    static std::string_view Text(Reader const& reader, int32_t const column) noexcept
+    {
+      return { reinterpret_cast<char const*>(reader.GetBlob(column)), static_cast<size_t>(reader.GetBlobLength(column)) };
+    }
+
+  public:
+    KVStore(KVStore const&) = delete;
+    KVStore& operator=(KVStore const&) = delete;
+
+    explicit KVStore(Connection const& connection, KVStoreOptions options = {})
+      : m_Connection(&connection)
+      , m_Options(std::move(options))
+    {
+      std::string const table = SQLiteQuoteIdentifier(m_Options.Table);
+
+      Execute(connection, ("Create Table If Not Exists " + table + " ( Key Blob Primary Key, Value Blob ) Without RowId").c_str());
+
+      m_Get.Prepare(connection, ("Select Value From " + table + " Where Key = ?").c_str());
+      m_Put.Prepare(connection, ("Insert Or Replace Into " + table + " Values (?, ?)").c_str());
+      m_Delete.Prepare(connection, ("Delete From " + table + " Where Key = ?").c_str());
+      m_ScanFrom.Prepare(connection, ("Select Key, Value From " + table + " Where Key >= ? Order By Key").c_str());
+      m_ScanRange.Prepare(connection, ("Select Key, Value From " + table + " Where Key >= ? And Key < ? Order By Key").c_str());
+
+      std::string multiGet = "Select Key, Value From " + table + " Where Key In (?";
+
+      for (int32_t index = 1; index < BatchSize; ++index)
+      {
+        multiGet += ", ?";
+      }
+
+      m_MultiGet.Prepare(connection, (multiGet + ")").c_str());
+    }
+
+    KVStore(KVStore&&) noexcept = default;
+
+    // Call Flush to observe write errors; the destructor can only drop them.
+    ~KVStore() noexcept
+    {
+      try
+      {
+        Flush();
+      }
+      catch (SQLiteException const&)
+      {
+      }
+    }
+
+    std::optional<std::string> Get(std::string_view const key) const
+    {
+      if (auto const pending = m_Pending.find(key); pending != m_Pending.end())
+      {
+        return pending->second;
+      }
+
+      std::optional<std::string> result;
+      m_Get.Bind(1, Bytes(key));
+
+      try
+      {
+        if (m_Get.Step())
+        {
+          result.emplace(Text(m_Get, 0));
+        }
+      }
+      catch (...)
+      {
+        sqlite3_reset(m_Get.GetAbi());
+        throw;
+      }
+
+      m_Get.Reset();
+      return result;
+    }
+
+    // One statement execution per BatchSize keys; duplicate keys are allowed.
+    std::vector<std::optional<std::string>> MultiGet(std::span<std::string_view const> const keys) const
+    {
+      std::vector<std::optional<std::string>> results(keys.size());
+      std::unordered_map<std::string_view, size_t> positions;
+      std::vector<size_t> batch;
+
+      auto const query = [&]
+        {
+          for (int32_t index = 0; index < BatchSize; ++index)
+          {
+            m_MultiGet.Bind(index + 1, Bytes(keys[batch[std::min<size_t>(index, batch.size() - 1)]]));
+          }
+
+          try
+          {
+            while (m_MultiGet.Step())
+            {
+              if (auto const position = positions.find(Text(m_MultiGet, 0)); position != positions.end())
+              {
+                results[position->second].emplace(Text(m_MultiGet, 1));
+              }
+            }
+          }
+          catch (...)
+          {
+            sqlite3_reset(m_MultiGet.GetAbi());
+            throw;
+          }
+
+          m_MultiGet.Reset();
+
+          for (size_t const index : batch)
+          {
+            if (size_t const first = positions[keys[index]]; first != index)
+            {
+              results[index] = results[first];
+            }
+          }
+
+          positions.clear();
+          batch.clear();
+        };
+
+      for (size_t index = 0; index < keys.size(); ++index)
+      {
+        if (auto const pending = m_Pending.find(keys[index]); pending != m_Pending.end())
+        {
+          results[index] = pending->second;
+          continue;
+        }
+
+        positions.try_emplace(keys[index], index);
+        batch.push_back(index);
+
+        if (batch.size() == BatchSize)
+        {
+          query();
+        }
+      }
+
+      if (!batch.empty())
+      {
+        query();
+      }
+
+      return results;
+    }
+
+    void Put(std::string_view const key, std::string_view const value)
+    {
+      m_Pending.insert_or_assign(std::string(key), std::string(value));
+      FlushIfFull();
+    }
+
+    void Delete(std::string_view const key)
+    {
+      m_Pending.insert_or_assign(std::string(key), std::nullopt);
+      FlushIfFull();
+    }
+
+    void MultiPut(std::span<std::pair<std::string_view, std::string_view> const> const items)
+    {
+      for (auto const& [key, value] : items)
+      {
+        m_Pending.insert_or_assign(std::string(key), std::string(value));
+      }
+
+      FlushIfFull();
+    }
+
+    // Visits keys in [first, last) in order; an empty last means no upper bound.
+    // The callback may return false to stop early, or throw.
+    template <typename F>
+    void Scan(std::string_view const first, std::string_view const last, F&& callback)
+    {
+      Flush();
+
+      Statement const& statement = last.empty() ? m_ScanFrom : m_ScanRange;
+      statement.Bind(1, Bytes(first));
+
+      if (!last.empty())
+      {
+        statement.Bind(2, Bytes(last));
+      }
+
+      try
+      {
+        while (statement.Step())
+        {
+          if constexpr (std::is_same_v<std::invoke_result_t<F&, std::string_view, std::string_view>, bool>)
+          {
+            if (!callback(Text(statement, 0), Text(statement, 1)))
+            {
+              break;
+            }
+          }
+          else
+          {
+            callback(Text(statement, 0), Text(statement, 1));
+          }
+        }
+      }
+      catch (...)
+      {
+        sqlite3_reset(statement.GetAbi());
+        throw;
+      }
+
+      statement.Reset();
+    }
+
+    // Writes every pending key in one transaction, or in the caller's transaction if one is open.
+    void Flush()
+    {
+      if (m_Pending.empty())
+      {
+        return;
+      }
+
+      std::optional<SQLiteTransaction<ThreadingPolicy>> transaction;
+
+      if (sqlite3_get_autocommit(m_Connection->GetAbi()))
+      {
+        transaction.emplace(*m_Connection, SQLiteTransactionType::Immediate);
+      }
+
+      for (auto const& [key, value] : m_Pending)
+      {
+        if (value)
+        {
+          m_Put.Bind(1, Bytes(key));
+          m_Put.Bind(2, Bytes(*value));
+          Run(m_Put);
+        }
+        else
+        {
+          m_Delete.Bind(1, Bytes(key));
+          Run(m_Delete);
+        }
+      }
+
+      if (transaction)
+      {
+        transaction->Commit();
+      }
+
+      m_Pending.clear();
+    }
+
+    size_t PendingCount() const noexcept
+    {
+      return m_Pending.size();
+    }
+
+  private:
+    void FlushIfFull()
+    {
+      if (m_Pending.size() >= m_Options.GroupCommitSize)
+      {
+        Flush();
+      }
+    }
+
+    Connection const* m_Connection = nullptr;
+    KVStoreOptions m_Options;
+    std::map<std::string, std::optional<std::string>, std::less<>> m_Pending;
+
+    Statement m_Get;
+    Statement m_Put;
+    Statement m_Delete;
+    Statement m_MultiGet;
+    Statement m_ScanFrom;
+    Statement m_ScanRange;
+  };
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct KeysetPagerOptions
+  {
+    int32_t PageSize = 1000;
+    bool Descending = false;
+  };
+
+  // Pages through the result of a query in key order. Each page continues after the key of the
+  // last row of the previous one, so it costs the same however deep the scan is, and no statement
+  // is left open between pages to hold a read transaction.
+  //
+  //   KeysetPager pager(connection, "Select Id, Name From Users Where Active", { "Id" });
+  //   while (pager.NextPage([](SQLiteRow const& row) { ... }));
+  //
+  // The keys must be columns of the query, not null, and unique together; a row added or
+  // changed behind the last key between pages is not seen.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class KeysetPager
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    struct Key
+    {
+      int32_t Column = 0;
+      SQLiteType Type = SQLiteType::Null;
+      sqlite3_int64 Integer = 0;
+      double Float = 0;
+      std::string Bytes;
+    };
+
+    void Save(Statement const& statement)
+    {
+      for (Key& key : m_Saved)
+      {
+        key.Type = statement.GetType(key.Column);
+
+        switch (key.Type)
+        {
+          case SQLiteType::Integer: key.Integer = statement.GetInt64(key.Column); break;
+          case SQLiteType::Float: key.Float = statement.GetDouble(key.Column); break;
+          case SQLiteType::Text: key.Bytes.assign(statement.GetString(key.Column), statement.GetStringLength(key.Column)); break;
+          case SQLiteType::Blob: key.Bytes.assign(reinterpret_cast<char const*>(statement.GetBlob(key.Column)), statement.GetBlobLength(key.Column)); break;
+          default: break;
+        }
+      }
+    }
+
+    void Restore() const
+    {
+      for (int32_t index = 1; Key const& key : m_Keys)
+      {
+        switch (key.Type)
+        {
+          case SQLiteType::Integer: m_Next.Bind(index, static_cast<int64_t>(key.Integer)); break;
+          case SQLiteType::Float: m_Next.Bind(index, key.Float); break;
+          case SQLiteType::Text: m_Next.Bind(index, key.Bytes); break;
+          case SQLiteType::Blob: m_Next.Bind(index, std::as_bytes(std::span(key.Bytes.data(), key.Bytes.size()))); break;
+          default: m_Next.Bind(index, nullptr); break;
+        }
+
+        ++index;
+      }
+    }
+
+  public:
+    KeysetPager(KeysetPager const&) = delete;
+    KeysetPager& operator=(KeysetPager const&) = delete;
+
+    KeysetPager(Connection const& connection, std::string_view const query, std::vector<std::string> const& keys, KeysetPagerOptions const& options = {})
+      : m_PageSize(options.PageSize)
+    {
+      if (keys.empty() || m_PageSize <= 0)
+      {
+        throw SQLiteException(SQLITE_MISUSE, "KeysetPager: at least one key and a positive page size are required");
+      }
+
+      char const* const after = options.Descending ? " < " : " > ";
+      char const* const from = options.Descending ? " <= " : " >= ";
+      std::string order;
+      std::string condition;
+
+      // (a, b) > (?1, ?2) written as a >= ?1 And ( a > ?1 Or b > ?2 ), so an index on a still bounds the search.
+      for (size_t index = keys.size(); index-- > 0;)
+      {
+        std::string const key = SQLiteQuoteIdentifier(keys[index]);
+        std::string const parameter = "?" + std::to_string(index + 1);
+
+        condition = condition.empty()
+          ? key + after + parameter
+          : key + from + parameter + " And ( " + key + after + parameter + " Or " + condition + " )";
+
+        order = key + (options.Descending ? " Desc" : "") + (order.empty() ? "" : ", ") + order;
+      }
+
+      std::string const base = "Select * From ( " + std::string(query) + " )";
+      std::string const limit = " Order By " + order + " Limit ?" + std::to_string(keys.size() + 1);
+
+      m_First.Prepare(connection, (base + limit).c_str());
+      m_Next.Prepare(connection, (base + " Where " + condition + limit).c_str());
+
+      for (std::string const& key : keys)
+      {
+        int32_t column = 0;
+
+        while (column < m_First.GetColumnCount() && sqlite3_stricmp(m_First.GetColumnName(column).data(), key.c_str()) != 0)
+        {
+          ++column;
+        }
+
+        if (column == m_First.GetColumnCount())
+        {
+          throw SQLiteException(SQLITE_ERROR, "KeysetPager: the query has no column " + key);
+        }
+
+        m_Keys.emplace_back().Column = column;
+      }
+
+      m_Saved = m_Keys;
+    }
+
+    // Calls function with each row of the next page and returns the number of rows, which is
+    // zero once the scan is done.
+    template <typename F>
+    int32_t NextPage(F&& function)
+    {
+      if (m_Done)
+      {
+        return 0;
+      }
+
+      Statement const& statement = m_Started ? m_Next : m_First;
+      int32_t rows = 0;
+
+      if (m_Started)
+      {
+        Restore();
+      }
+
+      statement.Bind(static_cast<int32_t>(m_Keys.size() + 1), m_PageSize);
+
+      try
+      {
+        while (statement.Step())
+        {
+          function(SQLiteRow(statement.GetAbi()));
+
+          if (++rows == m_PageSize)
+          {
+            Save(statement);
+          }
+        }
+      }
+      catch (...)
+      {
+        sqlite3_reset(statement.GetAbi());
+        throw;
+      }
+
+      statement.Reset();
+
+      // The continuation statement binds the keys without copying them, so they are only replaced once it is reset.
+      std::swap(m_Keys, m_Saved);
+      m_Started = true;
+      m_Done = rows < m_PageSize;
+      return rows;
+    }
+
+    bool Done() const noexcept
+    {
+      return m_Done;
+    }
+
+    // Starts again from the first page.
+    void Restart() noexcept
+    {
+      m_Started = false;
+      m_Done = false;
+    }
+
+  private:
+    Statement m_First;
+    Statement m_Next;
+    std::vector<Key> m_Keys;
+    std::vector<Key> m_Saved;
+    int32_t m_PageSize = 0;
+    bool m_Started = false;
+    bool m_Done = false;
+  };
+}
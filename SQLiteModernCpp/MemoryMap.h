@@ -0,0 +1,215 @@
+#pragma once
+
+#include "VfsShim.h"
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define SQLITE_MODERN_CPP_MADVISE 1
+#endif
+
+namespace ModernCppSQLite
+{
+  enum class SQLiteMemoryAdvice
+  {
+    Normal,     // Leave the kernel read-ahead heuristics alone.
+    Random,     // Point lookups: disable read-ahead on the mapping.
+    Sequential, // Scans: aggressive read-ahead and prefetch of the whole mapping.
+  };
+
+  struct SQLiteMemoryMapOptions
+  {
+    sqlite3_int64 Size = 256ll * 1024 * 1024;
+    SQLiteMemoryAdvice Advice = SQLiteMemoryAdvice::Normal;
+    int32_t Flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  };
+
+  struct SQLiteMemoryMapStatistics
+  {
+    sqlite3_int64 MappedReads = 0; // Pages served directly from the mapping (xFetch).
+    sqlite3_int64 FileReads = 0;   // Pages copied through the file (pread/ReadFile).
+    sqlite3_int64 AdvisedBytes = 0;
+  };
+
+  // Custom file control understood by the main database file of a memory mapped connection.
+  inline constexpr int32_t SQLiteMemoryMapStatisticsControl = 0x4D4D4150;
+
+  struct SQLiteMemoryMapFile : SQLiteShimFile
+  {
+    SQLiteMemoryMapStatistics Statistics;
+    sqlite3_int64 Limit;
+    void const* AdvisedRegion;
+  };
+
+  class SQLiteMemoryMapVfs : public SQLiteVfsShim<SQLiteMemoryMapVfs, SQLiteMemoryMapFile>
+  {
+  private:
+    using Base = SQLiteVfsShim<SQLiteMemoryMapVfs, SQLiteMemoryMapFile>;
+
+    static char const* Name(SQLiteMemoryAdvice const advice) noexcept
+    {
+      switch (advice)
+      {
+        case SQLiteMemoryAdvice::Random: return "mmap-random";
+        case SQLiteMemoryAdvice::Sequential: return "mmap-sequential";
+        default: return "mmap-normal";
+      }
+    }
+
+    static bool IsMainDatabase(SQLiteMemoryMapFile const& file) noexcept
+    {
+      return (file.Flags & SQLITE_OPEN_MAIN_DB) != 0;
+    }
+
+    void Advise(SQLiteMemoryMapFile& file, void const* const region) const noexcept
+    {
+      sqlite3_int64 size = 0;
+
+      if (SQLITE_OK != file.Real->pMethods->xFileSize(file.Real, &size))
+      {
+        return;
+      }
+
+      if (file.Limit >= 0 && size > file.Limit)
+      {
+        size = file.Limit;
+      }
+
+      file.AdvisedRegion = region;
+
+#ifdef SQLITE_MODERN_CPP_MADVISE
+      void* const address = const_cast<void*>(region);
+
+      switch (m_Advice)
+      {
+        case SQLiteMemoryAdvice::Random:
+          ::madvise(address, static_cast<size_t>(size), MADV_RANDOM);
+          break;
+
+        case SQLiteMemoryAdvice::Sequential:
+          ::madvise(address, static_cast<size_t>(size), MADV_SEQUENTIAL);
+          ::madvise(address, static_cast<size_t>(size), MADV_WILLNEED);
+          break;
+
+        default:
+          return;
+      }
+
+      file.Statistics.AdvisedBytes += size;
+#endif
+    }
+
+  public:
+    explicit SQLiteMemoryMapVfs(SQLiteMemoryAdvice const advice)
+      : Base(Name(advice))
+      , m_Advice(advice)
+    {
+    }
+
+    // One shim is registered per advice policy, on first use, for the lifetime of the process.
+    static SQLiteMemoryMapVfs& Get(SQLiteMemoryAdvice const advice)
+    {
+      switch (advice)
+      {
+        case SQLiteMemoryAdvice::Random:
+        {
+          static SQLiteMemoryMapVfs vfs(SQLiteMemoryAdvice::Random);
+          return vfs;
+        }
+        case SQLiteMemoryAdvice::Sequential:
+        {
+          static SQLiteMemoryMapVfs vfs(SQLiteMemoryAdvice::Sequential);
+          return vfs;
+        }
+        default:
+        {
+          static SQLiteMemoryMapVfs vfs(SQLiteMemoryAdvice::Normal);
+          return vfs;
+        }
+      }
+    }
+
+    SQLiteMemoryAdvice GetAdvice() const noexcept
+    {
+      return m_Advice;
+    }
+
+    void Opened(SQLiteMemoryMapFile& file, char const* const) noexcept
+    {
+      file.Limit = -1;
+    }
+
+    int32_t Read(SQLiteMemoryMapFile& file, void* const buffer, int32_t const amount, sqlite3_int64 const offset)
+    {
+      // Smaller reads are the pager peeking at the file header when a transaction starts.
+      if (IsMainDatabase(file) && amount >= 512)
+      {
+        ++file.Statistics.FileReads;
+      }
+
+      return Base::Read(file, buffer, amount, offset);
+    }
+
+    int32_t Fetch(SQLiteMemoryMapFile& file, sqlite3_int64 const offset, int32_t const amount, void** const page)
+    {
+      int32_t const result = Base::Fetch(file, offset, amount, page);
+
+      if (result == SQLITE_OK && *page && IsMainDatabase(file))
+      {
+        ++file.Statistics.MappedReads;
+
+        // SQLite maps the file as a single region starting at offset zero and
+        // remaps it as the file grows, so a new base address means a new mapping.
+        void const* const region = static_cast<char const*>(*page) - offset;
+
+        if (region != file.AdvisedRegion)
+        {
+          Advise(file, region);
+        }
+      }
+
+      return result;
+    }
+
+    int32_t FileControl(SQLiteMemoryMapFile& file, int32_t const operation, void* const argument)
+    {
+      if (operation == SQLiteMemoryMapStatisticsControl)
+      {
+        *static_cast<SQLiteMemoryMapStatistics*>(argument) = file.Statistics;
+        return SQLITE_OK;
+      }
+
+      // The argument is overwritten with the previous limit on the way out.
+      sqlite3_int64 const limit = operation == SQLITE_FCNTL_MMAP_SIZE ? *static_cast<sqlite3_int64*>(argument) : -1;
+      int32_t const result = Base::FileControl(file, operation, argument);
+
+      if (operation == SQLITE_FCNTL_MMAP_SIZE && result == SQLITE_OK && limit >= 0)
+      {
+        file.Limit = limit;
+        file.AdvisedRegion = nullptr;
+      }
+
+      return result;
+    }
+
+  private:
+    SQLiteMemoryAdvice m_Advice = SQLiteMemoryAdvice::Normal;
+  };
+
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  inline BasicSQLiteConnection<ThreadingPolicy> OpenMemoryMapped(char const* const filename, SQLiteMemoryMapOptions const& options = {})
+  {
+    BasicSQLiteConnection<ThreadingPolicy> connection;
+    connection.Open(filename, options.Flags, SQLiteMemoryMapVfs::Get(options.Advice).GetName());
+    connection.SetMemoryMapSize(options.Size);
+    return connection;
+  }
+
+  // Returns zeros for connections that were not opened through OpenMemoryMapped.
+  template <typename ThreadingPolicy>
+  inline SQLiteMemoryMapStatistics GetMemoryMapStatistics(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const database = "main") noexcept
+  {
+    SQLiteMemoryMapStatistics statistics;
+    sqlite3_file_control(connection.GetAbi(), database, SQLiteMemoryMapStatisticsControl, &statistics);
+    return statistics;
+  }
+}
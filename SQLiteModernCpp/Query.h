@@ -0,0 +1,434 @@
+#pragma once
+
+#include "Schema.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ModernCppSQLite
+{
+  // A term of a query renders its SQL and lists the types of the placeholders it contains, in
+  // order. A placeholder without a type of its own takes the Hint its context gives it.
+  template <typename Type>
+  concept SQLiteQueryTerm = requires(SQLiteConstexprText& sql)
+  {
+    Type::Render(sql);
+    typename Type::template Parameters<int64_t>;
+  };
+
+  // An expression also has the type of its value, which is void for an untyped placeholder.
+  template <typename Type>
+  concept SQLiteExpression = SQLiteQueryTerm<Type> && requires { typename Type::Value; };
+
+  // A column of an SQLiteTable, qualified by the table's name.
+  template <typename Table, SQLiteFixedString Name>
+  struct SQLiteField
+  {
+    static constexpr size_t Index = []
+    {
+      size_t index = 0;
+      size_t found = std::tuple_size_v<typename Table::ColumnList>;
+
+      std::apply([&](auto ... columns)
+        {
+          ((decltype(columns)::ColumnName == Name.View() ? found = index : 0, ++index), ...);
+        }, typename Table::ColumnList());
+
+      return found;
+    }();
+
+    static_assert(Index < std::tuple_size_v<typename Table::ColumnList>, "SQLiteField: the table has no column of this name");
+
+    using Value = typename std::tuple_element_t<Index, typename Table::ColumnList>::Type;
+
+    template <typename Hint>
+    using Parameters = std::tuple<>;
+
+    static constexpr bool Compound = false;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      sql.Quote(Table::TableName) << ".";
+      sql.Quote(Name.View());
+    }
+  };
+
+  template <typename Type, typename Hint>
+  struct SQLiteParameterType
+  {
+    using Value = std::conditional_t<std::is_void_v<Type>, typename SQLiteNullable<Hint>::Value, Type>;
+    static_assert(!std::is_void_v<Value>, "SQLiteParameter: the type cannot be inferred here, use Parameter<Type>");
+  };
+
+  // A placeholder. Without a type, it is bound as the value it is compared with.
+  template <typename Type = void>
+  struct SQLiteParameter
+  {
+    using Value = Type;
+
+    template <typename Hint>
+    using Parameters = std::tuple<typename SQLiteParameterType<Type, Hint>::Value>;
+
+    static constexpr bool Compound = false;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      sql << "?";
+    }
+  };
+
+  template <typename Type = void>
+  inline constexpr SQLiteParameter<Type> Parameter{ };
+
+  // An integer written into the SQL text.
+  template <auto Constant>
+  struct SQLiteLiteral
+  {
+    static_assert(std::is_integral_v<decltype(Constant)>, "SQLiteLiteral: only integers are written into the text");
+
+    using Value = decltype(Constant);
+
+    template <typename Hint>
+    using Parameters = std::tuple<>;
+
+    static constexpr bool Compound = false;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      char digits[24]{ };
+      size_t size = 0;
+      auto value = Constant;
+
+      do
+      {
+        int32_t const digit = static_cast<int32_t>(value % 10);
+        digits[size++] = static_cast<char>('0' + (digit < 0 ? -digit : digit));
+        value /= 10;
+      } while (value != 0);
+
+      if (Constant < 0)
+      {
+        sql << "-";
+      }
+
+      while (size != 0)
+      {
+        sql << std::string_view(&digits[--size], 1);
+      }
+    }
+  };
+
+  template <auto Constant>
+  inline constexpr SQLiteLiteral<Constant> Literal{ };
+
+  template <SQLiteExpression Operand>
+  constexpr void SQLiteRenderOperand(SQLiteConstexprText& sql)
+  {
+    if constexpr (Operand::Compound)
+    {
+      sql << "( ";
+      Operand::Render(sql);
+      sql << " )";
+    }
+    else
+    {
+      Operand::Render(sql);
+    }
+  }
+
+  // Left Operator Right. A predicate is a boolean; otherwise the value has the left operand's
+  // type. Each operand gives an untyped placeholder on the other side its type.
+  template <SQLiteFixedString Operator, bool Predicate, SQLiteExpression Left, SQLiteExpression Right>
+  struct SQLiteBinary
+  {
+    using Value = std::conditional_t<Predicate, bool, std::conditional_t<std::is_void_v<typename Left::Value>, typename Right::Value, typename Left::Value>>;
+
+    template <typename Hint>
+    using Parameters = decltype(std::tuple_cat(
+      std::declval<typename Left::template Parameters<std::conditional_t<std::is_void_v<typename Right::Value>, Hint, typename Right::Value>>>(),
+      std::declval<typename Right::template Parameters<std::conditional_t<std::is_void_v<typename Left::Value>, Hint, typename Left::Value>>>()));
+
+    static constexpr bool Compound = true;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      SQLiteRenderOperand<Left>(sql);
+      sql << " " << Operator.View() << " ";
+      SQLiteRenderOperand<Right>(sql);
+    }
+  };
+
+  template <SQLiteExpression Operand>
+  struct SQLiteNot
+  {
+    using Value = bool;
+
+    template <typename Hint>
+    using Parameters = typename Operand::template Parameters<bool>;
+
+    static constexpr bool Compound = true;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      sql << "Not ";
+      SQLiteRenderOperand<Operand>(sql);
+    }
+  };
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"=", true, Left, Right> operator==(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"<>", true, Left, Right> operator!=(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"<", true, Left, Right> operator<(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"<=", true, Left, Right> operator<=(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<">", true, Left, Right> operator>(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<">=", true, Left, Right> operator>=(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"And", true, Left, Right> operator&&(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"Or", true, Left, Right> operator||(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Operand>
+  constexpr SQLiteNot<Operand> operator!(Operand) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"+", false, Left, Right> operator+(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"-", false, Left, Right> operator-(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"*", false, Left, Right> operator*(Left, Right) noexcept { return { }; }
+
+  template <SQLiteExpression Left, SQLiteExpression Right>
+  constexpr SQLiteBinary<"/", false, Left, Right> operator/(Left, Right) noexcept { return { }; }
+
+  // A term of Order By.
+  template <SQLiteExpression Expression, bool Descending>
+  struct SQLiteOrdering
+  {
+    template <typename Hint>
+    using Parameters = typename Expression::template Parameters<typename Expression::Value>;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      SQLiteRenderOperand<Expression>(sql);
+      sql << (Descending ? " Desc" : " Asc");
+    }
+  };
+
+  template <SQLiteExpression Expression>
+  constexpr SQLiteOrdering<Expression, false> Ascending(Expression) noexcept { return { }; }
+
+  template <SQLiteExpression Expression>
+  constexpr SQLiteOrdering<Expression, true> Descending(Expression) noexcept { return { }; }
+
+  template <typename Table, SQLiteExpression Condition>
+  struct SQLiteJoin
+  {
+    template <typename Hint>
+    using Parameters = typename Condition::template Parameters<bool>;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      sql << " Inner Join ";
+      sql.Quote(Table::TableName) << " On ";
+      Condition::Render(sql);
+    }
+  };
+
+  // The terms of a query that has none.
+  struct SQLiteNoTerm
+  {
+    template <typename Hint>
+    using Parameters = std::tuple<>;
+  };
+
+  // A select whose shape is known at compile time, built by Select and the methods below:
+  //
+  //   constexpr auto query = Select(Id, Amount).From<Orders>()
+  //     .Where(Amount > Parameter<> && Customer == Parameter<>)
+  //     .OrderBy(Descending(Amount))
+  //     .Limit(Parameter<int64_t>);
+  //
+  //   SQLiteStatement statement(connection, query.Sql.data());
+  //   query.Bind(statement, 10.0, "Ada", 5);
+  //
+  //   for (SQLiteRow const& row : statement)
+  //   {
+  //     auto const [id, amount] = query.Read(row);
+  //   }
+  //
+  // Sql is rendered once into a string with static storage, so it can also key a statement cache.
+  // Placeholders are numbered in the order they appear; Parameters lists their types, inferred
+  // from the column each is compared with, and Row the types of the selected columns.
+  template <typename Fields, typename Source = void, typename Joins = std::tuple<>, typename Filter = SQLiteNoTerm, typename Orderings = std::tuple<>, typename Count = SQLiteNoTerm>
+  struct SQLiteQuery;
+
+  template <SQLiteExpression ... Fields, typename Source, SQLiteQueryTerm ... Joins, typename Filter, SQLiteQueryTerm ... Orderings, typename Count>
+  struct SQLiteQuery<std::tuple<Fields ...>, Source, std::tuple<Joins ...>, Filter, std::tuple<Orderings ...>, Count>
+  {
+    using Row = std::tuple<typename Fields::Value ...>;
+    using Parameters = decltype(std::tuple_cat(
+      std::declval<typename Fields::template Parameters<void>>() ...,
+      std::declval<typename Joins::template Parameters<bool>>() ...,
+      std::declval<typename Filter::template Parameters<bool>>(),
+      std::declval<typename Orderings::template Parameters<void>>() ...,
+      std::declval<typename Count::template Parameters<int64_t>>()));
+
+    static constexpr int32_t ParameterCount = std::tuple_size_v<Parameters>;
+
+    static constexpr void Render(SQLiteConstexprText& sql)
+    {
+      sql << "Select ";
+      bool first = true;
+      ((sql << (first ? "" : ", "), SQLiteRenderOperand<Fields>(sql), first = false), ...);
+
+      if constexpr (!std::is_void_v<Source>)
+      {
+        sql << " From ";
+        sql.Quote(Source::TableName);
+      }
+
+      (Joins::Render(sql), ...);
+
+      if constexpr (!std::is_same_v<Filter, SQLiteNoTerm>)
+      {
+        sql << " Where ";
+        Filter::Render(sql);
+      }
+
+      if constexpr (sizeof...(Orderings) != 0)
+      {
+        sql << " Order By ";
+        first = true;
+        ((sql << (first ? "" : ", "), Orderings::Render(sql), first = false), ...);
+      }
+
+      if constexpr (!std::is_same_v<Count, SQLiteNoTerm>)
+      {
+        sql << " Limit ";
+        Count::Render(sql);
+      }
+    }
+
+    static constexpr std::string_view Sql = SQLiteStaticText<&SQLiteQuery::Render>::View;
+
+    template <typename Table>
+    constexpr SQLiteQuery<std::tuple<Fields ...>, Table, std::tuple<Joins ...>, Filter, std::tuple<Orderings ...>, Count> From() const noexcept
+    {
+      static_assert(std::is_void_v<Source>, "SQLiteQuery: From is already given");
+      return { };
+    }
+
+    template <typename Table, SQLiteExpression Condition>
+    constexpr SQLiteQuery<std::tuple<Fields ...>, Source, std::tuple<Joins ..., SQLiteJoin<Table, Condition>>, Filter, std::tuple<Orderings ...>, Count> Join(Condition) const noexcept
+    {
+      static_assert(!std::is_void_v<Source>, "SQLiteQuery: Join needs From");
+      return { };
+    }
+
+    // Combine conditions with && and || rather than calling Where twice.
+    template <SQLiteExpression Condition>
+    constexpr SQLiteQuery<std::tuple<Fields ...>, Source, std::tuple<Joins ...>, Condition, std::tuple<Orderings ...>, Count> Where(Condition) const noexcept
+    {
+      static_assert(std::is_same_v<Filter, SQLiteNoTerm>, "SQLiteQuery: Where is already given");
+      return { };
+    }
+
+    // Terms are expressions, which sort ascending, or Ascending and Descending of one.
+    template <SQLiteQueryTerm ... Terms>
+    constexpr SQLiteQuery<std::tuple<Fields ...>, Source, std::tuple<Joins ...>, Filter, std::tuple<Orderings ..., Terms ...>, Count> OrderBy(Terms ...) const noexcept
+    {
+      return { };
+    }
+
+    template <SQLiteExpression Expression>
+    constexpr SQLiteQuery<std::tuple<Fields ...>, Source, std::tuple<Joins ...>, Filter, std::tuple<Orderings ...>, Expression> Limit(Expression) const noexcept
+    {
+      static_assert(std::is_same_v<Count, SQLiteNoTerm>, "SQLiteQuery: Limit is already given");
+      return { };
+    }
+
+    // Binds arguments, converted to the types in Parameters, to the placeholders in order. As with
+    // Bind, text passed as a std::string lvalue or a character pointer and blobs are bound in
+    // place and must outlive the step; text that has to be converted is copied.
+    template <typename Statement, typename ... Arguments>
+    static void Bind(Statement const& statement, Arguments&& ... arguments)
+    {
+      static_assert(sizeof...(Arguments) == ParameterCount, "SQLiteQuery: Bind takes one argument per placeholder");
+
+      [&]<size_t ... Index>(std::index_sequence<Index ...>)
+      {
+        (BindArgument<std::tuple_element_t<Index, Parameters>>(statement, static_cast<int32_t>(Index + 1), std::forward<Arguments>(arguments)), ...);
+      }(std::index_sequence_for<Arguments ...>());
+    }
+
+    template <typename Reader>
+    static Row Read(Reader const& reader)
+    {
+      return [&]<size_t ... Index>(std::index_sequence<Index ...>)
+      {
+        return Row(SQLiteReadValue<std::tuple_element_t<Index, Row>>(reader, static_cast<int32_t>(Index)) ...);
+      }(std::index_sequence_for<Fields ...>());
+    }
+
+  private:
+    template <typename Parameter, typename Statement, typename Argument>
+    static void BindArgument(Statement const& statement, int32_t const index, Argument&& argument)
+    {
+      if constexpr (std::is_lvalue_reference_v<Argument> && std::is_same_v<std::remove_cvref_t<Argument>, Parameter>)
+      {
+        SQLiteBindValue(statement, index, argument);
+      }
+      else if constexpr (SQLiteNullable<Parameter>::value)
+      {
+        Parameter value(std::forward<Argument>(argument));
+
+        if (value)
+        {
+          BindArgument<typename SQLiteNullable<Parameter>::Value>(statement, index, std::move(*value));
+        }
+        else
+        {
+          statement.Bind(index, nullptr);
+        }
+      }
+      else if constexpr (std::is_same_v<Parameter, std::string> && std::is_convertible_v<Argument, char const*>)
+      {
+        statement.Bind(index, static_cast<char const*>(argument));
+      }
+      else if constexpr (std::is_same_v<Parameter, std::string>)
+      {
+        statement.Bind(index, std::string(std::forward<Argument>(argument)));
+      }
+      else if constexpr (std::is_same_v<Parameter, std::vector<std::byte>>)
+      {
+        static_assert(std::is_lvalue_reference_v<Argument>, "SQLiteQuery: blobs are bound in place, pass one that outlives the step");
+        statement.Bind(index, std::span<std::byte const>(argument));
+      }
+      else
+      {
+        SQLiteBindValue(statement, index, static_cast<Parameter>(std::forward<Argument>(argument)));
+      }
+    }
+  };
+
+  template <SQLiteExpression ... Fields>
+  constexpr SQLiteQuery<std::tuple<Fields ...>> Select(Fields ...) noexcept
+  {
+    return { };
+  }
+}
@@ -0,0 +1,1188 @@
+#pragma once
+
+#include "ConnectionPool.h"
+
+// Linux only: results are shared through memfd_create and passed with SCM_RIGHTS.
+#ifdef __linux__
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <thread>
+#include <variant>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ModernCppSQLite
+{
+  // A query server lets the processes of one host share a database, its connections and their
+  // page caches over a Unix domain socket.
+  //
+  // Every message is a frame: a 4-byte payload size, a 4-byte request number chosen by the client
+  // and echoed in the responses, a 1-byte type, then the payload. Numbers are in host byte order,
+  // since both ends are on one host. Values are a 1-byte tag, the QueryValue index, followed by
+  // 8 bytes for integers and reals, or a 4-byte size and the bytes for text and blobs.
+  //
+  //   Prepare   text                      -> Handle  4-byte statement handle
+  //   Execute   handle, 2-byte count,     -> Columns 2-byte count, names
+  //             values                       Rows    rows of values, zero or more
+  //                                          Shared  8-byte size, with a memfd of more rows
+  //                                          Done    8-byte changes
+  //   Finalize  handle                    -> Done
+  //
+  // Any request can be answered with Error, a 4-byte code and the message, instead, including
+  // after some rows. Requests are answered in order, so a client can send several before
+  // reading the responses.
+  enum class QueryFrame : uint8_t
+  {
+    Prepare = 'P',
+    Execute = 'X',
+    Finalize = 'F',
+    Handle = 'H',
+    Columns = 'C',
+    Rows = 'R',
+    Shared = 'M',
+    Done = 'D',
+    Error = 'E',
+  };
+
+  using QueryValue = std::variant<std::nullptr_t, int64_t, double, std::string, std::vector<std::byte>>;
+
+  struct QueryServerOptions
+  {
+    ConnectionPoolOptions Pool;
+
+    // Rows are sent in frames of about this many bytes.
+    size_t FrameBytes = 64 * 1024;
+
+    // Once a result has sent this many bytes, the rest is written to one shared memory buffer
+    // that the client maps instead of reading through the socket. Zero sends every row in frames.
+    size_t SharedBytes = 1024 * 1024;
+
+    // Permissions of the socket file. Clients whose process runs as another user are refused.
+    mode_t SocketMode = 0600;
+    uid_t AllowedUser = ::geteuid();
+  };
+
+  class QueryProtocol
+  {
+  public:
+    static constexpr size_t HeaderSize = 9;
+    static constexpr uint32_t MaximumFrame = 64 * 1024 * 1024;
+
+    struct Header
+    {
+      uint32_t Size = 0;
+      uint32_t Request = 0;
+      QueryFrame Type = QueryFrame::Error;
+    };
+
+    class Writer
+    {
+    public:
+      template <typename Type>
+      void Put(Type const value)
+      {
+        std::byte bytes[sizeof(Type)];
+        std::memcpy(bytes, &value, sizeof(Type));
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + sizeof(Type));
+      }
+
+      void PutBytes(void const* const data, size_t const size)
+      {
+        Put(static_cast<uint32_t>(size));
+        m_Bytes.insert(m_Bytes.end(), static_cast<std::byte const*>(data), static_cast<std::byte const*>(data) + size);
+      }
+
+      void PutValue(QueryValue const& value)
+      {
+        Put(static_cast<uint8_t>(value.index()));
+
+        switch (value.index())
+        {
+          case 1: Put(std::get<int64_t>(value)); break;
+          case 2: Put(std::get<double>(value)); break;
+          case 3: PutBytes(std::get<std::string>(value).data(), std::get<std::string>(value).size()); break;
+          case 4: PutBytes(std::get<std::vector<std::byte>>(value).data(), std::get<std::vector<std::byte>>(value).size()); break;
+        }
+      }
+
+      // Appends column of the current row of reader as a value, without building a QueryValue.
+      template <typename Reader>
+      void PutColumn(Reader const& reader, int32_t const column)
+      {
+        switch (reader.GetType(column))
+        {
+          case SQLiteType::Integer: Put(uint8_t{ 1 }); Put(static_cast<int64_t>(reader.GetInt64(column))); break;
+          case SQLiteType::Float: Put(uint8_t{ 2 }); Put(reader.GetDouble(column)); break;
+          case SQLiteType::Text:
+          {
+            char const* const text = reader.GetString(column);
+            Put(uint8_t{ 3 });
+            PutBytes(text, static_cast<size_t>(reader.GetStringLength(column)));
+            break;
+          }
+          case SQLiteType::Blob:
+          {
+            std::byte const* const blob = reader.GetBlob(column);
+            Put(uint8_t{ 4 });
+            PutBytes(blob, static_cast<size_t>(reader.GetBlobLength(column)));
+            break;
+          }
+          default: Put(uint8_t{ 0 }); break;
+        }
+      }
+
+      std::vector<std::byte>& Bytes() noexcept
+      {
+        return m_Bytes;
+      }
+
+    private:
+      std::vector<std::byte> m_Bytes;
+    };
+
+    class Reader
+    {
+    public:
+      explicit Reader(std::span<std::byte const> const bytes) noexcept
+        : m_Bytes(bytes)
+      {
+      }
+
+      template <typename Type>
+      Type Get()
+      {
+        Type value;
+        std::memcpy(&value, Take(sizeof(Type)).data(), sizeof(Type));
+        return value;
+      }
+
+      std::span<std::byte const> GetBytes()
+      {
+        return Take(Get<uint32_t>());
+      }
+
+      std::string GetString()
+      {
+        std::span<std::byte const> const bytes = GetBytes();
+        return std::string(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+      }
+
+      QueryValue GetValue()
+      {
+        switch (Get<uint8_t>())
+        {
+          case 0: return nullptr;
+          case 1: return Get<int64_t>();
+          case 2: return Get<double>();
+          case 3: return GetString();
+          case 4:
+          {
+            std::span<std::byte const> const bytes = GetBytes();
+            return std::vector<std::byte>(bytes.begin(), bytes.end());
+          }
+        }
+
+        throw SQLiteException(SQLITE_PROTOCOL, "queryserver: unknown value type");
+      }
+
+      bool Empty() const noexcept
+      {
+        return m_Bytes.empty();
+      }
+
+    private:
+      std::span<std::byte const> Take(size_t const size)
+      {
+        if (size > m_Bytes.size())
+        {
+          throw SQLiteException(SQLITE_PROTOCOL, "queryserver: truncated frame");
+        }
+
+        std::span<std::byte const> const taken = m_Bytes.first(size);
+        m_Bytes = m_Bytes.subspan(size);
+        return taken;
+      }
+
+      std::span<std::byte const> m_Bytes;
+    };
+
+    // Sends a frame, and passes descriptor along with it unless it is negative.
+    static bool Send(int32_t const socket, QueryFrame const type, uint32_t const request, std::span<std::byte const> const payload, int32_t const descriptor = -1) noexcept
+    {
+      std::byte header[HeaderSize];
+      uint32_t const size = static_cast<uint32_t>(payload.size());
+      std::memcpy(header, &size, 4);
+      std::memcpy(header + 4, &request, 4);
+      header[8] = static_cast<std::byte>(type);
+
+      iovec parts[2] = { { header, HeaderSize }, { const_cast<std::byte*>(payload.data()), payload.size() } };
+      msghdr message{ };
+      message.msg_iov = parts;
+      message.msg_iovlen = 2;
+
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int32_t))]{ };
+
+      if (descriptor >= 0)
+      {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* const rights = CMSG_FIRSTHDR(&message);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(sizeof(int32_t));
+        std::memcpy(CMSG_DATA(rights), &descriptor, sizeof(int32_t));
+      }
+
+      size_t remaining = HeaderSize + payload.size();
+
+      while (remaining != 0)
+      {
+        ssize_t const sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+
+        if (sent < 0 && errno == EINTR)
+        {
+          continue;
+        }
+
+        if (sent <= 0)
+        {
+          return false;
+        }
+
+        remaining -= static_cast<size_t>(sent);
+        message.msg_control = nullptr;
+        message.msg_controllen = 0;
+
+        for (size_t skip = static_cast<size_t>(sent); skip != 0 && message.msg_iovlen != 0;)
+        {
+          size_t const part = std::min(skip, message.msg_iov->iov_len);
+          message.msg_iov->iov_base = static_cast<std::byte*>(message.msg_iov->iov_base) + part;
+          message.msg_iov->iov_len -= part;
+          skip -= part;
+
+          if (message.msg_iov->iov_len == 0)
+          {
+            ++message.msg_iov;
+            --message.msg_iovlen;
+          }
+        }
+      }
+
+      return true;
+    }
+
+    // Reads exactly size bytes, and a descriptor passed with them into descriptor if it is not null.
+    // Returns false if the peer closed the socket before the first byte.
+    static bool Receive(int32_t const socket, void* const data, size_t const size, int32_t* const descriptor = nullptr)
+    {
+      size_t received = 0;
+
+      while (received < size)
+      {
+        iovec part{ static_cast<std::byte*>(data) + received, size - received };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int32_t))]{ };
+        msghdr message{ };
+        message.msg_iov = &part;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t const count = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+
+        if (count < 0 && errno == EINTR)
+        {
+          continue;
+        }
+
+        if (count <= 0)
+        {
+          if (received == 0 && count == 0)
+          {
+            return false;
+          }
+
+          throw SQLiteException(SQLITE_IOERR, "queryserver: connection lost");
+        }
+
+        for (cmsghdr* rights = CMSG_FIRSTHDR(&message); rights; rights = CMSG_NXTHDR(&message, rights))
+        {
+          if (rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS)
+          {
+            int32_t passed = -1;
+            std::memcpy(&passed, CMSG_DATA(rights), sizeof(int32_t));
+
+            if (descriptor && *descriptor < 0)
+            {
+              *descriptor = passed;
+            }
+            else
+            {
+              ::close(passed);
+            }
+          }
+        }
+
+        received += static_cast<size_t>(count);
+      }
+
+      return true;
+    }
+
+    static bool ReceiveFrame(int32_t const socket, Header& header, std::vector<std::byte>& payload, int32_t* const descriptor = nullptr)
+    {
+      std::byte bytes[HeaderSize];
+
+      if (!Receive(socket, bytes, HeaderSize, descriptor))
+      {
+        return false;
+      }
+
+      std::memcpy(&header.Size, bytes, 4);
+      std::memcpy(&header.Request, bytes + 4, 4);
+      header.Type = static_cast<QueryFrame>(bytes[8]);
+
+      if (header.Size > MaximumFrame)
+      {
+        throw SQLiteException(SQLITE_PROTOCOL, "queryserver: frame too large");
+      }
+
+      payload.resize(header.Size);
+
+      if (header.Size != 0 && !Receive(socket, payload.data(), header.Size))
+      {
+        throw SQLiteException(SQLITE_IOERR, "queryserver: connection lost");
+      }
+
+      return true;
+    }
+
+    static sockaddr_un Address(std::string const& path)
+    {
+      sockaddr_un address{ };
+      address.sun_family = AF_UNIX;
+
+      if (path.size() >= sizeof(address.sun_path))
+      {
+        throw SQLiteException(SQLITE_CANTOPEN, "queryserver: socket path too long: " + path);
+      }
+
+      std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+      return address;
+    }
+  };
+
+  // Serves queries on a database through a SQLiteConnectionPool to the clients of a Unix domain
+  // socket, one thread per client. Statement handles belong to the client that prepared them;
+  // each request leases a connection and reuses the statement it cached for the same text. The
+  // requests between Begin and Commit all run on the connection that began the transaction.
+  // Clients cannot attach other files or change pragmas of the pooled connections.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class QueryServer
+  {
+  private:
+    using Pool = SQLiteConnectionPool<ThreadingPolicy>;
+
+    struct Session
+    {
+      int32_t Socket = -1;
+      std::thread Thread;
+      std::atomic<bool> Finished = false;
+    };
+
+    // Collects the rows of one result into frames, and past SharedBytes into a memfd.
+    class RowSink
+    {
+    public:
+      RowSink(int32_t const socket, uint32_t const request, QueryServerOptions const& options) noexcept
+        : m_Socket(socket)
+        , m_Request(request)
+        , m_Options(options)
+      {
+      }
+
+      RowSink(RowSink const&) = delete;
+      RowSink& operator=(RowSink const&) = delete;
+
+      ~RowSink() noexcept
+      {
+        if (m_Shared >= 0)
+        {
+          ::close(m_Shared);
+        }
+      }
+
+      QueryProtocol::Writer& Rows() noexcept
+      {
+        return m_Rows;
+      }
+
+      bool Flush(bool const last)
+      {
+        std::vector<std::byte>& bytes = m_Rows.Bytes();
+
+        if (!last && bytes.size() < m_Options.FrameBytes)
+        {
+          return true;
+        }
+
+#ifdef __linux__
+        if (m_Shared < 0 && m_Options.SharedBytes != 0 && m_Sent + bytes.size() > m_Options.SharedBytes && !last)
+        {
+          m_Shared = ::memfd_create("sqlite-query-result", MFD_CLOEXEC);
+        }
+#endif
+
+        if (m_Shared >= 0)
+        {
+          for (size_t written = 0; written < bytes.size();)
+          {
+            ssize_t const count = ::write(m_Shared, bytes.data() + written, bytes.size() - written);
+
+            if (count < 0 && errno == EINTR)
+            {
+              continue;
+            }
+
+            if (count <= 0)
+            {
+              throw SQLiteException(SQLITE_IOERR_WRITE, "queryserver: cannot write a shared result");
+            }
+
+            written += static_cast<size_t>(count);
+          }
+
+          m_SharedSize += bytes.size();
+          bytes.clear();
+
+          if (last)
+          {
+            QueryProtocol::Writer size;
+            size.Put(static_cast<uint64_t>(m_SharedSize));
+            return QueryProtocol::Send(m_Socket, QueryFrame::Shared, m_Request, size.Bytes(), m_Shared);
+          }
+
+          return true;
+        }
+
+        if (bytes.empty())
+        {
+          return true;
+        }
+
+        m_Sent += bytes.size();
+        bool const sent = QueryProtocol::Send(m_Socket, QueryFrame::Rows, m_Request, bytes);
+        bytes.clear();
+        return sent;
+      }
+
+    private:
+      int32_t m_Socket;
+      uint32_t m_Request;
+      QueryServerOptions const& m_Options;
+      QueryProtocol::Writer m_Rows;
+      size_t m_Sent = 0;
+      int32_t m_Shared = -1;
+      size_t m_SharedSize = 0;
+    };
+
+    static int Authorize(void*, int const action, char const* const name, char const* const value, char const*, char const*) noexcept
+    {
+      // Pragmas that take an argument only to read about it.
+      static constexpr char const* reading[] =
+      {
+        "table_info", "table_xinfo", "table_list", "index_info", "index_xinfo", "index_list", "foreign_key_list", "foreign_key_check", "integrity_check", "quick_check",
+      };
+
+      switch (action)
+      {
+        case SQLITE_ATTACH: case SQLITE_DETACH:
+          return SQLITE_DENY;
+
+        case SQLITE_PRAGMA:
+        {
+          if (sqlite3_stricmp(name, "optimize") == 0 || sqlite3_stricmp(name, "incremental_vacuum") == 0)
+          {
+            return SQLITE_DENY;
+          }
+
+          bool const reads = std::any_of(std::begin(reading), std::end(reading), [&](char const* const pragma) { return sqlite3_stricmp(name, pragma) == 0; });
+          return value && !reads ? SQLITE_DENY : SQLITE_OK;
+        }
+
+        default:
+          return SQLITE_OK;
+      }
+    }
+
+    static bool SendError(int32_t const socket, uint32_t const request, int32_t const code, std::string_view const message)
+    {
+      QueryProtocol::Writer error;
+      error.Put(code);
+      error.PutBytes(message.data(), message.size());
+      return QueryProtocol::Send(socket, QueryFrame::Error, request, error.Bytes());
+    }
+
+    bool Execute(typename Pool::Lease& lease, int32_t const socket, uint32_t const request, std::string const& sql, QueryProtocol::Reader& payload)
+    {
+      std::vector<QueryValue> parameters(payload.Get<uint16_t>());
+
+      for (QueryValue& parameter : parameters)
+      {
+        parameter = payload.GetValue();
+      }
+
+      auto& statement = lease.Prepare(sql);
+
+      try
+      {
+        for (int32_t index = 1; QueryValue const& parameter : parameters)
+        {
+          switch (parameter.index())
+          {
+            case 0: statement.Bind(index, nullptr); break;
+            case 1: statement.Bind(index, std::get<int64_t>(parameter)); break;
+            case 2: statement.Bind(index, std::get<double>(parameter)); break;
+            case 3: statement.Bind(index, std::get<std::string>(parameter)); break;
+            case 4: statement.Bind(index, std::span<std::byte const>(std::get<std::vector<std::byte>>(parameter))); break;
+          }
+
+          ++index;
+        }
+
+        int32_t const count = statement.GetColumnCount();
+        QueryProtocol::Writer columns;
+        columns.Put(static_cast<uint16_t>(count));
+
+        for (int32_t column = 0; column < count; ++column)
+        {
+          std::string_view const name = statement.GetColumnName(column);
+          columns.PutBytes(name.data(), name.size());
+        }
+
+        // sqlite3_changes keeps the count of the connection's last insert, update or delete.
+        auto const total = lease.GetConnection().TotalChanges();
+        bool connected = QueryProtocol::Send(socket, QueryFrame::Columns, request, columns.Bytes());
+        RowSink sink(socket, request, m_Options);
+
+        while (connected && statement.Step())
+        {
+          for (int32_t column = 0; column < count; ++column)
+          {
+            sink.Rows().PutColumn(statement, column);
+          }
+
+          connected = sink.Flush(false);
+        }
+
+        connected = connected && sink.Flush(true);
+        int64_t const changes = lease.GetConnection().TotalChanges() != total ? sqlite3_changes(lease.GetConnection().GetAbi()) : 0;
+        sqlite3_reset(statement.GetAbi());
+        sqlite3_clear_bindings(statement.GetAbi());
+
+        QueryProtocol::Writer done;
+        done.Put(changes);
+        return connected && QueryProtocol::Send(socket, QueryFrame::Done, request, done.Bytes());
+      }
+      catch (...)
+      {
+        sqlite3_reset(statement.GetAbi());
+        sqlite3_clear_bindings(statement.GetAbi());
+        throw;
+      }
+    }
+
+    // A session keeps its connection while a transaction it began is open, and returns it to the
+    // pool, which rolls the transaction back, when the client goes away.
+    void Serve(Session& session)
+    {
+      std::unordered_map<uint32_t, std::string> statements;
+      uint32_t nextHandle = 1;
+      QueryProtocol::Header header;
+      std::vector<std::byte> payload;
+      std::optional<typename Pool::Lease> held;
+
+      auto const lease = [&]
+        {
+          if (held)
+          {
+            typename Pool::Lease leased = std::move(*held);
+            held.reset();
+            return leased;
+          }
+
+          return m_Pool.Acquire();
+        };
+
+      auto const keep = [&](typename Pool::Lease& leased)
+        {
+          if (!sqlite3_get_autocommit(leased.GetConnection().GetAbi()))
+          {
+            held.emplace(std::move(leased));
+          }
+        };
+
+      try
+      {
+        while (QueryProtocol::ReceiveFrame(session.Socket, header, payload))
+        {
+          bool connected = true;
+
+          try
+          {
+            QueryProtocol::Reader reader(payload);
+
+            switch (header.Type)
+            {
+              case QueryFrame::Prepare:
+              {
+                std::string sql(reinterpret_cast<char const*>(payload.data()), payload.size());
+                typename Pool::Lease leased = lease();
+
+                try
+                {
+                  leased.Prepare(sql);
+                }
+                catch (...)
+                {
+                  keep(leased);
+                  throw;
+                }
+
+                keep(leased);
+
+                uint32_t const handle = nextHandle++;
+                statements.emplace(handle, std::move(sql));
+
+                QueryProtocol::Writer response;
+                response.Put(handle);
+                connected = QueryProtocol::Send(session.Socket, QueryFrame::Handle, header.Request, response.Bytes());
+                break;
+              }
+              case QueryFrame::Execute:
+              {
+                auto const found = statements.find(reader.Get<uint32_t>());
+
+                if (found == statements.end())
+                {
+                  throw SQLiteException(SQLITE_MISUSE, "queryserver: unknown statement handle");
+                }
+
+                typename Pool::Lease leased = lease();
+
+                try
+                {
+                  connected = Execute(leased, session.Socket, header.Request, found->second, reader);
+                }
+                catch (...)
+                {
+                  keep(leased);
+                  throw;
+                }
+
+                keep(leased);
+                break;
+              }
+              case QueryFrame::Finalize:
+              {
+                statements.erase(reader.Get<uint32_t>());
+
+                QueryProtocol::Writer response;
+                response.Put(int64_t{ 0 });
+                connected = QueryProtocol::Send(session.Socket, QueryFrame::Done, header.Request, response.Bytes());
+                break;
+              }
+              default:
+                throw SQLiteException(SQLITE_PROTOCOL, "queryserver: unknown request");
+            }
+          }
+          catch (SQLiteException const& ex)
+          {
+            connected = SendError(session.Socket, header.Request, ex.ErrorCode, ex.ErrorMessage);
+          }
+
+          if (!connected)
+          {
+            break;
+          }
+        }
+      }
+      catch (SQLiteException const&)
+      {
+        // The client went away in the middle of a frame.
+      }
+
+      session.Finished = true;
+    }
+
+    // Closes the sessions whose client went away. Called with m_Mutex held.
+    void Reap()
+    {
+      for (auto session = m_Sessions.begin(); session != m_Sessions.end();)
+      {
+        if (session->Finished)
+        {
+          session->Thread.join();
+          ::close(session->Socket);
+          session = m_Sessions.erase(session);
+        }
+        else
+        {
+          ++session;
+        }
+      }
+    }
+
+    void Accept()
+    {
+      while (true)
+      {
+        int32_t const client = ::accept4(m_Listener, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (client < 0)
+        {
+          if (errno == EINTR || errno == ECONNABORTED)
+          {
+            continue;
+          }
+
+          // Out of descriptors or memory until some client disconnects.
+          if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+          {
+            {
+              std::lock_guard lock(m_Mutex);
+              Reap();
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+          }
+
+          return;
+        }
+
+        ucred peer{ };
+        socklen_t size = sizeof(peer);
+
+        if (::getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &size) != 0 || peer.uid != m_Options.AllowedUser)
+        {
+          SendError(client, 0, SQLITE_AUTH, "queryserver: user not allowed");
+          ::close(client);
+          continue;
+        }
+
+        std::lock_guard lock(m_Mutex);
+
+        if (m_Stopping)
+        {
+          ::close(client);
+          return;
+        }
+
+        Reap();
+
+        Session& session = m_Sessions.emplace_back();
+        session.Socket = client;
+        session.Thread = std::thread([this, &session] { Serve(session); });
+      }
+    }
+
+  public:
+    QueryServer(QueryServer const&) = delete;
+    QueryServer& operator=(QueryServer const&) = delete;
+
+    // Listens on path, replacing a socket file left there, and serves until Stop.
+    QueryServer(char const* const database, std::string path, QueryServerOptions const& options = {})
+      : m_Pool(database, options.Pool)
+      , m_Options(options)
+      , m_Path(std::move(path))
+    {
+      {
+        std::vector<typename Pool::Lease> leases;
+
+        for (int32_t index = 0; index < m_Pool.Size(); ++index)
+        {
+          leases.push_back(m_Pool.Acquire());
+          sqlite3_set_authorizer(leases.back().GetConnection().GetAbi(), Authorize, nullptr);
+        }
+      }
+
+      sockaddr_un const address = QueryProtocol::Address(m_Path);
+      m_Listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      ::unlink(m_Path.c_str());
+
+      // Nobody can connect before listen, so the mode is in place for the first client.
+      if (m_Listener < 0 || ::bind(m_Listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 ||
+        ::chmod(m_Path.c_str(), m_Options.SocketMode) != 0 || ::listen(m_Listener, SOMAXCONN) != 0)
+      {
+        std::string const error = std::strerror(errno);
+
+        if (m_Listener >= 0)
+        {
+          ::close(m_Listener);
+        }
+
+        throw SQLiteException(SQLITE_CANTOPEN, "queryserver: cannot listen on " + m_Path + ": " + error);
+      }
+
+      m_Acceptor = std::thread([this] { Accept(); });
+    }
+
+    ~QueryServer() noexcept
+    {
+      Stop();
+    }
+
+    // Stops accepting, disconnects every client and waits for their requests to finish.
+    void Stop() noexcept
+    {
+      {
+        std::lock_guard lock(m_Mutex);
+
+        if (m_Stopping)
+        {
+          return;
+        }
+
+        m_Stopping = true;
+        ::shutdown(m_Listener, SHUT_RDWR);
+
+        for (Session& session : m_Sessions)
+        {
+          ::shutdown(session.Socket, SHUT_RDWR);
+        }
+      }
+
+      m_Acceptor.join();
+      ::close(m_Listener);
+      ::unlink(m_Path.c_str());
+
+      for (Session& session : m_Sessions)
+      {
+        session.Thread.join();
+        ::close(session.Socket);
+      }
+
+      m_Sessions.clear();
+    }
+
+    Pool& GetPool() noexcept
+    {
+      return m_Pool;
+    }
+
+    std::string const& GetPath() const noexcept
+    {
+      return m_Path;
+    }
+
+  private:
+    Pool m_Pool;
+    QueryServerOptions m_Options;
+    std::string m_Path;
+    int32_t m_Listener = -1;
+    std::thread m_Acceptor;
+
+    std::mutex m_Mutex;
+    bool m_Stopping = false;
+    std::list<Session> m_Sessions;
+  };
+
+  struct QueryResult
+  {
+    std::vector<std::string> Columns;
+
+    // Row by row.
+    std::vector<QueryValue> Values;
+    int64_t Changes = 0;
+
+    // Whether some rows came through shared memory.
+    bool Shared = false;
+
+    size_t RowCount() const noexcept
+    {
+      return Columns.empty() ? 0 : Values.size() / Columns.size();
+    }
+
+    QueryValue const& At(size_t const row, size_t const column) const noexcept
+    {
+      return Values[row * Columns.size() + column];
+    }
+  };
+
+  // One connection to a QueryServer. Not thread safe; use one per thread.
+  class QueryClient
+  {
+  private:
+    // Queued requests are written while the unanswered ones fit in this many bytes, which the
+    // socket buffers without the server reading any. The client then never blocks writing while
+    // the server blocks writing a response to it.
+    static constexpr size_t Window = 64 * 1024;
+
+    void Queue(QueryFrame const type, std::span<std::byte const> const payload)
+    {
+      std::byte header[QueryProtocol::HeaderSize];
+      uint32_t const size = static_cast<uint32_t>(payload.size());
+      uint32_t const request = m_NextRequest++;
+      std::memcpy(header, &size, 4);
+      std::memcpy(header + 4, &request, 4);
+      header[8] = static_cast<std::byte>(type);
+
+      m_Queued.insert(m_Queued.end(), header, header + QueryProtocol::HeaderSize);
+      m_Queued.insert(m_Queued.end(), payload.begin(), payload.end());
+      m_Requests.push_back(QueryProtocol::HeaderSize + payload.size());
+    }
+
+    // Writes the queued requests that fit in the window, and always at least one if none is unanswered.
+    void Flush()
+    {
+      size_t size = 0;
+
+      for (; m_Sent < m_Requests.size() && (m_Unanswered == 0 || m_Unanswered + m_Requests[m_Sent] <= Window); ++m_Sent)
+      {
+        m_Unanswered += m_Requests[m_Sent];
+        size += m_Requests[m_Sent];
+      }
+
+      for (size_t const end = m_Written + size; m_Written < end;)
+      {
+        ssize_t const count = ::send(m_Socket, m_Queued.data() + m_Written, end - m_Written, MSG_NOSIGNAL);
+
+        if (count < 0 && errno == EINTR)
+        {
+          continue;
+        }
+
+        if (count <= 0)
+        {
+          throw SQLiteException(SQLITE_IOERR, "queryclient: connection lost");
+        }
+
+        m_Written += static_cast<size_t>(count);
+      }
+
+      if (m_Written == m_Queued.size())
+      {
+        m_Queued.clear();
+        m_Written = 0;
+      }
+    }
+
+    // The oldest request has its last response.
+    void Answered() noexcept
+    {
+      m_Unanswered -= m_Requests.front();
+      m_Requests.pop_front();
+      --m_Sent;
+    }
+
+    // Reads the next response frame, throwing its error if it is one.
+    QueryFrame Next(std::vector<std::byte>& payload, int32_t* const descriptor = nullptr)
+    {
+      QueryProtocol::Header header;
+
+      if (!QueryProtocol::ReceiveFrame(m_Socket, header, payload, descriptor))
+      {
+        throw SQLiteException(SQLITE_IOERR, "queryclient: connection lost");
+      }
+
+      if (header.Type == QueryFrame::Error)
+      {
+        Answered();
+        QueryProtocol::Reader reader(payload);
+        int32_t const code = reader.Get<int32_t>();
+        throw SQLiteException(code, reader.GetString());
+      }
+
+      return header.Type;
+    }
+
+    static void ReadRows(QueryProtocol::Reader& reader, QueryResult& result)
+    {
+      while (!reader.Empty())
+      {
+        result.Values.push_back(reader.GetValue());
+      }
+    }
+
+  public:
+    QueryClient(QueryClient const&) = delete;
+    QueryClient& operator=(QueryClient const&) = delete;
+
+    explicit QueryClient(std::string const& path)
+    {
+      sockaddr_un const address = QueryProtocol::Address(path);
+      m_Socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+      if (m_Socket < 0 || ::connect(m_Socket, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0)
+      {
+        std::string const error = std::strerror(errno);
+
+        if (m_Socket >= 0)
+        {
+          ::close(m_Socket);
+        }
+
+        throw SQLiteException(SQLITE_CANTOPEN, "queryclient: cannot connect to " + path + ": " + error);
+      }
+    }
+
+    ~QueryClient() noexcept
+    {
+      ::close(m_Socket);
+    }
+
+    // Returns a handle for Send and Execute. Receive the results of earlier Sends first.
+    uint32_t Prepare(std::string_view const sql)
+    {
+      if (!m_Requests.empty())
+      {
+        throw SQLiteException(SQLITE_MISUSE, "queryclient: receive the pending results before preparing");
+      }
+
+      Queue(QueryFrame::Prepare, std::as_bytes(std::span(sql.data(), sql.size())));
+      Flush();
+
+      std::vector<std::byte> payload;
+      Next(payload);
+      Answered();
+      return QueryProtocol::Reader(payload).Get<uint32_t>();
+    }
+
+    // Queues an execution without waiting for it. Queued requests are written on the next
+    // Receives, and each Receive returns the next result in the order they were sent.
+    void Send(uint32_t const statement, std::span<QueryValue const> const parameters = {})
+    {
+      QueryProtocol::Writer request;
+      request.Put(statement);
+      request.Put(static_cast<uint16_t>(parameters.size()));
+
+      for (QueryValue const& parameter : parameters)
+      {
+        request.PutValue(parameter);
+      }
+
+      Queue(QueryFrame::Execute, request.Bytes());
+    }
+
+    QueryResult Receive()
+    {
+      if (m_Requests.empty())
+      {
+        throw SQLiteException(SQLITE_MISUSE, "queryclient: nothing was sent");
+      }
+
+      Flush();
+
+      QueryResult result;
+      std::vector<std::byte> payload;
+
+      while (true)
+      {
+        int32_t descriptor = -1;
+        QueryFrame const type = Next(payload, &descriptor);
+        QueryProtocol::Reader reader(payload);
+
+        if (type == QueryFrame::Columns)
+        {
+          result.Columns.resize(reader.Get<uint16_t>());
+
+          for (std::string& column : result.Columns)
+          {
+            column = reader.GetString();
+          }
+        }
+        else if (type == QueryFrame::Rows)
+        {
+          ReadRows(reader, result);
+        }
+        else if (type == QueryFrame::Shared)
+        {
+          size_t const size = static_cast<size_t>(reader.Get<uint64_t>());
+
+          if (descriptor < 0)
+          {
+            throw SQLiteException(SQLITE_PROTOCOL, "queryclient: shared result without a descriptor");
+          }
+
+          void* const data = size ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0) : nullptr;
+          ::close(descriptor);
+
+          if (data == MAP_FAILED)
+          {
+            throw SQLiteException(SQLITE_IOERR_MMAP, "queryclient: cannot map a shared result");
+          }
+
+          try
+          {
+            QueryProtocol::Reader rows(std::span(static_cast<std::byte const*>(data), size));
+            ReadRows(rows, result);
+          }
+          catch (...)
+          {
+            ::munmap(data, size);
+            throw;
+          }
+
+          if (data)
+          {
+            ::munmap(data, size);
+          }
+
+          result.Shared = true;
+        }
+        else if (type == QueryFrame::Done)
+        {
+          result.Changes = reader.Get<int64_t>();
+          Answered();
+          return result;
+        }
+        else
+        {
+          throw SQLiteException(SQLITE_PROTOCOL, "queryclient: unexpected response");
+        }
+      }
+    }
+
+    QueryResult Execute(uint32_t const statement, std::span<QueryValue const> const parameters = {})
+    {
+      Send(statement, parameters);
+      return Receive();
+    }
+
+    // Releases a handle. Receive the results of earlier Sends first.
+    void Finalize(uint32_t const statement)
+    {
+      if (!m_Requests.empty())
+      {
+        throw SQLiteException(SQLITE_MISUSE, "queryclient: receive the pending results before finalizing");
+      }
+
+      QueryProtocol::Writer request;
+      request.Put(statement);
+      Queue(QueryFrame::Finalize, request.Bytes());
+      Receive();
+    }
+
+  private:
+    int32_t m_Socket = -1;
+    uint32_t m_NextRequest = 1;
+
+    // The queued bytes, of which the first m_Written are written, and the size of each request
+    // not answered yet, of which the first m_Sent are written and add up to m_Unanswered.
+    std::vector<std::byte> m_Queued;
+    size_t m_Written = 0;
+    std::deque<size_t> m_Requests;
+    size_t m_Sent = 0;
+    size_t m_Unanswered = 0;
+  };
+}
+
+#endif
@@ -0,0 +1,785 @@
+#pragma once
+
+#include "VirtualTable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ModernCppSQLite
+{
+  // A whole file mapped read-only.
+  class SQLiteMappedFile
+  {
+  public:
+    explicit SQLiteMappedFile(std::string const& path)
+    {
+#ifdef _WIN32
+      m_File = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      LARGE_INTEGER size{ };
+
+      if (m_File == INVALID_HANDLE_VALUE || !::GetFileSizeEx(m_File, &size))
+      {
+        Close();
+        throw SQLiteException(SQLITE_CANTOPEN, "recordfile: cannot open " + path);
+      }
+
+      m_Size = static_cast<size_t>(size.QuadPart);
+
+      if (m_Size != 0)
+      {
+        m_Mapping = ::CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_Data = m_Mapping ? static_cast<std::byte const*>(::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+      }
+#else
+      m_File = ::open(path.c_str(), O_RDONLY);
+      struct stat status{ };
+
+      if (m_File < 0 || ::fstat(m_File, &status) != 0)
+      {
+        Close();
+        throw SQLiteException(SQLITE_CANTOPEN, "recordfile: cannot open " + path);
+      }
+
+      m_Size = static_cast<size_t>(status.st_size);
+
+      if (m_Size != 0)
+      {
+        void* const data = ::mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, m_File, 0);
+        m_Data = data == MAP_FAILED ? nullptr : static_cast<std::byte const*>(data);
+      }
+#endif
+
+      if (m_Size != 0 && !m_Data)
+      {
+        Close();
+        throw SQLiteException(SQLITE_IOERR_MMAP, "recordfile: cannot map " + path);
+      }
+    }
+
+    SQLiteMappedFile(SQLiteMappedFile const&) = delete;
+    SQLiteMappedFile& operator=(SQLiteMappedFile const&) = delete;
+
+    ~SQLiteMappedFile()
+    {
+      Close();
+    }
+
+    std::byte const* Data() const noexcept
+    {
+      return m_Data;
+    }
+
+    size_t Size() const noexcept
+    {
+      return m_Size;
+    }
+
+  private:
+    void Close() noexcept
+    {
+#ifdef _WIN32
+      if (m_Data) ::UnmapViewOfFile(m_Data);
+      if (m_Mapping) ::CloseHandle(m_Mapping);
+      if (m_File != INVALID_HANDLE_VALUE) ::CloseHandle(m_File);
+      m_Mapping = nullptr;
+      m_File = INVALID_HANDLE_VALUE;
+#else
+      if (m_Data) ::munmap(const_cast<std::byte*>(m_Data), m_Size);
+      if (m_File >= 0) ::close(m_File);
+      m_File = -1;
+#endif
+      m_Data = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#else
+    int m_File = -1;
+#endif
+    std::byte const* m_Data = nullptr;
+    size_t m_Size = 0;
+  };
+
+  // Binary fields are in the machine's byte order. Text and Blob fields have a fixed length, and
+  // text loses its trailing spaces and NULs. Digits and Decimal fields are numbers written out
+  // in ASCII, as in fixed-width text files; blank ones are null.
+  enum class SQLiteRecordType
+  {
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    Float,
+    Double,
+    Text,
+    Blob,
+    Digits,
+    Decimal,
+  };
+
+  struct SQLiteRecordField
+  {
+    std::string Name;
+    SQLiteRecordType Type = SQLiteRecordType::Int64;
+    uint32_t Offset = 0;
+    uint32_t Length = 0;
+  };
+
+  template <typename T>
+  constexpr SQLiteRecordType SQLiteRecordTypeOf() noexcept
+  {
+    if constexpr (std::is_same_v<T, int8_t>) return SQLiteRecordType::Int8;
+    else if constexpr (std::is_same_v<T, int16_t>) return SQLiteRecordType::Int16;
+    else if constexpr (std::is_same_v<T, int32_t>) return SQLiteRecordType::Int32;
+    else if constexpr (std::is_same_v<T, int64_t>) return SQLiteRecordType::Int64;
+    else if constexpr (std::is_same_v<T, uint8_t>) return SQLiteRecordType::UInt8;
+    else if constexpr (std::is_same_v<T, uint16_t>) return SQLiteRecordType::UInt16;
+    else if constexpr (std::is_same_v<T, uint32_t>) return SQLiteRecordType::UInt32;
+    else if constexpr (std::is_same_v<T, float>) return SQLiteRecordType::Float;
+    else if constexpr (std::is_same_v<T, double>) return SQLiteRecordType::Double;
+    else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_extent_t<T>, char>) return SQLiteRecordType::Text;
+    else if constexpr (std::is_array_v<T> && sizeof(std::remove_extent_t<T>) == 1) return SQLiteRecordType::Blob;
+    else static_assert(std::is_void_v<T>, "record members must be integers of up to 32 bits unsigned or 64 bits signed, floating point, or byte arrays");
+  }
+
+  // Names one member of a record struct for SQLiteRecordLayout::Of.
+  template <typename Record, typename Member>
+  struct SQLiteRecordMember
+  {
+    char const* Name;
+    Member Record::* Pointer;
+  };
+
+  template <typename Record, typename Member>
+  SQLiteRecordMember(char const*, Member Record::*) -> SQLiteRecordMember<Record, Member>;
+
+  struct SQLiteRecordLayout
+  {
+    std::vector<SQLiteRecordField> Fields;
+    uint32_t RecordSize = 0;
+    uint64_t HeaderSize = 0;
+
+    // A field whose values never decrease from one record to the next, or empty.
+    std::string SortedBy;
+
+    // The layout of a file of Record structs, as this compiler lays them out:
+    //
+    //   SQLiteRecordLayout::Of<Tick>({ "Time", &Tick::Time }, { "Price", &Tick::Price })
+    template <typename Record, typename ... Members>
+    static SQLiteRecordLayout Of(SQLiteRecordMember<Record, Members> const& ... members)
+    {
+      static_assert(std::is_trivially_copyable_v<Record> && std::is_default_constructible_v<Record>);
+
+      Record const record{ };
+      SQLiteRecordLayout layout;
+      layout.RecordSize = sizeof(Record);
+
+      auto const add = [&]<typename Member>(SQLiteRecordMember<Record, Member> const& member)
+      {
+        auto const offset = reinterpret_cast<char const*>(&(record.*member.Pointer)) - reinterpret_cast<char const*>(&record);
+        layout.Fields.push_back({ member.Name, SQLiteRecordTypeOf<Member>(), static_cast<uint32_t>(offset), static_cast<uint32_t>(sizeof(Member)) });
+      };
+
+      (add(members), ...);
+      return layout;
+    }
+  };
+
+  struct SQLiteRecordFile
+  {
+    std::string Path;
+    SQLiteRecordLayout Layout;
+  };
+
+  // Queries a file of fixed-size records in place. The file and layout come either from the
+  // arguments of Create Virtual Table,
+  //
+  //   Create Virtual Table Ticks Using recordfile ( 'ticks.dat', record 24, header 0, sorted Time,
+  //     Time Int64 0, Price Double 8, Volume Int32 16, Symbol Text 20 4 )
+  //
+  // where a field is "name type offset [length]", or from the SQLiteRecordFile a table-valued
+  // module was registered with by CreateRecordFileTable. Rows are records in file order and the
+  // rowid is the record number from 1. Ranges of rowids, and of the sorted field if there is one,
+  // are found without reading the records outside them; SQLite still checks every comparison.
+  // Text and blobs are handed to SQLite straight from the mapping.
+  class RecordFileTable : public SQLiteVirtualTable
+  {
+  private:
+    enum Plan
+    {
+      RowFirst = 1,
+      RowLast = 2,
+      RowPoint = 4,
+      KeyFirst = 8,
+      KeyLast = 16,
+      KeyPoint = 32,
+    };
+
+    static std::string Unquote(std::string_view const text)
+    {
+      if (char const quote = text.empty() ? 0 : text[0] == '[' ? ']' : text[0]; text.size() >= 2 && (quote == '"' || quote == '`' || quote == ']' || quote == '\''))
+      {
+        std::string result;
+
+        for (size_t index = 1; index + 1 < text.size(); ++index)
+        {
+          result += text[index];
+          index += text[index] == quote && text[index + 1] == quote;
+        }
+
+        return result;
+      }
+
+      return std::string(text);
+    }
+
+    static std::string Upper(std::string_view const text)
+    {
+      std::string result(text);
+      std::transform(result.begin(), result.end(), result.begin(), [](char const c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+      return result;
+    }
+
+    // Splits an argument into words, keeping quoted names whole.
+    static std::vector<std::string> Words(std::string_view const text)
+    {
+      std::vector<std::string> words;
+
+      for (size_t position = 0; position < text.size();)
+      {
+        if (std::isspace(static_cast<unsigned char>(text[position])))
+        {
+          ++position;
+          continue;
+        }
+
+        size_t end = position + 1;
+
+        if (char const quote = text[position] == '[' ? ']' : text[position]; quote == '"' || quote == '`' || quote == ']' || quote == '\'')
+        {
+          while (end < text.size() && !(text[end] == quote && (end + 1 == text.size() || text[end + 1] != quote)))
+          {
+            end += text[end] == quote ? 2 : 1;
+          }
+
+          end = std::min(end + 1, text.size());
+        }
+        else
+        {
+          while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end])))
+          {
+            ++end;
+          }
+        }
+
+        words.push_back(Unquote(text.substr(position, end - position)));
+        position = end;
+      }
+
+      return words;
+    }
+
+    static uint32_t Number(std::string const& word, std::string_view const argument)
+    {
+      uint32_t value = 0;
+
+      if (auto const [end, error] = std::from_chars(word.data(), word.data() + word.size(), value); error != std::errc() || end != word.data() + word.size())
+      {
+        throw SQLiteException(SQLITE_ERROR, "recordfile: expected a number in '" + std::string(argument) + "'");
+      }
+
+      return value;
+    }
+
+    static SQLiteRecordLayout Parse(std::span<char const* const> const arguments, std::string& path)
+    {
+      SQLiteRecordLayout layout;
+      path = Unquote(arguments[3]);
+
+      struct Type { char const* Name; SQLiteRecordType Type; uint32_t Length; };
+
+      static constexpr Type types[] =
+      {
+        { "INT8", SQLiteRecordType::Int8, 1 }, { "INT16", SQLiteRecordType::Int16, 2 }, { "INT32", SQLiteRecordType::Int32, 4 }, { "INT64", SQLiteRecordType::Int64, 8 },
+        { "UINT8", SQLiteRecordType::UInt8, 1 }, { "UINT16", SQLiteRecordType::UInt16, 2 }, { "UINT32", SQLiteRecordType::UInt32, 4 },
+        { "FLOAT", SQLiteRecordType::Float, 4 }, { "DOUBLE", SQLiteRecordType::Double, 8 },
+        { "TEXT", SQLiteRecordType::Text, 0 }, { "BLOB", SQLiteRecordType::Blob, 0 }, { "DIGITS", SQLiteRecordType::Digits, 0 }, { "DECIMAL", SQLiteRecordType::Decimal, 0 },
+      };
+
+      for (char const* const argument : arguments.subspan(4))
+      {
+        std::vector<std::string> const words = Words(argument);
+        std::string const keyword = words.empty() ? std::string() : Upper(words[0]);
+
+        if (words.size() == 2 && keyword == "RECORD") layout.RecordSize = Number(words[1], argument);
+        else if (words.size() == 2 && keyword == "HEADER") layout.HeaderSize = Number(words[1], argument);
+        else if (words.size() == 2 && keyword == "SORTED") layout.SortedBy = words[1];
+        else if (words.size() == 3 || words.size() == 4)
+        {
+          auto const type = std::find_if(std::begin(types), std::end(types), [&](Type const& type) { return Upper(words[1]) == type.Name; });
+
+          if (type == std::end(types) || (type->Length == 0) != (words.size() == 4))
+          {
+            throw SQLiteException(SQLITE_ERROR, "recordfile: expected 'name type offset', with a length after the offset of Text, Blob, Digits and Decimal fields, not '" + std::string(argument) + "'");
+          }
+
+          layout.Fields.push_back({ words[0], type->Type, Number(words[2], argument), type->Length ? type->Length : Number(words[3], argument) });
+        }
+        else
+        {
+          throw SQLiteException(SQLITE_ERROR, "recordfile: cannot parse '" + std::string(argument) + "'");
+        }
+      }
+
+      if (layout.RecordSize == 0)
+      {
+        for (SQLiteRecordField const& field : layout.Fields)
+        {
+          layout.RecordSize = std::max(layout.RecordSize, field.Offset + field.Length);
+        }
+      }
+
+      return layout;
+    }
+
+    std::byte const* Record(size_t const row) const noexcept
+    {
+      return m_Records + row * m_Layout.RecordSize;
+    }
+
+    template <typename T>
+    static T Load(std::byte const* const data) noexcept
+    {
+      T value;
+      std::memcpy(&value, data, sizeof(T));
+      return value;
+    }
+
+    static std::string_view Trimmed(std::byte const* const data, uint32_t const length, bool const leading) noexcept
+    {
+      std::string_view text(reinterpret_cast<char const*>(data), length);
+
+      while (!text.empty() && (text.back() == ' ' || text.back() == '\0'))
+      {
+        text.remove_suffix(1);
+      }
+
+      while (leading && !text.empty() && text.front() == ' ')
+      {
+        text.remove_prefix(1);
+      }
+
+      return text;
+    }
+
+    template <typename T>
+    static bool Ascii(std::string_view const text, T& value) noexcept
+    {
+      if (!text.empty() && text.front() == '+')
+      {
+        return Ascii(text.substr(1), value);
+      }
+
+      auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+      return error == std::errc() && end == text.data() + text.size();
+    }
+
+    bool Numeric(SQLiteRecordField const& field) const noexcept
+    {
+      return field.Type != SQLiteRecordType::Text && field.Type != SQLiteRecordType::Blob;
+    }
+
+    // The sorted field as a double. A blank or malformed Digits or Decimal field is NULL to SQLite,
+    // which orders it before every number, so it is -infinity here.
+    double Key(size_t const row) const noexcept
+    {
+      SQLiteRecordField const& field = m_Layout.Fields[m_Sorted];
+      std::byte const* const data = Record(row) + field.Offset;
+
+      switch (field.Type)
+      {
+        case SQLiteRecordType::Int8: return Load<int8_t>(data);
+        case SQLiteRecordType::Int16: return Load<int16_t>(data);
+        case SQLiteRecordType::Int32: return Load<int32_t>(data);
+        case SQLiteRecordType::Int64: return static_cast<double>(Load<int64_t>(data));
+        case SQLiteRecordType::UInt8: return Load<uint8_t>(data);
+        case SQLiteRecordType::UInt16: return Load<uint16_t>(data);
+        case SQLiteRecordType::UInt32: return Load<uint32_t>(data);
+        case SQLiteRecordType::Float: return Load<float>(data);
+        case SQLiteRecordType::Double: return Load<double>(data);
+
+        default:
+        {
+          double value = 0;
+          return Ascii(Trimmed(data, field.Length, true), value) ? value : -std::numeric_limits<double>::infinity();
+        }
+      }
+    }
+
+    // Narrows [first, last) to the records whose sorted field may satisfy "field op value".
+    void Narrow(size_t& first, size_t& last, sqlite3_value* const value, bool const lower, bool const upper) const
+    {
+      SQLiteRecordField const& field = m_Layout.Fields[m_Sorted];
+      int32_t const type = sqlite3_value_type(value);
+      size_t const begin = first;
+      size_t const count = last - first;
+
+      // Strict comparisons are searched as if inclusive; the rows on the edge are checked by SQLite.
+      auto const search = [&](auto const& before)
+      {
+        size_t low = begin;
+        size_t high = begin + count;
+
+        while (low < high)
+        {
+          size_t const middle = low + (high - low) / 2;
+
+          if (before(middle)) low = middle + 1;
+          else high = middle;
+        }
+
+        return low;
+      };
+
+      // Nothing compares true against NULL.
+      if (type == SQLITE_NULL)
+      {
+        last = first;
+        return;
+      }
+
+      if (Numeric(field))
+      {
+        // Text that looks like a number is converted by the column's affinity, so it cannot narrow.
+        if (type != SQLITE_INTEGER && type != SQLITE_FLOAT)
+        {
+          return;
+        }
+
+        double const bound = sqlite3_value_double(value);
+
+        if (lower) first = std::max(first, search([&](size_t const row) { return Key(row) < bound; }));
+        if (upper) last = std::min(last, search([&](size_t const row) { return Key(row) <= bound; }));
+      }
+      else if ((type == SQLITE_TEXT) == (field.Type == SQLiteRecordType::Text) && type != SQLITE_INTEGER && type != SQLITE_FLOAT)
+      {
+        std::string_view const bound(static_cast<char const*>(sqlite3_value_blob(value)), sqlite3_value_bytes(value));
+        auto const text = [&](size_t const row) { return field.Type == SQLiteRecordType::Text ? Trimmed(Record(row) + field.Offset, field.Length, false) : std::string_view(reinterpret_cast<char const*>(Record(row) + field.Offset), field.Length); };
+
+        if (lower) first = std::max(first, search([&](size_t const row) { return text(row) < bound; }));
+        if (upper) last = std::min(last, search([&](size_t const row) { return text(row) <= bound; }));
+      }
+      else if (field.Type == SQLiteRecordType::Blob || type == SQLITE_BLOB)
+      {
+        // Every number sorts before every text and every text before every blob, so a bound of
+        // another storage class keeps all the records on one side of it and none on the other.
+        // A number compared with a Text field is converted to text first, and is left to SQLite.
+        bool const below = field.Type == SQLiteRecordType::Blob;
+
+        if (below ? upper : lower)
+        {
+          last = first;
+        }
+      }
+    }
+
+  public:
+    class Cursor : public SQLiteVirtualCursor
+    {
+    public:
+      explicit Cursor(RecordFileTable& table) : m_Table(table)
+      {
+      }
+
+      void Filter(int32_t const plan, char const*, std::span<sqlite3_value* const> const arguments)
+      {
+        size_t argument = 0;
+        m_Row = 0;
+        m_End = m_Table.m_Count;
+
+        auto const rowBound = [&](bool const lower)
+        {
+          sqlite3_value* const value = arguments[argument];
+
+          if (int32_t const type = sqlite3_value_type(value); type == SQLITE_INTEGER || type == SQLITE_FLOAT)
+          {
+            // Rowid r is record r - 1.
+            double const bound = lower ? std::ceil(sqlite3_value_double(value)) - 1 : std::floor(sqlite3_value_double(value));
+            size_t const row = bound <= 0 ? 0 : bound >= static_cast<double>(m_Table.m_Count) ? m_Table.m_Count : static_cast<size_t>(bound);
+
+            if (lower) m_Row = std::max(m_Row, row);
+            else m_End = std::min(m_End, row);
+          }
+        };
+
+        if (plan & RowPoint)
+        {
+          rowBound(true);
+          rowBound(false);
+          ++argument;
+        }
+
+        if (plan & RowFirst) rowBound(true), ++argument;
+        if (plan & RowLast) rowBound(false), ++argument;
+
+        m_End = std::max(m_Row, m_End);
+
+        if (plan & KeyPoint) m_Table.Narrow(m_Row, m_End, arguments[argument++], true, true);
+        if (plan & KeyFirst) m_Table.Narrow(m_Row, m_End, arguments[argument++], true, false);
+        if (plan & KeyLast) m_Table.Narrow(m_Row, m_End, arguments[argument++], false, true);
+
+        m_End = std::max(m_Row, m_End);
+      }
+
+      void Next() noexcept
+      {
+        ++m_Row;
+      }
+
+      bool Eof() const noexcept
+      {
+        return m_Row >= m_End;
+      }
+
+      void Column(sqlite3_context* const context, int32_t const column) const
+      {
+        SQLiteRecordField const& field = m_Table.m_Layout.Fields[column];
+        std::byte const* const data = m_Table.Record(m_Row) + field.Offset;
+
+        switch (field.Type)
+        {
+          case SQLiteRecordType::Int8: sqlite3_result_int64(context, Load<int8_t>(data)); break;
+          case SQLiteRecordType::Int16: sqlite3_result_int64(context, Load<int16_t>(data)); break;
+          case SQLiteRecordType::Int32: sqlite3_result_int64(context, Load<int32_t>(data)); break;
+          case SQLiteRecordType::Int64: sqlite3_result_int64(context, Load<int64_t>(data)); break;
+          case SQLiteRecordType::UInt8: sqlite3_result_int64(context, Load<uint8_t>(data)); break;
+          case SQLiteRecordType::UInt16: sqlite3_result_int64(context, Load<uint16_t>(data)); break;
+          case SQLiteRecordType::UInt32: sqlite3_result_int64(context, Load<uint32_t>(data)); break;
+          case SQLiteRecordType::Float: sqlite3_result_double(context, Load<float>(data)); break;
+          case SQLiteRecordType::Double: sqlite3_result_double(context, Load<double>(data)); break;
+          case SQLiteRecordType::Blob: sqlite3_result_blob(context, data, static_cast<int32_t>(field.Length), SQLITE_STATIC); break;
+
+          case SQLiteRecordType::Text:
+          {
+            std::string_view const text = Trimmed(data, field.Length, false);
+            sqlite3_result_text(context, text.data(), static_cast<int32_t>(text.size()), SQLITE_STATIC);
+            break;
+          }
+
+          case SQLiteRecordType::Digits:
+          {
+            if (sqlite3_int64 value = 0; Ascii(Trimmed(data, field.Length, true), value)) sqlite3_result_int64(context, value);
+            break;
+          }
+
+          default:
+          {
+            if (double value = 0; Ascii(Trimmed(data, field.Length, true), value)) sqlite3_result_double(context, value);
+            break;
+          }
+        }
+      }
+
+      sqlite3_int64 RowId() const noexcept
+      {
+        return static_cast<sqlite3_int64>(m_Row) + 1;
+      }
+
+    private:
+      RecordFileTable const& m_Table;
+      size_t m_Row = 0;
+      size_t m_End = 0;
+    };
+
+    // The context is the SQLiteRecordFile of a module registered by CreateRecordFileTable.
+    RecordFileTable(sqlite3*, void* const context, std::span<char const* const> const arguments)
+    {
+      std::string path;
+
+      if (arguments.size() > 3)
+      {
+        m_Layout = Parse(arguments, path);
+      }
+      else if (context)
+      {
+        path = static_cast<SQLiteRecordFile const*>(context)->Path;
+        m_Layout = static_cast<SQLiteRecordFile const*>(context)->Layout;
+      }
+      else
+      {
+        throw SQLiteException(SQLITE_ERROR, "recordfile: a file and its fields are required");
+      }
+
+      if (m_Layout.Fields.empty() || m_Layout.RecordSize == 0)
+      {
+        throw SQLiteException(SQLITE_ERROR, "recordfile: at least one field is required");
+      }
+
+      for (SQLiteRecordField const& field : m_Layout.Fields)
+      {
+        if (field.Length == 0 || field.Offset + field.Length > m_Layout.RecordSize)
+        {
+          throw SQLiteException(SQLITE_ERROR, "recordfile: field " + field.Name + " does not fit in a record");
+        }
+
+        if (sqlite3_stricmp(field.Name.c_str(), m_Layout.SortedBy.c_str()) == 0)
+        {
+          m_Sorted = static_cast<int32_t>(&field - m_Layout.Fields.data());
+        }
+      }
+
+      if (!m_Layout.SortedBy.empty() && m_Sorted < 0)
+      {
+        throw SQLiteException(SQLITE_ERROR, "recordfile: no field named " + m_Layout.SortedBy + " to be sorted by");
+      }
+
+      m_File = std::make_shared<SQLiteMappedFile>(path);
+
+      size_t const header = static_cast<size_t>(std::min<uint64_t>(m_Layout.HeaderSize, m_File->Size()));
+      m_Records = m_File->Data() + header;
+      m_Count = (m_File->Size() - header) / m_Layout.RecordSize;
+    }
+
+    std::string Declaration() const
+    {
+      std::string columns;
+
+      for (SQLiteRecordField const& field : m_Layout.Fields)
+      {
+        char const* type = "Integer";
+
+        switch (field.Type)
+        {
+          case SQLiteRecordType::Float: case SQLiteRecordType::Double: case SQLiteRecordType::Decimal: type = "Real"; break;
+          case SQLiteRecordType::Text: type = "Text"; break;
+          case SQLiteRecordType::Blob: type = "Blob"; break;
+          default: break;
+        }
+
+        columns += (columns.empty() ? "" : ", ") + SQLiteQuoteIdentifier(field.Name) + " " + type;
+      }
+
+      return "Create Table x ( " + columns + " )";
+    }
+
+    void BestIndex(sqlite3_index_info& info) const
+    {
+      // Constraint indexes by plan bit, in the order Filter reads the arguments.
+      int32_t chosen[6] = { -1, -1, -1, -1, -1, -1 };
+
+      for (int32_t index = 0; index < info.nConstraint; ++index)
+      {
+        sqlite3_index_info::sqlite3_index_constraint const& constraint = info.aConstraint[index];
+        bool const row = constraint.iColumn < 0;
+
+        if (!constraint.usable || (!row && constraint.iColumn != m_Sorted))
+        {
+          continue;
+        }
+
+        // Text keys are in memcmp order, so only binary comparisons can narrow them.
+        if (!row && !Numeric(m_Layout.Fields[m_Sorted]))
+        {
+#if SQLITE_VERSION_NUMBER >= 3022000
+          if (char const* const collation = sqlite3_vtab_collation(&info, index); collation && sqlite3_stricmp(collation, "BINARY") != 0)
+          {
+            continue;
+          }
+#else
+          continue;
+#endif
+        }
+
+        int32_t const base = row ? 0 : 3;
+
+        switch (constraint.op)
+        {
+          case SQLITE_INDEX_CONSTRAINT_EQ: chosen[base + 2] = index; break;
+          case SQLITE_INDEX_CONSTRAINT_GT: case SQLITE_INDEX_CONSTRAINT_GE: chosen[base] = index; break;
+          case SQLITE_INDEX_CONSTRAINT_LT: case SQLITE_INDEX_CONSTRAINT_LE: chosen[base + 1] = index; break;
+          default: break;
+        }
+      }
+
+      // Filter reads the arguments in this order: RowPoint, RowFirst, RowLast, KeyPoint, KeyFirst, KeyLast.
+      int32_t const order[6] = { 2, 0, 1, 5, 3, 4 };
+      int32_t const bits[6] = { RowFirst, RowLast, RowPoint, KeyFirst, KeyLast, KeyPoint };
+      int32_t argument = 0;
+      double rows = static_cast<double>(m_Count);
+
+      info.idxNum = 0;
+
+      for (int32_t const slot : order)
+      {
+        if (chosen[slot] >= 0)
+        {
+          info.idxNum |= bits[slot];
+          info.aConstraintUsage[chosen[slot]].argvIndex = ++argument;
+          rows /= slot == 2 || slot == 5 ? std::max(rows, 1.0) : 4;
+        }
+      }
+
+      info.estimatedCost = std::max(rows, 1.0);
+      info.estimatedRows = static_cast<sqlite3_int64>(std::max(rows, 1.0));
+
+      // Records are read in rowid order, which is also the order of the sorted field.
+      if (info.nOrderBy == 1 && !info.aOrderBy[0].desc && (info.aOrderBy[0].iColumn < 0 || (m_Sorted >= 0 && info.aOrderBy[0].iColumn == m_Sorted && Numeric(m_Layout.Fields[m_Sorted]))))
+      {
+        info.orderByConsumed = 1;
+      }
+    }
+
+  private:
+    SQLiteRecordLayout m_Layout;
+    int32_t m_Sorted = -1;
+    std::shared_ptr<SQLiteMappedFile> m_File;
+    std::byte const* m_Records = nullptr;
+    size_t m_Count = 0;
+  };
+
+  // Registers the recordfile module, which takes the file and its layout as arguments.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  inline void CreateRecordFileModule(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const name = "recordfile")
+  {
+    CreateModule<RecordFileTable>(connection, name);
+  }
+
+  // Registers a module that can be queried as a table of the given file without creating it first:
+  //
+  //   CreateRecordFileTable(connection, "ticks", "ticks.dat", SQLiteRecordLayout::Of<Tick>(...));
+  //   Select Avg(Price) From ticks Where Time Between ? And ?
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  inline void CreateRecordFileTable(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const name, std::string path, SQLiteRecordLayout layout)
+  {
+    auto* const file = new SQLiteRecordFile{ std::move(path), std::move(layout) };
+
+    // SQLite calls the destructor even when registration fails.
+    if (SQLITE_OK != sqlite3_create_module_v2(connection.GetAbi(), name, &SQLiteModule<RecordFileTable>::Module, file, [](void* const file) { delete static_cast<SQLiteRecordFile*>(file); }))
+    {
+      connection.ThrowLastError();
+    }
+  }
+}
@@ -0,0 +1,894 @@
+#pragma once
+
+#include "VfsShim.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace ModernCppSQLite
+{
+  // The pages changed by one or more commits on the primary, as they are after the last of them.
+  // Applied in sequence to a copy of the primary, they make it a copy of the primary again.
+  struct SQLiteWalCommit
+  {
+    uint64_t Sequence = 0;
+
+    // When the commit was seen on the primary; the replica measures its lag from it.
+    std::chrono::system_clock::time_point Time;
+
+    uint32_t PageSize = 0;
+
+    // Size of the database after the commit, in pages.
+    uint32_t PageCount = 0;
+
+    std::vector<uint32_t> Pages;
+
+    // One page per entry of Pages, in the same order.
+    std::vector<std::byte> Data;
+
+    // False for all but the last of the commits a full copy is split into; the pages are only a
+    // copy of the primary once the last one is applied.
+    bool Final = true;
+
+    std::span<std::byte const> Page(size_t const index) const noexcept
+    {
+      return std::span(Data).subspan(index * PageSize, PageSize);
+    }
+
+    // Sizes and numbers are in host byte order, since both ends are on one host:
+    // 8-byte sequence, 8-byte time in nanoseconds, 4-byte page size, page count, number of
+    // pages and flags, 1 when not final, then the page numbers and the pages.
+    std::vector<std::byte> Encode() const
+    {
+      std::vector<std::byte> bytes(32 + Pages.size() * sizeof(uint32_t) + Data.size());
+      int64_t const time = std::chrono::duration_cast<std::chrono::nanoseconds>(Time.time_since_epoch()).count();
+      uint32_t const count = static_cast<uint32_t>(Pages.size());
+      uint32_t const flags = Final ? 0 : 1;
+
+      std::memcpy(bytes.data(), &Sequence, 8);
+      std::memcpy(bytes.data() + 8, &time, 8);
+      std::memcpy(bytes.data() + 16, &PageSize, 4);
+      std::memcpy(bytes.data() + 20, &PageCount, 4);
+      std::memcpy(bytes.data() + 24, &count, 4);
+      std::memcpy(bytes.data() + 28, &flags, 4);
+      std::memcpy(bytes.data() + 32, Pages.data(), Pages.size() * sizeof(uint32_t));
+      std::memcpy(bytes.data() + 32 + Pages.size() * sizeof(uint32_t), Data.data(), Data.size());
+      return bytes;
+    }
+
+    static SQLiteWalCommit Decode(std::span<std::byte const> const bytes)
+    {
+      SQLiteWalCommit commit;
+      int64_t time = 0;
+      uint32_t count = 0;
+      uint32_t flags = 0;
+
+      if (bytes.size() >= 32)
+      {
+        std::memcpy(&commit.Sequence, bytes.data(), 8);
+        std::memcpy(&time, bytes.data() + 8, 8);
+        std::memcpy(&commit.PageSize, bytes.data() + 16, 4);
+        std::memcpy(&commit.PageCount, bytes.data() + 20, 4);
+        std::memcpy(&count, bytes.data() + 24, 4);
+        std::memcpy(&flags, bytes.data() + 28, 4);
+      }
+
+      commit.Final = (flags & 1) == 0;
+
+      if (bytes.size() < 32 || bytes.size() != 32 + static_cast<size_t>(count) * (sizeof(uint32_t) + commit.PageSize))
+      {
+        throw SQLiteException(SQLITE_PROTOCOL, "walreplicator: malformed commit");
+      }
+
+      commit.Time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time)));
+      commit.Pages.resize(count);
+      std::memcpy(commit.Pages.data(), bytes.data() + 32, count * sizeof(uint32_t));
+      commit.Data.assign(bytes.begin() + 32 + count * sizeof(uint32_t), bytes.end());
+      return commit;
+    }
+  };
+
+  // Custom file control answered by every file opened through SQLiteWalVfs with its SQLiteShimFile.
+  inline constexpr int32_t SQLiteWalFileControl = 0x57414C46;
+
+  // The shim through which SQLiteWalReplicator reads the database file and its write-ahead log.
+  // Files opened through it identify themselves, so that frames are only ever read through a
+  // handle the connection itself keeps open, and never by opening the log a second time.
+  class SQLiteWalVfs : public SQLiteVfsShim<SQLiteWalVfs>
+  {
+  private:
+    using Base = SQLiteVfsShim<SQLiteWalVfs>;
+
+  public:
+    SQLiteWalVfs()
+      : Base("wal-replicated")
+    {
+    }
+
+    // Registered on first use, for the lifetime of the process.
+    static SQLiteWalVfs& Get()
+    {
+      static SQLiteWalVfs vfs;
+      return vfs;
+    }
+
+    int32_t FileControl(SQLiteShimFile& file, int32_t const operation, void* const argument)
+    {
+      if (operation == SQLiteWalFileControl)
+      {
+        *static_cast<SQLiteShimFile**>(argument) = &file;
+        return SQLITE_OK;
+      }
+
+      return Base::FileControl(file, operation, argument);
+    }
+  };
+
+  // Opens a database in WAL mode through SQLiteWalVfs, as SQLiteWalReplicator needs it.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  inline BasicSQLiteConnection<ThreadingPolicy> OpenReplicated(char const* const filename, int32_t const flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)
+  {
+    BasicSQLiteConnection<ThreadingPolicy> connection;
+    connection.Open(filename, flags, SQLiteWalVfs::Get().GetName());
+    connection.SetJournalMode("wal");
+    return connection;
+  }
+
+  struct WalReplicationOptions
+  {
+    // The replicator takes checkpoints over from wal_autocheckpoint: once the log holds this many
+    // frames, all of them shipped, it runs a passive checkpoint. Zero never checkpoints.
+    int32_t CheckpointFrames = 1000;
+
+    // The first copy of the database is sent in commits of at most this many pages.
+    uint32_t SeedPages = 4096;
+  };
+
+  struct WalReplicationStatistics
+  {
+    uint64_t Sequence = 0; // Of the last commit sent.
+    uint64_t Commits = 0;  // Commits shipped from the log, not counting seeds.
+    uint64_t Frames = 0;   // Log frames read.
+    uint64_t Pages = 0;    // Pages sent, seeds included; a page written by several frames is sent once.
+    uint64_t Seeds = 0;    // Full copies: the first, and one after every commit that could not be shipped.
+    uint64_t Errors = 0;
+    std::chrono::nanoseconds Time{}; // Spent shipping, on the committing threads.
+  };
+
+  // Ships every commit of a WAL database to a Transport, anything with a
+  // Send(SQLiteWalCommit const&) such as SQLiteReplicaFile or SQLiteReplicaSocket.
+  //
+  // Construction sends the whole database. After that sqlite3_wal_hook reports the size of the
+  // log after each commit, and the frames appended since the last one are read back through the
+  // connection's own handle on the log, which the operating system still has cached, and sent as
+  // the last version of each page they hold. The work and the bytes sent are those of the
+  // commit, where SQLiteBackup copies the whole database every time.
+  //
+  // The log must only be written through this connection: frames written by another one are
+  // shipped with the next commit here, unless a checkpoint restarted the log in between, in
+  // which case they are lost. A commit that cannot be shipped, the log restarted under it or the
+  // transport failing, does not fail on the primary; it is counted in Errors and the next commit
+  // sends a full copy instead.
+  template <typename Transport>
+  class SQLiteWalReplicator
+  {
+  private:
+    static constexpr int64_t WalHeaderSize = 32;
+    static constexpr int64_t FrameHeaderSize = 24;
+
+    struct WalHeader
+    {
+      uint32_t PageSize = 0;
+      uint32_t Salt[2]{};
+    };
+
+    static uint32_t BigEndian(std::byte const* const bytes) noexcept
+    {
+      return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 | static_cast<uint32_t>(bytes[2]) << 8 | static_cast<uint32_t>(bytes[3]);
+    }
+
+    static void Read(sqlite3_file* const file, void* const buffer, int64_t const amount, int64_t const offset)
+    {
+      if (int32_t const result = file->pMethods->xRead(file, buffer, static_cast<int32_t>(amount), offset); result != SQLITE_OK)
+      {
+        throw SQLiteException(result, "walreplicator: cannot read the database");
+      }
+    }
+
+    static int64_t Size(sqlite3_file* const file)
+    {
+      sqlite3_int64 size = 0;
+
+      if (int32_t const result = file->pMethods->xFileSize(file, &size); result != SQLITE_OK)
+      {
+        throw SQLiteException(result);
+      }
+
+      return size;
+    }
+
+    static int32_t Hook(void* const context, sqlite3* const, char const* const database, int32_t const frames)
+    {
+      if (std::strcmp(database, "main") == 0)
+      {
+        static_cast<SQLiteWalReplicator*>(context)->Ship(frames);
+      }
+
+      return SQLITE_OK;
+    }
+
+    // The database file or log, SQLITE_FCNTL_FILE_POINTER or SQLITE_FCNTL_JOURNAL_POINTER, as
+    // the shim file SQLite reads it through.
+    sqlite3_file* File(int32_t const control) const
+    {
+      sqlite3_file* file = nullptr;
+      SQLiteShimFile* shim = nullptr;
+      sqlite3_file_control(m_Connection, "main", control, &file);
+
+      if (!file || !file->pMethods || file->pMethods->xFileControl(file, SQLiteWalFileControl, &shim) != SQLITE_OK)
+      {
+        throw SQLiteException(SQLITE_MISUSE, "walreplicator: open the database with OpenReplicated");
+      }
+
+      return &shim->Base;
+    }
+
+    // Zeros while the log is empty.
+    WalHeader ReadWalHeader(sqlite3_file* const log) const
+    {
+      WalHeader header;
+
+      if (Size(log) >= WalHeaderSize)
+      {
+        std::byte bytes[WalHeaderSize];
+        Read(log, bytes, WalHeaderSize, 0);
+        header.PageSize = BigEndian(bytes + 8);
+        header.Salt[0] = BigEndian(bytes + 16);
+        header.Salt[1] = BigEndian(bytes + 20);
+      }
+
+      return header;
+    }
+
+    SQLiteWalCommit NextCommit(uint32_t const pageSize, uint32_t const pageCount)
+    {
+      SQLiteWalCommit commit;
+      commit.Sequence = ++m_Statistics.Sequence;
+      commit.Time = m_Time;
+      commit.PageSize = pageSize;
+      commit.PageCount = pageCount;
+      return commit;
+    }
+
+    // Sends every page of the database as of the first frames of the log, in commits of at most
+    // SeedPages pages, all but the last not final. Frames cannot be overwritten meanwhile, only by
+    // a writer restarting the log.
+    void Seed(int32_t const frames)
+    {
+      sqlite3_file* const database = File(SQLITE_FCNTL_FILE_POINTER);
+      sqlite3_file* const log = frames > 0 ? File(SQLITE_FCNTL_JOURNAL_POINTER) : nullptr;
+      WalHeader const header = log ? ReadWalHeader(log) : WalHeader{};
+
+      uint32_t pageSize = header.PageSize;
+      uint32_t pageCount = 0;
+
+      // The last frame holding each page.
+      std::unordered_map<uint32_t, int32_t> latest;
+
+      for (int32_t frame = 1; frame <= frames; ++frame)
+      {
+        std::byte bytes[FrameHeaderSize];
+        Read(log, bytes, FrameHeaderSize, WalHeaderSize + (frame - 1) * (FrameHeaderSize + pageSize));
+        latest[BigEndian(bytes)] = frame;
+
+        if (uint32_t const size = BigEndian(bytes + 4); size != 0)
+        {
+          pageCount = size;
+        }
+      }
+
+      if (frames <= 0 && Size(database) >= 100)
+      {
+        std::byte bytes[100];
+        Read(database, bytes, 100, 0);
+        uint32_t const size = static_cast<uint32_t>(bytes[16]) << 8 | static_cast<uint32_t>(bytes[17]);
+        pageSize = size == 1 ? 65536 : size;
+        pageCount = static_cast<uint32_t>(Size(database) / pageSize);
+      }
+
+      uint32_t page = 1;
+
+      do
+      {
+        SQLiteWalCommit commit = NextCommit(pageSize, pageCount);
+
+        for (; page <= pageCount && commit.Pages.size() < std::max(m_Options.SeedPages, 1u); ++page)
+        {
+          commit.Pages.push_back(page);
+          commit.Data.resize(commit.Data.size() + pageSize);
+          std::byte* const data = commit.Data.data() + commit.Data.size() - pageSize;
+
+          if (auto const found = latest.find(page); found != latest.end())
+          {
+            Read(log, data, pageSize, WalHeaderSize + (found->second - 1) * (FrameHeaderSize + pageSize) + FrameHeaderSize);
+          }
+          else
+          {
+            Read(database, data, pageSize, static_cast<int64_t>(page - 1) * pageSize);
+          }
+        }
+
+        commit.Final = page > pageCount;
+        m_Statistics.Pages += commit.Pages.size();
+        m_Transport.Send(commit);
+      } while (page <= pageCount);
+
+      ++m_Statistics.Seeds;
+      m_Frames = std::max(frames, 0);
+      m_Salt[0] = header.Salt[0];
+      m_Salt[1] = header.Salt[1];
+      m_Lost = false;
+    }
+
+    // Sends frames m_Frames + 1 to frames, or from the first frame when the log was restarted
+    // since the last commit.
+    void Append(int32_t const frames)
+    {
+      sqlite3_file* const log = File(SQLITE_FCNTL_JOURNAL_POINTER);
+      WalHeader const header = ReadWalHeader(log);
+
+      if (header.Salt[0] != m_Salt[0] || header.Salt[1] != m_Salt[1])
+      {
+        m_Frames = 0;
+      }
+
+      if (frames < m_Frames)
+      {
+        throw SQLiteException(SQLITE_CORRUPT, "walreplicator: the log shrank");
+      }
+
+      int64_t const frameSize = FrameHeaderSize + header.PageSize;
+      std::vector<std::byte> bytes(static_cast<size_t>(frameSize));
+      std::unordered_map<uint32_t, size_t> slots;
+      SQLiteWalCommit commit = NextCommit(header.PageSize, 0);
+
+      for (int32_t frame = m_Frames + 1; frame <= frames; ++frame)
+      {
+        Read(log, bytes.data(), frameSize, WalHeaderSize + (frame - 1) * frameSize);
+
+        // A frame of another generation of the log: it was restarted after the commit.
+        if (BigEndian(bytes.data() + 8) != header.Salt[0] || BigEndian(bytes.data() + 12) != header.Salt[1])
+        {
+          throw SQLiteException(SQLITE_BUSY_SNAPSHOT, "walreplicator: the log was restarted under the commit");
+        }
+
+        uint32_t const page = BigEndian(bytes.data());
+        auto const [slot, added] = slots.try_emplace(page, commit.Pages.size());
+
+        if (added)
+        {
+          commit.Pages.push_back(page);
+          commit.Data.resize(commit.Data.size() + header.PageSize);
+        }
+
+        std::memcpy(commit.Data.data() + slot->second * header.PageSize, bytes.data() + FrameHeaderSize, header.PageSize);
+      }
+
+      if (frames == m_Frames)
+      {
+        --m_Statistics.Sequence;
+        return;
+      }
+
+      // The last frame is that of a commit, which records the size of the database.
+      commit.PageCount = BigEndian(bytes.data() + 4);
+
+      if (commit.PageCount == 0)
+      {
+        throw SQLiteException(SQLITE_CORRUPT, "walreplicator: the log does not end with a commit");
+      }
+
+      m_Statistics.Frames += static_cast<uint64_t>(frames - m_Frames);
+      m_Statistics.Pages += commit.Pages.size();
+      ++m_Statistics.Commits;
+      m_Transport.Send(commit);
+
+      m_Frames = frames;
+      m_Salt[0] = header.Salt[0];
+      m_Salt[1] = header.Salt[1];
+    }
+
+    void Ship(int32_t const frames) noexcept
+    {
+      std::lock_guard lock(m_Mutex);
+      auto const start = std::chrono::steady_clock::now();
+      m_Time = std::chrono::system_clock::now();
+
+      try
+      {
+        if (m_Lost)
+        {
+          Seed(frames);
+        }
+        else
+        {
+          Append(frames);
+        }
+
+        // Everything in the log has been shipped, so the checkpoint may restart it.
+        if (m_Options.CheckpointFrames > 0 && frames >= m_Options.CheckpointFrames)
+        {
+          sqlite3_wal_checkpoint_v2(m_Connection, "main", SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+        }
+      }
+      catch (...)
+      {
+        ++m_Statistics.Errors;
+        m_Lost = true;
+      }
+
+      m_Statistics.Time += std::chrono::steady_clock::now() - start;
+    }
+
+  public:
+    SQLiteWalReplicator(SQLiteWalReplicator const&) = delete;
+    SQLiteWalReplicator& operator=(SQLiteWalReplicator const&) = delete;
+
+    template <typename ThreadingPolicy>
+    SQLiteWalReplicator(BasicSQLiteConnection<ThreadingPolicy> const& connection, Transport& transport, WalReplicationOptions const& options = {})
+      : m_Connection(connection.GetAbi())
+      , m_Transport(transport)
+      , m_Options(options)
+    {
+      // A passive checkpoint never waits; it is run for the size of the log.
+      int32_t frames = -1;
+
+      if (sqlite3_wal_checkpoint_v2(m_Connection, "main", SQLITE_CHECKPOINT_PASSIVE, &frames, nullptr) != SQLITE_OK || frames < 0)
+      {
+        throw SQLiteException(SQLITE_MISUSE, "walreplicator: the database is not in WAL mode");
+      }
+
+      std::lock_guard lock(m_Mutex);
+      m_Time = std::chrono::system_clock::now();
+      Seed(frames);
+
+      // Replaces the hook installed by wal_autocheckpoint.
+      sqlite3_wal_hook(m_Connection, Hook, this);
+    }
+
+    // Gives checkpoints back to wal_autocheckpoint, with SQLite's default of 1000 frames.
+    ~SQLiteWalReplicator() noexcept
+    {
+      sqlite3_wal_autocheckpoint(m_Connection, 1000);
+    }
+
+    WalReplicationStatistics GetStatistics() const
+    {
+      std::lock_guard lock(m_Mutex);
+      return m_Statistics;
+    }
+
+  private:
+    sqlite3* m_Connection = nullptr;
+    Transport& m_Transport;
+    WalReplicationOptions m_Options;
+
+    mutable std::mutex m_Mutex;
+    WalReplicationStatistics m_Statistics;
+    std::chrono::system_clock::time_point m_Time;
+
+    // Frames of the log already shipped, and the salts identifying its generation.
+    int32_t m_Frames = 0;
+    uint32_t m_Salt[2]{};
+    bool m_Lost = false;
+  };
+
+  struct SQLiteReplicaOptions
+  {
+    // How long Apply waits for readers of the replica to finish.
+    std::chrono::milliseconds BusyTimeout{ 5000 };
+
+    // Syncs the replica after every commit.
+    bool Synchronous = true;
+  };
+
+  struct SQLiteReplicaStatistics
+  {
+    uint64_t Sequence = 0; // Of the last commit applied.
+    uint64_t Commits = 0;
+    uint64_t Pages = 0;
+    std::chrono::microseconds Lag{};        // From the commit on the primary to its end of Apply, for the last commit.
+    std::chrono::microseconds MaximumLag{};
+  };
+
+  // A database file kept a copy of a primary by applying the commits of a SQLiteWalReplicator,
+  // and a transport itself when the replica is local. The file is written through the default
+  // VFS under an exclusive lock, so that connections reading the replica see whole commits; the
+  // lock is held from the first commit of a full copy to its final one.
+  //
+  // The replica is in rollback journal mode, so that those locks are the ones its readers take,
+  // with a change counter of its own; PRAGMA journal_mode = WAL promotes it. Apply is not atomic
+  // against a crash of the replica: a replicator sends a full copy first, so start a new one.
+  class SQLiteReplicaFile
+  {
+  private:
+    static void Check(int32_t const result)
+    {
+      if (result != SQLITE_OK)
+      {
+        throw SQLiteException(result);
+      }
+    }
+
+    static void PutBigEndian(std::byte* const bytes, uint32_t const value) noexcept
+    {
+      bytes[0] = static_cast<std::byte>(value >> 24);
+      bytes[1] = static_cast<std::byte>(value >> 16);
+      bytes[2] = static_cast<std::byte>(value >> 8);
+      bytes[3] = static_cast<std::byte>(value);
+    }
+
+    sqlite3_file* File() const noexcept
+    {
+      return reinterpret_cast<sqlite3_file*>(m_File.get());
+    }
+
+    void Lock()
+    {
+      auto const deadline = std::chrono::steady_clock::now() + m_Options.BusyTimeout;
+
+      for (int32_t level : { SQLITE_LOCK_SHARED, SQLITE_LOCK_EXCLUSIVE })
+      {
+        int32_t result;
+
+        while ((result = File()->pMethods->xLock(File(), level)) == SQLITE_BUSY && std::chrono::steady_clock::now() < deadline)
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (result != SQLITE_OK)
+        {
+          File()->pMethods->xUnlock(File(), SQLITE_LOCK_NONE);
+          throw SQLiteException(result, "replica: cannot lock " + m_Path);
+        }
+      }
+    }
+
+    // The header fields a reader in rollback journal mode relies on: file format versions, change
+    // counter, size in pages and the counter the size is valid for.
+    void WriteHeader(uint32_t const pageCount)
+    {
+      std::byte versions[2]{ std::byte{ 1 }, std::byte{ 1 } };
+      std::byte counter[8];
+      PutBigEndian(counter, ++m_Counter);
+      PutBigEndian(counter + 4, pageCount);
+
+      Check(File()->pMethods->xWrite(File(), versions, 2, 18));
+      Check(File()->pMethods->xWrite(File(), counter, 8, 24));
+      Check(File()->pMethods->xWrite(File(), counter, 4, 92));
+    }
+
+    void Write(SQLiteWalCommit const& commit)
+    {
+      for (size_t index = 0; index < commit.Pages.size(); ++index)
+      {
+        Check(File()->pMethods->xWrite(File(), commit.Page(index).data(), static_cast<int32_t>(commit.PageSize), static_cast<int64_t>(commit.Pages[index] - 1) * commit.PageSize));
+      }
+
+      // The header and size are published with the last part of a full copy.
+      if (!commit.Final)
+      {
+        return;
+      }
+
+      if (commit.PageCount > 0)
+      {
+        WriteHeader(commit.PageCount);
+      }
+
+      sqlite3_int64 size = 0;
+      int64_t const expected = static_cast<int64_t>(commit.PageCount) * commit.PageSize;
+      Check(File()->pMethods->xFileSize(File(), &size));
+
+      if (size != expected)
+      {
+        Check(File()->pMethods->xTruncate(File(), expected));
+      }
+
+      if (m_Options.Synchronous)
+      {
+        Check(File()->pMethods->xSync(File(), SQLITE_SYNC_NORMAL));
+      }
+    }
+
+  public:
+    SQLiteReplicaFile(SQLiteReplicaFile const&) = delete;
+    SQLiteReplicaFile& operator=(SQLiteReplicaFile const&) = delete;
+
+    explicit SQLiteReplicaFile(std::string path, SQLiteReplicaOptions const& options = {})
+      : m_Path(std::move(path))
+      , m_Options(options)
+      , m_Vfs(sqlite3_vfs_find(nullptr))
+    {
+      std::string full(static_cast<size_t>(m_Vfs->mxPathname) + 1, '\0');
+      Check(m_Vfs->xFullPathname(m_Vfs, m_Path.c_str(), static_cast<int32_t>(full.size()), full.data()));
+
+      // xOpen is given names in the form SQLite itself passes, with room for URI parameters.
+      m_Name = sqlite3_create_filename(full.c_str(), "", "", 0, nullptr);
+      m_File = std::make_unique<std::byte[]>(static_cast<size_t>(m_Vfs->szOsFile));
+
+      int32_t const result = m_Vfs->xOpen(m_Vfs, m_Name, File(), SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+
+      if (result != SQLITE_OK)
+      {
+        if (File()->pMethods)
+        {
+          File()->pMethods->xClose(File());
+        }
+
+        sqlite3_free_filename(m_Name);
+        throw SQLiteException(result, "replica: cannot open " + m_Path);
+      }
+
+      sqlite3_int64 size = 0;
+      File()->pMethods->xFileSize(File(), &size);
+
+      if (std::byte counter[4]; size >= 100 && File()->pMethods->xRead(File(), counter, 4, 24) == SQLITE_OK)
+      {
+        m_Counter = static_cast<uint32_t>(counter[0]) << 24 | static_cast<uint32_t>(counter[1]) << 16 | static_cast<uint32_t>(counter[2]) << 8 | static_cast<uint32_t>(counter[3]);
+      }
+    }
+
+    ~SQLiteReplicaFile() noexcept
+    {
+      File()->pMethods->xClose(File());
+      sqlite3_free_filename(m_Name);
+    }
+
+    // Commits are applied in the order they were sent; Apply does not check the sequence.
+    void Apply(SQLiteWalCommit const& commit)
+    {
+      if (!m_Locked)
+      {
+        Lock();
+        m_Locked = true;
+      }
+
+      try
+      {
+        Write(commit);
+      }
+      catch (...)
+      {
+        File()->pMethods->xUnlock(File(), SQLITE_LOCK_NONE);
+        m_Locked = false;
+        throw;
+      }
+
+      if (commit.Final)
+      {
+        File()->pMethods->xUnlock(File(), SQLITE_LOCK_NONE);
+        m_Locked = false;
+      }
+
+      auto const lag = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - commit.Time);
+      std::lock_guard lock(m_Mutex);
+      m_Statistics.Sequence = commit.Sequence;
+      m_Statistics.Commits += 1;
+      m_Statistics.Pages += commit.Pages.size();
+      m_Statistics.Lag = lag;
+      m_Statistics.MaximumLag = std::max(m_Statistics.MaximumLag, lag);
+    }
+
+    void Send(SQLiteWalCommit const& commit)
+    {
+      Apply(commit);
+    }
+
+    SQLiteReplicaStatistics GetStatistics() const
+    {
+      std::lock_guard lock(m_Mutex);
+      return m_Statistics;
+    }
+
+    std::string const& GetPath() const noexcept
+    {
+      return m_Path;
+    }
+
+  private:
+    std::string m_Path;
+    SQLiteReplicaOptions m_Options;
+    sqlite3_vfs* m_Vfs = nullptr;
+    sqlite3_filename m_Name = nullptr;
+    std::unique_ptr<std::byte[]> m_File;
+    uint32_t m_Counter = 0;
+
+    // Between the commits of a full copy.
+    bool m_Locked = false;
+
+    mutable std::mutex m_Mutex;
+    SQLiteReplicaStatistics m_Statistics;
+  };
+
+#ifdef __linux__
+  // Sends commits over a connected stream socket, or a pipe, to a SQLiteReplicaReceiver. Each is
+  // a 4-byte size followed by SQLiteWalCommit::Encode. Send returns once the kernel has the
+  // commit, so the primary only waits for a replica that falls a socket buffer behind.
+  class SQLiteReplicaSocket
+  {
+  public:
+    SQLiteReplicaSocket(SQLiteReplicaSocket const&) = delete;
+    SQLiteReplicaSocket& operator=(SQLiteReplicaSocket const&) = delete;
+
+    // Takes ownership of the descriptor.
+    explicit SQLiteReplicaSocket(int32_t const descriptor) noexcept
+      : m_Socket(descriptor)
+    {
+    }
+
+    ~SQLiteReplicaSocket() noexcept
+    {
+      ::close(m_Socket);
+    }
+
+    void Send(SQLiteWalCommit const& commit)
+    {
+      std::vector<std::byte> const payload = commit.Encode();
+      uint32_t const size = static_cast<uint32_t>(payload.size());
+      std::byte header[4];
+      std::memcpy(header, &size, 4);
+
+      for (std::span<std::byte const> const part : { std::span<std::byte const>(header), std::span<std::byte const>(payload) })
+      {
+        for (size_t sent = 0; sent < part.size();)
+        {
+          ssize_t const count = ::send(m_Socket, part.data() + sent, part.size() - sent, MSG_NOSIGNAL);
+
+          if (count < 0 && errno == EINTR)
+          {
+            continue;
+          }
+
+          if (count <= 0)
+          {
+            throw SQLiteException(SQLITE_IOERR_WRITE, "replica: connection lost");
+          }
+
+          sent += static_cast<size_t>(count);
+        }
+      }
+    }
+
+  private:
+    int32_t m_Socket = -1;
+  };
+
+  // Applies the commits arriving on a socket to a replica, on a thread of its own, until the
+  // sending end is closed or a commit cannot be applied.
+  class SQLiteReplicaReceiver
+  {
+  private:
+    bool ReadAll(std::byte* const bytes, size_t const size)
+    {
+      for (size_t received = 0; received < size;)
+      {
+        ssize_t const count = ::recv(m_Socket, bytes + received, size - received, 0);
+
+        if (count < 0 && errno == EINTR)
+        {
+          continue;
+        }
+
+        if (count <= 0)
+        {
+          return false;
+        }
+
+        received += static_cast<size_t>(count);
+      }
+
+      return true;
+    }
+
+    void Run() noexcept
+    {
+      try
+      {
+        std::vector<std::byte> payload;
+        uint32_t size = 0;
+
+        while (ReadAll(reinterpret_cast<std::byte*>(&size), 4))
+        {
+          payload.resize(size);
+
+          if (!ReadAll(payload.data(), size))
+          {
+            throw SQLiteException(SQLITE_IOERR_READ, "replica: truncated commit");
+          }
+
+          SQLiteWalCommit const commit = SQLiteWalCommit::Decode(payload);
+          m_Replica.Apply(commit);
+
+          std::lock_guard lock(m_Mutex);
+          m_Sequence = commit.Sequence;
+          m_Condition.notify_all();
+        }
+      }
+      catch (SQLiteException const& ex)
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Error.emplace(ex);
+      }
+      catch (std::exception const& ex)
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Error.emplace(SQLITE_ERROR, ex.what());
+      }
+
+      std::lock_guard lock(m_Mutex);
+      m_Stopped = true;
+      m_Condition.notify_all();
+    }
+
+  public:
+    SQLiteReplicaReceiver(SQLiteReplicaReceiver const&) = delete;
+    SQLiteReplicaReceiver& operator=(SQLiteReplicaReceiver const&) = delete;
+
+    // Takes ownership of the descriptor.
+    SQLiteReplicaReceiver(int32_t const descriptor, SQLiteReplicaFile& replica)
+      : m_Socket(descriptor)
+      , m_Replica(replica)
+    {
+      m_Thread = std::thread([this] { Run(); });
+    }
+
+    ~SQLiteReplicaReceiver() noexcept
+    {
+      ::shutdown(m_Socket, SHUT_RDWR);
+      m_Thread.join();
+      ::close(m_Socket);
+    }
+
+    // Waits until the commit with this sequence number is applied, throwing why the receiver
+    // stopped if it did first.
+    bool Wait(uint64_t const sequence, std::chrono::milliseconds const timeout)
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Condition.wait_for(lock, timeout, [&] { return m_Sequence >= sequence || m_Stopped; });
+
+      if (m_Sequence < sequence && m_Error)
+      {
+        throw *m_Error;
+      }
+
+      return m_Sequence >= sequence;
+    }
+
+  private:
+    int32_t m_Socket = -1;
+    SQLiteReplicaFile& m_Replica;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    uint64_t m_Sequence = 0;
+    bool m_Stopped = false;
+    std::optional<SQLiteException> m_Error;
+
+    std::thread m_Thread;
+  };
+#endif
+}
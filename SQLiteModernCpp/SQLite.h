@@ -13,7 +13,15 @@
 #include <string>
 #include <string_view>
 #include <optional>
+#include <span>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <unordered_map>
 
 #ifdef _DEBUG
 #define VERIFY ASSERT
@@ -79,6 +87,25 @@ namespace ModernCppSQLite
     return u"Invalid";
   }
 
+  // Quotes a table, column or index name for use in generated SQL.
+  inline std::string SQLiteQuoteIdentifier(std::string_view const name)
+  {
+    std::string result(1, '"');
+
+    for (char const c : name)
+    {
+      result += c;
+
+      if (c == '"')
+      {
+        result += c;
+      }
+    }
+
+    result += '"';
+    return result;
+  }
+
   struct SQLiteException
   {
     const int32_t ErrorCode = 0;
@@ -89,9 +116,74 @@ namespace ModernCppSQLite
       , ErrorMessage(sqlite3_errmsg(connection))
     {
     }
+
+    explicit SQLiteException(int32_t const errorCode)
+      : ErrorCode(errorCode)
+      , ErrorMessage(sqlite3_errstr(errorCode))
+    {
+    }
+
+    SQLiteException(int32_t const errorCode, std::string errorMessage)
+      : ErrorCode(errorCode)
+      , ErrorMessage(std::move(errorMessage))
+    {
+    }
   };
 
-  class SQLiteConnection
+  // Handles used from several threads: SQLite serializes every call on the connection mutex.
+  struct SQLiteShared
+  {
+    static constexpr int32_t OpenFlags = SQLITE_OPEN_FULLMUTEX;
+
+    void CheckThread() const noexcept
+    {
+    }
+
+    void AttachThread() noexcept
+    {
+    }
+  };
+
+  // Handles confined to one thread at a time: SQLite skips the connection mutex entirely.
+  // Debug builds assert that every use happens on the owning thread.
+  struct SQLiteThreadConfined
+  {
+    static constexpr int32_t OpenFlags = SQLITE_OPEN_NOMUTEX;
+
+#ifdef _DEBUG
+    void CheckThread() const noexcept
+    {
+      ASSERT(m_Owner == std::this_thread::get_id());
+    }
+
+    void AttachThread() noexcept
+    {
+      m_Owner = std::this_thread::get_id();
+    }
+
+  private:
+    std::thread::id m_Owner = std::this_thread::get_id();
+#else
+    void CheckThread() const noexcept
+    {
+    }
+
+    void AttachThread() noexcept
+    {
+    }
+#endif
+  };
+
+  template <typename T>
+  concept SQLiteThreadingPolicy = requires(T& policy)
+  {
+    { T::OpenFlags } -> std::convertible_to<int32_t>;
+    policy.CheckThread();
+    policy.AttachThread();
+  };
+
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class BasicSQLiteConnection : private ThreadingPolicy
   {
   private:
     struct SQLiteConnectionHandleTraits : SQLiteHandleTraits<sqlite3*>
@@ -104,10 +196,54 @@ namespace ModernCppSQLite
 
     using SQLiteConnectionHandle = SQLiteHandle<SQLiteConnectionHandleTraits>;
 
+    template <typename C>
+    static std::string ToUtf8(C const* text)
+    {
+      std::string result;
+
+      for (; *text; ++text)
+      {
+        char32_t code = static_cast<char32_t>(*text);
+
+        if constexpr (sizeof(C) == sizeof(char16_t))
+        {
+          if (code >= 0xD800 && code < 0xDC00 && text[1] >= 0xDC00 && text[1] < 0xE000)
+          {
+            code = 0x10000 + ((code - 0xD800) << 10) + (static_cast<char32_t>(*++text) - 0xDC00);
+          }
+        }
+
+        if (code < 0x80)
+        {
+          result += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+          result += static_cast<char>(0xC0 | (code >> 6));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+          result += static_cast<char>(0xE0 | (code >> 12));
+          result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+          result += static_cast<char>(0xF0 | (code >> 18));
+          result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+          result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+      }
+
+      return result;
+    }
+
     template <typename F, typename C>
     void InternalOpen(F open, C const* const filename)
     {
-      SQLiteConnection temp;
+      BasicSQLiteConnection temp;
 
       if (SQLITE_OK != open(filename, temp.m_Handle.Set()))
       {
@@ -117,24 +253,34 @@ namespace ModernCppSQLite
       swap(m_Handle, temp.m_Handle);
     }
 
+    template <typename F>
+    void InternalExecute(char const* const text, F callback, void* const context) const
+    {
+      if (SQLITE_OK != sqlite3_exec(GetAbi(), text, callback, context, nullptr))
+      {
+        ThrowLastError();
+      }
+    }
+
   public:
+    using ThreadingPolicy::AttachThread;
 
-    SQLiteConnection() noexcept = default;
+    BasicSQLiteConnection() noexcept = default;
 
     template <typename C>
-    explicit SQLiteConnection(C const* const filename)
+    explicit BasicSQLiteConnection(C const* const filename)
     {
       Open(filename);
     }
 
-    static SQLiteConnection Memory()
+    static BasicSQLiteConnection Memory()
     {
-      return SQLiteConnection(":memory:");
+      return BasicSQLiteConnection(":memory:");
     }
 
-    static SQLiteConnection WideMemory()
+    static BasicSQLiteConnection WideMemory()
     {
-      return SQLiteConnection(L":memory:");
+      return BasicSQLiteConnection(L":memory:");
     }
 
     [[noreturn]] void ThrowLastError() const
@@ -149,27 +295,38 @@ namespace ModernCppSQLite
 
     sqlite3* GetAbi() const noexcept
     {
+      ThreadingPolicy::CheckThread();
       return m_Handle.Get();
     }
 
-    void Open(char const* const filename)
+    // The threading policy, not the caller, decides between SQLITE_OPEN_NOMUTEX and SQLITE_OPEN_FULLMUTEX.
+    void Open(char const* const filename, int32_t const flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, char const* const vfs = nullptr)
     {
-      InternalOpen(sqlite3_open, filename);
+      ASSERT(ThreadingPolicy::OpenFlags != SQLITE_OPEN_FULLMUTEX || sqlite3_threadsafe() != 0);
+
+      InternalOpen([flags, vfs](char const* const name, sqlite3** const handle)
+        {
+          return sqlite3_open_v2(name, handle, (flags & ~(SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_FULLMUTEX)) | ThreadingPolicy::OpenFlags, vfs);
+        }, filename);
     }
 
-    void Open(wchar_t const* const filename)
+    void Open(char8_t const* const filename, int32_t const flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, char const* const vfs = nullptr)
     {
-      InternalOpen(sqlite3_open16, filename);
+      Open((char const* const)filename, flags, vfs);
     }
 
-    void Open(char8_t const* const filename)
+    // sqlite3_open16 cannot take open flags, so the name is converted and the UTF-16
+    // encoding it would have given to a new database is requested explicitly.
+    void Open(wchar_t const* const filename, int32_t const flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, char const* const vfs = nullptr)
     {
-      InternalOpen(sqlite3_open, (char const* const)filename);
+      Open(ToUtf8(filename).c_str(), flags, vfs);
+      InternalExecute("PRAGMA encoding = 'UTF-16'", nullptr, nullptr);
     }
 
-    void Open(char16_t const* const filename)
+    void Open(char16_t const* const filename, int32_t const flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, char const* const vfs = nullptr)
     {
-      InternalOpen(sqlite3_open16, filename);
+      Open(ToUtf8(filename).c_str(), flags, vfs);
+      InternalExecute("PRAGMA encoding = 'UTF-16'", nullptr, nullptr);
     }
 
     sqlite3_int64 RowId() const noexcept
@@ -179,7 +336,55 @@ namespace ModernCppSQLite
 
     sqlite3_int64 TotalChanges() const noexcept
     {
+#if SQLITE_VERSION_NUMBER >= 3037000
       return sqlite3_total_changes64(GetAbi());
+#else
+      return sqlite3_total_changes(GetAbi());
+#endif
+    }
+
+    void SetBusyTimeout(std::chrono::milliseconds const timeout) const
+    {
+      if (SQLITE_OK != sqlite3_busy_timeout(GetAbi(), static_cast<int32_t>(timeout.count())))
+      {
+        ThrowLastError();
+      }
+    }
+
+    void SetMemoryMapSize(sqlite3_int64 const size) const
+    {
+      InternalExecute(("PRAGMA mmap_size = " + std::to_string(size)).c_str(), nullptr, nullptr);
+    }
+
+    sqlite3_int64 GetMemoryMapSize() const
+    {
+      sqlite3_int64 size = 0;
+
+      InternalExecute("PRAGMA mmap_size", [](void* const context, int32_t, char** const values, char**)
+        {
+          *static_cast<sqlite3_int64*>(context) = values[0] ? std::strtoll(values[0], nullptr, 10) : 0;
+          return SQLITE_OK;
+        }, &size);
+
+      return size;
+    }
+
+    // PRAGMA journal_mode answers with the mode the database is left in, which is not the one
+    // asked for when it cannot change, as an in-memory database cannot to "wal".
+    void SetJournalMode(char const* const mode) const
+    {
+      std::string result;
+
+      InternalExecute(("PRAGMA journal_mode = " + std::string(mode)).c_str(), [](void* const context, int32_t, char** const values, char**)
+        {
+          *static_cast<std::string*>(context) = values[0] ? values[0] : "";
+          return SQLITE_OK;
+        }, &result);
+
+      if (sqlite3_stricmp(result.c_str(), mode) != 0)
+      {
+        throw SQLiteException(SQLITE_ERROR, "journal_mode is " + result + ", not " + mode);
+      }
     }
 
     template <typename F>
@@ -192,6 +397,9 @@ namespace ModernCppSQLite
     SQLiteConnectionHandle m_Handle;
   };
 
+  using SQLiteConnection = BasicSQLiteConnection<SQLiteShared>;
+  using SQLiteConfinedConnection = BasicSQLiteConnection<SQLiteThreadConfined>;
+
 
   class SQLiteBackup
   {
@@ -207,13 +415,14 @@ namespace ModernCppSQLite
     using SQLiteBackupHandle = SQLiteHandle<SQLiteBackupHandleTraits>;
 
   public:
+    template <typename DestinationPolicy, typename SourcePolicy>
     SQLiteBackup(
-      SQLiteConnection const& destination,
-      SQLiteConnection const& source,
+      BasicSQLiteConnection<DestinationPolicy> const& destination,
+      BasicSQLiteConnection<SourcePolicy> const& source,
       char const* const destinationName = "main",
       char const* const sourceName = "main")
       : m_Handle(sqlite3_backup_init(destination.GetAbi(), destinationName, source.GetAbi(), sourceName))
-      , m_Destination(&destination)
+      , m_Destination(destination.GetAbi())
     {
       if (!m_Handle)
       {
@@ -236,14 +445,94 @@ namespace ModernCppSQLite
       // Reset() calls sqlite3_backup_finish() so that error information 
       // will be made available through the destination connection.
       m_Handle.Reset();
-      m_Destination->ThrowLastError();
+      throw SQLiteException(m_Destination);
 
       // throw Exception(result);
     }
 
   private:
     SQLiteBackupHandle m_Handle;
-    SQLiteConnection const* m_Destination = nullptr;
+    sqlite3* m_Destination = nullptr;
+  };
+
+  // Interns the text of a result so that each distinct value is stored once. Codes are assigned
+  // from zero in order of first appearance; views and codes stay valid until Clear.
+  class SQLiteStringDictionary
+  {
+  public:
+    static constexpr uint32_t Null = UINT32_MAX;
+
+    uint32_t Intern(std::string_view const value)
+    {
+      if (auto const found = m_Codes.find(value); found != m_Codes.end())
+      {
+        return found->second;
+      }
+
+      std::string_view const stored = m_Values.emplace_back(value);
+      uint32_t const code = static_cast<uint32_t>(m_Views.size());
+      m_Views.push_back(stored);
+      m_Codes.emplace(stored, code);
+      return code;
+    }
+
+    std::string_view Value(uint32_t const code) const noexcept
+    {
+      return code == Null ? std::string_view() : m_Views[code];
+    }
+
+    std::string_view operator[](uint32_t const code) const noexcept
+    {
+      return Value(code);
+    }
+
+    size_t Size() const noexcept
+    {
+      return m_Views.size();
+    }
+
+    void Clear() noexcept
+    {
+      m_Codes.clear();
+      m_Views.clear();
+      m_Values.clear();
+    }
+
+  private:
+    std::deque<std::string> m_Values;
+    std::vector<std::string_view> m_Views;
+    std::unordered_map<std::string_view, uint32_t> m_Codes;
+  };
+
+  template <typename Type>
+  concept SQLiteDuration = std::is_same_v<Type, std::chrono::duration<typename Type::rep, typename Type::period>>;
+
+  template <typename Type>
+  concept SQLiteTimePoint = std::is_same_v<Type, std::chrono::time_point<typename Type::clock, typename Type::duration>>;
+
+  // Time points are bound and read as integer ticks of their own duration since their clock's
+  // epoch, which for system_clock is 1970-01-01 UTC. This stores them as ticks of Unit since
+  // an epoch given in days from 1970-01-01 instead, rounding down to a whole Unit.
+  //
+  //   using Gps = SQLiteTimeEncoding<std::chrono::microseconds, 3657>;
+  //   statement.Bind(1, Gps::Encode(now));
+  //   auto const time = Gps::Decode<std::chrono::nanoseconds>(reader.GetInt64(0));
+  template <typename Unit, int64_t EpochDays = 0>
+  struct SQLiteTimeEncoding
+  {
+    static constexpr std::chrono::sys_days Epoch{ std::chrono::days(EpochDays) };
+
+    template <typename Duration>
+    static constexpr int64_t Encode(std::chrono::sys_time<Duration> const value) noexcept
+    {
+      return std::chrono::floor<Unit>(value - Epoch).count();
+    }
+
+    template <typename Duration = Unit>
+    static constexpr std::chrono::sys_time<Duration> Decode(int64_t const ticks) noexcept
+    {
+      return std::chrono::floor<Duration>(Epoch + Unit(ticks));
+    }
   };
 
   template <typename T>
@@ -309,6 +598,21 @@ namespace ModernCppSQLite
       return reinterpret_cast<char16_t const*>(::sqlite3_column_text16(static_cast<T const*>(this)->GetAbi(), column));
     }
 
+    // The code of the column's text in the dictionary, or SQLiteStringDictionary::Null.
+    uint32_t GetStringCode(SQLiteStringDictionary& dictionary, int32_t const column = 0) const
+    {
+      sqlite3_stmt* const statement = static_cast<T const*>(this)->GetAbi();
+      char const* const text = reinterpret_cast<char const*>(::sqlite3_column_text(statement, column));
+
+      return text ? dictionary.Intern(std::string_view(text, ::sqlite3_column_bytes(statement, column))) : SQLiteStringDictionary::Null;
+    }
+
+    // The column's text as stored in the dictionary; a null view when the column is null.
+    std::string_view GetInternedString(SQLiteStringDictionary& dictionary, int32_t const column = 0) const
+    {
+      return dictionary.Value(GetStringCode(dictionary, column));
+    }
+
     int32_t GetBlobLength(int32_t const column = 0) const noexcept
     {
       return ::sqlite3_column_bytes(static_cast<T const*>(this)->GetAbi(), column);
@@ -423,9 +727,27 @@ namespace ModernCppSQLite
     {
       return static_cast<SQLiteType>(::sqlite3_column_type(static_cast<T const*>(this)->GetAbi(), column));
     }
+
+    // Reads the column as Type: durations and time points from integer ticks, as they are bound.
+    template <typename Type>
+    Type Get(int32_t const column = 0) const
+    {
+      if constexpr (std::is_same_v<Type, bool>) return GetBoolean(column);
+      else if constexpr (std::is_integral_v<Type> || std::is_enum_v<Type>) return static_cast<Type>(GetInt64(column));
+      else if constexpr (std::is_floating_point_v<Type>) return static_cast<Type>(GetDouble(column));
+      else if constexpr (SQLiteDuration<Type>) return Type(static_cast<typename Type::rep>(GetInt64(column)));
+      else if constexpr (SQLiteTimePoint<Type>) return Type(typename Type::duration(static_cast<typename Type::duration::rep>(GetInt64(column))));
+      else if constexpr (std::is_same_v<Type, std::string_view> || std::is_same_v<Type, std::string>)
+      {
+        char const* const text = GetString(column);
+        return text ? Type(text, static_cast<size_t>(GetStringLength(column))) : Type();
+      }
+      else static_assert(sizeof(Type) == 0, "Get: unsupported type");
+    }
   };
 
-  class SQLiteStatement : public SQLiteReader<SQLiteStatement>
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class BasicSQLiteStatement : public SQLiteReader<BasicSQLiteStatement<ThreadingPolicy>>, private ThreadingPolicy
   {
   private:
     struct SQLiteStatementHandleTraits : SQLiteHandleTraits<sqlite3_stmt*>
@@ -439,9 +761,10 @@ namespace ModernCppSQLite
     using SQLiteStatementHandle = SQLiteHandle<SQLiteStatementHandleTraits>;
 
     template <typename F, typename C, typename ... Values>
-    void InternalPrepare(SQLiteConnection const& connection, F prepare, C const* const text, Values && ... values)
+    void InternalPrepare(BasicSQLiteConnection<ThreadingPolicy> const& connection, F prepare, C const* const text, Values && ... values)
     {
       ASSERT(connection);
+      ThreadingPolicy::AttachThread();
 
       if (SQLITE_OK != prepare(connection.GetAbi(), text, -1, m_Handle.Set(), nullptr))
       {
@@ -474,10 +797,12 @@ namespace ModernCppSQLite
     }
 
   public:
-    SQLiteStatement() noexcept = default;
+    using ThreadingPolicy::AttachThread;
+
+    BasicSQLiteStatement() noexcept = default;
 
     template <typename C, typename ... Values>
-    SQLiteStatement(SQLiteConnection const& connection, C const* const text, Values && ... values)
+    BasicSQLiteStatement(BasicSQLiteConnection<ThreadingPolicy> const& connection, C const* const text, Values && ... values)
     {
       Prepare(connection, text, std::forward<Values>(values) ...);
     }
@@ -489,6 +814,7 @@ namespace ModernCppSQLite
 
     sqlite3_stmt* GetAbi() const noexcept
     {
+      ThreadingPolicy::CheckThread();
       return m_Handle.Get();
     }
 
@@ -498,25 +824,25 @@ namespace ModernCppSQLite
     }
 
     template <typename ... Values>
-    void Prepare(SQLiteConnection const& connection, char const* const text, Values && ... values)
+    void Prepare(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const text, Values && ... values)
     {
       InternalPrepare(connection, sqlite3_prepare_v2, text, std::forward<Values>(values) ...);
     }
 
     template <typename ... Values>
-    void Prepare(SQLiteConnection const& connection, wchar_t const* const text, Values && ... values)
+    void Prepare(BasicSQLiteConnection<ThreadingPolicy> const& connection, wchar_t const* const text, Values && ... values)
     {
       InternalPrepare(connection, sqlite3_prepare16_v2, text, std::forward<Values>(values) ...);
     }
 
     template <typename ... Values>
-    void Prepare(SQLiteConnection const& connection, char8_t const* const text, Values && ... values)
+    void Prepare(BasicSQLiteConnection<ThreadingPolicy> const& connection, char8_t const* const text, Values && ... values)
     {
       InternalPrepare(connection, sqlite3_prepare_v2, (char const* const)text, std::forward<Values>(values) ...);
     }
 
     template <typename ... Values>
-    void Prepare(SQLiteConnection const& connection, char16_t const* const text, Values && ... values)
+    void Prepare(BasicSQLiteConnection<ThreadingPolicy> const& connection, char16_t const* const text, Values && ... values)
     {
       InternalPrepare(connection, sqlite3_prepare16_v2, text, std::forward<Values>(values) ...);
     }
@@ -675,6 +1001,22 @@ namespace ModernCppSQLite
       }
     }
 
+    void Bind(int32_t const index, std::span<std::byte const> const value) const
+    {
+      if (SQLITE_OK != sqlite3_bind_blob(GetAbi(), index, value.data(), static_cast<int32_t>(value.size()), SQLITE_STATIC))
+      {
+        ThrowLastError();
+      }
+    }
+
+    void Bind(int32_t const index, sqlite3_value const* const value) const
+    {
+      if (SQLITE_OK != sqlite3_bind_value(GetAbi(), index, value))
+      {
+        ThrowLastError();
+      }
+    }
+
     void Bind(int32_t const index, std::nullptr_t) const
     {
       if (SQLITE_OK != sqlite3_bind_null(GetAbi(), index))
@@ -713,7 +1055,7 @@ namespace ModernCppSQLite
     template <typename Clock, typename Duration = typename Clock::duration>
     void Bind(int32_t const index, const std::chrono::time_point<Clock, Duration>& value) const
     {
-      if (SQLITE_OK != sqlite3_bind_int64(GetAbi(), index, static_cast<sqlite3_int64>(value.time_since_epoch())))
+      if (SQLITE_OK != sqlite3_bind_int64(GetAbi(), index, static_cast<sqlite3_int64>(value.time_since_epoch().count())))
       {
         ThrowLastError();
       }
@@ -729,6 +1071,9 @@ namespace ModernCppSQLite
     SQLiteStatementHandle m_Handle;
   };
 
+  using SQLiteStatement = BasicSQLiteStatement<SQLiteShared>;
+  using SQLiteConfinedStatement = BasicSQLiteStatement<SQLiteThreadConfined>;
+
   class SQLiteRow : public SQLiteReader<SQLiteRow>
   {
   public:
@@ -746,12 +1091,13 @@ namespace ModernCppSQLite
   };
 
 
+  template <typename Statement = SQLiteStatement>
   class SQLiteRowIterator
   {
   public:
     SQLiteRowIterator() noexcept = default;
 
-    SQLiteRowIterator(SQLiteStatement const& statement) noexcept
+    SQLiteRowIterator(Statement const& statement) noexcept
     {
       if (statement.Step())
       {
@@ -780,22 +1126,143 @@ namespace ModernCppSQLite
     }
 
   private:
-    SQLiteStatement const* m_Statement = nullptr;
+    Statement const* m_Statement = nullptr;
   };
 
-  inline SQLiteRowIterator begin(SQLiteStatement const& statement) noexcept
+  template <typename ThreadingPolicy>
+  inline SQLiteRowIterator<BasicSQLiteStatement<ThreadingPolicy>> begin(BasicSQLiteStatement<ThreadingPolicy> const& statement) noexcept
   {
-    return SQLiteRowIterator(statement);
+    return SQLiteRowIterator<BasicSQLiteStatement<ThreadingPolicy>>(statement);
   }
 
-  inline SQLiteRowIterator end(SQLiteStatement const&) noexcept
+  template <typename ThreadingPolicy>
+  inline SQLiteRowIterator<BasicSQLiteStatement<ThreadingPolicy>> end(BasicSQLiteStatement<ThreadingPolicy> const&) noexcept
   {
-    return SQLiteRowIterator();
+    return SQLiteRowIterator<BasicSQLiteStatement<ThreadingPolicy>>();
   }
 
-  template <typename C, typename ... Values>
-  inline void Execute(SQLiteConnection const& connection, C const* const text, Values && ... values)
+  template <typename ThreadingPolicy, typename C, typename ... Values>
+  inline void Execute(BasicSQLiteConnection<ThreadingPolicy> const& connection, C const* const text, Values && ... values)
   {
-    SQLiteStatement(connection, text, std::forward<Values>(values) ...).Execute();
+    BasicSQLiteStatement<ThreadingPolicy>(connection, text, std::forward<Values>(values) ...).Execute();
   }
+
+  // julianday_from_ticks(ticks, ticks_per_second [, epoch_days]) gives the Julian day number of a
+  // time stored as integer ticks since an epoch in days from 1970-01-01, so that the date and time
+  // functions apply to it: datetime(julianday_from_ticks(Time, 1000000)). ticks_from_julianday
+  // takes the same arguments with a Julian day number in place of the ticks. A Julian day number
+  // is a double, precise to about 0.1 ms in this era.
+  class SQLiteTimeFunctions
+  {
+  private:
+    static constexpr double UnixEpoch = 2440587.5;
+
+    static bool Arguments(sqlite3_context* const context, int32_t const count, sqlite3_value** const values, sqlite3_int64& perDay, sqlite3_int64& epoch) noexcept
+    {
+      perDay = sqlite3_value_int64(values[1]) * 86'400;
+      epoch = count > 2 ? sqlite3_value_int64(values[2]) : 0;
+
+      if (perDay <= 0)
+      {
+        sqlite3_result_error(context, "ticks_per_second must be positive", -1);
+        return false;
+      }
+
+      return sqlite3_value_type(values[0]) != SQLITE_NULL;
+    }
+
+    static void ToJulianDay(sqlite3_context* const context, int32_t const count, sqlite3_value** const values) noexcept
+    {
+      sqlite3_int64 perDay = 0;
+      sqlite3_int64 epoch = 0;
+
+      if (Arguments(context, count, values, perDay, epoch))
+      {
+        // Whole days are split off first so that the fraction keeps the ticks' precision.
+        sqlite3_int64 const ticks = sqlite3_value_int64(values[0]);
+        sqlite3_int64 const days = ticks / perDay - (ticks % perDay < 0 ? 1 : 0);
+        sqlite3_result_double(context, UnixEpoch + static_cast<double>(epoch + days) + static_cast<double>(ticks - days * perDay) / static_cast<double>(perDay));
+      }
+    }
+
+    static void FromJulianDay(sqlite3_context* const context, int32_t const count, sqlite3_value** const values) noexcept
+    {
+      sqlite3_int64 perDay = 0;
+      sqlite3_int64 epoch = 0;
+
+      if (Arguments(context, count, values, perDay, epoch))
+      {
+        double const day = sqlite3_value_double(values[0]) - UnixEpoch;
+        double const whole = std::floor(day);
+        sqlite3_result_int64(context, (static_cast<sqlite3_int64>(whole) - epoch) * perDay + std::llround((day - whole) * static_cast<double>(perDay)));
+      }
+    }
+
+  public:
+    template <typename ThreadingPolicy>
+    static void Create(BasicSQLiteConnection<ThreadingPolicy> const& connection)
+    {
+      int32_t constexpr flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC;
+
+      for (int32_t const count : { 2, 3 })
+      {
+        if (SQLITE_OK != sqlite3_create_function_v2(connection.GetAbi(), "julianday_from_ticks", count, flags, nullptr, ToJulianDay, nullptr, nullptr, nullptr)
+          || SQLITE_OK != sqlite3_create_function_v2(connection.GetAbi(), "ticks_from_julianday", count, flags, nullptr, FromJulianDay, nullptr, nullptr, nullptr))
+        {
+          connection.ThrowLastError();
+        }
+      }
+    }
+  };
+
+  enum class SQLiteTransactionType
+  {
+    Deferred,
+    Immediate,
+    Exclusive,
+  };
+
+  // Rolls back on destruction unless committed.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class SQLiteTransaction
+  {
+  public:
+    SQLiteTransaction(SQLiteTransaction const&) = delete;
+    SQLiteTransaction& operator=(SQLiteTransaction const&) = delete;
+
+    explicit SQLiteTransaction(BasicSQLiteConnection<ThreadingPolicy> const& connection, SQLiteTransactionType const type = SQLiteTransactionType::Deferred)
+      : m_Connection(&connection)
+    {
+      switch (type)
+      {
+        case SQLiteTransactionType::Immediate: Execute(connection, "Begin Immediate"); break;
+        case SQLiteTransactionType::Exclusive: Execute(connection, "Begin Exclusive"); break;
+        default: Execute(connection, "Begin"); break;
+      }
+    }
+
+    ~SQLiteTransaction() noexcept
+    {
+      if (m_Connection)
+      {
+        sqlite3_exec(m_Connection->GetAbi(), "Rollback", nullptr, nullptr, nullptr);
+      }
+    }
+
+    void Commit()
+    {
+      ASSERT(m_Connection);
+      Execute(*m_Connection, "Commit");
+      m_Connection = nullptr;
+    }
+
+    void Rollback()
+    {
+      ASSERT(m_Connection);
+      Execute(*std::exchange(m_Connection, nullptr), "Rollback");
+    }
+
+  private:
+    BasicSQLiteConnection<ThreadingPolicy> const* m_Connection = nullptr;
+  };
 }
@@ -0,0 +1,569 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  // A string literal that can be passed as a template argument.
+  template <size_t Size>
+  struct SQLiteFixedString
+  {
+    char Text[Size]{ };
+
+    constexpr SQLiteFixedString(char const (&text)[Size]) noexcept
+    {
+      std::copy_n(text, Size, Text);
+    }
+
+    constexpr std::string_view View() const noexcept
+    {
+      return { Text, Size - 1 };
+    }
+  };
+
+  // Text built in a constant expression. std::vector rather than std::string, whose short
+  // string storage some compilers do not accept in constant expressions yet.
+  struct SQLiteConstexprText
+  {
+    std::vector<char> Characters;
+
+    constexpr SQLiteConstexprText& operator<<(std::string_view const text)
+    {
+      Characters.insert(Characters.end(), text.begin(), text.end());
+      return *this;
+    }
+
+    // Appends name as a quoted identifier.
+    constexpr SQLiteConstexprText& Quote(std::string_view const name)
+    {
+      Characters.push_back('"');
+
+      for (char const c : name)
+      {
+        Characters.push_back(c);
+
+        if (c == '"')
+        {
+          Characters.push_back('"');
+        }
+      }
+
+      Characters.push_back('"');
+      return *this;
+    }
+  };
+
+  // The text written by the constexpr function Build, rendered once at compile time into a
+  // null-terminated array so that View.data() can be prepared directly.
+  template <auto Build>
+  struct SQLiteStaticText
+  {
+    static constexpr size_t Size = []
+    {
+      SQLiteConstexprText text;
+      Build(text);
+      return text.Characters.size();
+    }();
+
+    static constexpr std::array<char, Size + 1> Text = []
+    {
+      SQLiteConstexprText text;
+      Build(text);
+      std::array<char, Size + 1> characters{ };
+      std::copy(text.Characters.begin(), text.Characters.end(), characters.begin());
+      return characters;
+    }();
+
+    static constexpr std::string_view View{ Text.data(), Size };
+  };
+
+  template <typename Type>
+  struct SQLiteNullable : std::false_type
+  {
+    using Value = Type;
+  };
+
+  template <typename Type>
+  struct SQLiteNullable<std::optional<Type>> : std::true_type
+  {
+    using Value = Type;
+  };
+
+  template <typename Pointer>
+  struct SQLiteMemberPointer;
+
+  template <typename Record, typename Member>
+  struct SQLiteMemberPointer<Member Record::*>
+  {
+    using Class = Record;
+    using Type = Member;
+  };
+
+  // The storage class a member type is bound as, which is also its declared type in the DDL.
+  template <typename Type>
+  constexpr SQLiteType SQLiteColumnTypeOf() noexcept
+  {
+    if constexpr (std::is_integral_v<Type> || std::is_enum_v<Type> || SQLiteDuration<Type> || SQLiteTimePoint<Type>) return SQLiteType::Integer;
+    else if constexpr (std::is_floating_point_v<Type>) return SQLiteType::Float;
+    else if constexpr (std::is_same_v<Type, std::string>) return SQLiteType::Text;
+    else if constexpr (std::is_same_v<Type, std::vector<std::byte>>) return SQLiteType::Blob;
+    else static_assert(sizeof(Type) == 0, "SQLiteColumn: unsupported member type");
+  }
+
+  // Binds a value of a column type: std::optional binds null when empty, and every integer other
+  // than bool is widened so that types such as long long are not ambiguous.
+  template <typename Statement, typename Type>
+  void SQLiteBindValue(Statement const& statement, int32_t const index, Type const& value)
+  {
+    if constexpr (SQLiteNullable<Type>::value)
+    {
+      if (value)
+      {
+        SQLiteBindValue(statement, index, *value);
+      }
+      else
+      {
+        statement.Bind(index, nullptr);
+      }
+    }
+    else if constexpr (std::is_integral_v<Type> && !std::is_same_v<Type, bool>) statement.Bind(index, static_cast<int64_t>(value));
+    else if constexpr (std::is_floating_point_v<Type>) statement.Bind(index, static_cast<double>(value));
+    else if constexpr (std::is_same_v<Type, std::vector<std::byte>>) statement.Bind(index, std::span<std::byte const>(value));
+    else statement.Bind(index, value);
+  }
+
+  // Reads a value of a column type, the inverse of SQLiteBindValue.
+  template <typename Type, typename Reader>
+  Type SQLiteReadValue(Reader const& reader, int32_t const column)
+  {
+    if constexpr (SQLiteNullable<Type>::value)
+    {
+      if (reader.GetType(column) == SQLiteType::Null)
+      {
+        return std::nullopt;
+      }
+
+      return SQLiteReadValue<typename SQLiteNullable<Type>::Value>(reader, column);
+    }
+    else if constexpr (std::is_same_v<Type, std::vector<std::byte>>)
+    {
+      std::byte const* const data = reader.GetBlob(column);
+      return Type(data, data + reader.GetBlobLength(column));
+    }
+    else
+    {
+      return reader.template Get<Type>(column);
+    }
+  }
+
+  // One member of a record as a column. Members of type std::optional are nullable; all other
+  // columns are declared Not Null.
+  template <SQLiteFixedString Name, auto Member, bool Key = false>
+  struct SQLiteColumn
+  {
+    using Record = typename SQLiteMemberPointer<decltype(Member)>::Class;
+    using Type = typename SQLiteMemberPointer<decltype(Member)>::Type;
+    using Value = typename SQLiteNullable<Type>::Value;
+
+    static constexpr std::string_view ColumnName = Name.View();
+    static constexpr bool PrimaryKey = Key;
+    static constexpr bool Nullable = SQLiteNullable<Type>::value;
+    static constexpr SQLiteType ColumnType = SQLiteColumnTypeOf<Value>();
+
+    template <typename Statement>
+    static void Bind(Statement const& statement, int32_t const index, Record const& record)
+    {
+      SQLiteBindValue(statement, index, record.*Member);
+    }
+
+    template <typename Reader>
+    static void Read(Reader const& reader, int32_t const column, Record& record)
+    {
+      record.*Member = SQLiteReadValue<Type>(reader, column);
+    }
+  };
+
+  template <SQLiteFixedString Name, auto Member>
+  using SQLiteKeyColumn = SQLiteColumn<Name, Member, true>;
+
+  // The SQL text of a table; SQLiteTable exposes it rendered at compile time.
+  template <SQLiteFixedString Name, typename ... Columns>
+  struct SQLiteTableText
+  {
+    // Writes the quoted columns, keys only if keys, each followed by suffix and joined by separator.
+    static constexpr void List(SQLiteConstexprText& sql, std::string_view const separator, std::string_view const suffix, bool const keys)
+    {
+      bool first = true;
+
+      auto const add = [&](std::string_view const name, bool const key)
+      {
+        if (!keys || key)
+        {
+          sql << (first ? "" : separator);
+          sql.Quote(name) << suffix;
+          first = false;
+        }
+      };
+
+      (add(Columns::ColumnName, Columns::PrimaryKey), ...);
+    }
+
+    static constexpr void Create(SQLiteConstexprText& sql)
+    {
+      sql << "Create Table If Not Exists ";
+      sql.Quote(Name.View()) << " ( ";
+
+      auto const add = [&](std::string_view const name, SQLiteType const type, bool const nullable)
+      {
+        sql.Quote(name) << " " << SQLiteTypeName(type) << (nullable ? ", " : " Not Null, ");
+      };
+
+      (add(Columns::ColumnName, Columns::ColumnType, Columns::Nullable), ...);
+      sql << "Primary Key ( ";
+      List(sql, ", ", "", true);
+      sql << " ) )";
+    }
+
+    // Rows is the number of rows in the Values clause.
+    template <size_t Rows = 1>
+    static constexpr void Insert(SQLiteConstexprText& sql)
+    {
+      sql << "Insert Into ";
+      sql.Quote(Name.View()) << " ( ";
+      List(sql, ", ", "", false);
+      sql << " ) Values ";
+
+      for (size_t row = 0; row < Rows; ++row)
+      {
+        sql << (row ? ", ( ?" : "( ?");
+
+        for (size_t index = 1; index < sizeof...(Columns); ++index)
+        {
+          sql << ", ?";
+        }
+
+        sql << " )";
+      }
+    }
+
+    template <size_t Rows = 1>
+    static constexpr void Upsert(SQLiteConstexprText& sql)
+    {
+      Insert<Rows>(sql);
+      sql << " On Conflict ( ";
+      List(sql, ", ", "", true);
+      sql << " ) Do ";
+
+      if constexpr ((Columns::PrimaryKey && ...))
+      {
+        sql << "Nothing";
+        return;
+      }
+
+      sql << "Update Set ";
+      bool first = true;
+
+      auto const add = [&](std::string_view const name, bool const key)
+      {
+        if (!key)
+        {
+          sql << (first ? "" : ", ");
+          sql.Quote(name) << " = excluded.";
+          sql.Quote(name);
+          first = false;
+        }
+      };
+
+      (add(Columns::ColumnName, Columns::PrimaryKey), ...);
+    }
+
+    static constexpr void Select(SQLiteConstexprText& sql)
+    {
+      sql << "Select ";
+      List(sql, ", ", "", false);
+      sql << " From ";
+      sql.Quote(Name.View()) << " Where ";
+      List(sql, " And ", " = ?", true);
+    }
+
+    static constexpr void Delete(SQLiteConstexprText& sql)
+    {
+      sql << "Delete From ";
+      sql.Quote(Name.View()) << " Where ";
+      List(sql, " And ", " = ?", true);
+    }
+  };
+
+  // Describes a table by its columns, in order, and renders its SQL at compile time:
+  //
+  //   using Orders = SQLiteTable<"Orders",
+  //     SQLiteKeyColumn<"Id", &Order::Id>,
+  //     SQLiteColumn<"Customer", &Order::Customer>,
+  //     SQLiteColumn<"Note", &Order::Note>>;
+  //
+  //   Execute(connection, Orders::Create.data());
+  //
+  // Placeholders are numbered in column order; Select and Delete take the key columns in order.
+  // Upsert is Insert with an On Conflict clause, which needs SQLite 3.24, and UpsertBatch the same
+  // for BatchRows records at once.
+  template <SQLiteFixedString Name, typename ... Columns>
+  struct SQLiteTable
+  {
+    using ColumnList = std::tuple<Columns ...>;
+    using Record = std::tuple_element_t<0, std::tuple<typename Columns::Record ...>>;
+    using Key = decltype(std::tuple_cat(std::declval<std::conditional_t<Columns::PrimaryKey, std::tuple<typename Columns::Type>, std::tuple<>>>() ...));
+
+    static_assert((std::is_same_v<Record, typename Columns::Record> && ...), "SQLiteTable: every column must be a member of the same record");
+    static_assert((Columns::PrimaryKey || ...), "SQLiteTable: at least one column must be a key");
+
+    static constexpr std::string_view TableName = Name.View();
+    static constexpr int32_t ColumnCount = sizeof...(Columns);
+    static constexpr int32_t KeyCount = std::tuple_size_v<Key>;
+
+    // Enough rows to amortize the step, within the 999 placeholders SQLite allowed before 3.32.
+    static constexpr int32_t BatchRows = std::clamp(999 / ColumnCount, 1, 64);
+
+    static constexpr std::string_view Create = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::Create>::View;
+    static constexpr std::string_view Insert = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::template Insert<>>::View;
+    static constexpr std::string_view Upsert = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::template Upsert<>>::View;
+    static constexpr std::string_view UpsertBatch = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::template Upsert<BatchRows>>::View;
+    static constexpr std::string_view Select = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::Select>::View;
+    static constexpr std::string_view Delete = SQLiteStaticText<&SQLiteTableText<Name, Columns ...>::Delete>::View;
+
+    // Binds every member of record to placeholders first to first + ColumnCount - 1, as Insert and
+    // Upsert expect from 1. Text and blobs are bound without a copy, so record must outlive the step.
+    template <typename Statement>
+    static void Bind(Statement const& statement, Record const& record, int32_t const first = 1)
+    {
+      int32_t index = first - 1;
+      (Columns::Bind(statement, ++index, record), ...);
+    }
+
+    // Binds a key to placeholders 1 to KeyCount, as Select and Delete expect.
+    template <typename Statement>
+    static void BindKey(Statement const& statement, Key const& key)
+    {
+      std::apply([&](auto const& ... values)
+        {
+          int32_t index = 0;
+          (SQLiteBindValue(statement, ++index, values), ...);
+        }, key);
+    }
+
+    // Reads a record from the columns of a row of Select, in column order.
+    template <typename Reader>
+    static Record Read(Reader const& reader)
+    {
+      Record record{ };
+      int32_t column = 0;
+      (Columns::Read(reader, column++, record), ...);
+      return record;
+    }
+  };
+
+  // Names the SQLiteTable that Upsert writes records of type Record to:
+  //
+  //   template <> struct ModernCppSQLite::SQLiteTableOf<Order> { using Table = Orders; };
+  template <typename Record>
+  struct SQLiteTableOf;
+
+  struct UpsertOptions
+  {
+    // Records written per transaction when the caller has none open.
+    size_t TransactionSize = 4096;
+
+    // Writes Table::BatchRows records per statement with UpsertBatch, and the rest one at a time.
+    bool MultiRow = true;
+  };
+
+  // Upserts records through single, and through batch unless it is null, in transactions of
+  // options.TransactionSize records or in the caller's transaction if one is open.
+  template <typename Table, SQLiteThreadingPolicy ThreadingPolicy>
+  void SQLiteUpsertRecords(BasicSQLiteConnection<ThreadingPolicy> const& connection, BasicSQLiteStatement<ThreadingPolicy> const& single,
+    BasicSQLiteStatement<ThreadingPolicy> const* const batch, std::span<typename Table::Record const> const records, UpsertOptions const& options)
+  {
+    size_t const transactionSize = std::max<size_t>(options.TransactionSize, 1);
+
+    for (size_t begin = 0; begin < records.size(); begin += transactionSize)
+    {
+      auto const chunk = records.subspan(begin, std::min(transactionSize, records.size() - begin));
+      std::optional<SQLiteTransaction<ThreadingPolicy>> transaction;
+
+      if (sqlite3_get_autocommit(connection.GetAbi()))
+      {
+        transaction.emplace(connection, SQLiteTransactionType::Immediate);
+      }
+
+      try
+      {
+        size_t row = 0;
+
+        for (; batch && row + Table::BatchRows <= chunk.size(); row += Table::BatchRows)
+        {
+          for (int32_t record = 0; record < Table::BatchRows; ++record)
+          {
+            Table::Bind(*batch, chunk[row + record], record * Table::ColumnCount + 1);
+          }
+
+          batch->Execute();
+          batch->Reset();
+        }
+
+        for (; row < chunk.size(); ++row)
+        {
+          Table::Bind(single, chunk[row]);
+          single.Execute();
+          single.Reset();
+        }
+      }
+      catch (SQLiteException const&)
+      {
+        sqlite3_reset(single.GetAbi());
+
+        if (batch)
+        {
+          sqlite3_reset(batch->GetAbi());
+        }
+
+        throw;
+      }
+
+      if (transaction)
+      {
+        transaction->Commit();
+      }
+    }
+  }
+
+  // Inserts records into the table SQLiteTableOf<Record> names, or updates those whose key
+  // exists, preparing its statements once for the call:
+  //
+  //   Upsert<Order>(connection, orders);
+  template <typename Record, SQLiteThreadingPolicy ThreadingPolicy>
+  void Upsert(BasicSQLiteConnection<ThreadingPolicy> const& connection, std::span<Record const> const records, UpsertOptions const& options = {})
+  {
+    using Table = typename SQLiteTableOf<Record>::Table;
+
+    BasicSQLiteStatement<ThreadingPolicy> single(connection, Table::Upsert.data());
+    BasicSQLiteStatement<ThreadingPolicy> batch;
+    bool const multiRow = options.MultiRow && records.size() >= static_cast<size_t>(Table::BatchRows);
+
+    if (multiRow)
+    {
+      batch.Prepare(connection, Table::UpsertBatch.data());
+    }
+
+    SQLiteUpsertRecords<Table>(connection, single, multiRow ? &batch : nullptr, records, options);
+  }
+
+  // Prepares the statements of a table once and binds and reads its records through them.
+  template <typename Table, SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class TableAccessor
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+    using Record = typename Table::Record;
+    using Key = typename Table::Key;
+
+    // Runs statement once and leaves it ready for the next call.
+    static void Run(Statement const& statement)
+    {
+      try
+      {
+        statement.Execute();
+      }
+      catch (SQLiteException const&)
+      {
+        sqlite3_reset(statement.GetAbi());
+        throw;
+      }
+
+      statement.Reset();
+    }
+
+  public:
+    TableAccessor(TableAccessor const&) = delete;
+    TableAccessor& operator=(TableAccessor const&) = delete;
+
+    // Creates the table if it does not exist.
+    explicit TableAccessor(Connection const& connection)
+      : m_Connection(&connection)
+    {
+      Execute(connection, Table::Create.data());
+
+      m_Insert.Prepare(connection, Table::Insert.data());
+      m_Upsert.Prepare(connection, Table::Upsert.data());
+      m_UpsertBatch.Prepare(connection, Table::UpsertBatch.data());
+      m_Select.Prepare(connection, Table::Select.data());
+      m_Delete.Prepare(connection, Table::Delete.data());
+    }
+
+    TableAccessor(TableAccessor&&) noexcept = default;
+
+    void Insert(Record const& record)
+    {
+      Table::Bind(m_Insert, record);
+      Run(m_Insert);
+    }
+
+    void Upsert(Record const& record)
+    {
+      Table::Bind(m_Upsert, record);
+      Run(m_Upsert);
+    }
+
+    // As the free Upsert, through the statements prepared once for the accessor.
+    void Upsert(std::span<Record const> const records, UpsertOptions const& options = {})
+    {
+      SQLiteUpsertRecords<Table>(*m_Connection, m_Upsert, options.MultiRow ? &m_UpsertBatch : nullptr, records, options);
+    }
+
+    std::optional<Record> Find(Key const& key)
+    {
+      Table::BindKey(m_Select, key);
+      std::optional<Record> record;
+
+      try
+      {
+        if (m_Select.Step())
+        {
+          record = Table::Read(m_Select);
+        }
+      }
+      catch (SQLiteException const&)
+      {
+        sqlite3_reset(m_Select.GetAbi());
+        throw;
+      }
+
+      m_Select.Reset();
+      return record;
+    }
+
+    // Returns whether a record was deleted.
+    bool Delete(Key const& key)
+    {
+      Table::BindKey(m_Delete, key);
+      Run(m_Delete);
+      return sqlite3_changes(m_Connection->GetAbi()) > 0;
+    }
+
+  private:
+    Connection const* m_Connection;
+    Statement m_Insert;
+    Statement m_Upsert;
+    Statement m_UpsertBatch;
+    Statement m_Select;
+    Statement m_Delete;
+  };
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  struct StatisticsMaintainerOptions
+  {
+    // A table is analyzed again once it has seen this many changes, or Drift times the rows it
+    // had when last analyzed if that is more.
+    int64_t MinimumChanges = 10'000;
+    double Drift = 0.2;
+
+    // Rows examined per index by each ANALYZE, or 0 for all of them; see PRAGMA analysis_limit.
+    int32_t AnalysisLimit = 0;
+
+    std::chrono::milliseconds BusyTimeout = std::chrono::seconds(5);
+  };
+
+  // Keeps sqlite_stat1 current for the main database of a connection. Changes are counted per
+  // table by an update hook, which replaces any other update hook of the connection; changes it
+  // does not see, such as those to WITHOUT ROWID tables, are counted from TotalChanges and make the
+  // whole database due. Tables are analyzed on a second connection on a background thread.
+  //
+  // Poll runs on the connection's thread, between statements: it queues the tables that have
+  // drifted and reloads the statistics written since the last poll. Reloading expires the
+  // connection's prepared statements, which SQLite prepares again with new plans on their next step.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class StatisticsMaintainer
+  {
+  private:
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    struct Table
+    {
+      int64_t Changes = 0;
+      int64_t Rows = 0;
+      bool Queued = false;
+    };
+
+    static void OnUpdate(void* const context, int32_t, char const* const database, char const* const table, sqlite3_int64) noexcept
+    {
+      StatisticsMaintainer& self = *static_cast<StatisticsMaintainer*>(context);
+
+      if (std::strcmp(database, "main") != 0)
+      {
+        return;
+      }
+
+      // Most runs of changes are to one table; avoid hashing its name for each row.
+      if (!self.m_Last || self.m_Last->first != table)
+      {
+        self.m_Last = &*self.m_Tables.try_emplace(table).first;
+      }
+
+      ++self.m_Last->second.Changes;
+      ++self.m_Hooked;
+    }
+
+    // The row count of each table as of its last ANALYZE.
+    void ReadRows()
+    {
+      Statement exists(*m_Connection, "Select 1 From sqlite_master Where Type = 'table' And Name = 'sqlite_stat1'");
+
+      if (!exists.Step())
+      {
+        return;
+      }
+
+      for (Statement select(*m_Connection, "Select Tbl, Max(Cast(Stat As Integer)) From sqlite_stat1 Group By Tbl"); select.Step();)
+      {
+        m_Last = nullptr;
+        m_Tables[select.GetString(0)].Rows = select.GetInt64(1);
+      }
+    }
+
+    void Queue(std::string table)
+    {
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Queue.push_back(std::move(table));
+      }
+
+      m_Wake.notify_one();
+    }
+
+    // Any other failure stops the thread, and Poll reports it.
+    void Run(std::string const filename, StatisticsMaintainerOptions const options) noexcept
+    {
+      try
+      {
+        Analyze(filename, options);
+      }
+      catch (SQLiteException const& ex)
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Error.emplace(ex);
+      }
+      catch (std::exception const& ex)
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Error.emplace(SQLITE_ERROR, ex.what());
+      }
+    }
+
+    void Analyze(std::string const& filename, StatisticsMaintainerOptions const& options)
+    {
+      SQLiteConfinedConnection connection(filename.c_str());
+      connection.SetBusyTimeout(options.BusyTimeout);
+
+      if (options.AnalysisLimit > 0)
+      {
+        // The pragma answers with the limit it set, so it is stepped rather than executed.
+        BasicSQLiteStatement<SQLiteThreadConfined>(connection, ("PRAGMA analysis_limit = " + std::to_string(options.AnalysisLimit)).c_str()).Step();
+      }
+
+      std::unique_lock lock(m_Mutex);
+
+      while (true)
+      {
+        m_Wake.wait(lock, [&] { return m_Stopping || !m_Queue.empty(); });
+
+        if (m_Stopping)
+        {
+          return;
+        }
+
+        std::string const table = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        lock.unlock();
+
+        // A table that cannot be analyzed now, because it was dropped or the database stayed
+        // busy, is queued again when it drifts again.
+        try
+        {
+          Execute(connection, table.empty() ? "Analyze main" : ("Analyze main." + SQLiteQuoteIdentifier(table)).c_str());
+        }
+        catch (SQLiteException const&)
+        {
+        }
+
+        lock.lock();
+        m_Analyzed.push_back(table);
+      }
+    }
+
+  public:
+    StatisticsMaintainer(StatisticsMaintainer const&) = delete;
+    StatisticsMaintainer& operator=(StatisticsMaintainer const&) = delete;
+
+    explicit StatisticsMaintainer(Connection const& connection, StatisticsMaintainerOptions const& options = {})
+      : m_Connection(&connection)
+      , m_MinimumChanges(options.MinimumChanges)
+      , m_Drift(options.Drift)
+      , m_Total(connection.TotalChanges())
+    {
+      char const* const filename = sqlite3_db_filename(connection.GetAbi(), "main");
+
+      if (!filename || !*filename)
+      {
+        throw SQLiteException(SQLITE_MISUSE, "StatisticsMaintainer: the main database must be a file another connection can open");
+      }
+
+      ReadRows();
+
+      sqlite3_update_hook(connection.GetAbi(), OnUpdate, this);
+      m_Thread = std::thread(&StatisticsMaintainer::Run, this, std::string(filename), options);
+    }
+
+    ~StatisticsMaintainer()
+    {
+      sqlite3_update_hook(m_Connection->GetAbi(), nullptr, nullptr);
+
+      {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+      }
+
+      m_Wake.notify_one();
+      m_Thread.join();
+    }
+
+    // Throws why the background thread stopped, if it did.
+    void Poll()
+    {
+      std::vector<std::string> analyzed;
+
+      {
+        std::lock_guard lock(m_Mutex);
+
+        if (m_Error)
+        {
+          throw *m_Error;
+        }
+
+        analyzed.swap(m_Analyzed);
+      }
+
+      if (!analyzed.empty())
+      {
+        Execute(*m_Connection, "Analyze sqlite_master");
+        ReadRows();
+        m_Analyses += analyzed.size();
+
+        for (std::string const& table : analyzed)
+        {
+          if (table.empty())
+          {
+            m_WholeQueued = false;
+          }
+          else if (auto const found = m_Tables.find(table); found != m_Tables.end())
+          {
+            found->second.Queued = false;
+          }
+        }
+      }
+
+      sqlite3_int64 const total = m_Connection->TotalChanges();
+      m_Unattributed += std::max<int64_t>(0, total - m_Total - m_Hooked);
+      m_Total = total;
+      m_Hooked = 0;
+
+      for (auto& [name, table] : m_Tables)
+      {
+        if (!table.Queued && table.Changes >= std::max(m_MinimumChanges, static_cast<int64_t>(m_Drift * static_cast<double>(table.Rows))))
+        {
+          table.Queued = true;
+          table.Changes = 0;
+          Queue(name);
+        }
+      }
+
+      if (!m_WholeQueued && m_Unattributed >= m_MinimumChanges)
+      {
+        m_WholeQueued = true;
+        m_Unattributed = 0;
+        Queue(std::string());
+      }
+    }
+
+    // ANALYZE runs whose statistics have been reloaded by Poll.
+    int64_t GetAnalysisCount() const noexcept
+    {
+      return m_Analyses;
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+    int64_t m_MinimumChanges = 0;
+    double m_Drift = 0;
+
+    // Only used on the connection's thread.
+    std::unordered_map<std::string, Table> m_Tables;
+    std::pair<std::string const, Table>* m_Last = nullptr;
+    int64_t m_Hooked = 0;
+    int64_t m_Unattributed = 0;
+    sqlite3_int64 m_Total = 0;
+    bool m_WholeQueued = false;
+    int64_t m_Analyses = 0;
+
+    // Shared with the background thread; an empty name is the whole database.
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::deque<std::string> m_Queue;
+    std::vector<std::string> m_Analyzed;
+    bool m_Stopping = false;
+    std::optional<SQLiteException> m_Error;
+    std::thread m_Thread;
+  };
+}
@@ -0,0 +1,814 @@
+#pragma once
+
+#include "VirtualTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  // Gorilla compression of (time, value) samples: timestamps as zigzag-encoded delta-of-deltas
+  // in 1, 9, 12, 16 or 68 bits, values as the XOR with the previous value, storing only the
+  // meaningful bits and reusing the previous leading/trailing zero window when it fits.
+  class GorillaEncoder
+  {
+  private:
+    void Write(uint64_t const value, int32_t const bits)
+    {
+      uint64_t const masked = bits == 64 ? value : value & ((uint64_t{ 1 } << bits) - 1);
+      int32_t const free = 64 - m_Used;
+
+      if (bits < free)
+      {
+        m_Buffer |= masked << (free - bits);
+        m_Used += bits;
+        return;
+      }
+
+      m_Buffer |= masked >> (bits - free);
+
+      for (int32_t shift = 56; shift >= 0; shift -= 8)
+      {
+        m_Bytes += static_cast<char>(m_Buffer >> shift);
+      }
+
+      m_Used = bits - free;
+      m_Buffer = m_Used == 0 ? 0 : masked << (64 - m_Used);
+    }
+
+  public:
+    void Append(int64_t const time, double const value)
+    {
+      uint64_t const bits = std::bit_cast<uint64_t>(value);
+
+      if (m_Count == 0)
+      {
+        Write(static_cast<uint64_t>(time), 64);
+        Write(bits, 64);
+        m_FirstTime = time;
+      }
+      else
+      {
+        int64_t const delta = time - m_LastTime;
+        int64_t const deltaOfDelta = delta - m_LastDelta;
+        uint64_t const zigzag = (static_cast<uint64_t>(deltaOfDelta) << 1) ^ static_cast<uint64_t>(deltaOfDelta >> 63);
+
+        if (zigzag == 0) Write(0b0, 1);
+        else if (zigzag < (1 << 7)) { Write(0b10, 2); Write(zigzag, 7); }
+        else if (zigzag < (1 << 9)) { Write(0b110, 3); Write(zigzag, 9); }
+        else if (zigzag < (1 << 12)) { Write(0b1110, 4); Write(zigzag, 12); }
+        else { Write(0b1111, 4); Write(zigzag, 64); }
+
+        m_LastDelta = delta;
+
+        if (uint64_t const xored = bits ^ m_LastBits; xored == 0)
+        {
+          Write(0b0, 1);
+        }
+        else
+        {
+          int32_t const leading = std::min(std::countl_zero(xored), 31);
+          int32_t const trailing = std::countr_zero(xored);
+
+          if (leading >= m_Leading && trailing >= m_Trailing)
+          {
+            Write(0b10, 2);
+            Write(xored >> m_Trailing, 64 - m_Leading - m_Trailing);
+          }
+          else
+          {
+            int32_t const meaningful = 64 - leading - trailing;
+
+            Write(0b11, 2);
+            Write(leading, 5);
+            Write(meaningful - 1, 6);
+            Write(xored >> trailing, meaningful);
+
+            m_Leading = leading;
+            m_Trailing = trailing;
+          }
+        }
+      }
+
+      m_LastTime = time;
+      m_LastBits = bits;
+      ++m_Count;
+    }
+
+    // The encoded samples so far; the last byte is zero padded.
+    std::string Bytes() const
+    {
+      std::string result = m_Bytes;
+
+      for (int32_t shift = 56; shift > 56 - ((m_Used + 7) / 8) * 8; shift -= 8)
+      {
+        result += static_cast<char>(m_Buffer >> shift);
+      }
+
+      return result;
+    }
+
+    void Clear() noexcept
+    {
+      *this = GorillaEncoder();
+    }
+
+    int32_t Count() const noexcept
+    {
+      return m_Count;
+    }
+
+    int64_t FirstTime() const noexcept
+    {
+      return m_FirstTime;
+    }
+
+    int64_t LastTime() const noexcept
+    {
+      return m_LastTime;
+    }
+
+  private:
+    std::string m_Bytes;
+    uint64_t m_Buffer = 0;
+    int32_t m_Used = 0;
+
+    int32_t m_Count = 0;
+    int64_t m_FirstTime = 0;
+    int64_t m_LastTime = 0;
+    int64_t m_LastDelta = 0;
+    uint64_t m_LastBits = 0;
+    int32_t m_Leading = 64;
+    int32_t m_Trailing = 64;
+  };
+
+  class GorillaDecoder
+  {
+  private:
+    uint64_t Window() const noexcept
+    {
+      size_t const offset = m_Position / 8;
+      uint64_t window = 0;
+
+      if (offset + 8 <= m_Data.size())
+      {
+        std::memcpy(&window, m_Data.data() + offset, 8);
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+          window = ((window & 0x00000000FFFFFFFFull) << 32) | ((window & 0xFFFFFFFF00000000ull) >> 32);
+          window = ((window & 0x0000FFFF0000FFFFull) << 16) | ((window & 0xFFFF0000FFFF0000ull) >> 16);
+          window = ((window & 0x00FF00FF00FF00FFull) << 8) | ((window & 0xFF00FF00FF00FF00ull) >> 8);
+        }
+      }
+      else
+      {
+        for (size_t index = 0; index < 8; ++index)
+        {
+          window = (window << 8) | (offset + index < m_Data.size() ? static_cast<uint8_t>(m_Data[offset + index]) : 0);
+        }
+      }
+
+      return window << (m_Position % 8);
+    }
+
+    uint64_t Read(int32_t const bits) noexcept
+    {
+      if (bits > 56)
+      {
+        uint64_t const high = Read(bits - 32);
+        return (high << 32) | Read(32);
+      }
+
+      uint64_t const value = Window() >> (64 - bits);
+      m_Position += bits;
+      return value;
+    }
+
+    // Counts the leading one bits of the next prefix, reading at most limit bits.
+    int32_t Prefix(int32_t const limit) noexcept
+    {
+      int32_t const ones = std::min(std::countl_one(Window()), limit);
+      m_Position += std::min(ones + 1, limit);
+      return ones;
+    }
+
+  public:
+    explicit GorillaDecoder(std::span<std::byte const> const data) noexcept : m_Data(data)
+    {
+    }
+
+    // Appends count samples in struct-of-arrays form, the layout the range filters work on.
+    void Decode(int32_t const count, std::vector<int64_t>& times, std::vector<double>& values)
+    {
+      if (count <= 0)
+      {
+        return;
+      }
+
+      size_t const start = times.size();
+      times.resize(start + count);
+      values.resize(start + count);
+
+      int64_t* const time = times.data() + start;
+      double* const value = values.data() + start;
+
+      time[0] = static_cast<int64_t>(Read(64));
+      uint64_t bits = Read(64);
+      value[0] = std::bit_cast<double>(bits);
+
+      int64_t delta = 0;
+      int32_t leading = 0;
+      int32_t trailing = 0;
+
+      for (int32_t index = 1; index < count; ++index)
+      {
+        static constexpr int32_t Widths[] = { 0, 7, 9, 12, 64 };
+
+        if (int32_t const width = Widths[Prefix(4)]; width != 0)
+        {
+          uint64_t const zigzag = Read(width);
+          delta += static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        }
+
+        time[index] = time[index - 1] + delta;
+
+        if (int32_t const control = Prefix(2); control == 1)
+        {
+          bits ^= Read(64 - leading - trailing) << trailing;
+        }
+        else if (control == 2)
+        {
+          leading = static_cast<int32_t>(Read(5));
+          int32_t const meaningful = static_cast<int32_t>(Read(6)) + 1;
+          trailing = 64 - leading - meaningful;
+          bits ^= Read(meaningful) << trailing;
+        }
+
+        value[index] = std::bit_cast<double>(bits);
+      }
+    }
+
+  private:
+    std::span<std::byte const> m_Data;
+    size_t m_Position = 0;
+  };
+
+  struct TimeSeriesOptions
+  {
+    std::string Table = "TimeSeries";
+
+    // Samples buffered per series before they are compressed into a chunk row.
+    int32_t ChunkSize = 1024;
+  };
+
+  struct TimeSeriesSummary
+  {
+    int64_t Count = 0;
+    double Sum = 0;
+    double Min = std::numeric_limits<double>::infinity();
+    double Max = -std::numeric_limits<double>::infinity();
+  };
+
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  class TimeSeriesTable;
+
+  // Append-only store of (time, value) samples per named series. Samples are buffered per
+  // series and written as Gorilla-compressed chunks of (Series, FirstTime, LastTime, Count, Data).
+  // Times must not decrease within a series.
+  template <SQLiteThreadingPolicy ThreadingPolicy = SQLiteShared>
+  class TimeSeriesStore
+  {
+  private:
+    friend class TimeSeriesTable<ThreadingPolicy>;
+
+    using Connection = BasicSQLiteConnection<ThreadingPolicy>;
+    using Statement = BasicSQLiteStatement<ThreadingPolicy>;
+
+    struct SeriesBuffer
+    {
+      GorillaEncoder Encoder;
+      int64_t LastTime = std::numeric_limits<int64_t>::min();
+    };
+
+    static std::span<std::byte const> Bytes(std::string_view const value) noexcept
+    {
+      return std::as_bytes(std::span(value.data(), value.size()));
+    }
+
+    // Decodes a chunk and returns the [begin, end) positions of the samples within [first, last].
+    static std::pair<size_t, size_t> Decode(std::span<std::byte const> const data, int32_t const count, int64_t const first, int64_t const last, std::vector<int64_t>& times, std::vector<double>& values)
+    {
+      times.clear();
+      values.clear();
+      GorillaDecoder(data).Decode(count, times, values);
+
+      auto const begin = std::lower_bound(times.begin(), times.end(), first);
+      auto const end = std::upper_bound(begin, times.end(), last);
+      return { begin - times.begin(), end - times.begin() };
+    }
+
+    // Writes the encoder's samples as a chunk and leaves them in it; the caller clears it once
+    // the chunk is committed.
+    void FlushSeries(std::string const& series, GorillaEncoder const& encoder)
+    {
+      std::string const data = encoder.Bytes();
+
+      try
+      {
+        m_Insert.Bind(1, series);
+        m_Insert.Bind(2, encoder.FirstTime());
+        m_Insert.Bind(3, encoder.LastTime());
+        m_Insert.Bind(4, encoder.Count());
+        m_Insert.Bind(5, Bytes(data));
+        m_Insert.Execute();
+        m_Insert.Reset();
+      }
+      catch (...)
+      {
+        sqlite3_reset(m_Insert.GetAbi());
+        throw;
+      }
+    }
+
+  public:
+    TimeSeriesStore(TimeSeriesStore const&) = delete;
+    TimeSeriesStore& operator=(TimeSeriesStore const&) = delete;
+
+    explicit TimeSeriesStore(Connection const& connection, TimeSeriesOptions options = {})
+      : m_Connection(&connection)
+      , m_Options(std::move(options))
+    {
+      std::string const table = SQLiteQuoteIdentifier(m_Options.Table);
+
+      Execute(connection, ("Create Table If Not Exists " + table +
+        " ( Id Integer Primary Key, Series Text Not Null, FirstTime Integer Not Null, LastTime Integer Not Null, Count Integer Not Null, Data Blob Not Null )").c_str());
+      Execute(connection, ("Create Index If Not Exists " + SQLiteQuoteIdentifier(m_Options.Table + "_Series") + " On " + table + " ( Series, LastTime )").c_str());
+
+      m_Insert.Prepare(connection, ("Insert Into " + table + " ( Series, FirstTime, LastTime, Count, Data ) Values ( ?, ?, ?, ?, ? )").c_str());
+      m_LastTime.Prepare(connection, ("Select Max(LastTime) From " + table + " Where Series = ?").c_str());
+      m_Chunks.Prepare(connection, ("Select Count, Data From " + table + " Where Series = ? And LastTime >= ? And FirstTime <= ? Order By LastTime").c_str());
+    }
+
+    // Call Flush to observe write errors; the destructor can only drop them.
+    ~TimeSeriesStore() noexcept
+    {
+      try
+      {
+        Flush();
+      }
+      catch (SQLiteException const&)
+      {
+      }
+    }
+
+    void Append(std::string_view const series, int64_t const time, double const value)
+    {
+      auto buffer = m_Buffers.find(series);
+
+      if (buffer == m_Buffers.end())
+      {
+        buffer = m_Buffers.emplace(std::string(series), SeriesBuffer()).first;
+
+        m_LastTime.Bind(1, buffer->first);
+
+        if (m_LastTime.Step() && m_LastTime.GetType() != SQLiteType::Null)
+        {
+          buffer->second.LastTime = m_LastTime.GetInt64();
+        }
+
+        m_LastTime.Reset();
+      }
+
+      if (time < buffer->second.LastTime)
+      {
+        throw SQLiteException(SQLITE_CONSTRAINT);
+      }
+
+      buffer->second.Encoder.Append(time, value);
+      buffer->second.LastTime = time;
+
+      if (buffer->second.Encoder.Count() >= m_Options.ChunkSize)
+      {
+        FlushSeries(buffer->first, buffer->second.Encoder);
+        buffer->second.Encoder.Clear();
+      }
+    }
+
+    // Writes every partial chunk in one transaction, or in the caller's transaction if one is open.
+    // The samples stay buffered until every chunk is written and committed, so a failed Flush can
+    // be retried.
+    void Flush()
+    {
+      std::optional<SQLiteTransaction<ThreadingPolicy>> transaction;
+
+      for (auto& [series, buffer] : m_Buffers)
+      {
+        if (buffer.Encoder.Count() == 0)
+        {
+          continue;
+        }
+
+        if (!transaction && sqlite3_get_autocommit(m_Connection->GetAbi()))
+        {
+          transaction.emplace(*m_Connection, SQLiteTransactionType::Immediate);
+        }
+
+        FlushSeries(series, buffer.Encoder);
+      }
+
+      if (transaction)
+      {
+        transaction->Commit();
+      }
+
+      for (auto& [series, buffer] : m_Buffers)
+      {
+        buffer.Encoder.Clear();
+      }
+    }
+
+    // Calls callback(std::span<int64_t const> times, std::span<double const> values) once per
+    // chunk with the samples in [first, last], in time order, buffered samples included.
+    template <typename F>
+    void Scan(std::string_view const series, int64_t const first, int64_t const last, F&& callback)
+    {
+      auto const visit = [&](std::span<std::byte const> const data, int32_t const count)
+        {
+          auto const [begin, end] = Decode(data, count, first, last, m_Times, m_Values);
+
+          if (begin != end)
+          {
+            callback(std::span<int64_t const>(m_Times.data() + begin, end - begin), std::span<double const>(m_Values.data() + begin, end - begin));
+          }
+        };
+
+      m_Chunks.Bind(1, series.data(), static_cast<int32_t>(series.size()));
+      m_Chunks.Bind(2, first);
+      m_Chunks.Bind(3, last);
+
+      while (m_Chunks.Step())
+      {
+        visit(std::span(m_Chunks.GetBlob(1), m_Chunks.GetBlobLength(1)), m_Chunks.GetInt32(0));
+      }
+
+      m_Chunks.Reset();
+
+      if (auto const buffer = m_Buffers.find(series); buffer != m_Buffers.end() && buffer->second.Encoder.Count() != 0)
+      {
+        std::string const data = buffer->second.Encoder.Bytes();
+        visit(Bytes(data), buffer->second.Encoder.Count());
+      }
+    }
+
+    std::pair<std::vector<int64_t>, std::vector<double>> Query(std::string_view const series, int64_t const first, int64_t const last)
+    {
+      std::pair<std::vector<int64_t>, std::vector<double>> result;
+
+      Scan(series, first, last, [&](std::span<int64_t const> const times, std::span<double const> const values)
+        {
+          result.first.insert(result.first.end(), times.begin(), times.end());
+          result.second.insert(result.second.end(), values.begin(), values.end());
+        });
+
+      return result;
+    }
+
+    TimeSeriesSummary Summarize(std::string_view const series, int64_t const first, int64_t const last)
+    {
+      TimeSeriesSummary summary;
+
+      Scan(series, first, last, [&](std::span<int64_t const>, std::span<double const> const values)
+        {
+          // Independent lanes so the compiler can keep the loop in vector registers.
+          double sum[4] = { };
+          double minimum[4] = { summary.Min, summary.Min, summary.Min, summary.Min };
+          double maximum[4] = { summary.Max, summary.Max, summary.Max, summary.Max };
+          size_t index = 0;
+
+          for (; index + 4 <= values.size(); index += 4)
+          {
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+              double const value = values[index + lane];
+              sum[lane] += value;
+              minimum[lane] = value < minimum[lane] ? value : minimum[lane];
+              maximum[lane] = value > maximum[lane] ? value : maximum[lane];
+            }
+          }
+
+          for (; index < values.size(); ++index)
+          {
+            sum[0] += values[index];
+            minimum[0] = values[index] < minimum[0] ? values[index] : minimum[0];
+            maximum[0] = values[index] > maximum[0] ? values[index] : maximum[0];
+          }
+
+          summary.Count += static_cast<int64_t>(values.size());
+          summary.Sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+          summary.Min = std::min({ summary.Min, minimum[0], minimum[1], minimum[2], minimum[3] });
+          summary.Max = std::max({ summary.Max, maximum[0], maximum[1], maximum[2], maximum[3] });
+        });
+
+      return summary;
+    }
+
+    // Registers the table-valued function name(series) with columns Time and Value.
+    // The store must outlive the connection's use of it.
+    void CreateModule(char const* const name)
+    {
+      ModernCppSQLite::CreateModule<TimeSeriesTable<ThreadingPolicy>>(*m_Connection, name, this);
+    }
+
+  private:
+    Connection const* m_Connection = nullptr;
+    TimeSeriesOptions m_Options;
+    std::map<std::string, SeriesBuffer, std::less<>> m_Buffers;
+
+    std::vector<int64_t> m_Times;
+    std::vector<double> m_Values;
+
+    Statement m_Insert;
+    Statement m_LastTime;
+    Statement m_Chunks;
+  };
+
+  // Select Time, Value From name('series') Where Time Between ? And ?
+  //
+  // Series is a hidden column; left unconstrained, every series is returned. Time bounds are
+  // used to skip chunks and are checked again by SQLite, so any comparison is safe to push down.
+  template <SQLiteThreadingPolicy ThreadingPolicy>
+  class TimeSeriesTable : public SQLiteVirtualTable
+  {
+  private:
+    using Store = TimeSeriesStore<ThreadingPolicy>;
+
+    enum Column { Time, Value, Series };
+    enum Plan { HasSeries = 1, HasFirst = 2, HasLast = 4, HasPoint = 8 };
+
+    static int64_t Bound(sqlite3_value* const value, bool const lower) noexcept
+    {
+      double const bound = lower ? std::ceil(sqlite3_value_double(value)) : std::floor(sqlite3_value_double(value));
+
+      if (bound <= -9.2e18) return std::numeric_limits<int64_t>::min();
+      if (bound >= 9.2e18) return std::numeric_limits<int64_t>::max();
+      return static_cast<int64_t>(bound);
+    }
+
+  public:
+    class Cursor : public SQLiteVirtualCursor
+    {
+    private:
+      struct Chunk
+      {
+        std::string Series;
+        std::string Data;
+        int32_t Count = 0;
+      };
+
+      bool Load()
+      {
+        if (m_Statement && m_Statement->Step())
+        {
+          m_Series.assign(reinterpret_cast<char const*>(m_Statement->GetBlob(0)), m_Statement->GetBlobLength(0));
+          std::tie(m_Position, m_End) = Store::Decode(std::span(m_Statement->GetBlob(2), m_Statement->GetBlobLength(2)), m_Statement->GetInt32(1), m_First, m_Last, m_Times, m_Values);
+          return true;
+        }
+
+        if (m_Statement)
+        {
+          m_Statement->Reset();
+          m_Statement = nullptr;
+        }
+
+        if (m_Pending.empty())
+        {
+          return false;
+        }
+
+        Chunk const chunk = std::move(m_Pending.back());
+        m_Pending.pop_back();
+
+        m_Series = chunk.Series;
+        std::tie(m_Position, m_End) = Store::Decode(Store::Bytes(chunk.Data), chunk.Count, m_First, m_Last, m_Times, m_Values);
+        return true;
+      }
+
+      void Skip()
+      {
+        while (m_Position == m_End)
+        {
+          if (!Load())
+          {
+            m_Eof = true;
+            return;
+          }
+        }
+      }
+
+    public:
+      explicit Cursor(TimeSeriesTable& table) : m_Store(table.m_Store)
+      {
+        std::string const name = SQLiteQuoteIdentifier(m_Store->m_Options.Table);
+
+        m_OneSeries.Prepare(*m_Store->m_Connection, ("Select Series, Count, Data From " + name + " Where Series = ? And LastTime >= ? And FirstTime <= ? Order By LastTime").c_str());
+        m_AllSeries.Prepare(*m_Store->m_Connection, ("Select Series, Count, Data From " + name + " Where LastTime >= ? And FirstTime <= ? Order By Series, LastTime").c_str());
+      }
+
+      void Filter(int32_t const plan, char const*, std::span<sqlite3_value* const> const arguments)
+      {
+        size_t argument = 0;
+        std::string series;
+
+        if (plan & HasSeries)
+        {
+          char const* const text = reinterpret_cast<char const*>(sqlite3_value_text(arguments[argument++]));
+          series = text ? text : "";
+        }
+
+        if (plan & HasPoint)
+        {
+          m_First = Bound(arguments[argument], true);
+          m_Last = Bound(arguments[argument++], false);
+        }
+        else
+        {
+          m_First = plan & HasFirst ? Bound(arguments[argument++], true) : std::numeric_limits<int64_t>::min();
+          m_Last = plan & HasLast ? Bound(arguments[argument++], false) : std::numeric_limits<int64_t>::max();
+        }
+
+        if (m_Statement)
+        {
+          m_Statement->Reset();
+        }
+
+        if (plan & HasSeries)
+        {
+          m_Statement = &m_OneSeries;
+          m_Statement->BindAll(std::string(series), m_First, m_Last);
+        }
+        else
+        {
+          m_Statement = &m_AllSeries;
+          m_Statement->BindAll(m_First, m_Last);
+        }
+
+        // Buffered samples are newer than every stored chunk of their series, so they come last.
+        m_Pending.clear();
+
+        for (auto const& [name, buffer] : m_Store->m_Buffers)
+        {
+          if (buffer.Encoder.Count() != 0 && (!(plan & HasSeries) || name == series) && buffer.Encoder.LastTime() >= m_First && buffer.Encoder.FirstTime() <= m_Last)
+          {
+            m_Pending.push_back({ name, buffer.Encoder.Bytes(), buffer.Encoder.Count() });
+          }
+        }
+
+        std::reverse(m_Pending.begin(), m_Pending.end());
+
+        m_RowId = 0;
+        m_Position = m_End = 0;
+        m_Eof = false;
+        Skip();
+      }
+
+      void Next()
+      {
+        ++m_Position;
+        ++m_RowId;
+        Skip();
+      }
+
+      bool Eof() const noexcept
+      {
+        return m_Eof;
+      }
+
+      void Column(sqlite3_context* const context, int32_t const column) const
+      {
+        switch (column)
+        {
+          case Time: sqlite3_result_int64(context, m_Times[m_Position]); break;
+          case Value: sqlite3_result_double(context, m_Values[m_Position]); break;
+          default: sqlite3_result_text(context, m_Series.data(), static_cast<int32_t>(m_Series.size()), SQLITE_TRANSIENT); break;
+        }
+      }
+
+      sqlite3_int64 RowId() const noexcept
+      {
+        return m_RowId;
+      }
+
+    private:
+      Store* m_Store = nullptr;
+
+      BasicSQLiteStatement<ThreadingPolicy> m_OneSeries;
+      BasicSQLiteStatement<ThreadingPolicy> m_AllSeries;
+      BasicSQLiteStatement<ThreadingPolicy>* m_Statement = nullptr;
+      std::vector<Chunk> m_Pending;
+
+      int64_t m_First = 0;
+      int64_t m_Last = 0;
+      std::string m_Series;
+      std::vector<int64_t> m_Times;
+      std::vector<double> m_Values;
+      size_t m_Position = 0;
+      size_t m_End = 0;
+      sqlite3_int64 m_RowId = 0;
+      bool m_Eof = true;
+    };
+
+    TimeSeriesTable(sqlite3*, void* const context, std::span<char const* const>) noexcept
+      : m_Store(static_cast<Store*>(context))
+    {
+    }
+
+    std::string Declaration() const
+    {
+      return "Create Table x ( Time Integer, Value Real, Series Text Hidden )";
+    }
+
+    void BestIndex(sqlite3_index_info& info) const
+    {
+      int32_t series = -1;
+      int32_t first = -1;
+      int32_t last = -1;
+
+      for (int32_t index = 0; index < info.nConstraint; ++index)
+      {
+        sqlite3_index_info::sqlite3_index_constraint const& constraint = info.aConstraint[index];
+
+        if (!constraint.usable)
+        {
+          continue;
+        }
+
+        if (constraint.iColumn == Series && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ)
+        {
+          series = index;
+        }
+        else if (constraint.iColumn == Time)
+        {
+          if (constraint.op == SQLITE_INDEX_CONSTRAINT_EQ || constraint.op == SQLITE_INDEX_CONSTRAINT_GE || constraint.op == SQLITE_INDEX_CONSTRAINT_GT)
+          {
+            first = first < 0 ? index : first;
+          }
+
+          if (constraint.op == SQLITE_INDEX_CONSTRAINT_EQ || constraint.op == SQLITE_INDEX_CONSTRAINT_LE || constraint.op == SQLITE_INDEX_CONSTRAINT_LT)
+          {
+            last = last < 0 ? index : last;
+          }
+        }
+      }
+
+      int32_t argument = 0;
+      info.idxNum = 0;
+      info.estimatedCost = 1e9;
+
+      if (series >= 0)
+      {
+        info.idxNum |= HasSeries;
+        info.aConstraintUsage[series].argvIndex = ++argument;
+        info.aConstraintUsage[series].omit = 1;
+        info.estimatedCost /= 1000;
+      }
+
+      if (first >= 0 && first == last)
+      {
+        info.idxNum |= HasPoint;
+        info.aConstraintUsage[first].argvIndex = ++argument;
+        info.estimatedCost /= 100;
+      }
+      else
+      {
+        if (first >= 0)
+        {
+          info.idxNum |= HasFirst;
+          info.aConstraintUsage[first].argvIndex = ++argument;
+          info.estimatedCost /= 4;
+        }
+
+        if (last >= 0)
+        {
+          info.idxNum |= HasLast;
+          info.aConstraintUsage[last].argvIndex = ++argument;
+          info.estimatedCost /= 4;
+        }
+      }
+
+      // Chunks of one series are read in time order.
+      if (series >= 0 && info.nOrderBy == 1 && info.aOrderBy[0].iColumn == Time && !info.aOrderBy[0].desc)
+      {
+        info.orderByConsumed = 1;
+      }
+    }
+
+  private:
+    Store* m_Store = nullptr;
+  };
+}
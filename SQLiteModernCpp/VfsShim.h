@@ -0,0 +1,338 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <new>
+#include <string>
+
+namespace ModernCppSQLite
+{
+  // Every file opened through a shim starts with this header. The file of the wrapped
+  // VFS is allocated by SQLite in the same block, right after the derived file type.
+  struct SQLiteShimFile
+  {
+    sqlite3_file Base;
+    sqlite3_file* Real;
+    void* Shim;
+    int32_t Flags;
+  };
+
+  // Base for VFS shims that wrap another registered VFS. Derived classes hide the
+  // hooks they are interested in; everything else is forwarded to the wrapped VFS.
+  template <typename Derived, typename File = SQLiteShimFile>
+  class SQLiteVfsShim
+  {
+  private:
+    static constexpr int32_t RealFileOffset = (sizeof(File) + 7) & ~7;
+
+    static Derived& Shim(sqlite3_file* const file) noexcept
+    {
+      return *static_cast<Derived*>(reinterpret_cast<File*>(file)->Shim);
+    }
+
+    static File& Self(sqlite3_file* const file) noexcept
+    {
+      return *reinterpret_cast<File*>(file);
+    }
+
+    static sqlite3_vfs* Real(sqlite3_vfs* const vfs) noexcept
+    {
+      return static_cast<SQLiteVfsShim*>(vfs->pAppData)->m_Real;
+    }
+
+    static int32_t XClose(sqlite3_file* const file)
+    {
+      int32_t const result = Shim(file).Close(Self(file));
+      Self(file).~File();
+      return result;
+    }
+
+    static int32_t XRead(sqlite3_file* const file, void* const buffer, int32_t const amount, sqlite3_int64 const offset)
+    {
+      return Shim(file).Read(Self(file), buffer, amount, offset);
+    }
+
+    static int32_t XWrite(sqlite3_file* const file, void const* const buffer, int32_t const amount, sqlite3_int64 const offset)
+    {
+      return Shim(file).Write(Self(file), buffer, amount, offset);
+    }
+
+    static int32_t XTruncate(sqlite3_file* const file, sqlite3_int64 const size)
+    {
+      return Shim(file).Truncate(Self(file), size);
+    }
+
+    static int32_t XSync(sqlite3_file* const file, int32_t const flags)
+    {
+      return Shim(file).Sync(Self(file), flags);
+    }
+
+    static int32_t XFileSize(sqlite3_file* const file, sqlite3_int64* const size)
+    {
+      return Self(file).Real->pMethods->xFileSize(Self(file).Real, size);
+    }
+
+    static int32_t XLock(sqlite3_file* const file, int32_t const lock)
+    {
+      return Self(file).Real->pMethods->xLock(Self(file).Real, lock);
+    }
+
+    static int32_t XUnlock(sqlite3_file* const file, int32_t const lock)
+    {
+      return Self(file).Real->pMethods->xUnlock(Self(file).Real, lock);
+    }
+
+    static int32_t XCheckReservedLock(sqlite3_file* const file, int32_t* const result)
+    {
+      return Self(file).Real->pMethods->xCheckReservedLock(Self(file).Real, result);
+    }
+
+    static int32_t XFileControl(sqlite3_file* const file, int32_t const operation, void* const argument)
+    {
+      return Shim(file).FileControl(Self(file), operation, argument);
+    }
+
+    static int32_t XSectorSize(sqlite3_file* const file)
+    {
+      return Self(file).Real->pMethods->xSectorSize(Self(file).Real);
+    }
+
+    static int32_t XDeviceCharacteristics(sqlite3_file* const file)
+    {
+      return Self(file).Real->pMethods->xDeviceCharacteristics(Self(file).Real);
+    }
+
+    static int32_t XShmMap(sqlite3_file* const file, int32_t const region, int32_t const size, int32_t const extend, void volatile** const address)
+    {
+      return Self(file).Real->pMethods->xShmMap(Self(file).Real, region, size, extend, address);
+    }
+
+    static int32_t XShmLock(sqlite3_file* const file, int32_t const offset, int32_t const count, int32_t const flags)
+    {
+      return Self(file).Real->pMethods->xShmLock(Self(file).Real, offset, count, flags);
+    }
+
+    static void XShmBarrier(sqlite3_file* const file)
+    {
+      Self(file).Real->pMethods->xShmBarrier(Self(file).Real);
+    }
+
+    static int32_t XShmUnmap(sqlite3_file* const file, int32_t const deleteFlag)
+    {
+      return Self(file).Real->pMethods->xShmUnmap(Self(file).Real, deleteFlag);
+    }
+
+    static int32_t XFetch(sqlite3_file* const file, sqlite3_int64 const offset, int32_t const amount, void** const page)
+    {
+      return Shim(file).Fetch(Self(file), offset, amount, page);
+    }
+
+    static int32_t XUnfetch(sqlite3_file* const file, sqlite3_int64 const offset, void* const page)
+    {
+      return Self(file).Real->pMethods->xUnfetch(Self(file).Real, offset, page);
+    }
+
+    // The shim never advertises more than the wrapped file supports, otherwise SQLite
+    // would try to use shared memory or memory mapping on files that cannot provide it.
+    static sqlite3_io_methods const* Methods(int32_t const version) noexcept
+    {
+      static sqlite3_io_methods const methods[] =
+      {
+        { 1, XClose, XRead, XWrite, XTruncate, XSync, XFileSize, XLock, XUnlock, XCheckReservedLock, XFileControl, XSectorSize, XDeviceCharacteristics, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr },
+        { 2, XClose, XRead, XWrite, XTruncate, XSync, XFileSize, XLock, XUnlock, XCheckReservedLock, XFileControl, XSectorSize, XDeviceCharacteristics, XShmMap, XShmLock, XShmBarrier, XShmUnmap, nullptr, nullptr },
+        { 3, XClose, XRead, XWrite, XTruncate, XSync, XFileSize, XLock, XUnlock, XCheckReservedLock, XFileControl, XSectorSize, XDeviceCharacteristics, XShmMap, XShmLock, XShmBarrier, XShmUnmap, XFetch, XUnfetch },
+      };
+
+      return &methods[(version < 1 ? 1 : version > 3 ? 3 : version) - 1];
+    }
+
+    static int32_t XOpen(sqlite3_vfs* const vfs, char const* const name, sqlite3_file* const file, int32_t const flags, int32_t* const outFlags)
+    {
+      auto& shim = *static_cast<Derived*>(static_cast<SQLiteVfsShim*>(vfs->pAppData));
+      File& self = *new (file) File{};
+      self.Real = reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(file) + RealFileOffset);
+      self.Shim = &shim;
+      self.Flags = flags;
+
+      int32_t const result = Real(vfs)->xOpen(Real(vfs), name, self.Real, flags, outFlags);
+
+      if (self.Real->pMethods)
+      {
+        self.Base.pMethods = Methods(self.Real->pMethods->iVersion);
+      }
+      else
+      {
+        // Without methods SQLite never calls xClose, which would destroy the file.
+        self.~File();
+        return result;
+      }
+
+      if (result == SQLITE_OK)
+      {
+        shim.Opened(self, name);
+      }
+
+      return result;
+    }
+
+    static int32_t XDelete(sqlite3_vfs* const vfs, char const* const name, int32_t const syncDirectory)
+    {
+      return Real(vfs)->xDelete(Real(vfs), name, syncDirectory);
+    }
+
+    static int32_t XAccess(sqlite3_vfs* const vfs, char const* const name, int32_t const flags, int32_t* const result)
+    {
+      return Real(vfs)->xAccess(Real(vfs), name, flags, result);
+    }
+
+    static int32_t XFullPathname(sqlite3_vfs* const vfs, char const* const name, int32_t const size, char* const output)
+    {
+      return Real(vfs)->xFullPathname(Real(vfs), name, size, output);
+    }
+
+    static void* XDlOpen(sqlite3_vfs* const vfs, char const* const name)
+    {
+      return Real(vfs)->xDlOpen(Real(vfs), name);
+    }
+
+    static void XDlError(sqlite3_vfs* const vfs, int32_t const size, char* const message)
+    {
+      Real(vfs)->xDlError(Real(vfs), size, message);
+    }
+
+    static void (*XDlSym(sqlite3_vfs* const vfs, void* const library, char const* const symbol))(void)
+    {
+      return Real(vfs)->xDlSym(Real(vfs), library, symbol);
+    }
+
+    static void XDlClose(sqlite3_vfs* const vfs, void* const library)
+    {
+      Real(vfs)->xDlClose(Real(vfs), library);
+    }
+
+    static int32_t XRandomness(sqlite3_vfs* const vfs, int32_t const size, char* const output)
+    {
+      return Real(vfs)->xRandomness(Real(vfs), size, output);
+    }
+
+    static int32_t XSleep(sqlite3_vfs* const vfs, int32_t const microseconds)
+    {
+      return Real(vfs)->xSleep(Real(vfs), microseconds);
+    }
+
+    static int32_t XCurrentTime(sqlite3_vfs* const vfs, double* const time)
+    {
+      return Real(vfs)->xCurrentTime(Real(vfs), time);
+    }
+
+    static int32_t XGetLastError(sqlite3_vfs* const vfs, int32_t const size, char* const message)
+    {
+      return Real(vfs)->xGetLastError ? Real(vfs)->xGetLastError(Real(vfs), size, message) : 0;
+    }
+
+    static int32_t XCurrentTimeInt64(sqlite3_vfs* const vfs, sqlite3_int64* const time)
+    {
+      return Real(vfs)->xCurrentTimeInt64(Real(vfs), time);
+    }
+
+  protected:
+    // Hooks, hidden by derived classes as needed.
+
+    void Opened(File&, char const* const) noexcept
+    {
+    }
+
+    int32_t Close(File& file)
+    {
+      return file.Real->pMethods ? file.Real->pMethods->xClose(file.Real) : SQLITE_OK;
+    }
+
+    int32_t Read(File& file, void* const buffer, int32_t const amount, sqlite3_int64 const offset)
+    {
+      return file.Real->pMethods->xRead(file.Real, buffer, amount, offset);
+    }
+
+    int32_t Write(File& file, void const* const buffer, int32_t const amount, sqlite3_int64 const offset)
+    {
+      return file.Real->pMethods->xWrite(file.Real, buffer, amount, offset);
+    }
+
+    int32_t Truncate(File& file, sqlite3_int64 const size)
+    {
+      return file.Real->pMethods->xTruncate(file.Real, size);
+    }
+
+    int32_t Sync(File& file, int32_t const flags)
+    {
+      return file.Real->pMethods->xSync(file.Real, flags);
+    }
+
+    int32_t FileControl(File& file, int32_t const operation, void* const argument)
+    {
+      return file.Real->pMethods->xFileControl(file.Real, operation, argument);
+    }
+
+    int32_t Fetch(File& file, sqlite3_int64 const offset, int32_t const amount, void** const page)
+    {
+      return file.Real->pMethods->xFetch(file.Real, offset, amount, page);
+    }
+
+  public:
+    SQLiteVfsShim(SQLiteVfsShim const&) = delete;
+    SQLiteVfsShim& operator=(SQLiteVfsShim const&) = delete;
+
+    explicit SQLiteVfsShim(std::string name, char const* const realName = nullptr)
+      : m_Name(std::move(name))
+      , m_Real(sqlite3_vfs_find(realName))
+    {
+      if (!m_Real)
+      {
+        throw SQLiteException(SQLITE_NOTFOUND);
+      }
+
+      m_Vfs.iVersion = 2;
+      m_Vfs.szOsFile = RealFileOffset + m_Real->szOsFile;
+      m_Vfs.mxPathname = m_Real->mxPathname;
+      m_Vfs.zName = m_Name.c_str();
+      m_Vfs.pAppData = this;
+      m_Vfs.xOpen = XOpen;
+      m_Vfs.xDelete = XDelete;
+      m_Vfs.xAccess = XAccess;
+      m_Vfs.xFullPathname = XFullPathname;
+      m_Vfs.xDlOpen = XDlOpen;
+      m_Vfs.xDlError = XDlError;
+      m_Vfs.xDlSym = XDlSym;
+      m_Vfs.xDlClose = XDlClose;
+      m_Vfs.xRandomness = XRandomness;
+      m_Vfs.xSleep = XSleep;
+      m_Vfs.xCurrentTime = XCurrentTime;
+      m_Vfs.xGetLastError = XGetLastError;
+      m_Vfs.xCurrentTimeInt64 = m_Real->iVersion >= 2 && m_Real->xCurrentTimeInt64 ? XCurrentTimeInt64 : nullptr;
+
+      if (int32_t const result = sqlite3_vfs_register(&m_Vfs, 0); result != SQLITE_OK)
+      {
+        throw SQLiteException(result);
+      }
+    }
+
+    ~SQLiteVfsShim() noexcept
+    {
+      sqlite3_vfs_unregister(&m_Vfs);
+    }
+
+    char const* GetName() const noexcept
+    {
+      return m_Vfs.zName;
+    }
+
+    sqlite3_vfs* GetAbi() noexcept
+    {
+      return &m_Vfs;
+    }
+
+  private:
+    std::string m_Name;
+    sqlite3_vfs* m_Real = nullptr;
+    sqlite3_vfs m_Vfs{ };
+  };
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <new>
+#include <span>
+
+namespace ModernCppSQLite
+{
+  // Base of virtual table implementations; SQLite only sees the sqlite3_vtab part.
+  struct SQLiteVirtualTable : sqlite3_vtab
+  {
+    SQLiteVirtualTable() noexcept : sqlite3_vtab{ }
+    {
+    }
+  };
+
+  struct SQLiteVirtualCursor : sqlite3_vtab_cursor
+  {
+    SQLiteVirtualCursor() noexcept : sqlite3_vtab_cursor{ }
+    {
+    }
+  };
+
+  // Builds an sqlite3_module out of a C++ table type. The table derives from SQLiteVirtualTable and provides
+  //
+  //   Table(sqlite3* connection, void* context, std::span<char const* const> arguments)
+  //   std::string Declaration() const                        the statement given to sqlite3_declare_vtab
+  //   void BestIndex(sqlite3_index_info& info) const
+  //   using Cursor = ...                                     derives from SQLiteVirtualCursor, constructed from Table&
+  //     void Filter(int32_t plan, char const* planText, std::span<sqlite3_value* const> arguments)
+  //     void Next()
+  //     bool Eof() const
+  //     void Column(sqlite3_context* context, int32_t column) const
+  //     sqlite3_int64 RowId() const
+  //
+  // and optionally
+  //
+  //   static void Create(sqlite3*, void*, std::span<char const* const>)   run by Create Virtual Table before construction
+  //   void Destroy()                                                       run by Drop Table
+  //   void Update(std::span<sqlite3_value* const> arguments, sqlite3_int64& rowId)
+  //   void Begin(), void Sync(), void Commit(), void Rollback()
+  //
+  // A table without Create is eponymous: it can be queried as a table-valued function without being created.
+  // A SQLiteException thrown from any of these becomes the error code and message of the SQLite call;
+  // any other exception becomes SQLITE_ERROR, with its what() as the message.
+  template <typename Table>
+  class SQLiteModule
+  {
+  private:
+    using Cursor = typename Table::Cursor;
+
+    static Table& Self(sqlite3_vtab* const table) noexcept
+    {
+      return *static_cast<Table*>(table);
+    }
+
+    static Cursor& Self(sqlite3_vtab_cursor* const cursor) noexcept
+    {
+      return *static_cast<Cursor*>(cursor);
+    }
+
+    template <typename F>
+    static int Guard(sqlite3_vtab* const table, F&& function) noexcept
+    {
+      try
+      {
+        function();
+        return SQLITE_OK;
+      }
+      catch (SQLiteException const& ex)
+      {
+        sqlite3_free(table->zErrMsg);
+        table->zErrMsg = sqlite3_mprintf("%s", ex.ErrorMessage.c_str());
+        return ex.ErrorCode;
+      }
+      catch (std::bad_alloc const&)
+      {
+        return SQLITE_NOMEM;
+      }
+      catch (std::exception const& ex)
+      {
+        sqlite3_free(table->zErrMsg);
+        table->zErrMsg = sqlite3_mprintf("%s", ex.what());
+        return SQLITE_ERROR;
+      }
+      catch (...)
+      {
+        return SQLITE_ERROR;
+      }
+    }
+
+    template <bool Create>
+    static int XConnect(sqlite3* const connection, void* const context, int const argc, char const* const* const argv, sqlite3_vtab** const result, char** const error) noexcept
+    {
+      std::span<char const* const> const arguments(argv, argc);
+      Table* table = nullptr;
+
+      try
+      {
+        if constexpr (Create)
+        {
+          Table::Create(connection, context, arguments);
+        }
+
+        table = new Table(connection, context, arguments);
+
+        if (int32_t const code = sqlite3_declare_vtab(connection, table->Declaration().c_str()); code != SQLITE_OK)
+        {
+          delete table;
+          return code;
+        }
+
+        *result = table;
+        return SQLITE_OK;
+      }
+      catch (SQLiteException const& ex)
+      {
+        delete table;
+        *error = sqlite3_mprintf("%s", ex.ErrorMessage.c_str());
+        return ex.ErrorCode;
+      }
+      catch (std::bad_alloc const&)
+      {
+        delete table;
+        return SQLITE_NOMEM;
+      }
+      catch (std::exception const& ex)
+      {
+        delete table;
+        *error = sqlite3_mprintf("%s", ex.what());
+        return SQLITE_ERROR;
+      }
+      catch (...)
+      {
+        delete table;
+        return SQLITE_ERROR;
+      }
+    }
+
+    static int XDisconnect(sqlite3_vtab* const table) noexcept
+    {
+      delete &Self(table);
+      return SQLITE_OK;
+    }
+
+    static int XDestroy(sqlite3_vtab* const table) noexcept
+    {
+      if (int32_t const code = Guard(table, [&] { Self(table).Destroy(); }); code != SQLITE_OK)
+      {
+        return code;
+      }
+
+      return XDisconnect(table);
+    }
+
+    static int XBestIndex(sqlite3_vtab* const table, sqlite3_index_info* const info) noexcept
+    {
+      return Guard(table, [&] { Self(table).BestIndex(*info); });
+    }
+
+    static int XOpen(sqlite3_vtab* const table, sqlite3_vtab_cursor** const result) noexcept
+    {
+      return Guard(table, [&] { *result = new Cursor(Self(table)); });
+    }
+
+    static int XClose(sqlite3_vtab_cursor* const cursor) noexcept
+    {
+      delete &Self(cursor);
+      return SQLITE_OK;
+    }
+
+    static int XFilter(sqlite3_vtab_cursor* const cursor, int const plan, char const* const planText, int const argc, sqlite3_value** const argv) noexcept
+    {
+      return Guard(cursor->pVtab, [&] { Self(cursor).Filter(plan, planText, std::span<sqlite3_value* const>(argv, argc)); });
+    }
+
+    static int XNext(sqlite3_vtab_cursor* const cursor) noexcept
+    {
+      return Guard(cursor->pVtab, [&] { Self(cursor).Next(); });
+    }
+
+    static int XEof(sqlite3_vtab_cursor* const cursor) noexcept
+    {
+      return Self(cursor).Eof();
+    }
+
+    static int XColumn(sqlite3_vtab_cursor* const cursor, sqlite3_context* const context, int const column) noexcept
+    {
+      return Guard(cursor->pVtab, [&] { Self(cursor).Column(context, column); });
+    }
+
+    static int XRowId(sqlite3_vtab_cursor* const cursor, sqlite3_int64* const rowId) noexcept
+    {
+      *rowId = Self(cursor).RowId();
+      return SQLITE_OK;
+    }
+
+    static int XUpdate(sqlite3_vtab* const table, int const argc, sqlite3_value** const argv, sqlite3_int64* const rowId) noexcept
+    {
+      return Guard(table, [&] { Self(table).Update(std::span<sqlite3_value* const>(argv, argc), *rowId); });
+    }
+
+    static int XBegin(sqlite3_vtab* const table) noexcept
+    {
+      return Guard(table, [&] { Self(table).Begin(); });
+    }
+
+    static int XSync(sqlite3_vtab* const table) noexcept
+    {
+      return Guard(table, [&] { Self(table).Sync(); });
+    }
+
+    static int XCommit(sqlite3_vtab* const table) noexcept
+    {
+      return Guard(table, [&] { Self(table).Commit(); });
+    }
+
+    static int XRollback(sqlite3_vtab* const table) noexcept
+    {
+      return Guard(table, [&] { Self(table).Rollback(); });
+    }
+
+    static sqlite3_module MakeModule() noexcept
+    {
+      sqlite3_module module{ };
+      module.iVersion = 1;
+
+      if constexpr (requires (sqlite3* connection, std::span<char const* const> arguments) { Table::Create(connection, nullptr, arguments); })
+      {
+        module.xCreate = XConnect<true>;
+      }
+      else
+      {
+        module.xCreate = XConnect<false>;
+      }
+
+      if constexpr (requires (Table& table) { table.Destroy(); })
+      {
+        module.xDestroy = XDestroy;
+      }
+      else
+      {
+        module.xDestroy = XDisconnect;
+      }
+
+      module.xConnect = XConnect<false>;
+      module.xBestIndex = XBestIndex;
+      module.xDisconnect = XDisconnect;
+      module.xOpen = XOpen;
+      module.xClose = XClose;
+      module.xFilter = XFilter;
+      module.xNext = XNext;
+      module.xEof = XEof;
+      module.xColumn = XColumn;
+      module.xRowid = XRowId;
+
+      if constexpr (requires (Table& table, sqlite3_int64& rowId) { table.Update(std::span<sqlite3_value* const>(), rowId); })
+      {
+        module.xUpdate = XUpdate;
+      }
+
+      if constexpr (requires (Table& table) { table.Begin(); table.Sync(); table.Commit(); table.Rollback(); })
+      {
+        module.xBegin = XBegin;
+        module.xSync = XSync;
+        module.xCommit = XCommit;
+        module.xRollback = XRollback;
+      }
+
+      return module;
+    }
+
+  public:
+    static inline sqlite3_module const Module = MakeModule();
+  };
+
+  // The context is handed to every Table constructor; it must outlive the connection or the next registration.
+  template <typename Table, SQLiteThreadingPolicy ThreadingPolicy>
+  inline void CreateModule(BasicSQLiteConnection<ThreadingPolicy> const& connection, char const* const name, void* const context = nullptr)
+  {
+    if (SQLITE_OK != sqlite3_create_module(connection.GetAbi(), name, &SQLiteModule<Table>::Module, context))
+    {
+      connection.ThrowLastError();
+    }
+  }
+}
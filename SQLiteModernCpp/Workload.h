@@ -0,0 +1,621 @@
+#pragma once
+
+#include "SQLite.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernCppSQLite
+{
+  // The log is "SQLW" and a version byte, then records. A statement record, 'S', gives a statement
+  // its number the first time it runs: its number and text. An execution record, 'E', has the
+  // statement number, the thread, when it started and how long it took in nanoseconds, and its
+  // parameters as a type and a value each. Numbers are LEB128 varints, signed ones zigzag encoded.
+  struct WorkloadParameter
+  {
+    SQLiteType Type = SQLiteType::Null;
+    int64_t Integer = 0;
+    double Float = 0;
+    std::string Bytes;
+  };
+
+  struct WorkloadExecution
+  {
+    uint32_t Statement = 0;
+    uint32_t Thread = 0;
+    uint64_t Start = 0;
+    uint64_t Duration = 0;
+    std::vector<WorkloadParameter> Parameters;
+  };
+
+  struct WorkloadLog
+  {
+    std::vector<std::string> Statements;
+    std::vector<WorkloadExecution> Executions;
+
+    static WorkloadLog Read(char const* const filename)
+    {
+      std::ifstream file(filename, std::ios::binary);
+      std::string const data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      size_t position = 5;
+
+      if (data.size() < position || data.compare(0, 4, "SQLW") != 0 || data[4] != 1)
+      {
+        throw SQLiteException(SQLITE_CORRUPT, std::string("workload: not a workload log: ") + filename);
+      }
+
+      auto const varint = [&]
+      {
+        uint64_t value = 0;
+
+        for (int32_t shift = 0; position < data.size() && shift < 64; shift += 7)
+        {
+          uint8_t const byte = static_cast<uint8_t>(data[position++]);
+          value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+          if (!(byte & 0x80))
+          {
+            return value;
+          }
+        }
+
+        throw SQLiteException(SQLITE_CORRUPT, "workload: truncated log");
+      };
+
+      auto const bytes = [&]
+      {
+        size_t const size = static_cast<size_t>(varint());
+
+        if (size > data.size() - position)
+        {
+          throw SQLiteException(SQLITE_CORRUPT, "workload: truncated log");
+        }
+
+        position += size;
+        return data.substr(position - size, size);
+      };
+
+      WorkloadLog log;
+
+      while (position < data.size())
+      {
+        char const tag = data[position++];
+
+        if (tag == 'S')
+        {
+          size_t const number = static_cast<size_t>(varint());
+
+          // The recorder numbers statements in order.
+          if (number > log.Statements.size())
+          {
+            throw SQLiteException(SQLITE_CORRUPT, "workload: statement numbers out of order in log");
+          }
+
+          log.Statements.resize(std::max(log.Statements.size(), number + 1));
+          log.Statements[number] = bytes();
+        }
+        else if (tag == 'E')
+        {
+          WorkloadExecution& execution = log.Executions.emplace_back();
+          execution.Statement = static_cast<uint32_t>(varint());
+
+          // The replayer indexes Statements with it.
+          if (execution.Statement >= log.Statements.size())
+          {
+            throw SQLiteException(SQLITE_CORRUPT, "workload: execution of an unknown statement in log");
+          }
+
+          execution.Thread = static_cast<uint32_t>(varint());
+          execution.Start = varint();
+          execution.Duration = varint();
+          execution.Parameters.resize(static_cast<size_t>(varint()));
+
+          for (WorkloadParameter& parameter : execution.Parameters)
+          {
+            if (position >= data.size())
+            {
+              throw SQLiteException(SQLITE_CORRUPT, "workload: truncated log");
+            }
+
+            parameter.Type = static_cast<SQLiteType>(data[position++]);
+
+            switch (parameter.Type)
+            {
+              case SQLiteType::Integer:
+              {
+                uint64_t const value = varint();
+                parameter.Integer = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+                break;
+              }
+
+              case SQLiteType::Float:
+              {
+                if (data.size() - position < sizeof(double))
+                {
+                  throw SQLiteException(SQLITE_CORRUPT, "workload: truncated log");
+                }
+
+                std::memcpy(&parameter.Float, data.data() + position, sizeof(double));
+                position += sizeof(double);
+                break;
+              }
+
+              case SQLiteType::Text: case SQLiteType::Blob: parameter.Bytes = bytes(); break;
+              default: break;
+            }
+          }
+        }
+        else
+        {
+          throw SQLiteException(SQLITE_CORRUPT, "workload: unknown record in log");
+        }
+      }
+
+      return log;
+    }
+  };
+
+  // Appends every statement that the attached connections run to a log, with the values bound to
+  // its parameters, recovered by matching the statement's text with sqlite3_expanded_sql. Floating
+  // point values are as precise as that prints them, 15 digits. Attaching replaces a connection's
+  // trace and profile callbacks. Before SQLite 3.14 statements are logged without parameters.
+  class WorkloadRecorder
+  {
+  private:
+    static void Varint(std::string& out, uint64_t value)
+    {
+      for (; value >= 0x80; value >>= 7)
+      {
+        out += static_cast<char>(value | 0x80);
+      }
+
+      out += static_cast<char>(value);
+    }
+
+    static void Bytes(std::string& out, std::string_view const value)
+    {
+      Varint(out, value.size());
+      out += value;
+    }
+
+    // Reads the literal that sqlite3_expanded_sql wrote for a parameter.
+    static size_t Literal(std::string_view const text, size_t position, std::string& out)
+    {
+      if (text.substr(position, 4) == "NULL")
+      {
+        out += static_cast<char>(SQLiteType::Null);
+        return position + 4;
+      }
+
+      if (text[position] == '\'' || ((text[position] == 'x' || text[position] == 'X') && position + 1 < text.size() && text[position + 1] == '\''))
+      {
+        bool const blob = text[position] != '\'';
+        std::string value;
+        position += blob ? 2 : 1;
+
+        while (position < text.size() && !(text[position] == '\'' && (position + 1 == text.size() || text[position + 1] != '\'' || blob)))
+        {
+          if (blob)
+          {
+            uint8_t byte = 0;
+            std::from_chars(text.data() + position, text.data() + std::min(position + 2, text.size()), byte, 16);
+            value += static_cast<char>(byte);
+            position += 2;
+          }
+          else
+          {
+            position += text[position] == '\'' ? 1 : 0;
+            value += text[position++];
+          }
+        }
+
+        out += static_cast<char>(blob ? SQLiteType::Blob : SQLiteType::Text);
+        Bytes(out, value);
+        return position + 1;
+      }
+
+      size_t const end = text.find_first_not_of("0123456789+-.eEInf", position);
+      std::string const number(text.substr(position, end - position));
+
+      if (number.find_first_of(".eEI") == std::string::npos)
+      {
+        int64_t const value = std::strtoll(number.c_str(), nullptr, 10);
+        out += static_cast<char>(SQLiteType::Integer);
+        Varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+      }
+      else
+      {
+        double const value = std::strtod(number.c_str(), nullptr);
+        out += static_cast<char>(SQLiteType::Float);
+        out.append(reinterpret_cast<char const*>(&value), sizeof(value));
+      }
+
+      return end == std::string_view::npos ? text.size() : end;
+    }
+
+    // Appends the parameter count and values in parameter order; the texts differ only where sql
+    // has parameters, numbered as SQLite numbers them.
+    static void Parameters(std::string_view const sql, std::string_view const expanded, std::string& out)
+    {
+      std::vector<std::string> values;
+      std::unordered_map<std::string_view, size_t> names;
+      size_t at = 0;
+
+      for (size_t position = 0; position < sql.size() && at < expanded.size();)
+      {
+        char const c = sql[position];
+
+        if (c == '\'' || c == '"' || c == '`' || c == '[')
+        {
+          char const close = c == '[' ? ']' : c;
+          size_t const end = std::min(sql.find(close, position + 1), sql.size() - 1) + 1;
+          at += end - position;
+          position = end;
+        }
+        else if ((c == '-' || c == '/') && position + 1 < sql.size() && sql[position + 1] == (c == '-' ? '-' : '*'))
+        {
+          size_t const end = c == '-' ? std::min(sql.find('\n', position), sql.size()) : std::min(sql.find("*/", position + 2), sql.size() - 2) + 2;
+          at += end - position;
+          position = end;
+        }
+        else if (c == '?' || c == ':' || c == '@' || c == '$')
+        {
+          size_t end = position + 1;
+
+          while (end < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[end])) || sql[end] == '_'))
+          {
+            ++end;
+          }
+
+          std::string_view const name = sql.substr(position, end - position);
+          size_t index = values.size();
+
+          if (c != '?')
+          {
+            index = names.try_emplace(name, values.size()).first->second;
+          }
+          else if (size_t number = 0; name.size() > 1 && std::from_chars(name.data() + 1, name.data() + name.size(), number).ec == std::errc() && number > 0)
+          {
+            index = number - 1;
+          }
+
+          values.resize(std::max(values.size(), index + 1));
+          values[index].clear();
+          at = Literal(expanded, at, values[index]);
+          position = end;
+        }
+        else
+        {
+          ++position;
+          ++at;
+        }
+      }
+
+      Varint(out, values.size());
+
+      for (std::string const& value : values)
+      {
+        out += value.empty() ? std::string(1, static_cast<char>(SQLiteType::Null)) : value;
+      }
+    }
+
+    uint32_t Number(std::string_view const sql)
+    {
+      auto const found = m_Numbers.find(std::string(sql));
+
+      if (found != m_Numbers.end())
+      {
+        return found->second;
+      }
+
+      uint32_t const number = static_cast<uint32_t>(m_Numbers.size());
+      m_Numbers.emplace(sql, number);
+      m_Buffer += 'S';
+      Varint(m_Buffer, number);
+      Bytes(m_Buffer, sql);
+      return number;
+    }
+
+    void Add(std::string_view const sql, std::string_view const expanded, uint64_t const duration)
+    {
+      uint64_t const end = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+      std::string parameters;
+      Parameters(sql, expanded, parameters);
+
+      std::lock_guard lock(m_Mutex);
+      uint32_t const statement = Number(sql);
+      uint32_t const thread = m_Threads.try_emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_Threads.size())).first->second;
+
+      m_Buffer += 'E';
+      Varint(m_Buffer, statement);
+      Varint(m_Buffer, thread);
+      Varint(m_Buffer, end - std::min(end, duration));
+      Varint(m_Buffer, duration);
+      m_Buffer += parameters;
+
+      if (m_Buffer.size() >= 1024 * 1024)
+      {
+        Flush();
+      }
+    }
+
+    void Flush()
+    {
+      m_File.write(m_Buffer.data(), static_cast<std::streamsize>(m_Buffer.size()));
+      m_Buffer.clear();
+    }
+
+#if SQLITE_VERSION_NUMBER >= 3014000
+    static int32_t OnTrace(uint32_t, void* const context, void* const statement, void* const nanoseconds) noexcept
+    {
+      sqlite3_stmt* const handle = static_cast<sqlite3_stmt*>(statement);
+      char const* const sql = sqlite3_sql(handle);
+      char* const expanded = sql ? sqlite3_expanded_sql(handle) : nullptr;
+
+      // An execution that cannot be logged, for want of memory, is left out.
+      try
+      {
+        if (sql)
+        {
+          static_cast<WorkloadRecorder*>(context)->Add(sql, expanded ? expanded : "", static_cast<uint64_t>(*static_cast<sqlite3_int64 const*>(nanoseconds)));
+        }
+      }
+      catch (std::exception const&)
+      {
+      }
+
+      sqlite3_free(expanded);
+      return 0;
+    }
+#else
+    static void OnProfile(void* const context, char const* const sql, sqlite3_uint64 const nanoseconds) noexcept
+    {
+      try
+      {
+        static_cast<WorkloadRecorder*>(context)->Add(sql, "", nanoseconds);
+      }
+      catch (std::exception const&)
+      {
+      }
+    }
+#endif
+
+  public:
+    WorkloadRecorder(WorkloadRecorder const&) = delete;
+    WorkloadRecorder& operator=(WorkloadRecorder const&) = delete;
+
+    explicit WorkloadRecorder(char const* const filename)
+      : m_File(filename, std::ios::binary | std::ios::trunc)
+      , m_Start(std::chrono::steady_clock::now())
+    {
+      if (!m_File)
+      {
+        throw SQLiteException(SQLITE_CANTOPEN, std::string("workload: cannot create ") + filename);
+      }
+
+      m_Buffer = std::string("SQLW\x01", 5);
+    }
+
+    ~WorkloadRecorder()
+    {
+      std::lock_guard lock(m_Mutex);
+      Flush();
+    }
+
+    template <SQLiteThreadingPolicy ThreadingPolicy>
+    void Attach(BasicSQLiteConnection<ThreadingPolicy> const& connection)
+    {
+#if SQLITE_VERSION_NUMBER >= 3014000
+      sqlite3_trace_v2(connection.GetAbi(), SQLITE_TRACE_PROFILE, OnTrace, this);
+#else
+      sqlite3_profile(connection.GetAbi(), OnProfile, this);
+#endif
+    }
+
+    template <SQLiteThreadingPolicy ThreadingPolicy>
+    void Detach(BasicSQLiteConnection<ThreadingPolicy> const& connection)
+    {
+#if SQLITE_VERSION_NUMBER >= 3014000
+      sqlite3_trace_v2(connection.GetAbi(), 0, nullptr, nullptr);
+#else
+      sqlite3_profile(connection.GetAbi(), nullptr, nullptr);
+#endif
+    }
+
+  private:
+    std::ofstream m_File;
+    std::chrono::steady_clock::time_point const m_Start;
+
+    std::mutex m_Mutex;
+    std::string m_Buffer;
+    std::unordered_map<std::string, uint32_t> m_Numbers;
+    std::map<std::thread::id, uint32_t> m_Threads;
+  };
+
+  struct WorkloadLatency
+  {
+    std::string Sql;
+    int64_t Count = 0;
+    int64_t Errors = 0;
+
+    // Microseconds.
+    double Median = 0;
+    double P90 = 0;
+    double P99 = 0;
+    double Max = 0;
+  };
+
+  struct WorkloadReport
+  {
+    double Milliseconds = 0;
+    WorkloadLatency All;
+    std::vector<WorkloadLatency> Statements;
+  };
+
+  // Runs a log against a database, each recorded thread on its own thread and connection, and
+  // measures how long each execution takes from binding its parameters to its last step. A
+  // thread's executions run in the order they finished in the recording. Paced replay starts each
+  // one no sooner than it started in the recording, relative to the first; SQLite times statements
+  // to the millisecond, so that is approximate. Fast replay starts each as soon as the one before
+  // it on its thread is done.
+  class WorkloadReplayer
+  {
+  private:
+    static WorkloadLatency Summarize(std::string sql, std::vector<double>& latencies, int64_t const errors)
+    {
+      WorkloadLatency latency{ std::move(sql), static_cast<int64_t>(latencies.size()), errors };
+
+      if (latencies.empty())
+      {
+        return latency;
+      }
+
+      std::sort(latencies.begin(), latencies.end());
+
+      auto const at = [&](double const fraction) { return latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()))]; };
+
+      latency.Median = at(0.5);
+      latency.P90 = at(0.9);
+      latency.P99 = at(0.99);
+      latency.Max = latencies.back();
+      return latency;
+    }
+
+  public:
+    static WorkloadReport Replay(WorkloadLog const& log, char const* const database, bool const paced)
+    {
+      std::map<uint32_t, std::vector<WorkloadExecution const*>> threads;
+
+      for (WorkloadExecution const& execution : log.Executions)
+      {
+        threads[execution.Thread].push_back(&execution);
+      }
+
+      uint64_t const first = log.Executions.empty() ? 0 : std::min_element(log.Executions.begin(), log.Executions.end(), [](auto const& left, auto const& right) { return left.Start < right.Start; })->Start;
+
+      // Microseconds and errors per statement, per replay thread.
+      struct Results
+      {
+        std::vector<std::vector<double>> Latencies;
+        std::vector<int64_t> Errors;
+        std::string Error;
+      };
+
+      std::vector<Results> results(threads.size());
+      std::vector<std::thread> workers;
+      auto const start = std::chrono::steady_clock::now();
+
+      for (size_t index = 0; auto& [thread, executions] : threads)
+      {
+        workers.emplace_back([&, &executions = executions, &result = results[index++]]
+          {
+            result.Latencies.resize(log.Statements.size());
+            result.Errors.resize(log.Statements.size());
+
+            try
+            {
+              SQLiteConfinedConnection connection(database);
+              connection.SetBusyTimeout(std::chrono::seconds(10));
+              std::vector<std::optional<SQLiteConfinedStatement>> statements(log.Statements.size());
+
+              for (WorkloadExecution const* const execution : executions)
+              {
+                if (paced)
+                {
+                  std::this_thread::sleep_until(start + std::chrono::nanoseconds(execution->Start - first));
+                }
+
+                auto const begin = std::chrono::steady_clock::now();
+
+                try
+                {
+                  std::optional<SQLiteConfinedStatement>& statement = statements[execution->Statement];
+
+                  if (!statement)
+                  {
+                    statement.emplace(connection, log.Statements[execution->Statement].c_str());
+                  }
+
+                  for (int32_t parameter = 1; WorkloadParameter const& value : execution->Parameters)
+                  {
+                    switch (value.Type)
+                    {
+                      case SQLiteType::Integer: statement->Bind(parameter, value.Integer); break;
+                      case SQLiteType::Float: statement->Bind(parameter, value.Float); break;
+                      case SQLiteType::Text: statement->Bind(parameter, value.Bytes.data(), static_cast<int32_t>(value.Bytes.size())); break;
+                      case SQLiteType::Blob: statement->Bind(parameter, std::as_bytes(std::span(value.Bytes.data(), value.Bytes.size()))); break;
+                      default: statement->Bind(parameter, nullptr); break;
+                    }
+
+                    ++parameter;
+                  }
+
+                  while (statement->Step());
+                  statement->Reset();
+                }
+                catch (SQLiteException const&)
+                {
+                  if (std::optional<SQLiteConfinedStatement> const& statement = statements[execution->Statement])
+                  {
+                    sqlite3_reset(statement->GetAbi());
+                  }
+
+                  ++result.Errors[execution->Statement];
+                  continue;
+                }
+
+                result.Latencies[execution->Statement].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+              }
+            }
+            catch (SQLiteException const& ex)
+            {
+              result.Error = ex.ErrorMessage;
+            }
+          });
+      }
+
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+
+      WorkloadReport report;
+      report.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      std::vector<double> all;
+      int64_t errors = 0;
+
+      for (size_t statement = 0; statement < log.Statements.size(); ++statement)
+      {
+        std::vector<double> latencies;
+        int64_t failed = 0;
+
+        for (Results const& result : results)
+        {
+          if (!result.Error.empty())
+          {
+            throw SQLiteException(SQLITE_ERROR, "workload: " + result.Error);
+          }
+
+          latencies.insert(latencies.end(), result.Latencies[statement].begin(), result.Latencies[statement].end());
+          failed += result.Errors[statement];
+        }
+
+        all.insert(all.end(), latencies.begin(), latencies.end());
+        errors += failed;
+        report.Statements.push_back(Summarize(log.Statements[statement], latencies, failed));
+      }
+
+      report.All = Summarize("", all, errors);
+      return report;
+    }
+  };
+}
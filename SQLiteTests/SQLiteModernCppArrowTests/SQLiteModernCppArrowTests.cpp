@@ -0,0 +1,185 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include <Arrow.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "Arrow.db";
+constexpr int64_t RowCount = 1'000'000;
+constexpr int64_t BatchRows = 65'536;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What a consumer builds when it converts row by row through the reader getters.
+struct Rows
+{
+  std::vector<int64_t> Ids;
+  std::vector<std::optional<std::string>> Names;
+  std::vector<std::optional<double>> Prices;
+  std::vector<int64_t> Quantities;
+};
+
+bool Valid(ArrowArray const& column, int64_t const row) noexcept
+{
+  uint8_t const* const validity = static_cast<uint8_t const*>(column.buffers[0]);
+  int64_t const at = column.offset + row;
+  return !validity || (validity[at / 8] >> (at % 8) & 1) != 0;
+}
+
+// Compares the columns of the exported batches, read straight from their buffers, with the rows.
+bool Matches(std::vector<SQLiteArrowBatch> const& batches, Rows const& rows)
+{
+  size_t row = 0;
+
+  for (SQLiteArrowBatch const& batch : batches)
+  {
+    ArrowSchema const& schema = batch.Schema;
+    ArrowArray const& array = batch.Array;
+
+    if (schema.n_children != 4 || std::string_view(schema.children[0]->format) != "l" || std::string_view(schema.children[1]->format) != "u"
+      || std::string_view(schema.children[2]->format) != "g" || std::string_view(schema.children[3]->format) != "l")
+    {
+      return false;
+    }
+
+    ArrowArray const& ids = *array.children[0];
+    ArrowArray const& names = *array.children[1];
+    ArrowArray const& prices = *array.children[2];
+    ArrowArray const& quantities = *array.children[3];
+
+    for (int64_t index = 0; index < array.length; ++index, ++row)
+    {
+      if (row >= rows.Ids.size()) return false;
+      if (!Valid(ids, index) || static_cast<int64_t const*>(ids.buffers[1])[ids.offset + index] != rows.Ids[row]) return false;
+      if (!Valid(quantities, index) || static_cast<int64_t const*>(quantities.buffers[1])[quantities.offset + index] != rows.Quantities[row]) return false;
+
+      std::optional<double> price;
+      if (Valid(prices, index)) price = static_cast<double const*>(prices.buffers[1])[prices.offset + index];
+      if (price != rows.Prices[row]) return false;
+
+      std::optional<std::string> name;
+
+      if (Valid(names, index))
+      {
+        int32_t const* const offsets = static_cast<int32_t const*>(names.buffers[1]) + names.offset + index;
+        name.emplace(static_cast<char const*>(names.buffers[2]) + offsets[0], offsets[1] - offsets[0]);
+      }
+
+      if (name != rows.Names[row]) return false;
+    }
+  }
+
+  return row == rows.Ids.size();
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+
+    Execute(connection, "Create Table Sales ( Id Integer Primary Key, Name Text, Price Real, Quantity Integer )");
+    Execute(connection, "Create Table Copy ( Id Integer Primary Key, Name Text, Price Real, Quantity Integer )");
+
+    {
+      SQLiteTransaction transaction(connection);
+      SQLiteStatement insert(connection, "Insert Into Sales ( Name, Price, Quantity ) Values ( ?, ?, ? )");
+
+      for (int64_t row = 0; row < RowCount; ++row)
+      {
+        if (row % 10 == 0) insert.Bind(1, nullptr); else insert.Bind(1, std::string("product ") + std::to_string(row % 5000));
+        if (row % 13 == 0) insert.Bind(2, nullptr); else insert.Bind(2, static_cast<double>(row % 10'000) / 100);
+        insert.Bind(3, row % 50);
+        insert.Execute();
+        insert.Reset();
+      }
+
+      transaction.Commit();
+    }
+
+    Rows rows;
+
+    double const rowByRow = Milliseconds([&]
+      {
+        SQLiteStatement select(connection, "Select Id, Name, Price, Quantity From Sales");
+
+        while (select.Step())
+        {
+          rows.Ids.push_back(select.GetInt64(0));
+          rows.Names.push_back(select.GetType(1) == SQLiteType::Null ? std::nullopt : std::optional<std::string>(select.GetString(1)));
+          rows.Prices.push_back(select.GetType(2) == SQLiteType::Null ? std::nullopt : std::optional<double>(select.GetDouble(2)));
+          rows.Quantities.push_back(select.GetInt64(3));
+        }
+      });
+
+    std::vector<SQLiteArrowBatch> batches;
+    int64_t exported = 0;
+
+    double const arrow = Milliseconds([&]
+      {
+        SQLiteStatement select(connection, "Select Id, Name, Price, Quantity From Sales");
+
+        do
+        {
+          batches.push_back(ExportArrow(select, BatchRows));
+          exported += batches.back().Length();
+        }
+        while (batches.back().Length() == BatchRows);
+      });
+
+    double const import = Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+
+        for (SQLiteArrowBatch const& batch : batches)
+        {
+          ImportArrow(connection, "Copy", batch.Schema, batch.Array);
+        }
+
+        transaction.Commit();
+      });
+
+    SQLiteStatement check(connection, "Select Count(*) From ( Select * From Sales Except Select * From Copy )");
+    check.Step();
+
+    printf("%-14s %8.1f ms  %lld rows\n", "row by row", rowByRow, static_cast<long long>(rows.Ids.size()));
+    printf("%-14s %8.1f ms  %lld rows in %zu batches\n", "ExportArrow", arrow, static_cast<long long>(exported), batches.size());
+    printf("%-14s %8.1f ms  %lld rows differ\n", "ImportArrow", import, static_cast<long long>(check.GetInt64()));
+
+    Check(rows.Ids.size() == RowCount && exported == RowCount, "every row is exported");
+    Check(batches.size() == (RowCount + BatchRows) / BatchRows, "batches hold as many rows as they are given");
+    Check(Matches(batches, rows), "the exported columns hold what the getters read, nulls included");
+
+    SQLiteStatement count(connection, "Select Count(*) From Copy");
+    count.Step();
+    Check(check.GetInt64() == 0 && count.GetInt64() == RowCount, "the imported copy holds every row unchanged");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <SQLite.h>
+
+using namespace ModernCppSQLite;
+
+// Each benchmark runs the same work through the wrapper and through the C API on the same
+// connection. The time reported is the best of several runs, in nanoseconds per operation.
+//
+//   SQLiteModernCppBenchmarks [--iterations N] [--repetitions N] [--json file]
+
+struct Result
+{
+  std::string Name;
+  double Wrapper = 0;
+  double Raw = 0;
+};
+
+int64_t Iterations = 1'000'000;
+int32_t Repetitions = 5;
+
+// Keeps the values read by a benchmark from being optimized away.
+int64_t volatile Sink = 0;
+
+template <typename F>
+double NanosecondsPerOperation(int64_t const operations, F&& function)
+{
+  double best = 0;
+
+  for (int32_t repetition = 0; repetition < Repetitions; ++repetition)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    function();
+    double const elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(operations);
+
+    if (repetition == 0 || elapsed < best)
+    {
+      best = elapsed;
+    }
+  }
+
+  return best;
+}
+
+void Check(sqlite3* const connection, int32_t const result)
+{
+  if (result != SQLITE_OK && result != SQLITE_ROW && result != SQLITE_DONE)
+  {
+    throw SQLiteException(connection);
+  }
+}
+
+template <typename W, typename R>
+void Run(std::vector<Result>& results, char const* const name, int64_t const operations, W&& wrapper, R&& raw)
+{
+  Result& result = results.emplace_back();
+  result.Name = name;
+  result.Wrapper = NanosecondsPerOperation(operations, wrapper);
+  result.Raw = NanosecondsPerOperation(operations, raw);
+  printf("%-16s %10.1f %10.1f %8.2fx\n", name, result.Wrapper, result.Raw, result.Wrapper / result.Raw);
+}
+
+std::vector<Result> Benchmark()
+{
+  std::vector<Result> results;
+  auto connection = SQLiteConnection::Memory();
+  sqlite3* const handle = connection.GetAbi();
+
+  Execute(connection, "Create Table Numbers ( Id Integer Primary Key, Value Integer, Amount Real, Name Text, Data Blob )");
+
+  {
+    SQLiteTransaction transaction(connection);
+    SQLiteStatement insert(connection, "Insert Into Numbers ( Value, Amount, Name, Data ) Values ( ?, ?, ?, ? )");
+
+    for (int32_t row = 0; row < 10'000; ++row)
+    {
+      insert.BindAll(row, row / 4.0, "name " + std::to_string(row), std::as_bytes(std::span("data", 4)));
+      insert.Execute();
+      insert.Reset();
+    }
+
+    transaction.Commit();
+  }
+
+  printf("%-16s %10s %10s %9s\n", "ns/op", "wrapper", "raw", "overhead");
+
+  {
+    SQLiteStatement statement(connection, "Select ?1, ?2, ?3");
+    sqlite3_stmt* const raw = statement.GetAbi();
+    std::string const text = "benchmark";
+
+    Run(results, "Bind.Int", Iterations,
+      [&] { for (int64_t i = 0; i < Iterations; ++i) statement.Bind(1, static_cast<int32_t>(i)); },
+      [&] { for (int64_t i = 0; i < Iterations; ++i) Check(handle, sqlite3_bind_int(raw, 1, static_cast<int32_t>(i))); });
+
+    Run(results, "Bind.Double", Iterations,
+      [&] { for (int64_t i = 0; i < Iterations; ++i) statement.Bind(2, static_cast<double>(i)); },
+      [&] { for (int64_t i = 0; i < Iterations; ++i) Check(handle, sqlite3_bind_double(raw, 2, static_cast<double>(i))); });
+
+    Run(results, "Bind.Text", Iterations,
+      [&] { for (int64_t i = 0; i < Iterations; ++i) statement.Bind(3, text); },
+      [&] { for (int64_t i = 0; i < Iterations; ++i) Check(handle, sqlite3_bind_text(raw, 3, text.data(), static_cast<int32_t>(text.size()), SQLITE_STATIC)); });
+
+    Run(results, "Reset", Iterations,
+      [&] { for (int64_t i = 0; i < Iterations; ++i) statement.Reset(); },
+      [&] { for (int64_t i = 0; i < Iterations; ++i) Check(handle, sqlite3_reset(raw)); });
+  }
+
+  {
+    SQLiteStatement statement(connection, "Select Value From Numbers");
+    sqlite3_stmt* const raw = statement.GetAbi();
+    int64_t const rows = Iterations / 10'000 * 10'000;
+
+    Run(results, "Step", rows,
+      [&] { for (int64_t pass = 0; pass < rows / 10'000; ++pass) { while (statement.Step()); statement.Reset(); } },
+      [&] { for (int64_t pass = 0; pass < rows / 10'000; ++pass) { while (sqlite3_step(raw) == SQLITE_ROW); Check(handle, sqlite3_reset(raw)); } });
+
+    Run(results, "RowIterator", rows,
+      [&]
+      {
+        for (int64_t pass = 0; pass < rows / 10'000; ++pass)
+        {
+          int64_t sum = 0;
+
+          for (SQLiteRow const& row : statement)
+          {
+            sum += row.GetInt64();
+          }
+
+          statement.Reset();
+          Sink = sum;
+        }
+      },
+      [&]
+      {
+        for (int64_t pass = 0; pass < rows / 10'000; ++pass)
+        {
+          int64_t sum = 0;
+
+          while (sqlite3_step(raw) == SQLITE_ROW)
+          {
+            sum += sqlite3_column_int64(raw, 0);
+          }
+
+          Check(handle, sqlite3_reset(raw));
+          Sink = sum;
+        }
+      });
+  }
+
+  {
+    SQLiteStatement statement(connection, "Select Value, Amount, Name, Data From Numbers Where Id = 1");
+    sqlite3_stmt* const raw = statement.GetAbi();
+    statement.Step();
+
+    Run(results, "GetInt64", Iterations,
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += statement.GetInt64(0); Sink = sum; },
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += sqlite3_column_int64(raw, 0); Sink = sum; });
+
+    Run(results, "GetDouble", Iterations,
+      [&] { double sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += statement.GetDouble(1); Sink = static_cast<int64_t>(sum); },
+      [&] { double sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += sqlite3_column_double(raw, 1); Sink = static_cast<int64_t>(sum); });
+
+    Run(results, "GetString", Iterations,
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += statement.GetString(2)[0] + statement.GetStringLength(2); Sink = sum; },
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += sqlite3_column_text(raw, 2)[0] + sqlite3_column_bytes(raw, 2); Sink = sum; });
+
+    Run(results, "GetBlob", Iterations,
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += std::to_integer<int32_t>(statement.GetBlob(3)[0]) + statement.GetBlobLength(3); Sink = sum; },
+      [&] { int64_t sum = 0; for (int64_t i = 0; i < Iterations; ++i) sum += static_cast<unsigned char const*>(sqlite3_column_blob(raw, 3))[0] + sqlite3_column_bytes(raw, 3); Sink = sum; });
+
+    statement.Reset();
+  }
+
+  {
+    Execute(connection, "Create Table Counter ( Value Integer )");
+    Execute(connection, "Insert Into Counter Values ( 0 )");
+    char const* const update = "Update Counter Set Value = Value + 1";
+    int64_t const operations = std::max<int64_t>(1, Iterations / 100);
+
+    Run(results, "Execute", operations,
+      [&] { for (int64_t i = 0; i < operations; ++i) Execute(connection, update); },
+      [&]
+      {
+        for (int64_t i = 0; i < operations; ++i)
+        {
+          sqlite3_stmt* statement = nullptr;
+          Check(handle, sqlite3_prepare_v2(handle, update, -1, &statement, nullptr));
+          int32_t const result = sqlite3_step(statement);
+          sqlite3_finalize(statement);
+          Check(handle, result);
+        }
+      });
+  }
+
+  {
+    auto destination = SQLiteConnection::Memory();
+    int64_t const operations = std::max<int64_t>(1, Iterations / 10'000);
+
+    Run(results, "Backup", operations,
+      [&] { for (int64_t i = 0; i < operations; ++i) SQLiteBackup(destination, connection).Step(); },
+      [&]
+      {
+        for (int64_t i = 0; i < operations; ++i)
+        {
+          sqlite3_backup* const backup = sqlite3_backup_init(destination.GetAbi(), "main", handle, "main");
+
+          if (!backup)
+          {
+            destination.ThrowLastError();
+          }
+
+          sqlite3_backup_step(backup, -1);
+          Check(destination.GetAbi(), sqlite3_backup_finish(backup));
+        }
+      });
+  }
+
+  return results;
+}
+
+void WriteJson(char const* const filename, std::vector<Result> const& results)
+{
+  std::ofstream file(filename);
+  file << "{\n  \"sqlite\": \"" << sqlite3_libversion() << "\",\n  \"iterations\": " << Iterations << ",\n  \"repetitions\": " << Repetitions << ",\n  \"benchmarks\": [\n";
+
+  for (size_t index = 0; Result const& result : results)
+  {
+    char line[256];
+    snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"wrapper_ns\": %.3f, \"raw_ns\": %.3f, \"overhead\": %.4f }%s\n",
+      result.Name.c_str(), result.Wrapper, result.Raw, result.Wrapper / result.Raw, ++index < results.size() ? "," : "");
+    file << line;
+  }
+
+  file << "  ]\n}\n";
+}
+
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  try
+  {
+    char const* json = nullptr;
+
+    for (int32_t index = 1; index + 1 < argc; index += 2)
+    {
+      if (std::strcmp(argv[index], "--iterations") == 0) Iterations = std::max(10'000LL, std::atoll(argv[index + 1]));
+      else if (std::strcmp(argv[index], "--repetitions") == 0) Repetitions = std::max(1, std::atoi(argv[index + 1]));
+      else if (std::strcmp(argv[index], "--json") == 0) json = argv[index + 1];
+    }
+
+    std::vector<Result> const results = Benchmark();
+
+    if (json)
+    {
+      WriteJson(json, results);
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+}
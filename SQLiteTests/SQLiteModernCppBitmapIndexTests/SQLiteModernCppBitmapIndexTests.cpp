@@ -0,0 +1,130 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include <BitmapIndex.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "BitmapIndex.db";
+constexpr int32_t RowCount = 1'000'000;
+constexpr int32_t ChangeCount = 10'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Load(SQLiteConnection const& connection, int32_t const count, uint32_t const seed)
+{
+  std::mt19937 random(seed);
+  char const* const statuses[] = { "open", "held", "shipped", "closed", "void" };
+  char const* const regions[] = { "north", "south", "east", "west", "central", "overseas", "online", "partner" };
+  char const* const types[] = { "retail", "wholesale", "internal", "sample" };
+
+  SQLiteTransaction transaction(connection);
+  SQLiteStatement insert(connection, "Insert Into Orders ( Status, Region, Type, Amount ) Values ( ?, ?, ?, ? )");
+
+  for (int32_t row = 0; row < count; ++row)
+  {
+    insert.BindAll(statuses[random() % 5], regions[random() % 8], types[random() % 4], static_cast<double>(random() % 100'000) / 100);
+    insert.Execute();
+    insert.Reset();
+  }
+
+  transaction.Commit();
+}
+
+// Runs the same filter against the B-tree indexed table and the bitmap index, which must agree.
+void Query(SQLiteConnection const& connection, char const* const filter)
+{
+  double results[4] = { };
+
+  std::string const text[] =
+  {
+    std::string("Select Count(*) From Orders Where ") + filter,
+    std::string("Select Count(*) From OrdersIndex Where ") + filter,
+    std::string("Select Total(Amount) From Orders Where ") + filter,
+    std::string("Select Total(Amount) From Orders Where RowId In ( Select RowId From OrdersIndex Where ") + filter + " )",
+  };
+
+  for (size_t index = 0; index < std::size(text); ++index)
+  {
+    std::string const& query = text[index];
+    double& total = results[index];
+
+    double const elapsed = Milliseconds([&]
+      {
+        SQLiteStatement statement(connection, query.c_str());
+        statement.Step();
+        total = statement.GetDouble();
+      });
+
+    printf("%8.2f ms  %-120s (%.2f)\n", elapsed, query.c_str(), total);
+  }
+
+  Check(results[0] > 0 && results[1] == results[0], "the bitmap index counts the rows the table does");
+  Check(std::abs(results[3] - results[2]) <= 1e-9 * results[2], "the bitmap index selects the rows the table does");
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    CreateBitmapIndexModule(connection);
+
+    Execute(connection, "Create Table Orders ( Id Integer Primary Key, Status Text, Region Text, Type Text, Amount Real )");
+    Execute(connection, "Create Index Orders_Status On Orders ( Status )");
+    Execute(connection, "Create Index Orders_Region On Orders ( Region )");
+    Execute(connection, "Create Index Orders_Type On Orders ( Type )");
+
+    printf("load:          %8.1f ms\n", Milliseconds([&] { Load(connection, RowCount, 7); }));
+    printf("build index:   %8.1f ms\n", Milliseconds([&] { Execute(connection, "Create Virtual Table OrdersIndex Using bitmapindex ( Orders, Status, Region, Type )"); }));
+    printf("insert %d:  %8.1f ms\n", ChangeCount, Milliseconds([&] { Load(connection, ChangeCount, 11); }));
+
+    printf("update %d:  %8.1f ms\n", ChangeCount, Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+        Execute(connection, "Update Orders Set Status = 'closed' Where Id % 100 = 0");
+        transaction.Commit();
+      }));
+
+    printf("delete %d:  %8.1f ms\n", ChangeCount, Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+        Execute(connection, "Delete From Orders Where Id % 100 = 1");
+        transaction.Commit();
+      }));
+
+    Execute(connection, "Analyze");
+
+    Query(connection, "Status = 'open' And Region = 'east'");
+    Query(connection, "Status In ( 'open', 'held' ) And Region In ( 'east', 'west', 'online' ) And Type = 'retail'");
+    Query(connection, "Status = 'void' And Type = 'sample' And Region = 'partner'");
+    Query(connection, "Status = 'closed'");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+
+#include <BulkLoader.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "BulkLoader.db";
+// The first argument, if any, replaces the number of rows.
+int32_t RowCount = 2'000'000;
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Both loads get the same rows in the same random key order.
+template <typename F>
+void Generate(F&& add)
+{
+  std::mt19937_64 random(7);
+
+  for (int32_t row = 0; row < RowCount; ++row)
+  {
+    std::string const account = "account-" + std::to_string(random() % 1'000'000'000);
+    add(account, static_cast<int64_t>(row), static_cast<int64_t>(random() % 10'000), static_cast<double>(random() % 100'000) / 100);
+  }
+}
+
+void Create(SQLiteConnection const& connection, char const* const table)
+{
+  Execute(connection, (std::string("Create Table ") + table + " ( Account Text, Sequence Integer, Customer Integer, Amount Real, Primary Key ( Account, Sequence ) ) Without RowId").c_str());
+  Execute(connection, (std::string("Create Index ") + table + "_Customer On " + table + " ( Customer )").c_str());
+}
+
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  if (argc > 1)
+  {
+    RowCount = std::max(1, std::atoi(argv[1]));
+  }
+
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    connection.SetJournalMode("wal");
+
+    Create(connection, "Unsorted");
+    Create(connection, "Sorted");
+
+    double const unsorted = Milliseconds([&]
+      {
+        SQLiteStatement insert(connection, "Insert Into Unsorted Values ( ?, ?, ?, ? )");
+        std::optional<SQLiteTransaction<>> transaction(std::in_place, connection);
+        int64_t count = 0;
+
+        Generate([&](std::string const& account, int64_t const sequence, int64_t const customer, double const amount)
+          {
+            insert.BindAll(account, sequence, customer, amount);
+            insert.Execute();
+            insert.Reset();
+
+            if (++count % 500'000 == 0)
+            {
+              transaction->Commit();
+              transaction.emplace(connection);
+            }
+          });
+
+        transaction->Commit();
+      });
+
+    double add = 0;
+
+    double const sorted = Milliseconds([&]
+      {
+        BulkLoader loader(connection, "Sorted", { .MemoryLimit = 64 * 1024 * 1024 });
+
+        add = Milliseconds([&] { Generate([&](auto const& ... values) { loader.Add(values ...); }); });
+        loader.Finish();
+      });
+
+    SQLiteStatement check(connection, "Select (Select Count(*) From Sorted), (Select Count(*) From ( Select * From Unsorted Except Select * From Sorted ))");
+    check.Step();
+
+    printf("unsorted inserts  %9.1f ms  %8.0f rows/s\n", unsorted, RowCount / unsorted * 1000);
+    printf("bulk loader       %9.1f ms  %8.0f rows/s  (%.1f ms adding and sorting runs)\n", sorted, RowCount / sorted * 1000, add);
+    int64_t const differ = check.GetInt64(1);
+    printf("%lld rows loaded, %lld differ\n", static_cast<long long>(check.GetInt64(0)), static_cast<long long>(differ));
+    check.Reset();
+
+    // A load failing after some of its transactions committed must not leave the indexes dropped.
+    {
+      Create(connection, "Failed");
+      BulkLoader loader(connection, "Failed", { .TransactionRows = 2 });
+
+      for (int64_t sequence : { 1, 2, 3, 4, 4, 5 })
+      {
+        loader.Add("account", sequence, sequence * 10, 1.0);
+      }
+
+      bool failed = false;
+
+      try
+      {
+        loader.Finish();
+      }
+      catch (SQLiteException const& ex)
+      {
+        failed = (ex.ErrorCode & 0xff) == SQLITE_CONSTRAINT;
+      }
+
+      SQLiteStatement indexes(connection, "Select Count(*) From sqlite_master Where Type = 'index' And Name = 'Failed_Customer'");
+      indexes.Step();
+      printf("failed load: %s, index %s\n", failed ? "rejected" : "NOT rejected", indexes.GetInt64() == 1 ? "kept" : "LOST");
+
+      if (!failed || indexes.GetInt64() != 1 || differ != 0)
+      {
+        return 1;
+      }
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
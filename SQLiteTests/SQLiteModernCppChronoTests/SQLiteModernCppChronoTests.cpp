@@ -0,0 +1,132 @@
+#include <iostream>
+#include <chrono>
+
+#include <SQLite.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = steady_clock::now();
+  function();
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+int32_t main()
+{
+  try
+  {
+    auto connection = SQLiteConnection::Memory();
+    SQLiteTimeFunctions::Create(connection);
+    Execute(connection, "Create Table Events ( Time Integer, Elapsed Integer )");
+
+    // 2024-02-29 12:34:56.789012345 UTC
+    sys_time<nanoseconds> const time = sys_days(year(2024) / 2 / 29) + 12h + 34min + 56s + 789'012'345ns;
+    nanoseconds const elapsed = 1h + 1ns;
+
+    {
+      SQLiteStatement insert(connection, "Insert Into Events Values ( ?, ? )");
+      insert.BindAll(time, elapsed);
+      insert.Execute();
+    }
+
+    SQLiteStatement select(connection, "Select Time, Elapsed, datetime(julianday_from_ticks(Time, 1000000000)), strftime('%f', julianday_from_ticks(Time, 1000000000)) From Events");
+    select.Step();
+
+    Check(select.Get<sys_time<nanoseconds>>(0) == time, "a nanosecond time point reads back as bound");
+    Check(select.Get<nanoseconds>(1) == elapsed, "a duration reads back as bound");
+    Check(std::string_view(select.GetString(2)) == "2024-02-29 12:34:56", "julianday_from_ticks gives the date and time");
+    Check(std::string_view(select.GetString(3)) == "56.789", "julianday_from_ticks keeps milliseconds");
+    select.Reset();
+
+    SQLiteStatement ticks(connection, "Select ticks_from_julianday(julianday('2024-02-29 12:34:56.789'), 1000), ticks_from_julianday(julianday_from_ticks(?1, 1000, 3657), 1000, 3657)");
+    using Gps = SQLiteTimeEncoding<microseconds, 3657>;
+    ticks.Bind(1, SQLiteTimeEncoding<milliseconds, 3657>::Encode(time));
+    ticks.Step();
+    Check(ticks.Get<sys_time<milliseconds>>(0) == floor<milliseconds>(time), "ticks_from_julianday gives milliseconds since 1970");
+    Check(ticks.GetInt64(1) == SQLiteTimeEncoding<milliseconds, 3657>::Encode(time), "milliseconds survive a round trip through a Julian day with another epoch");
+    Check(Gps::Decode<nanoseconds>(Gps::Encode(time)) == floor<microseconds>(time), "an encoding rounds to its unit");
+    Check(Gps::Encode(sys_days(year(1980) / 1 / 6)) == 0, "an encoding counts from its epoch");
+    ticks.Reset();
+
+    auto const now = steady_clock::now();
+    SQLiteStatement echo(connection, "Select ?");
+    echo.Bind(1, now);
+    echo.Step();
+    Check(echo.Get<steady_clock::time_point>() == now, "a steady_clock time point reads back as bound");
+    echo.Reset();
+
+    // The same timestamps as integer ticks and as text that has to be formatted and parsed.
+    int64_t constexpr Rows = 200'000;
+    Execute(connection, "Create Table Ticks ( Time Integer )");
+    Execute(connection, "Create Table Texts ( Time Text )");
+
+    double const integers = Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+        SQLiteStatement insert(connection, "Insert Into Ticks Values ( ? )");
+
+        for (int64_t row = 0; row < Rows; ++row)
+        {
+          insert.Bind(1, time + microseconds(row));
+          insert.Execute();
+          insert.Reset();
+        }
+
+        transaction.Commit();
+
+        nanoseconds total{ };
+
+        for (SQLiteRow const& row : SQLiteStatement(connection, "Select Time From Ticks"))
+        {
+          total += row.Get<sys_time<nanoseconds>>() - time;
+        }
+
+        Check(total == microseconds(Rows * (Rows - 1) / 2), "integer ticks add up");
+      });
+
+    double const texts = Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+        SQLiteStatement insert(connection, "Insert Into Texts Values ( strftime('%Y-%m-%d %H:%M:%f', ?, 'unixepoch') )");
+
+        for (int64_t row = 0; row < Rows; ++row)
+        {
+          insert.Bind(1, duration<double>(time.time_since_epoch() + microseconds(row)).count());
+          insert.Execute();
+          insert.Reset();
+        }
+
+        transaction.Commit();
+
+        double total = 0;
+
+        for (SQLiteRow const& row : SQLiteStatement(connection, "Select (julianday(Time) - 2440587.5) * 86400.0 From Texts"))
+        {
+          total += row.GetDouble();
+        }
+
+        Check(total > 0, "text timestamps parse");
+      });
+
+    printf("\n%lld timestamps written and read: %.1f ms as integer ticks, %.1f ms as text\n", static_cast<long long>(Rows), integers, texts);
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
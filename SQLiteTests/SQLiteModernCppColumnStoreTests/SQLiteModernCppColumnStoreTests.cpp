@@ -0,0 +1,162 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <ColumnStore.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "ColumnStore.db";
+constexpr int32_t ColumnCount = 40;
+constexpr int32_t RowCount = 200'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Id, then columns cycling through a low-cardinality code, a wide integer, a price and a region.
+std::string Columns()
+{
+  std::string columns = "Id Integer";
+
+  for (int32_t column = 1; column < ColumnCount; ++column)
+  {
+    char const* const types[] = { "Integer", "Integer", "Real", "Text" };
+    columns += ", c" + std::to_string(column) + " " + types[column % 4];
+  }
+
+  return columns;
+}
+
+void Load(SQLiteConnection const& connection, char const* const table)
+{
+  std::mt19937 random(7);
+  char const* const regions[] = { "north", "south", "east", "west", "central" };
+
+  std::string text = std::string("Insert Into ") + table + " Values ( ?";
+
+  for (int32_t column = 1; column < ColumnCount; ++column)
+  {
+    text += ", ?";
+  }
+
+  SQLiteTransaction transaction(connection);
+  SQLiteStatement insert(connection, (text + " )").c_str());
+
+  for (int64_t row = 0; row < RowCount; ++row)
+  {
+    insert.Bind(1, row);
+
+    for (int32_t column = 1; column < ColumnCount; ++column)
+    {
+      switch (column % 4)
+      {
+        case 0: insert.Bind(column + 1, static_cast<int32_t>(random() % 8)); break;
+        case 1: insert.Bind(column + 1, static_cast<int64_t>(random())); break;
+        case 2: insert.Bind(column + 1, static_cast<double>(random() % 10'000) / 100); break;
+        default: insert.Bind(column + 1, regions[random() % 5]); break;
+      }
+    }
+
+    insert.Execute();
+    insert.Reset();
+  }
+
+  transaction.Commit();
+}
+
+// Returns the count and the total of every query.
+std::vector<std::pair<int64_t, double>> Query(SQLiteConnection const& connection, char const* const name, char const* const table)
+{
+  char const* const queries[] =
+  {
+    "Select Count(*), Total(c2), Total(c6) From %s Where c4 = 3",
+    "Select Count(*), Total(c10) From %s Where c3 = 'east' And c8 < 2",
+    "Select Count(*), Total(c2) From %s Where Id Between 50000 And 60000",
+  };
+
+  std::vector<std::pair<int64_t, double>> results;
+
+  for (char const* const query : queries)
+  {
+    char text[256];
+    snprintf(text, sizeof(text), query, table);
+
+    int64_t count = 0;
+    double total = 0;
+
+    double const elapsed = Milliseconds([&]
+      {
+        SQLiteStatement statement(connection, text);
+        statement.Step();
+        count = statement.GetInt64(0);
+        total = statement.GetDouble(1);
+      });
+
+    printf("%-12s %8.2f ms  %-70s (%.2f)\n", name, elapsed, text, total);
+    results.emplace_back(count, total);
+  }
+
+  return results;
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    {
+      SQLiteConnection connection{ DatabaseName };
+      CreateColumnStoreModule(connection);
+
+      Execute(connection, ("Create Table Rows ( " + Columns() + " )").c_str());
+      Execute(connection, ("Create Virtual Table Columns Using columnstore ( " + Columns() + " )").c_str());
+
+      printf("load rows:    %8.1f ms\n", Milliseconds([&] { Load(connection, "Rows"); }));
+      printf("load columns: %8.1f ms\n", Milliseconds([&] { Load(connection, "Columns"); }));
+    }
+
+    // A fresh connection, so both tables are read from the file.
+    SQLiteConnection connection{ DatabaseName };
+    CreateColumnStoreModule(connection);
+
+    auto const rows = Query(connection, "row store", "Rows");
+    auto const columns = Query(connection, "column store", "Columns");
+
+    Check(rows == columns, "the column store answers the queries as the row store does");
+    Check(rows[2].first == 10'001, "a range of ids selects every row in it");
+
+    SQLiteStatement count(connection, "Select Count(*) From Columns");
+    count.Step();
+    Check(count.GetInt64() == RowCount, "the column store holds every row loaded");
+    count.Reset();
+
+    SQLiteStatement differences(connection, "Select Count(*) From ( Select * From Rows Except Select * From Columns )");
+    differences.Step();
+    Check(differences.GetInt64() == 0, "every row reads back from the column store as it was loaded");
+    differences.Reset();
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+
+#include <IndexAdvisor.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "IndexAdvisor.db";
+constexpr int32_t OrderCount = 300'000;
+constexpr int32_t CustomerCount = 20'000;
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Load(SQLiteConnection const& connection)
+{
+  std::mt19937 random(7);
+  char const* const statuses[] = { "open", "shipped", "closed", "closed", "closed", "closed", "closed", "closed" };
+
+  SQLiteTransaction transaction(connection);
+  SQLiteStatement order(connection, "Insert Into Orders ( Customer, Status, Placed, Amount ) Values ( ?, ?, ?, ? )");
+  SQLiteStatement customer(connection, "Insert Into Customers ( Name, Region ) Values ( ?, ? )");
+
+  for (int32_t row = 0; row < OrderCount; ++row)
+  {
+    order.BindAll(static_cast<int32_t>(random() % CustomerCount), statuses[random() % 8], static_cast<int32_t>(random() % 1'000'000), static_cast<double>(random() % 10'000) / 100);
+    order.Execute();
+    order.Reset();
+  }
+
+  for (int32_t row = 0; row < CustomerCount; ++row)
+  {
+    customer.BindAll("customer " + std::to_string(row), row % 2 ? "east" : "west");
+    customer.Execute();
+    customer.Reset();
+  }
+
+  transaction.Commit();
+}
+
+// A small mix of lookups, a paged listing, a report, and point updates.
+void Workload(SQLiteConnection const& connection)
+{
+  SQLiteStatement byCustomer(connection, "Select Total(Amount) From Orders Where Customer = ?");
+  SQLiteStatement recent(connection, "Select Id, Placed From Orders o Where o.Status = 'open' And o.Placed > ? Order By Placed Limit 20");
+  SQLiteStatement report(connection, "Select c.Name, Sum(o.Amount) From Customers c Join Orders o On o.Customer = c.Id Where c.Region = ? Group By c.Name");
+  SQLiteStatement close(connection, "Update Orders Set Status = 'closed' Where Id = ?");
+
+  for (int32_t index = 0; index < 20; ++index)
+  {
+    byCustomer.BindAll(index * 37);
+    while (byCustomer.Step());
+    byCustomer.Reset();
+
+    recent.BindAll(index * 40'000);
+    while (recent.Step());
+    recent.Reset();
+
+    close.BindAll(index + 1);
+    close.Execute();
+    close.Reset();
+  }
+
+  report.BindAll("east");
+  while (report.Step());
+  report.Reset();
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    Execute(connection, "Create Table Customers ( Id Integer Primary Key, Name Text, Region Text )");
+    Execute(connection, "Create Table Orders ( Id Integer Primary Key, Customer Integer, Status Text, Placed Integer, Amount Real )");
+    Load(connection);
+
+    bool rejected = false;
+
+    try
+    {
+      IndexAdvisor unsampled(connection, { .MaxSamples = 0 });
+    }
+    catch (SQLiteException const& ex)
+    {
+      rejected = ex.ErrorCode == SQLITE_MISUSE;
+    }
+
+    if (!rejected)
+    {
+      printf("an advisor without samples was not rejected\n");
+      return 1;
+    }
+
+    IndexAdvisor advisor(connection, { .Repeat = 2 });
+    advisor.Attach();
+    double const before = Milliseconds([&] { Workload(connection); });
+    advisor.Detach();
+
+    std::vector<IndexProposal> proposals;
+    printf("advise:   %8.1f ms\n", Milliseconds([&] { proposals = advisor.Advise(); }));
+
+    for (IndexProposal const& proposal : proposals)
+    {
+      printf("%8.1f -> %8.1f ms  %s\n                        %s\n", proposal.Before, proposal.After, proposal.Sql.c_str(), proposal.Reason.c_str());
+    }
+
+    // Each proposal was timed with the ones before it in place, so they are taken together.
+    for (IndexProposal const& proposal : proposals)
+    {
+      Execute(connection, proposal.Sql.c_str());
+    }
+
+    printf("workload: %8.1f ms before, %8.1f ms after\n", before, Milliseconds([&] { Workload(connection); }));
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+}
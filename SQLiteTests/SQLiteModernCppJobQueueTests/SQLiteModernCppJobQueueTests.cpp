@@ -0,0 +1,233 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <JobQueue.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono_literals;
+
+constexpr char const* DatabaseName = "JobQueue.db";
+constexpr int32_t JobCount = 20'000;
+constexpr int32_t BaselineJobCount = 2'000;
+constexpr int32_t ClaimSize = 32;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+SQLiteConnection OpenDatabase()
+{
+  SQLiteConnection connection{ DatabaseName };
+  connection.SetBusyTimeout(10s);
+  connection.SetJournalMode("wal");
+  Execute(connection, "Pragma synchronous = NORMAL");
+  return connection;
+}
+
+template <typename F>
+double JobsPerSecond(int32_t const jobs, int32_t const workers, F&& work)
+{
+  std::vector<std::thread> threads;
+  auto const start = std::chrono::steady_clock::now();
+
+  for (int32_t worker = 0; worker < workers; ++worker)
+  {
+    threads.emplace_back(work);
+  }
+
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  return jobs / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double RunJobQueue(int32_t const workers)
+{
+  SQLiteConnection connection = OpenDatabase();
+  JobQueue queue(connection);
+
+  std::vector<std::string> const payloads(1'000, std::string(64, 'p'));
+  std::vector<std::string_view> const views(payloads.begin(), payloads.end());
+
+  for (int32_t enqueued = 0; enqueued < JobCount; enqueued += static_cast<int32_t>(views.size()))
+  {
+    queue.Enqueue(views);
+  }
+
+  std::atomic<int32_t> remaining = JobCount;
+
+  return JobsPerSecond(JobCount, workers, [&]
+    {
+      while (remaining > 0)
+      {
+        std::vector<Job> const jobs = queue.WaitClaimBatch(ClaimSize, 30s, 10ms);
+
+        if (!jobs.empty())
+        {
+          queue.Ack(jobs);
+          remaining -= static_cast<int32_t>(jobs.size());
+        }
+      }
+    });
+}
+
+// Today's pattern: every worker has its own connection and spends several statements per job.
+double RunBaseline(int32_t const workers)
+{
+  {
+    SQLiteConnection connection = OpenDatabase();
+    Execute(connection, "Create Table If Not Exists Baseline ( Id Integer Primary Key, Status Integer, Payload Blob )");
+    Execute(connection, "Create Index If Not Exists Baseline_Status On Baseline ( Status )");
+
+    SQLiteTransaction transaction(connection);
+    SQLiteStatement insert(connection, "Insert Into Baseline ( Status, Payload ) Values ( 0, RandomBlob(64) )");
+
+    for (int32_t job = 0; job < BaselineJobCount; ++job)
+    {
+      insert.Execute();
+      insert.Reset();
+    }
+
+    transaction.Commit();
+  }
+
+  return JobsPerSecond(BaselineJobCount, workers, []
+    {
+      SQLiteConnection connection = OpenDatabase();
+      SQLiteStatement select(connection, "Select Id From Baseline Where Status = 0 Limit 1");
+      SQLiteStatement update(connection, "Update Baseline Set Status = 1 Where Id = ?");
+      SQLiteStatement remove(connection, "Delete From Baseline Where Id = ?");
+
+      while (true)
+      {
+        SQLiteTransaction transaction(connection, SQLiteTransactionType::Immediate);
+
+        if (!select.Step())
+        {
+          select.Reset();
+          break;
+        }
+
+        int64_t const id = select.GetInt64();
+        select.Reset();
+
+        update.Bind(1, id);
+        update.Execute();
+        update.Reset();
+        transaction.Commit();
+
+        SQLiteTransaction acknowledge(connection, SQLiteTransactionType::Immediate);
+        remove.Bind(1, id);
+        remove.Execute();
+        remove.Reset();
+        acknowledge.Commit();
+      }
+    });
+}
+
+int64_t JobsLeft(SQLiteConnection const& connection)
+{
+  SQLiteStatement count(connection, "Select Count(*) From Leases");
+  count.Step();
+  return count.GetInt64();
+}
+
+// A worker whose lease expired must not delete a job that was made ready again or leased to another worker.
+void RunLeaseChecks()
+{
+  SQLiteConnection connection = OpenDatabase();
+  JobQueue queue(connection, { .Table = "Leases" });
+
+  queue.Enqueue("first");
+  std::vector<Job> const expired = queue.ClaimBatch(1, 20ms);
+  std::this_thread::sleep_for(50ms);
+
+  // Claiming nothing still makes the expired job ready again.
+  queue.ClaimBatch(0, 30s);
+  queue.Ack(expired);
+  Check(expired.size() == 1 && JobsLeft(connection) == 1, "an ack after the lease expired keeps the requeued job");
+
+  std::vector<Job> const reclaimed = queue.ClaimBatch(1, 30s);
+  queue.Ack(expired);
+  Check(reclaimed.size() == 1 && reclaimed[0].Id == expired[0].Id && JobsLeft(connection) == 1, "an ack after the lease expired keeps the job leased to another worker");
+
+  queue.Release(expired);
+  Check(queue.ClaimBatch(1, 30s).empty(), "a release after the lease expired keeps the job leased to another worker");
+
+  queue.Ack(reclaimed);
+  Check(JobsLeft(connection) == 0, "the current lease acknowledges the job");
+
+  queue.Enqueue("second");
+  std::vector<Job> const released = queue.ClaimBatch(1, 30s);
+  queue.Release(released);
+  queue.Ack(released);
+  Check(JobsLeft(connection) == 1, "an ack after a release keeps the job");
+}
+
+void RunPayloadChecks()
+{
+  SQLiteConnection connection = OpenDatabase();
+  JobQueue queue(connection, { .Table = "Payloads" });
+
+  queue.Enqueue(std::string_view());
+  std::vector<Job> const empty = queue.ClaimBatch(1, 30s);
+  SQLiteStatement nulls(connection, "Select Count(*) From Payloads Where Payload Is Null");
+  nulls.Step();
+  Check(empty.size() == 1 && empty[0].Payload.empty() && nulls.GetInt64() == 0, "an empty payload is stored as an empty blob");
+  nulls.Reset();
+  queue.Ack(empty);
+
+  Execute(connection, "Create Temp Trigger Refuse Before Insert On Payloads When New.Payload = Cast('refused' As Blob) Begin Select Raise(Abort, 'refused'); End");
+  bool refused = false;
+
+  try
+  {
+    queue.Enqueue("refused");
+  }
+  catch (SQLiteException const&)
+  {
+    refused = true;
+  }
+
+  queue.Enqueue("accepted");
+  std::vector<Job> const accepted = queue.ClaimBatch(2, 30s);
+  Check(refused && accepted.size() == 1 && accepted[0].Payload == "accepted", "a queue keeps working after a refused enqueue");
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+    RunLeaseChecks();
+    RunPayloadChecks();
+
+    for (int32_t workers = 1; workers <= 32; workers *= 2)
+    {
+      std::filesystem::remove(DatabaseName);
+
+      double const queue = RunJobQueue(workers);
+      double const baseline = RunBaseline(workers);
+
+      printf("%2d workers  JobQueue: %10.0f jobs/s  baseline: %10.0f jobs/s\n", workers, queue, baseline);
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
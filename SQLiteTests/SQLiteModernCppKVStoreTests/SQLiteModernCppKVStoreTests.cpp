@@ -0,0 +1,222 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <KVStore.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "KVStore.db";
+constexpr int32_t KeyCount = 20'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double OperationsPerSecond(size_t const operations, F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return operations / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string MakeKey(int32_t const value)
+{
+  char key[16];
+  snprintf(key, sizeof(key), "key:%08d", value);
+  return key;
+}
+
+// The pattern the services use today: a statement prepared per call, one transaction per write.
+void RunHandWritten(SQLiteConnection const& connection, std::vector<std::string> const& keys, std::string const& value)
+{
+  Execute(connection, "Create Table If Not Exists kv ( k Text Primary Key, v Blob )");
+
+  double const puts = OperationsPerSecond(keys.size(), [&]
+    {
+      for (std::string const& key : keys)
+      {
+        Execute(connection, "Insert Or Replace Into kv Values (?, ?)", key, value);
+      }
+    });
+
+  size_t found = 0;
+
+  double const gets = OperationsPerSecond(keys.size(), [&]
+    {
+      for (std::string const& key : keys)
+      {
+        SQLiteStatement statement(connection, "Select v From kv Where k = ?", key);
+        found += statement.Step();
+      }
+    });
+
+  printf("%-12s put: %10.0f ops/s  get: %10.0f ops/s  (%zu found)\n", "hand-written", puts, gets, found);
+}
+
+void RunKVStore(SQLiteConnection const& connection, std::vector<std::string> const& keys, std::string const& value)
+{
+  KVStore store(connection);
+
+  double const puts = OperationsPerSecond(keys.size(), [&]
+    {
+      for (std::string const& key : keys)
+      {
+        store.Put(key, value);
+      }
+
+      store.Flush();
+    });
+
+  size_t found = 0;
+
+  double const gets = OperationsPerSecond(keys.size(), [&]
+    {
+      for (std::string const& key : keys)
+      {
+        found += store.Get(key).has_value();
+      }
+    });
+
+  std::vector<std::string_view> const views(keys.begin(), keys.end());
+
+  double const multiGets = OperationsPerSecond(keys.size(), [&]
+    {
+      for (std::optional<std::string> const& result : store.MultiGet(views))
+      {
+        found += result.has_value();
+      }
+    });
+
+  size_t scanned = 0;
+
+  double const scans = OperationsPerSecond(keys.size(), [&]
+    {
+      store.Scan(MakeKey(0), {}, [&](std::string_view, std::string_view)
+        {
+          ++scanned;
+        });
+    });
+
+  printf("%-12s put: %10.0f ops/s  get: %10.0f ops/s  multi-get: %10.0f ops/s  scan: %10.0f rows/s  (%zu found, %zu scanned)\n",
+    "KVStore", puts, gets, multiGets, scans, found, scanned);
+}
+
+std::string ScanKeys(KVStore<>& store, std::string_view const first, std::string_view const last)
+{
+  std::string keys;
+
+  store.Scan(first, last, [&](std::string_view const key, std::string_view)
+    {
+      keys += key.empty() ? "<empty>" : key;
+      keys += ' ';
+    });
+
+  return keys;
+}
+
+void RunChecks(SQLiteConnection const& connection)
+{
+  KVStore store(connection, { .Table = "Checks" });
+
+  store.Put("b", "2");
+  store.Put("a", "1");
+  store.Put("c", "3");
+  store.Put("d", "4");
+  Check(store.Get("a") == "1" && !store.Get("e"), "pending writes are visible to Get");
+
+  store.Flush();
+  Check(store.Get("c") == "3" && store.PendingCount() == 0, "flushed writes are visible to Get");
+
+  store.Delete("c");
+  Check(!store.Get("c"), "a pending delete hides the key");
+  store.Flush();
+  Check(!store.Get("c") && ScanKeys(store, {}, {}) == "a b d ", "a flushed delete removes the key");
+
+  Check(ScanKeys(store, "b", "d") == "b ", "a bounded scan stops before its upper bound");
+  Check(ScanKeys(store, "b", {}) == "b d ", "an empty upper bound scans to the end");
+
+  store.Put({}, "empty");
+  store.Flush();
+  Check(store.Get("") == "empty" && ScanKeys(store, {}, "b") == "<empty> a ", "the empty key is stored as an empty blob");
+
+  try
+  {
+    store.Scan({}, {}, [](std::string_view, std::string_view) { throw std::runtime_error("stop"); });
+  }
+  catch (std::runtime_error const&)
+  {
+  }
+
+  bool busy = false;
+
+  for (sqlite3_stmt* statement = sqlite3_next_stmt(connection.GetAbi(), nullptr); statement; statement = sqlite3_next_stmt(connection.GetAbi(), statement))
+  {
+    busy = busy || sqlite3_stmt_busy(statement);
+  }
+
+  Check(!busy, "a scan whose callback throws does not keep reading");
+
+  Execute(connection, "Create Temp Trigger Refuse Before Insert On Checks When New.Key = Cast('e' As Blob) Begin Select Raise(Abort, 'refused'); End");
+  store.Put("e", "5");
+  bool refused = false;
+
+  try
+  {
+    store.Flush();
+  }
+  catch (SQLiteException const&)
+  {
+    refused = true;
+  }
+
+  Execute(connection, "Drop Trigger Refuse");
+  store.Flush();
+  Check(refused && store.Get("e") == "5" && store.PendingCount() == 0, "a failed flush can be retried");
+
+  SQLiteStatement nulls(connection, "Select Count(*) From Checks Where Key Is Null");
+  nulls.Step();
+  Check(nulls.GetInt64() == 0, "no key is stored as NULL");
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    connection.SetJournalMode("wal");
+
+    std::vector<std::string> keys;
+
+    for (int32_t index = 0; index < KeyCount; ++index)
+    {
+      keys.push_back(MakeKey(index));
+    }
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{ 42 });
+
+    std::string const value(100, 'v');
+
+    RunChecks(connection);
+    RunHandWritten(connection, keys, value);
+    RunKVStore(connection, keys, value);
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
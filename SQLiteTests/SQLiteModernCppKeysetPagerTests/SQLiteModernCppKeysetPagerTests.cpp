@@ -0,0 +1,123 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <vector>
+
+#include <KeysetPager.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "KeysetPager.db";
+constexpr int32_t RowCount = 100'000;
+constexpr int32_t PageSize = 1'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    Execute(connection, "Create Table Events ( Id Integer Primary Key, Kind Integer, At Integer, Detail Text )");
+    Execute(connection, "Create Index Events_At On Events ( At )");
+
+    {
+      SQLiteTransaction transaction(connection);
+      SQLiteStatement insert(connection, "Insert Into Events ( Kind, At, Detail ) Values ( ?, ?, ? )");
+
+      for (int32_t row = 0; row < RowCount; ++row)
+      {
+        insert.BindAll(row % 7, static_cast<int64_t>(row) * 7919 % RowCount / 10, "event detail " + std::to_string(row));
+        insert.Execute();
+        insert.Reset();
+      }
+
+      transaction.Commit();
+    }
+
+    // Limit/Offset: every page skips over all the rows before it.
+    SQLiteStatement offset(connection, "Select Id, Kind, At, Detail From Events Where Kind <> 3 Order By At, Id Limit ? Offset ?");
+    int64_t offsetRows = 0;
+    int32_t pages = 0;
+    std::vector<std::vector<int64_t>> offsetPages;
+    double lastOffsetPage = 0;
+
+    double const offsetTotal = Milliseconds([&]
+      {
+        for (int32_t rows = PageSize; rows == PageSize; ++pages)
+        {
+          rows = 0;
+          std::vector<int64_t>& ids = offsetPages.emplace_back();
+
+          lastOffsetPage = Milliseconds([&]
+            {
+              offset.BindAll(PageSize, static_cast<int64_t>(pages) * PageSize);
+
+              while (offset.Step())
+              {
+                ids.push_back(offset.GetInt64(0));
+                ++rows;
+              }
+
+              offset.Reset();
+            });
+
+          offsetRows += rows;
+        }
+      });
+
+    // Keyset: every page starts from the (At, Id) of the last row of the previous one.
+    KeysetPager pager(connection, "Select Id, Kind, At, Detail From Events Where Kind <> 3", { "At", "Id" }, { PageSize });
+    int64_t keysetRows = 0;
+    double lastKeysetPage = 0;
+    std::vector<std::vector<int64_t>> keysetPages;
+
+    double const keysetTotal = Milliseconds([&]
+      {
+        while (!pager.Done())
+        {
+          std::vector<int64_t>& ids = keysetPages.emplace_back();
+          lastKeysetPage = Milliseconds([&] { keysetRows += pager.NextPage([&](SQLiteRow const& row) { ids.push_back(row.GetInt64(0)); }); });
+        }
+      });
+
+    printf("%d pages of %d rows\n", pages, PageSize);
+    printf("limit/offset  %9.1f ms total  %7.2f ms last page  %lld rows\n", offsetTotal, lastOffsetPage, static_cast<long long>(offsetRows));
+    printf("keyset        %9.1f ms total  %7.2f ms last page  %lld rows\n", keysetTotal, lastKeysetPage, static_cast<long long>(keysetRows));
+
+    // The offset query may end with an empty page that the pager, knowing it is done, never reads.
+    if (!offsetPages.empty() && offsetPages.back().empty() && (keysetPages.empty() || !keysetPages.back().empty()))
+    {
+      offsetPages.pop_back();
+    }
+
+    SQLiteStatement count(connection, "Select Count(*) From Events Where Kind <> 3");
+    count.Step();
+    Check(keysetRows == count.GetInt64() && keysetRows == offsetRows, "keyset paging visits every row once");
+    Check(keysetPages == offsetPages, "keyset pages hold the rows of the offset pages, in the same order");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <MemoryMap.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "MemoryMap.db";
+constexpr int32_t RowCount = 200'000;
+constexpr int32_t LookupCount = 200'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+void CreateDatabase()
+{
+  SQLiteConnection connection{ DatabaseName };
+
+  Execute(connection, "Create Table Things ( Id Integer Primary Key, Payload Blob )");
+  Execute(connection,
+    "With Recursive Numbers(Value) As (Select 1 Union All Select Value + 1 From Numbers Where Value < ?) "
+    "Insert Into Things Select Value, RandomBlob(200) From Numbers", RowCount);
+}
+
+template <typename F>
+double Measure(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns a digest of the rows looked up, which is the same whatever the options.
+uint64_t Run(char const* const name, SQLiteMemoryMapOptions const& options, std::vector<int32_t> const& keys)
+{
+  SQLiteConnection connection = OpenMemoryMapped(DatabaseName, options);
+
+  sqlite3_int64 bytes = 0;
+  uint64_t digest = 0;
+  SQLiteStatement lookup(connection, "Select Payload From Things Where Id = ?");
+
+  double const lookups = Measure([&]
+    {
+      for (int32_t const key : keys)
+      {
+        lookup.Bind(1, key);
+
+        if (lookup.Step())
+        {
+          bytes += lookup.GetBlobLength();
+          digest = digest * 31 + std::to_integer<uint64_t>(*lookup.GetBlob());
+        }
+
+        lookup.Reset();
+      }
+    });
+
+  double const scan = Measure([&]
+    {
+      for (SQLiteRow const& row : SQLiteStatement{ connection, "Select Payload From Things" })
+      {
+        bytes += row.GetBlobLength();
+      }
+    });
+
+  SQLiteMemoryMapStatistics const statistics = GetMemoryMapStatistics(connection);
+
+  printf("%-16s mmap_size: %10lld  lookups: %8.2f ms  scan: %8.2f ms  mapped reads: %8lld  file reads: %8lld  (%lld bytes)\n",
+    name,
+    static_cast<long long>(connection.GetMemoryMapSize()),
+    lookups,
+    scan,
+    static_cast<long long>(statistics.MappedReads),
+    static_cast<long long>(statistics.FileReads),
+    static_cast<long long>(bytes));
+
+  Check(connection.GetMemoryMapSize() == options.Size, "the connection maps as much as it was asked to");
+  Check(options.Size == 0 ? statistics.MappedReads == 0 && statistics.FileReads > 0 : statistics.MappedReads > statistics.FileReads,
+    "pages are read through the mapping only when there is one");
+  return digest;
+}
+
+int32_t main()
+{
+  try
+  {
+    if (!std::filesystem::exists(DatabaseName))
+    {
+      CreateDatabase();
+    }
+
+    std::mt19937 generator{ 42 };
+    std::uniform_int_distribution<int32_t> distribution{ 1, RowCount };
+    std::vector<int32_t> keys(LookupCount);
+
+    for (int32_t& key : keys)
+    {
+      key = distribution(generator);
+    }
+
+    // The first run only warms the operating system page cache.
+    uint64_t const digest = Run("warm-up", { .Size = 0 }, keys);
+
+    Check(Run("pread", { .Size = 0 }, keys) == digest, "reads without a mapping return the same rows");
+    Check(Run("mmap", { .Advice = SQLiteMemoryAdvice::Normal }, keys) == digest, "mapped reads return the same rows");
+    Check(Run("mmap+random", { .Advice = SQLiteMemoryAdvice::Random }, keys) == digest, "mapped reads advised random return the same rows");
+    Check(Run("mmap+sequential", { .Advice = SQLiteMemoryAdvice::Sequential }, keys) == digest, "mapped reads advised sequential return the same rows");
+
+    bool missing = false;
+
+    try
+    {
+      OpenMemoryMapped("MemoryMapMissing.db", { .Flags = SQLITE_OPEN_READONLY });
+    }
+    catch (SQLiteException const& ex)
+    {
+      missing = (ex.ErrorCode & 0xff) == SQLITE_CANTOPEN;
+    }
+
+    Check(missing, "a file the wrapped VFS cannot open is not opened");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
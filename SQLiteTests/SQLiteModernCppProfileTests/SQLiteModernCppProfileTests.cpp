@@ -25,17 +25,18 @@ int32_t main()
 
       connection.Profile([]([[maybe_unused]] int32_t* context, const char* const statement, const sqlite3_uint64 time)
         {
-          std::chrono::seconds seconds{ time };
-          auto miliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(seconds);
+          // SQLite reports the time in nanoseconds.
+          std::chrono::nanoseconds nanoseconds{ time };
+          auto miliseconds = std::chrono::duration<double, std::milli>(nanoseconds);
 
-          printf_s("Seconds: %lld, %s\n", seconds.count(), statement);
-          printf_s("Miliseconds: %lld, %s\n", miliseconds.count(), statement);
+          printf("Nanoseconds: %lld, %s\n", static_cast<long long>(nanoseconds.count()), statement);
+          printf("Miliseconds: %.3f, %s\n", miliseconds.count(), statement);
 
         }, &argument_context);
 
       for (int32_t index = 0; const SQLiteRow & row : SQLiteStatement{ connection, "Select * From Things" })
       {
-        printf_s("[%2d]: %.2f\n", ++index, row.GetDouble());
+        printf("[%2d]: %.2f\n", ++index, row.GetDouble());
       }
 
       std::cout << "\n\n";
@@ -45,11 +46,11 @@ int32_t main()
 
     connection.Profile([]([[maybe_unused]] int32_t* context, const char* const statement, const uint64_t time)
       {
-        std::chrono::seconds seconds{ time };
-        auto miliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(seconds);
+        std::chrono::nanoseconds nanoseconds{ time };
+        auto miliseconds = std::chrono::duration<double, std::milli>(nanoseconds);
 
-        printf_s("Seconds: %lld, %s\n", seconds.count(), statement);
-        printf_s("Miliseconds: %lld, %s\n", miliseconds.count(), statement);
+        printf("Nanoseconds: %lld, %s\n", static_cast<long long>(nanoseconds.count()), statement);
+        printf("Miliseconds: %.3f, %s\n", miliseconds.count(), statement);
       });
 
     Execute(connection, "Create Table Things ( Content Read )");
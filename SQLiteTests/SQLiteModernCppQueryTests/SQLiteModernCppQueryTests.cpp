@@ -0,0 +1,182 @@
+#include <iostream>
+#include <chrono>
+
+#include <Query.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = steady_clock::now();
+  function();
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+struct Order
+{
+  int64_t Id = 0;
+  std::string Customer;
+  double Amount = 0;
+  std::optional<std::string> Note;
+};
+
+struct Line
+{
+  int64_t Order = 0;
+  int32_t Number = 0;
+  int32_t Quantity = 0;
+};
+
+using Orders = SQLiteTable<"Orders",
+  SQLiteKeyColumn<"Id", &Order::Id>,
+  SQLiteColumn<"Customer", &Order::Customer>,
+  SQLiteColumn<"Amount", &Order::Amount>,
+  SQLiteColumn<"Note", &Order::Note>>;
+
+using Lines = SQLiteTable<"Lines",
+  SQLiteKeyColumn<"Order", &Line::Order>,
+  SQLiteKeyColumn<"Number", &Line::Number>,
+  SQLiteColumn<"Quantity", &Line::Quantity>>;
+
+constexpr SQLiteField<Orders, "Id"> Id;
+constexpr SQLiteField<Orders, "Customer"> Customer;
+constexpr SQLiteField<Orders, "Amount"> Amount;
+constexpr SQLiteField<Orders, "Note"> Note;
+constexpr SQLiteField<Lines, "Order"> LineOrder;
+constexpr SQLiteField<Lines, "Quantity"> Quantity;
+
+constexpr auto Large = Select(Id, Amount).From<Orders>()
+  .Where(Amount > Parameter<> && Customer == Parameter<>)
+  .OrderBy(Descending(Amount))
+  .Limit(Parameter<>);
+
+constexpr auto Ordered = Select(Customer, Quantity * Literal<2>).From<Orders>()
+  .Join<Lines>(LineOrder == Id)
+  .Where(!(Quantity < Literal<-1>) || Note == Parameter<>)
+  .OrderBy(Customer, Ascending(Quantity));
+
+constexpr auto Scaled = Select(Amount * Parameter<double>).From<Orders>()
+  .Where(Id == Parameter<>);
+
+static_assert(Large.Sql == R"(Select "Orders"."Id", "Orders"."Amount" From "Orders" Where ( "Orders"."Amount" > ? ) And ( "Orders"."Customer" = ? ) Order By "Orders"."Amount" Desc Limit ?)");
+static_assert(std::is_same_v<decltype(Large)::Parameters, std::tuple<double, std::string, int64_t>>);
+static_assert(std::is_same_v<decltype(Large)::Row, std::tuple<int64_t, double>>);
+
+static_assert(Ordered.Sql == R"(Select "Orders"."Customer", ( "Lines"."Quantity" * 2 ) From "Orders" Inner Join "Lines" On "Lines"."Order" = "Orders"."Id" Where ( Not ( "Lines"."Quantity" < -1 ) ) Or ( "Orders"."Note" = ? ) Order By "Orders"."Customer", "Lines"."Quantity" Asc)");
+static_assert(std::is_same_v<decltype(Ordered)::Parameters, std::tuple<std::string>>);
+static_assert(std::is_same_v<decltype(Ordered)::Row, std::tuple<std::string, int32_t>>);
+
+static_assert(Scaled.Sql == R"(Select ( "Orders"."Amount" * ? ) From "Orders" Where "Orders"."Id" = ?)");
+static_assert(std::is_same_v<decltype(Scaled)::Parameters, std::tuple<double, int64_t>>);
+static_assert(Scaled.ParameterCount == 2);
+
+int32_t main()
+{
+  try
+  {
+    auto connection = SQLiteConnection::Memory();
+    TableAccessor<Orders> orders(connection);
+    TableAccessor<Lines> lines(connection);
+
+    orders.Insert({ 1, "Ada", 30, std::nullopt });
+    orders.Insert({ 2, "Ada", 5, "small" });
+    orders.Insert({ 3, "Ada", 50, std::nullopt });
+    orders.Insert({ 4, "Bob", 70, std::nullopt });
+    lines.Insert({ 1, 1, 2 });
+    lines.Insert({ 4, 1, 3 });
+
+    SQLiteStatement large(connection, Large.Sql.data());
+    std::string const ada = "Ada";
+    Large.Bind(large, 10, ada, 5);
+    std::vector<std::tuple<int64_t, double>> rows;
+
+    for (SQLiteRow const& row : large)
+    {
+      rows.push_back(Large.Read(row));
+    }
+
+    Check(rows == std::vector<std::tuple<int64_t, double>>{ { 3, 50.0 }, { 1, 30.0 } }, "where, order by and limit select the expected rows");
+
+    large.Reset();
+    Large.Bind(large, 0.0, std::string_view("Bob"), int32_t{ 1 });
+    large.Step();
+    Check(std::get<0>(Large.Read(large)) == 4, "converted arguments bind as their inferred types");
+    large.Reset();
+
+    SQLiteStatement ordered(connection, Ordered.Sql.data());
+    Ordered.Bind(ordered, "small");
+    std::vector<std::tuple<std::string, int32_t>> joined;
+
+    for (SQLiteRow const& row : ordered)
+    {
+      joined.push_back(Ordered.Read(row));
+    }
+
+    Check(joined == std::vector<std::tuple<std::string, int32_t>>{ { "Ada", 4 }, { "Bob", 6 } }, "join reads typed columns");
+
+    SQLiteStatement scaled(connection, Scaled.Sql.data());
+    Scaled.Bind(scaled, 0.5, 4);
+    scaled.Step();
+    Check(std::get<0>(Scaled.Read(scaled)) == 35.0, "placeholders in the select list bind before those in where");
+    scaled.Reset();
+
+    // The same query with its text built and prepared for every call.
+    int32_t constexpr Queries = 20'000;
+    int64_t runtime = 0;
+    int64_t compiled = 0;
+
+    double const concatenated = Milliseconds([&]
+      {
+        for (int32_t query = 0; query < Queries; ++query)
+        {
+          std::string const sql = std::string("Select \"Orders\".\"Id\" From \"Orders\" Where \"Orders\".\"Amount\" > ") + "?" + " And \"Orders\".\"Customer\" = " + "?";
+          SQLiteStatement statement(connection, sql.c_str());
+          statement.BindAll(static_cast<double>(query % 60), ada);
+
+          for (SQLiteRow const& row : statement)
+          {
+            runtime += row.GetInt64();
+          }
+        }
+      });
+
+    constexpr auto Filtered = Select(Id).From<Orders>().Where(Amount > Parameter<> && Customer == Parameter<>);
+    SQLiteStatement filtered(connection, Filtered.Sql.data());
+
+    double const prepared = Milliseconds([&]
+      {
+        for (int32_t query = 0; query < Queries; ++query)
+        {
+          Filtered.Bind(filtered, query % 60, ada);
+
+          for (SQLiteRow const& row : filtered)
+          {
+            compiled += std::get<0>(Filtered.Read(row));
+          }
+
+          filtered.Reset();
+        }
+      });
+
+    Check(runtime == compiled, "the compiled query returns what the concatenated one does");
+    printf("\n%d queries: %.1f ms built and prepared per call, %.1f ms compiled and prepared once\n", Queries, concatenated, prepared);
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
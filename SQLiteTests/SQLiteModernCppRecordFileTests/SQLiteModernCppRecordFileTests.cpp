@@ -0,0 +1,203 @@
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <random>
+
+#include <RecordFile.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "RecordFile.db";
+constexpr char const* TickFileName = "Ticks.dat";
+constexpr char const* TextFileName = "Quotes.txt";
+constexpr char const* KeyFileName = "Keys.txt";
+constexpr int32_t TickCount = 5'000'000;
+constexpr int32_t QuoteCount = 1'000'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+struct Tick
+{
+  int64_t Time;
+  double Price;
+  int32_t Volume;
+  char Symbol[8];
+};
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Writes ticks a few milliseconds apart, and fixed-width quote lines sorted by symbol.
+void Generate()
+{
+  std::mt19937 random(7);
+  char const* const symbols[] = { "AAPL", "AMZN", "GOOG", "IBM", "MSFT", "ORCL", "SAP", "TSLA" };
+
+  std::ofstream ticks(TickFileName, std::ios::binary);
+  int64_t time = 1'600'000'000'000;
+
+  for (int32_t index = 0; index < TickCount; ++index)
+  {
+    Tick tick{ };
+    tick.Time = time += random() % 10;
+    tick.Price = static_cast<double>(10'000 + random() % 90'000) / 100;
+    tick.Volume = static_cast<int32_t>(random() % 1'000);
+    std::memcpy(tick.Symbol, symbols[random() % 8], 4);
+    ticks.write(reinterpret_cast<char const*>(&tick), sizeof(tick));
+  }
+
+  std::ofstream quotes(TextFileName, std::ios::binary);
+
+  for (int32_t index = 0; index < QuoteCount; ++index)
+  {
+    char line[32];
+    snprintf(line, sizeof(line), "%-6s%10.2f%8d\n", symbols[index * 8LL / QuoteCount], static_cast<double>(random() % 100'000) / 100, static_cast<int32_t>(random() % 10'000));
+    quotes.write(line, 25);
+  }
+}
+
+void Query(SQLiteConnection const& connection, char const* const table, char const* const query)
+{
+  double total = 0;
+
+  double const elapsed = Milliseconds([&]
+    {
+      std::string text(query);
+      text.replace(text.find('@'), 1, table);
+
+      SQLiteStatement statement(connection, text.c_str());
+      statement.Step();
+      total = statement.GetDouble();
+    });
+
+  printf("%-8s %8.2f ms  %-100s (%.2f)\n", table, elapsed, query, total);
+}
+
+int64_t Count(SQLiteConnection const& connection, std::string const& query)
+{
+  SQLiteStatement statement(connection, query.c_str());
+  statement.Step();
+  return statement.GetInt64();
+}
+
+// Records whose Key is blank for the first six and then 6 to 9, and whose Name and Data are "k000" to "k009".
+// Each field is the sorted one of a table, and every range must find what a plain table finds.
+void CheckRanges(SQLiteConnection const& connection)
+{
+  {
+    std::ofstream keys(KeyFileName, std::ios::binary);
+
+    for (int32_t index = 0; index < 10; ++index)
+    {
+      char line[16];
+      snprintf(line, sizeof(line), "%4sk%03dk%03d", index < 6 ? "" : std::to_string(index).c_str(), index, index);
+      keys.write(line, 12);
+    }
+  }
+
+  for (char const* const sorted : { "Key", "Name", "Data" })
+  {
+    Execute(connection, (std::string("Create Virtual Table Sorted") + sorted + " Using recordfile ( '" + KeyFileName + "', sorted " + sorted + ", Key Digits 0 4, Name Text 4 4, Data Blob 8 4 )").c_str());
+  }
+
+  Execute(connection, "Create Table Plain As Select * From SortedKey");
+
+  char const* const conditions[] =
+  {
+    "Key >= 7", "Key <= 8", "Key < 7", "Key = 9", "Key > -1", "Key = Null", "Key Is Null", "Key >= '7'",
+    "Name >= 'k003'", "Name < 'k003'", "Name = 'k003'", "Name >= X'00'", "Name <= X'00'", "Name = X'6B303033'", "Name > 5", "Name < 5",
+    "Data >= X'6B303035'", "Data < X'6B303035'", "Data >= 'k005'", "Data <= 'k005'", "Data = 'k005'", "Data > 1", "Data < 1", "Data = Null",
+  };
+
+  bool same = true;
+
+  for (char const* const condition : conditions)
+  {
+    int64_t const expected = Count(connection, std::string("Select Count(*) From Plain Where ") + condition);
+
+    for (char const* const sorted : { "Key", "Name", "Data" })
+    {
+      if (int64_t const found = Count(connection, std::string("Select Count(*) From Sorted") + sorted + " Where " + condition); found != expected)
+      {
+        printf("sorted by %s, where %s: %lld rows instead of %lld\n", sorted, condition, static_cast<long long>(found), static_cast<long long>(expected));
+        same = false;
+      }
+    }
+  }
+
+  Check(same, "ranges of a sorted field find the rows of a plain table, for bounds of every storage class");
+  std::filesystem::remove(KeyFileName);
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+    Generate();
+
+    SQLiteConnection connection{ DatabaseName };
+    CreateRecordFileModule(connection);
+    CheckRanges(connection);
+
+    SQLiteRecordLayout layout = SQLiteRecordLayout::Of<Tick>(
+      SQLiteRecordMember{ "Time", &Tick::Time },
+      SQLiteRecordMember{ "Price", &Tick::Price },
+      SQLiteRecordMember{ "Volume", &Tick::Volume },
+      SQLiteRecordMember{ "Symbol", &Tick::Symbol });
+
+    layout.SortedBy = "Time";
+    CreateRecordFileTable(connection, "Mapped", TickFileName, std::move(layout));
+
+    // The alternative: copy the file into an indexed table before querying it.
+    printf("import:   %8.1f ms\n", Milliseconds([&]
+      {
+        SQLiteTransaction transaction(connection);
+        Execute(connection, "Create Table Imported ( Time Integer, Price Real, Volume Integer, Symbol Text )");
+        Execute(connection, "Insert Into Imported Select * From Mapped");
+        Execute(connection, "Create Index Imported_Time On Imported ( Time )");
+        transaction.Commit();
+      }));
+
+    Execute(connection, "Analyze");
+
+    int64_t const middle = 1'600'000'000'000 + TickCount * 9LL / 4;
+    std::string const range = "Select Total(Price * Volume) From @ Where Time Between " + std::to_string(middle) + " And " + std::to_string(middle + 60'000);
+
+    for (char const* const table : { "Imported", "Mapped" })
+    {
+      Query(connection, table, "Select Total(Price * Volume) From @");
+      Query(connection, table, "Select Total(Price) From @ Where Symbol = 'IBM'");
+      Query(connection, table, "Select Total(Price) From @ Where RowId Between 2000000 And 2010000");
+      Query(connection, table, range.c_str());
+    }
+
+    Execute(connection, (std::string("Create Virtual Table Quotes Using recordfile ( '") + TextFileName + "', record 25, sorted Symbol, Symbol Text 0 6, Bid Decimal 6 10, Size Digits 16 8 )").c_str());
+
+    Query(connection, "Quotes", "Select Total(Bid * Size) From @");
+    Query(connection, "Quotes", "Select Total(Bid * Size) From @ Where Symbol = 'MSFT'");
+    Query(connection, "Quotes", "Select Count(*) From @ Where Symbol >= 'GOOG' And Symbol < 'MSFT'");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  std::filesystem::remove(TickFileName);
+  std::filesystem::remove(TextFileName);
+  return Failures == 0 ? 0 : 1;
+}
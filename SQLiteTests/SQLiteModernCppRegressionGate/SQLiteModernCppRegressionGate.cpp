@@ -0,0 +1,323 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs a benchmark target several times and compares one of the metrics it writes with --json to
+// a baseline. A metric has regressed when its 95% confidence interval no longer overlaps the
+// baseline's and it has moved by more than the threshold, relative to the baseline, in the worse
+// direction. The diff table names every metric; the exit code is 1 if any regressed.
+//
+//   SQLiteModernCppRegressionGate --target path --baseline file [--metric overhead] [--higher-is-better]
+//     [--runs 5] [--threshold 0.1] [--args "..."] [--build Release] [--update]
+//
+// --update writes the measurements as the new baseline instead of comparing. Baselines of ratios,
+// such as the wrapper's overhead over the C API, carry between machines; absolute times do not,
+// and neither does anything between build types. --build names the target's build type, which
+// --update records; a target built otherwise than the baseline is not compared, and the gate
+// exits with Skipped.
+
+#ifdef _WIN32
+constexpr char const* Quiet = " > NUL";
+#else
+constexpr char const* Quiet = " > /dev/null";
+#endif
+
+constexpr int32_t Skipped = 77;
+
+struct Statistic
+{
+  double Mean = 0;
+  double Interval = 0;
+  int64_t Runs = 0;
+};
+
+struct GateOptions
+{
+  std::string Target;
+  std::string Baseline;
+  std::string Metric = "overhead";
+  std::string Arguments;
+  bool HigherIsBetter = false;
+  int32_t Runs = 5;
+  double Threshold = 0.1;
+  std::string Build;
+  bool Update = false;
+};
+
+// Two-sided 95% quantiles of Student's t distribution, by degrees of freedom.
+double Student(int64_t const freedom)
+{
+  static constexpr double Quantiles[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+  return freedom >= 1 && freedom <= 30 ? Quantiles[freedom - 1] : 1.960;
+}
+
+Statistic Summarize(std::vector<double> const& samples)
+{
+  Statistic statistic{ 0, 0, static_cast<int64_t>(samples.size()) };
+
+  for (double const sample : samples)
+  {
+    statistic.Mean += sample / static_cast<double>(samples.size());
+  }
+
+  if (samples.size() > 1)
+  {
+    double variance = 0;
+
+    for (double const sample : samples)
+    {
+      variance += (sample - statistic.Mean) * (sample - statistic.Mean) / static_cast<double>(samples.size() - 1);
+    }
+
+    statistic.Interval = Student(statistic.Runs - 1) * std::sqrt(variance / static_cast<double>(samples.size()));
+  }
+
+  return statistic;
+}
+
+// Reads the number after "key": in text, from position on.
+bool Number(std::string const& text, size_t const position, size_t const end, std::string const& key, double& value)
+{
+  size_t const found = text.find("\"" + key + "\"", position);
+
+  if (found == std::string::npos || found >= end)
+  {
+    return false;
+  }
+
+  size_t const colon = text.find(':', found);
+  value = std::strtod(text.c_str() + colon + 1, nullptr);
+  return true;
+}
+
+// Reads the string after "key": in the file, or nothing if it has none.
+std::string Text(std::string const& filename, std::string const& key)
+{
+  std::ifstream file(filename);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  std::string const text = stream.str();
+
+  size_t const found = text.find("\"" + key + "\"");
+
+  if (found == std::string::npos)
+  {
+    return { };
+  }
+
+  size_t const open = text.find('"', text.find(':', found) + 1);
+  size_t const close = text.find('"', open + 1);
+  return open == std::string::npos || close == std::string::npos ? std::string() : text.substr(open + 1, close - open - 1);
+}
+
+// The benchmarks write flat objects with a "name" and numbers; returns the given numbers by name.
+std::map<std::string, std::vector<double>> Read(std::string const& filename, std::vector<std::string> const& keys)
+{
+  std::ifstream file(filename);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  std::string const text = stream.str();
+  std::map<std::string, std::vector<double>> values;
+
+  for (size_t position = text.find("\"name\""); position != std::string::npos; position = text.find("\"name\"", position + 1))
+  {
+    size_t const open = text.find('"', text.find(':', position) + 1);
+    size_t const close = text.find('"', open + 1);
+    size_t const end = text.find('}', close);
+    std::vector<double>& numbers = values[text.substr(open + 1, close - open - 1)];
+
+    for (std::string const& key : keys)
+    {
+      double value = 0;
+
+      if (Number(text, close, end, key, value))
+      {
+        numbers.push_back(value);
+      }
+    }
+  }
+
+  return values;
+}
+
+void Write(std::string const& filename, GateOptions const& options, std::map<std::string, Statistic> const& statistics)
+{
+  std::ofstream file(filename);
+  file << "{\n  \"target\": \"" << std::filesystem::path(options.Target).filename().string() << "\",\n  \"build\": \"" << options.Build << "\",\n  \"metric\": \"" << options.Metric << "\",\n  \"benchmarks\": [\n";
+
+  for (size_t index = 0; auto const& [name, statistic] : statistics)
+  {
+    char line[256];
+    snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"mean\": %.6g, \"interval\": %.6g, \"runs\": %lld }%s\n",
+      name.c_str(), statistic.Mean, statistic.Interval, static_cast<long long>(statistic.Runs), ++index < statistics.size() ? "," : "");
+    file << line;
+  }
+
+  file << "  ]\n}\n";
+}
+
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  GateOptions options;
+
+  for (int32_t index = 1; index < argc; ++index)
+  {
+    std::string_view const name = argv[index];
+    char const* const value = index + 1 < argc ? argv[index + 1] : "";
+
+    if (name == "--update") options.Update = true;
+    else if (name == "--higher-is-better") options.HigherIsBetter = true;
+    else if (name == "--target") options.Target = value, ++index;
+    else if (name == "--baseline") options.Baseline = value, ++index;
+    else if (name == "--metric") options.Metric = value, ++index;
+    else if (name == "--args") options.Arguments = value, ++index;
+    else if (name == "--runs") options.Runs = std::max(2, std::atoi(value)), ++index;
+    else if (name == "--threshold") options.Threshold = std::atof(value), ++index;
+    else if (name == "--build") options.Build = value, ++index;
+    else
+    {
+      std::clog << "unknown option " << name << std::endl;
+      return 2;
+    }
+  }
+
+  if (options.Target.empty() || options.Baseline.empty())
+  {
+    std::clog << "--target and --baseline are required" << std::endl;
+    return 2;
+  }
+
+  if (!options.Update && !options.Build.empty())
+  {
+    if (std::string const build = Text(options.Baseline, "build"); build != options.Build)
+    {
+      printf("skipped: the baseline was measured on a %s build, the target is a %s build\n", build.empty() ? "unknown" : build.c_str(), options.Build.c_str());
+      return Skipped;
+    }
+  }
+
+  std::map<std::string, std::vector<double>> samples;
+  std::string const output = (std::filesystem::temp_directory_path() / "SQLiteModernCppRegressionGate.json").string();
+
+  for (int32_t run = 0; run < options.Runs; ++run)
+  {
+    std::filesystem::remove(output);
+    std::string const command = "\"" + options.Target + "\" " + options.Arguments + " --json \"" + output + "\"" + Quiet;
+
+    if (std::system(command.c_str()) != 0 || !std::filesystem::exists(output))
+    {
+      std::clog << "failed: " << command << std::endl;
+      return 2;
+    }
+
+    for (auto const& [name, values] : Read(output, { options.Metric }))
+    {
+      samples[name].insert(samples[name].end(), values.begin(), values.end());
+    }
+  }
+
+  std::map<std::string, Statistic> current;
+
+  for (auto const& [name, values] : samples)
+  {
+    if (!values.empty())
+    {
+      current[name] = Summarize(values);
+    }
+  }
+
+  if (options.Update)
+  {
+    Write(options.Baseline, options, current);
+    printf("wrote %zu metrics to %s\n", current.size(), options.Baseline.c_str());
+    return 0;
+  }
+
+  std::map<std::string, Statistic> baseline;
+
+  for (auto const& [name, values] : Read(options.Baseline, { "mean", "interval", "runs" }))
+  {
+    if (values.size() == 3)
+    {
+      baseline[name] = { values[0], values[1], static_cast<int64_t>(values[2]) };
+    }
+  }
+
+  if (baseline.empty())
+  {
+    std::clog << "no baseline in " << options.Baseline << std::endl;
+    return 2;
+  }
+
+  std::vector<std::string> regressed;
+  printf("\n%-20s %22s %22s %9s  %s\n", options.Metric.c_str(), "baseline", "current", "change", "status");
+
+  auto const format = [](Statistic const* const statistic)
+  {
+    char text[64] = "-";
+
+    if (statistic)
+    {
+      snprintf(text, sizeof(text), "%.4g +- %.2g", statistic->Mean, statistic->Interval);
+    }
+
+    return std::string(text);
+  };
+
+  std::map<std::string, bool> names;
+
+  for (auto const& [name, statistic] : baseline) names[name] = true;
+  for (auto const& [name, statistic] : current) names[name] = true;
+
+  for (auto const& [name, present] : names)
+  {
+    auto const before = baseline.find(name);
+    auto const after = current.find(name);
+    Statistic const* const old = before != baseline.end() ? &before->second : nullptr;
+    Statistic const* const now = after != current.end() ? &after->second : nullptr;
+    char const* status = !old ? "new" : !now ? "missing" : "ok";
+    double change = 0;
+
+    if (old && now && old->Mean != 0)
+    {
+      change = (now->Mean - old->Mean) / std::abs(old->Mean);
+      double const worse = options.HigherIsBetter ? -change : change;
+      bool const separated = std::abs(now->Mean - old->Mean) > now->Interval + old->Interval;
+
+      if (separated && worse > options.Threshold)
+      {
+        status = "REGRESSED";
+        regressed.push_back(name);
+      }
+      else if (separated && -worse > options.Threshold)
+      {
+        status = "improved";
+      }
+    }
+
+    printf("%-20s %22s %22s %+8.1f%%  %s\n", name.c_str(), format(old).c_str(), format(now).c_str(), change * 100, status);
+  }
+
+  if (!regressed.empty())
+  {
+    printf("\n%zu regressed:", regressed.size());
+
+    for (std::string const& name : regressed)
+    {
+      printf(" %s", name.c_str());
+    }
+
+    printf("\n");
+    return 1;
+  }
+
+  printf("\nno regressions beyond %.0f%% of the baseline\n", options.Threshold * 100);
+  return 0;
+}
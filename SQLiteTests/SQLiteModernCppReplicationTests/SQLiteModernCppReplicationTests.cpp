@@ -0,0 +1,247 @@
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include <Replication.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = steady_clock::now();
+  function();
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+std::string Digest(SQLiteConnection const& connection)
+{
+  SQLiteStatement digest(connection, "Select Count(*) || ':' || Total(Id * Value) || ':' || Total(Length(Name)) From Items");
+  digest.Step();
+  return digest.GetString();
+}
+
+std::string IntegrityCheck(SQLiteConnection const& connection)
+{
+  SQLiteStatement check(connection, "PRAGMA integrity_check");
+  check.Step();
+  return check.GetString();
+}
+
+void Write(SQLiteConnection const& connection, int32_t const first, int32_t const count)
+{
+  SQLiteTransaction transaction(connection, SQLiteTransactionType::Immediate);
+  SQLiteStatement insert(connection, "Insert Or Replace Into Items ( Id, Name, Value ) Values ( ?, ?, ? )");
+
+  for (int32_t id = first; id < first + count; ++id)
+  {
+    insert.BindAll(int64_t{ id }, "item " + std::to_string(id) + std::string(static_cast<size_t>(id % 200), 'x'), id * 0.5);
+    insert.Execute();
+    insert.Reset();
+  }
+
+  transaction.Commit();
+}
+
+// The bytes of a database file, without the header fields a replica keeps for itself.
+std::string Pages(std::filesystem::path const& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  for (size_t const offset : { 18, 19, 24, 25, 26, 27, 28, 29, 30, 31, 92, 93, 94, 95 })
+  {
+    if (offset < bytes.size())
+    {
+      bytes[offset] = 0;
+    }
+  }
+
+  return bytes;
+}
+
+// Applies commits to a replica, trying a reader of it after each part of a full copy.
+struct ProbingTransport
+{
+  SQLiteReplicaFile& Replica;
+  SQLiteConnection const& Reader;
+  int32_t Parts = 0;
+  int32_t Busy = 0;
+
+  void Send(SQLiteWalCommit const& commit)
+  {
+    Replica.Apply(commit);
+
+    if (!commit.Final)
+    {
+      ++Parts;
+
+      try
+      {
+        Digest(Reader);
+      }
+      catch (SQLiteException const& ex)
+      {
+        Busy += ex.ErrorCode == SQLITE_BUSY;
+      }
+    }
+  }
+};
+
+int32_t main()
+{
+  std::filesystem::path const directory = std::filesystem::temp_directory_path() / "SQLiteModernCppReplicationTests";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory / "primary");
+  std::filesystem::create_directories(directory / "replica");
+  std::string const primaryPath = (directory / "primary" / "Primary.db").string();
+
+  try
+  {
+    auto primary = OpenReplicated(primaryPath.c_str());
+    Execute(primary, "Create Table Items ( Id Integer Primary Key, Name Text, Value Real )");
+    Write(primary, 0, 5000);
+
+    // Applied directly, on the committing thread.
+    {
+      std::string const replicaPath = (directory / "replica" / "Direct.db").string();
+      SQLiteReplicaFile replica(replicaPath);
+      SQLiteWalReplicator replicator(primary, replica, { .CheckpointFrames = 50, .SeedPages = 16 });
+
+      SQLiteConnection reader;
+      reader.Open(replicaPath.c_str(), SQLITE_OPEN_READONLY);
+      Check(Digest(reader) == Digest(primary) && replicator.GetStatistics().Sequence > 1, "the seed copies the log and the file in several commits");
+
+      for (int32_t round = 0; round < 40; ++round)
+      {
+        Write(primary, round * 100, 150);
+      }
+
+      Execute(primary, "Delete From Items Where Id % 3 = 0");
+      Check(Digest(reader) == Digest(primary), "an open reader of the replica sees every commit");
+
+      WalReplicationStatistics const statistics = replicator.GetStatistics();
+      Check(statistics.Commits == 41 && statistics.Seeds == 1 && statistics.Errors == 0, "every commit is shipped once");
+
+      // The replicator's checkpoints let the log restart instead of growing.
+      Check(std::filesystem::file_size(primaryPath + "-wal") < statistics.Frames * (4096 + 24), "commits are shipped across checkpoints");
+
+      Execute(primary, "Delete From Items Where Id >= 1000");
+      Execute(primary, "Vacuum");
+      Check(Digest(reader) == Digest(primary) && IntegrityCheck(reader) == "ok", "a vacuum shrinks the replica");
+
+      SQLiteStatement checkpoint(primary, "PRAGMA wal_checkpoint(TRUNCATE)");
+      Check(checkpoint.Step() && checkpoint.GetInt64(0) == 0, "the log is truncated");
+      checkpoint.Reset();
+      Check(Pages(primaryPath) == Pages(replicaPath), "the replica has the pages of the primary");
+
+      Write(primary, 2000, 10);
+      Check(Digest(reader) == Digest(primary), "writes after the log was truncated are shipped");
+    }
+
+    // A reader of the replica cannot see a full copy half written over an older one.
+    {
+      std::string const replicaPath = (directory / "replica" / "Seeded.db").string();
+      SQLiteReplicaFile replica(replicaPath);
+
+      {
+        SQLiteWalReplicator first(primary, replica, { .SeedPages = 16 });
+      }
+
+      Write(primary, 0, 3000);
+
+      SQLiteConnection reader;
+      reader.Open(replicaPath.c_str(), SQLITE_OPEN_READONLY);
+      std::string const before = Digest(reader);
+
+      ProbingTransport transport{ replica, reader };
+      SQLiteWalReplicator second(primary, transport, { .SeedPages = 16 });
+
+      Check(transport.Parts > 1 && transport.Busy == transport.Parts && before != Digest(reader) && Digest(reader) == Digest(primary) && IntegrityCheck(reader) == "ok",
+        "a full copy is published only with its last part");
+    }
+
+    bool failed = false;
+
+    try
+    {
+      SQLiteConnection plain(primaryPath.c_str());
+      SQLiteReplicaFile replica((directory / "replica" / "Plain.db").string());
+      SQLiteWalReplicator replicator(plain, replica);
+    }
+    catch (SQLiteException const& ex)
+    {
+      failed = ex.ErrorCode == SQLITE_MISUSE;
+    }
+
+    Check(failed, "a connection opened without the shim is rejected");
+
+#ifdef __linux__
+    // Over a socket, applied by a thread of the replica, against a full copy for every commit.
+    {
+      std::string const replicaPath = (directory / "replica" / "Socket.db").string();
+      int32_t descriptors[2];
+      ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, descriptors);
+
+      SQLiteReplicaFile replica(replicaPath);
+      SQLiteReplicaReceiver receiver(descriptors[1], replica);
+      SQLiteReplicaSocket socket(descriptors[0]);
+
+      Write(primary, 0, 50'000);
+      SQLiteWalReplicator replicator(primary, socket);
+
+      int32_t const commits = 200;
+      double const shipped = Milliseconds([&]
+        {
+          for (int32_t commit = 0; commit < commits; ++commit)
+          {
+            Write(primary, commit * 10, 10);
+          }
+
+          receiver.Wait(replicator.GetStatistics().Sequence, seconds(10));
+        });
+
+      SQLiteConnection reader;
+      reader.Open(replicaPath.c_str(), SQLITE_OPEN_READONLY);
+      Check(Digest(reader) == Digest(primary) && IntegrityCheck(reader) == "ok", "the socket replica follows the primary");
+
+      SQLiteReplicaStatistics const statistics = replica.GetStatistics();
+      Check(statistics.Sequence == replicator.GetStatistics().Sequence && statistics.MaximumLag < seconds(10), "the replica reports its lag");
+
+      double const copied = Milliseconds([&]
+        {
+          SQLiteConnection copy((directory / "replica" / "Backup.db").string().c_str());
+          SQLiteBackup backup(copy, primary);
+          while (backup.Step());
+        });
+
+      SQLiteStatement pages(primary, "PRAGMA page_count");
+      pages.Step();
+
+      printf("\n%d commits of 10 rows to a %lld page database: %.1f ms shipped in total, %.1f ms on the primary, lag %lld us, at most %lld us\n",
+        commits, static_cast<long long>(pages.GetInt64()), shipped, duration<double, std::milli>(replicator.GetStatistics().Time).count(),
+        static_cast<long long>(statistics.Lag.count()), static_cast<long long>(statistics.MaximumLag.count()));
+      printf("one SQLiteBackup of the database: %.1f ms, %.1f s for as many commits\n", copied, copied * commits / 1000);
+    }
+#endif
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  std::filesystem::remove_all(directory);
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <SQLite.h>
+
+using namespace ModernCppSQLite;
+
+// Measures how point reads scale with reader threads while 0, 1 or 2 writer threads update the
+// same WAL database. Each point of the sweep runs for a fixed time and reports the read and write
+// throughput, the reads per reader thread, and the share of the threads' time spent waiting:
+//
+//   mutex  for the connection mutex, held by another thread of a shared connection
+//   busy   in the busy handler, for the write lock or a checkpoint of another connection
+//
+// Connections are either one SQLiteConnection shared by all threads, which is opened with
+// FULLMUTEX, or one per thread opened with FULLMUTEX (SQLiteConnection) or NOMUTEX
+// (SQLiteConfinedConnection). Every combination is run with each mmap_size and cache_size given.
+//
+//   SQLiteModernCppScaling [--readers 1,2,4] [--writers 0,1,2] [--modes shared,full,nomutex]
+//     [--mmap 0,268435456] [--cache 0,65536] [--seconds S] [--rows N] [--json file]
+
+constexpr char const* DatabaseName = "Scaling.db";
+
+struct ScalingOptions
+{
+  std::vector<int64_t> Readers;
+  std::vector<int64_t> Writers = { 0, 1, 2 };
+  std::vector<std::string> Modes = { "shared", "full", "nomutex" };
+  std::vector<int64_t> MemoryMapSizes = { 0, 256 * 1024 * 1024 };
+  std::vector<int64_t> CacheSizes = { 0 };
+  double Seconds = 1;
+  int64_t Rows = 100'000;
+  std::string Json;
+};
+
+struct ThreadResult
+{
+  int64_t Operations = 0;
+  int64_t MutexWait = 0;
+  int64_t BusyWait = 0;
+  int64_t Elapsed = 0;
+};
+
+struct Point
+{
+  int64_t Readers = 0;
+  int64_t Writers = 0;
+  std::string Mode;
+  int64_t MemoryMapSize = 0;
+  int64_t CacheSize = 0;
+  double Reads = 0;
+  double ReadsPerThread = 0;
+  double Writes = 0;
+  double ReadMutexWait = 0;
+  double ReadBusyWait = 0;
+  double WriteMutexWait = 0;
+  double WriteBusyWait = 0;
+};
+
+int64_t Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Retries for up to ten seconds, counting the time slept.
+int32_t OnBusy(void* const context, int32_t const count) noexcept
+{
+  if (count >= 100'000)
+  {
+    return 0;
+  }
+
+  int64_t const start = Now();
+  std::this_thread::sleep_for(std::chrono::microseconds(100));
+  static_cast<ThreadResult*>(context)->BusyWait += Now() - start;
+  return 1;
+}
+
+template <typename Connection>
+void Configure(Connection const& connection, ThreadResult& result, int64_t const memoryMapSize, int64_t const cacheSize)
+{
+  sqlite3_busy_handler(connection.GetAbi(), OnBusy, &result);
+  connection.SetMemoryMapSize(memoryMapSize);
+
+  if (cacheSize > 0)
+  {
+    Execute(connection, ("PRAGMA cache_size = -" + std::to_string(cacheSize)).c_str());
+  }
+}
+
+// Runs one thread's operations until stop is set. The connection mutex, which a NOMUTEX
+// connection does not have, is held around each operation so that the time waiting for it can be
+// measured; SQLite takes it again, recursively, in each call.
+template <SQLiteThreadingPolicy ThreadingPolicy>
+void Work(BasicSQLiteConnection<ThreadingPolicy> const& connection, bool const writer, int64_t const rows, int32_t const seed, std::atomic<bool> const& stop, ThreadResult& result)
+{
+  std::mt19937_64 random(static_cast<uint64_t>(seed));
+  sqlite3_mutex* const mutex = sqlite3_db_mutex(connection.GetAbi());
+  int64_t const start = Now();
+
+  auto const locked = [&](auto&& function)
+  {
+    if (!mutex)
+    {
+      function();
+      return;
+    }
+
+    if (sqlite3_mutex_try(mutex) != SQLITE_OK)
+    {
+      int64_t const wait = Now();
+      sqlite3_mutex_enter(mutex);
+      result.MutexWait += Now() - wait;
+    }
+
+    try
+    {
+      function();
+    }
+    catch (...)
+    {
+      sqlite3_mutex_leave(mutex);
+      throw;
+    }
+
+    sqlite3_mutex_leave(mutex);
+  };
+
+  BasicSQLiteStatement<ThreadingPolicy> statement;
+  locked([&] { statement.Prepare(connection, writer ? "Update Items Set Value = Value + 1 Where Id = ?" : "Select Value From Items Where Id = ?"); });
+
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    int64_t const id = 1 + static_cast<int64_t>(random() % static_cast<uint64_t>(rows));
+
+    locked([&]
+      {
+        statement.Bind(1, id);
+
+        while (statement.Step())
+        {
+        }
+
+        statement.Reset();
+      });
+
+    ++result.Operations;
+  }
+
+  result.Elapsed = Now() - start;
+}
+
+Point Measure(ScalingOptions const& options, int64_t const readers, int64_t const writers, std::string const& mode, int64_t const memoryMapSize, int64_t const cacheSize)
+{
+  std::vector<ThreadResult> results(static_cast<size_t>(readers + writers));
+  std::vector<std::thread> threads;
+  std::atomic<bool> stop{ false };
+  std::atomic<bool> failed{ false };
+  std::optional<SQLiteConnection> shared;
+
+  if (mode == "shared")
+  {
+    shared.emplace(DatabaseName);
+    Configure(*shared, results[0], memoryMapSize, cacheSize);
+  }
+
+  for (int64_t thread = 0; thread < readers + writers; ++thread)
+  {
+    threads.emplace_back([&, thread]
+      {
+        ThreadResult& result = results[static_cast<size_t>(thread)];
+        bool const writer = thread >= readers;
+
+        try
+        {
+          if (shared)
+          {
+            Work(*shared, writer, options.Rows, static_cast<int32_t>(thread), stop, result);
+          }
+          else if (mode == "full")
+          {
+            SQLiteConnection connection{ DatabaseName };
+            Configure(connection, result, memoryMapSize, cacheSize);
+            Work(connection, writer, options.Rows, static_cast<int32_t>(thread), stop, result);
+          }
+          else
+          {
+            SQLiteConfinedConnection connection{ DatabaseName };
+            Configure(connection, result, memoryMapSize, cacheSize);
+            Work(connection, writer, options.Rows, static_cast<int32_t>(thread), stop, result);
+          }
+        }
+        catch (SQLiteException const& ex)
+        {
+          std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+          std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+          failed = true;
+        }
+      });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.Seconds));
+  stop = true;
+
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (failed)
+  {
+    throw SQLiteException(SQLITE_ERROR, "a benchmark thread failed");
+  }
+
+  Point point{ readers, writers, mode, memoryMapSize, cacheSize };
+
+  auto const sum = [&](bool const writer, auto const member)
+  {
+    double total = 0;
+    double elapsed = 0;
+
+    for (int64_t thread = writer ? readers : 0; thread < (writer ? readers + writers : readers); ++thread)
+    {
+      total += static_cast<double>(results[static_cast<size_t>(thread)].*member);
+      elapsed += static_cast<double>(results[static_cast<size_t>(thread)].Elapsed);
+    }
+
+    return std::pair(total, elapsed);
+  };
+
+  // The busy handler of a shared connection counts its waits in the first thread's result.
+  auto const [reads, readTime] = sum(false, &ThreadResult::Operations);
+  auto const [writes, writeTime] = sum(true, &ThreadResult::Operations);
+  point.Reads = readTime > 0 ? reads / (readTime / 1e9 / static_cast<double>(readers)) : 0;
+  point.ReadsPerThread = readers > 0 ? point.Reads / static_cast<double>(readers) : 0;
+  point.Writes = writeTime > 0 ? writes / (writeTime / 1e9 / static_cast<double>(writers)) : 0;
+  point.ReadMutexWait = readTime > 0 ? sum(false, &ThreadResult::MutexWait).first / readTime : 0;
+  point.ReadBusyWait = readTime > 0 ? sum(false, &ThreadResult::BusyWait).first / readTime : 0;
+  point.WriteMutexWait = writeTime > 0 ? sum(true, &ThreadResult::MutexWait).first / writeTime : 0;
+  point.WriteBusyWait = writeTime > 0 ? sum(true, &ThreadResult::BusyWait).first / writeTime : 0;
+  return point;
+}
+
+template <typename T>
+std::vector<T> List(char const* const text)
+{
+  std::vector<T> values;
+  std::stringstream stream(text);
+
+  for (std::string item; std::getline(stream, item, ',');)
+  {
+    if constexpr (std::is_same_v<T, std::string>) values.push_back(item);
+    else values.push_back(std::atoll(item.c_str()));
+  }
+
+  return values;
+}
+
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  try
+  {
+    ScalingOptions options;
+
+    for (int64_t readers = 1; readers <= std::max<int64_t>(1, std::thread::hardware_concurrency()); readers *= 2)
+    {
+      options.Readers.push_back(readers);
+    }
+
+    for (int32_t index = 1; index + 1 < argc; index += 2)
+    {
+      std::string_view const name = argv[index];
+      char const* const value = argv[index + 1];
+
+      if (name == "--readers") options.Readers = List<int64_t>(value);
+      else if (name == "--writers") options.Writers = List<int64_t>(value);
+      else if (name == "--modes") options.Modes = List<std::string>(value);
+      else if (name == "--mmap") options.MemoryMapSizes = List<int64_t>(value);
+      else if (name == "--cache") options.CacheSizes = List<int64_t>(value);
+      else if (name == "--seconds") options.Seconds = std::atof(value);
+      else if (name == "--rows") options.Rows = std::max<int64_t>(1, std::atoll(value));
+      else if (name == "--json") options.Json = value;
+      else throw SQLiteException(SQLITE_MISUSE, "unknown option " + std::string(name));
+    }
+
+    for (char const* const suffix : { "", "-wal", "-shm" })
+    {
+      std::filesystem::remove(std::string(DatabaseName) + suffix);
+    }
+
+    {
+      SQLiteConnection connection{ DatabaseName };
+      connection.SetJournalMode("wal");
+      Execute(connection, "Create Table Items ( Id Integer Primary Key, Value Integer, Payload Blob )");
+      SQLiteTransaction transaction(connection);
+      SQLiteStatement insert(connection, "Insert Into Items Values ( ?, 0, RandomBlob(100) )");
+
+      for (int64_t id = 1; id <= options.Rows; ++id)
+      {
+        insert.Bind(1, id);
+        insert.Execute();
+        insert.Reset();
+      }
+
+      transaction.Commit();
+    }
+
+    std::vector<Point> points;
+    printf("%-8s %7s %7s %11s %9s %12s %12s %10s %7s %7s %7s %7s\n", "mode", "readers", "writers", "mmap", "cache", "reads/s", "per reader", "writes/s", "r mutex", "r busy", "w mutex", "w busy");
+
+    for (std::string const& mode : options.Modes)
+    {
+      if (mode != "shared" && mode != "full" && mode != "nomutex")
+      {
+        throw SQLiteException(SQLITE_MISUSE, "unknown mode " + mode);
+      }
+
+      for (int64_t const memoryMapSize : options.MemoryMapSizes)
+      {
+        for (int64_t const cacheSize : options.CacheSizes)
+        {
+          for (int64_t const writers : options.Writers)
+          {
+            for (int64_t const readers : options.Readers)
+            {
+              Point const& point = points.emplace_back(Measure(options, readers, writers, mode, memoryMapSize, cacheSize));
+              printf("%-8s %7lld %7lld %11lld %9lld %12.0f %12.0f %10.0f %6.1f%% %6.1f%% %6.1f%% %6.1f%%\n", mode.c_str(), static_cast<long long>(readers), static_cast<long long>(writers), static_cast<long long>(memoryMapSize), static_cast<long long>(cacheSize),
+                point.Reads, point.ReadsPerThread, point.Writes, point.ReadMutexWait * 100, point.ReadBusyWait * 100, point.WriteMutexWait * 100, point.WriteBusyWait * 100);
+            }
+          }
+        }
+      }
+    }
+
+    if (!options.Json.empty())
+    {
+      std::ofstream file(options.Json);
+      file << "{\n  \"rows\": " << options.Rows << ",\n  \"seconds\": " << options.Seconds << ",\n  \"points\": [\n";
+
+      for (size_t index = 0; Point const& point : points)
+      {
+        char line[512];
+        snprintf(line, sizeof(line), "    { \"mode\": \"%s\", \"readers\": %lld, \"writers\": %lld, \"mmap\": %lld, \"cache\": %lld, \"reads\": %.1f, \"reads_per_thread\": %.1f, \"writes\": %.1f, "
+          "\"read_mutex_wait\": %.4f, \"read_busy_wait\": %.4f, \"write_mutex_wait\": %.4f, \"write_busy_wait\": %.4f }%s\n",
+          point.Mode.c_str(), static_cast<long long>(point.Readers), static_cast<long long>(point.Writers), static_cast<long long>(point.MemoryMapSize), static_cast<long long>(point.CacheSize),
+          point.Reads, point.ReadsPerThread, point.Writes, point.ReadMutexWait, point.ReadBusyWait, point.WriteMutexWait, point.WriteBusyWait, ++index < points.size() ? "," : "");
+        file << line;
+      }
+
+      file << "  ]\n}\n";
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+}
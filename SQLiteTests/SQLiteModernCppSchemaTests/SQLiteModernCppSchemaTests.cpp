@@ -0,0 +1,117 @@
+#include <iostream>
+#include <chrono>
+
+#include <Schema.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+enum class Status : int32_t
+{
+  Open,
+  Shipped,
+};
+
+struct Order
+{
+  int64_t Id = 0;
+  std::string Customer;
+  double Amount = 0;
+  Status State = Status::Open;
+  sys_time<milliseconds> Placed;
+  std::optional<std::string> Note;
+  std::vector<std::byte> Signature;
+};
+
+using Orders = SQLiteTable<"Orders",
+  SQLiteKeyColumn<"Id", &Order::Id>,
+  SQLiteColumn<"Customer", &Order::Customer>,
+  SQLiteColumn<"Amount", &Order::Amount>,
+  SQLiteColumn<"State", &Order::State>,
+  SQLiteColumn<"Placed", &Order::Placed>,
+  SQLiteColumn<"Note", &Order::Note>,
+  SQLiteColumn<"Signature", &Order::Signature>>;
+
+struct Line
+{
+  int64_t Order = 0;
+  int32_t Number = 0;
+  long long Quantity = 0;
+};
+
+using Lines = SQLiteTable<"Order Lines",
+  SQLiteKeyColumn<"Order", &Line::Order>,
+  SQLiteKeyColumn<"Number", &Line::Number>,
+  SQLiteColumn<"Quantity", &Line::Quantity>>;
+
+static_assert(Orders::Create == R"(Create Table If Not Exists "Orders" ( "Id" Integer Not Null, "Customer" Text Not Null, "Amount" Float Not Null, "State" Integer Not Null, "Placed" Integer Not Null, "Note" Text, "Signature" Blob Not Null, Primary Key ( "Id" ) ))");
+static_assert(Orders::Insert == R"(Insert Into "Orders" ( "Id", "Customer", "Amount", "State", "Placed", "Note", "Signature" ) Values ( ?, ?, ?, ?, ?, ?, ? ))");
+static_assert(Orders::Select == R"(Select "Id", "Customer", "Amount", "State", "Placed", "Note", "Signature" From "Orders" Where "Id" = ?)");
+static_assert(Lines::Upsert == R"(Insert Into "Order Lines" ( "Order", "Number", "Quantity" ) Values ( ?, ?, ? ) On Conflict ( "Order", "Number" ) Do Update Set "Quantity" = excluded."Quantity")");
+static_assert(Lines::Delete == R"(Delete From "Order Lines" Where "Order" = ? And "Number" = ?)");
+static_assert(Lines::KeyCount == 2 && std::is_same_v<Lines::Key, std::tuple<int64_t, int32_t>>);
+
+int32_t main()
+{
+  try
+  {
+    auto connection = SQLiteConnection::Memory();
+    TableAccessor<Orders> orders(connection);
+    TableAccessor<Lines> lines(connection);
+
+    Order const order{ 7, "Ada", 12.5, Status::Shipped, sys_days(year(2024) / 3 / 1) + 90min, std::nullopt, { std::byte{ 1 }, std::byte{ 0 }, std::byte{ 2 } } };
+    orders.Insert(order);
+
+    std::optional<Order> found = orders.Find(7);
+    Check(found.has_value(), "an inserted record is found by its key");
+    Check(found && found->Customer == "Ada" && found->Amount == 12.5 && found->State == Status::Shipped, "text, real and enum members read back");
+    Check(found && found->Placed == order.Placed && !found->Note && found->Signature == order.Signature, "time point, null and blob members read back");
+    Check(!orders.Find(8), "a missing key finds nothing");
+
+    Order updated = order;
+    updated.Note = "fragile";
+    orders.Upsert(updated);
+    found = orders.Find(7);
+    Check(found && found->Note == "fragile", "upsert updates an existing record");
+
+    bool duplicate = false;
+
+    try
+    {
+      orders.Insert(order);
+    }
+    catch (SQLiteException const&)
+    {
+      duplicate = true;
+    }
+
+    Check(duplicate, "insert rejects a duplicate key");
+    Check(orders.Find(7).has_value(), "the accessor is usable after an error");
+
+    lines.Insert({ 7, 1, 3 });
+    lines.Upsert({ 7, 2, 5 });
+    lines.Upsert({ 7, 1, 4 });
+    Check(lines.Find({ 7, 1 })->Quantity == 4 && lines.Find({ 7, 2 })->Quantity == 5, "composite keys bind in order");
+    Check(lines.Delete({ 7, 2 }) && !lines.Delete({ 7, 2 }), "delete reports whether a record was removed");
+
+    SQLiteStatement count(connection, "Select Count(*), Sum(Quantity) From \"Order Lines\"");
+    count.Step();
+    Check(count.GetInt64(0) == 1 && count.GetInt64(1) == 4, "one line remains");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,345 @@
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+
+#include <QueryServer.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = steady_clock::now();
+  function();
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+#ifdef __linux__
+
+int32_t main()
+{
+  std::filesystem::path const directory = std::filesystem::temp_directory_path() / "SQLiteModernCppServerTests";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  std::string const database = (directory / "Server.db").string();
+  std::string const socket = (directory / "Server.sock").string();
+
+  try
+  {
+    {
+      SQLiteConnection connection(database.c_str());
+      connection.SetJournalMode("wal");
+      Execute(connection, "Create Table Items ( Id Integer Primary Key, Name Text, Price Real, Data Blob )");
+    }
+
+    QueryServer server(database.c_str(), socket);
+    QueryClient client(socket);
+
+    uint32_t const insert = client.Prepare("Insert Into Items ( Name, Price, Data ) Values ( ?, ?, ? )");
+    std::vector<QueryValue> const item{ std::string("first"), 1.5, std::vector<std::byte>{ std::byte{ 7 }, std::byte{ 0 } } };
+    Check(client.Execute(insert, item).Changes == 1, "an insert reports its changes");
+
+    uint32_t const select = client.Prepare("Select Id, Name, Price, Data, Null As Missing From Items Where Id = ?");
+    QueryResult const one = client.Execute(select, std::vector<QueryValue>{ int64_t{ 1 } });
+    Check(one.Columns == std::vector<std::string>{ "Id", "Name", "Price", "Data", "Missing" } && one.RowCount() == 1, "a select returns its columns and row");
+    Check(one.At(0, 1) == item[0] && one.At(0, 2) == item[1] && one.At(0, 3) == item[2] && std::holds_alternative<std::nullptr_t>(one.At(0, 4)), "values keep their types");
+    Check(one.Changes == 0, "a select after an insert reports no changes");
+
+    // Pipelined: every insert is sent before the first result is read.
+    {
+      client.Execute(client.Prepare("Begin"));
+      std::vector<QueryValue> values{ std::string(), 0.0, nullptr };
+
+      for (int32_t index = 0; index < 1000; ++index)
+      {
+        values[0] = "item " + std::to_string(index);
+        values[1] = static_cast<double>(index);
+        client.Send(insert, values);
+      }
+
+      int64_t changes = 0;
+
+      for (int32_t index = 0; index < 1000; ++index)
+      {
+        changes += client.Receive().Changes;
+      }
+
+      client.Execute(client.Prepare("Commit"));
+      Check(changes == 1000, "pipelined requests are answered in order");
+    }
+
+    // Pipelined requests and responses that are each larger than the socket buffers.
+    {
+      uint32_t const echo = client.Prepare("Select ?1, Length(?1) From Items Where Id <= 4");
+      std::vector<QueryValue> const large{ std::string(64 * 1024, 'x') };
+
+      for (int32_t index = 0; index < 200; ++index)
+      {
+        client.Send(echo, large);
+      }
+
+      bool same = true;
+
+      for (int32_t index = 0; index < 200; ++index)
+      {
+        QueryResult const result = client.Receive();
+        same = same && result.RowCount() == 4 && result.At(3, 0) == large[0];
+      }
+
+      Check(same, "large pipelined requests do not block on each other");
+    }
+
+    // A transaction stays on the connection of the client that began it, while others use the rest of the pool.
+    {
+      client.Execute(client.Prepare("Create Table Ledger ( Id Integer Primary Key, Owner Text )"));
+
+      SQLiteConnection outside;
+      outside.Open(database.c_str(), SQLITE_OPEN_READONLY);
+      SQLiteStatement count(outside, "Select Count(*) From Ledger Where Owner = ?");
+
+      auto const rows = [&](char const* const owner)
+        {
+          count.BindAll(owner);
+          count.Step();
+          int64_t const result = count.GetInt64();
+          count.Reset();
+          return result;
+        };
+
+      QueryClient other(socket);
+      uint32_t const mine = client.Prepare("Insert Into Ledger ( Owner ) Values ( 'A' )");
+      uint32_t const theirs = other.Prepare("Insert Into Ledger ( Owner ) Values ( 'B' )");
+
+      client.Execute(client.Prepare("Begin"));
+      Check(other.Execute(theirs).Changes == 1 && rows("B") == 1, "a write of another client outside the transaction is committed");
+
+      client.Execute(mine);
+      Check(rows("A") == 0, "a write inside the transaction is not visible outside it");
+
+      client.Execute(client.Prepare("Rollback"));
+      Check(rows("A") == 0 && other.Execute(theirs).Changes == 1 && rows("B") == 2, "the transaction rolls back on the connection that began it");
+
+      {
+        QueryClient leaving(socket);
+        leaving.Execute(leaving.Prepare("Begin Immediate"));
+        leaving.Execute(leaving.Prepare("Insert Into Ledger ( Owner ) Values ( 'C' )"));
+      }
+
+      // Waits on the write lock until the server notices the client left.
+      Check(other.Execute(theirs).Changes == 1 && rows("C") == 0 && rows("B") == 3, "the transaction of a client that went away is rolled back");
+    }
+
+    bool failed = false;
+
+    try
+    {
+      client.Prepare("Select Name From Nowhere");
+    }
+    catch (SQLiteException const& ex)
+    {
+      failed = ex.ErrorCode == SQLITE_ERROR && std::string_view(ex.ErrorMessage).find("Nowhere") != std::string_view::npos;
+    }
+
+    Check(failed, "a prepare error reaches the client");
+    Check(client.Execute(select, std::vector<QueryValue>{ int64_t{ 1 } }).RowCount() == 1, "the client is usable after an error");
+
+    // Several clients at once, each from its own thread.
+    {
+      std::vector<std::thread> threads;
+      std::atomic<int64_t> rows = 0;
+
+      for (int32_t thread = 0; thread < 8; ++thread)
+      {
+        threads.emplace_back([&]
+          {
+            QueryClient local(socket);
+            uint32_t const count = local.Prepare("Select Count(*) From Items Where Price >= ?");
+
+            for (int32_t query = 0; query < 100; ++query)
+            {
+              rows += std::get<int64_t>(local.Execute(count, std::vector<QueryValue>{ 500.0 }).At(0, 0));
+            }
+          });
+      }
+
+      for (std::thread& thread : threads)
+      {
+        thread.join();
+      }
+
+      Check(rows == 8 * 100 * 500, "concurrent clients share the pool");
+    }
+
+    // A large result, through frames only and then mostly through shared memory.
+    {
+      client.Execute(client.Prepare("Insert Into Items ( Name, Price ) With Numbers ( Value ) As ( Select 1 Union All Select Value + 1 From Numbers Where Value < 200000 ) Select printf('bulk %08d', Value), Value From Numbers"));
+      uint32_t const all = client.Prepare("Select Id, Name, Price From Items");
+      QueryResult shared;
+      double const sharedTime = Milliseconds([&] { shared = client.Execute(all); });
+
+      QueryServerOptions options;
+      options.SharedBytes = 0;
+      QueryServer framed(database.c_str(), (directory / "Framed.sock").string(), options);
+      QueryClient framedClient((directory / "Framed.sock").string());
+      uint32_t const framedAll = framedClient.Prepare("Select Id, Name, Price From Items");
+      QueryResult frames;
+      double const framesTime = Milliseconds([&] { frames = framedClient.Execute(framedAll); });
+
+      Check(shared.Shared && !frames.Shared, "a large result goes through shared memory unless disabled");
+      Check(shared.RowCount() == 201001 && shared.Values == frames.Values, "shared and framed results agree");
+
+      printf("\n%zu rows: %.1f ms in frames, %.1f ms through shared memory\n", shared.RowCount(), framesTime, sharedTime);
+    }
+
+    // Only this user can reach the socket, and nobody can reach other files through it.
+    {
+      Check(std::filesystem::status(socket).permissions() == (std::filesystem::perms::owner_read | std::filesystem::perms::owner_write), "the socket is private to its user");
+
+      int32_t denied = 0;
+
+      for (char const* const sql : { "Attach Database ':memory:' As Other", "PRAGMA journal_mode = DELETE", "PRAGMA writable_schema = 1" })
+      {
+        try
+        {
+          client.Prepare(sql);
+        }
+        catch (SQLiteException const& ex)
+        {
+          denied += ex.ErrorCode == SQLITE_AUTH;
+        }
+      }
+
+      Check(denied == 3 && client.Execute(client.Prepare("PRAGMA table_info(Items)")).RowCount() == 4, "attach and pragma assignments are denied, pragma queries are not");
+
+      QueryServerOptions options;
+      options.AllowedUser = ::geteuid() + 1;
+      QueryServer other(database.c_str(), (directory / "Other.sock").string(), options);
+      failed = false;
+
+      try
+      {
+        QueryClient stranger((directory / "Other.sock").string());
+        stranger.Prepare("Select 1");
+      }
+      catch (SQLiteException const& ex)
+      {
+        // The refusal, or the closed socket if the server hung up first.
+        failed = ex.ErrorCode == SQLITE_AUTH || ex.ErrorCode == SQLITE_IOERR;
+      }
+
+      Check(failed, "a client running as another user is refused");
+    }
+
+    // A lease keeps the statements it was given when the cache fills.
+    {
+      SQLiteConnectionPool pool(database.c_str(), { .Size = 1, .StatementCacheSize = 2 });
+      bool valid = true;
+
+      {
+        auto lease = pool.Acquire();
+        std::vector<SQLiteStatement*> statements;
+
+        for (int32_t value = 0; value < 3; ++value)
+        {
+          statements.push_back(&lease.Prepare("Select " + std::to_string(value)));
+        }
+
+        for (int32_t value = 0; value < 3; ++value)
+        {
+          valid = valid && statements[value]->Step() && statements[value]->GetInt32() == value;
+          statements[value]->Reset();
+        }
+      }
+
+      auto lease = pool.Acquire();
+      SQLiteStatement& first = lease.Prepare("Select 3");
+      SQLiteStatement& second = lease.Prepare("Select 2");
+      valid = valid && first.Step() && first.GetInt32() == 3 && second.Step() && second.GetInt32() == 2;
+
+      Check(valid, "statements handed to a lease are not evicted from a full cache");
+    }
+
+    // Out of descriptors, the server waits for some instead of no longer accepting.
+    {
+      rlimit const original = [] { rlimit limit{ }; ::getrlimit(RLIMIT_NOFILE, &limit); return limit; }();
+      rlimit lowered = original;
+      lowered.rlim_cur = std::min<rlim_t>(original.rlim_cur, 512);
+      ::setrlimit(RLIMIT_NOFILE, &lowered);
+
+      // Leave one descriptor, for the client's socket.
+      std::vector<int32_t> descriptors;
+
+      for (int32_t descriptor; (descriptor = ::dup(0)) >= 0;)
+      {
+        descriptors.push_back(descriptor);
+      }
+
+      ::close(descriptors.back());
+      descriptors.pop_back();
+
+      QueryClient waiting(socket);
+
+      std::thread release([&]
+        {
+          std::this_thread::sleep_for(milliseconds(200));
+
+          for (int32_t const descriptor : descriptors)
+          {
+            ::close(descriptor);
+          }
+        });
+
+      bool const served = waiting.Execute(waiting.Prepare("Select 1")).RowCount() == 1;
+      release.join();
+      ::setrlimit(RLIMIT_NOFILE, &original);
+
+      Check(served, "a client that connects while descriptors are exhausted is served later");
+    }
+
+    client.Finalize(select);
+    failed = false;
+
+    try
+    {
+      client.Execute(select);
+    }
+    catch (SQLiteException const& ex)
+    {
+      failed = ex.ErrorCode == SQLITE_MISUSE;
+    }
+
+    Check(failed, "a finalized handle is rejected");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  std::filesystem::remove_all(directory);
+  return Failures == 0 ? 0 : 1;
+}
+
+#else
+
+int32_t main()
+{
+  printf("the query server needs Linux\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+
+#include <StatisticsMaintainer.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "StatisticsMaintainer.db";
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Orders start out spread over many customers and few days; the ingest then brings a flood of
+// orders from one wholesale customer spread over many days, which the old statistics cannot know.
+void Insert(SQLiteConnection const& connection, int32_t const count, bool const flood, StatisticsMaintainer<>* const maintainer)
+{
+  std::mt19937 random(flood ? 11 : 7);
+  SQLiteStatement insert(connection, "Insert Into Orders ( Customer, Day, Amount ) Values ( ?, ?, ? )");
+
+  for (int32_t batch = 0; batch < count; batch += 5'000)
+  {
+    SQLiteTransaction transaction(connection);
+
+    for (int32_t row = batch; row < std::min(count, batch + 5'000); ++row)
+    {
+      insert.BindAll(flood ? 42 : static_cast<int32_t>(random() % 10'000), flood ? static_cast<int32_t>(random() % 100'000) : static_cast<int32_t>(random() % 10), 1.0);
+      insert.Execute();
+      insert.Reset();
+    }
+
+    transaction.Commit();
+
+    if (maintainer)
+    {
+      maintainer->Poll();
+    }
+  }
+}
+
+void Query(SQLiteStatement& query, char const* const label)
+{
+  double total = 0;
+
+  double const elapsed = Milliseconds([&]
+    {
+      for (int32_t day = 0; day < 20; ++day)
+      {
+        query.BindAll(42, 50'000 + day);
+        query.Step();
+        total += query.GetDouble();
+        query.Reset();
+      }
+    });
+
+  printf("%-32s %8.2f ms  (%.0f)\n", label, elapsed, total);
+}
+
+// The index the query is planned to search Orders with.
+std::string Plan(SQLiteConnection const& connection)
+{
+  SQLiteStatement plan(connection, "Explain Query Plan Select Total(Amount) From Orders Where Customer = ? And Day = ?");
+  std::string detail;
+
+  while (plan.Step())
+  {
+    detail += plan.GetString(3);
+  }
+
+  return detail.find("Orders_Day") != std::string::npos ? "Orders_Day" : detail.find("Orders_Customer") != std::string::npos ? "Orders_Customer" : detail;
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+    std::filesystem::remove(std::string(DatabaseName) + "-wal");
+    std::filesystem::remove(std::string(DatabaseName) + "-shm");
+
+    SQLiteConnection connection{ DatabaseName };
+    connection.SetJournalMode("wal");
+
+    // Each background ANALYZE holds the write lock for a moment.
+    connection.SetBusyTimeout(std::chrono::seconds(5));
+    Execute(connection, "Create Table Orders ( Id Integer Primary Key, Customer Integer, Day Integer, Amount Real )");
+    Execute(connection, "Create Index Orders_Customer On Orders ( Customer )");
+    Execute(connection, "Create Index Orders_Day On Orders ( Day )");
+
+    Insert(connection, 20'000, false, nullptr);
+    Execute(connection, "Analyze");
+
+    SQLiteStatement query(connection, "Select Total(Amount) From Orders Where Customer = ? And Day = ?");
+
+    for (bool const maintained : { false, true })
+    {
+      std::optional<StatisticsMaintainer<>> maintainer;
+
+      if (maintained)
+      {
+        maintainer.emplace(connection, StatisticsMaintainerOptions{ .MinimumChanges = 5'000 });
+      }
+
+      double const ingest = Milliseconds([&] { Insert(connection, 100'000, true, maintainer ? &*maintainer : nullptr); });
+
+      if (maintainer)
+      {
+        // Gives the last ANALYZE time to finish and its statistics a poll to be loaded.
+        for (int32_t wait = 0; wait < 100 && (maintainer->GetAnalysisCount() == 0 || Plan(connection) != "Orders_Day"); ++wait)
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(50));
+          maintainer->Poll();
+        }
+
+        printf("ingest %8.1f ms with %lld ANALYZE runs in the background\n", ingest, static_cast<long long>(maintainer->GetAnalysisCount()));
+        Query(query, "after ingest, maintained:");
+        Check(maintainer->GetAnalysisCount() > 0, "the ingest is analyzed in the background");
+        Check(Plan(connection) == "Orders_Day", "the maintained statistics plan the query on the selective index");
+      }
+      else
+      {
+        printf("ingest %8.1f ms\n", ingest);
+        Query(query, "after ingest, stale statistics:");
+        Check(Plan(connection) == "Orders_Customer", "the stale statistics plan the query on the index that was selective");
+        Execute(connection, "Delete From Orders Where Customer = 42");
+      }
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
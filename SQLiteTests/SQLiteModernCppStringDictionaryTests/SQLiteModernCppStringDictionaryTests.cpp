@@ -0,0 +1,134 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <SQLite.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "StringDictionary.db";
+constexpr int32_t RowCount = 2'000'000;
+constexpr int32_t CityCount = 300;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(DatabaseName);
+
+    SQLiteConnection connection{ DatabaseName };
+    Execute(connection, "Create Table Visits ( Id Integer Primary Key, City Text, Country Text )");
+
+    {
+      std::mt19937 random(7);
+      SQLiteTransaction transaction(connection);
+      SQLiteStatement insert(connection, "Insert Into Visits ( City, Country ) Values ( ?, ? )");
+
+      for (int32_t row = 0; row < RowCount; ++row)
+      {
+        uint32_t const city = random() % CityCount;
+        insert.BindAll("City of somewhere number " + std::to_string(city), "Country " + std::to_string(city % 20));
+        insert.Execute();
+        insert.Reset();
+      }
+
+      transaction.Commit();
+    }
+
+    SQLiteStatement select(connection, "Select City, Country From Visits");
+
+    // Each row copied into its own strings.
+    std::vector<std::string> cities;
+    std::vector<std::string> countries;
+
+    double const copied = Milliseconds([&]
+      {
+        for (SQLiteRow const& row : select)
+        {
+          cities.emplace_back(row.GetString(0), row.GetStringLength(0));
+          countries.emplace_back(row.GetString(1), row.GetStringLength(1));
+        }
+      });
+
+    select.Reset();
+
+    // Each row reduced to a pair of codes into per-column dictionaries.
+    SQLiteStringDictionary cityNames;
+    SQLiteStringDictionary countryNames;
+    std::vector<uint32_t> cityCodes;
+    std::vector<uint32_t> countryCodes;
+
+    double const interned = Milliseconds([&]
+      {
+        for (SQLiteRow const& row : select)
+        {
+          cityCodes.push_back(row.GetStringCode(cityNames, 0));
+          countryCodes.push_back(row.GetStringCode(countryNames, 1));
+        }
+      });
+
+    // Comparing a column against a value: string compares against one code compare.
+    std::string const wanted = "City of somewhere number 42";
+    size_t copiedMatches = 0;
+    size_t internedMatches = 0;
+
+    double const copiedCompare = Milliseconds([&] { copiedMatches = std::count(cities.begin(), cities.end(), wanted); });
+
+    double const internedCompare = Milliseconds([&]
+      {
+        uint32_t const code = cityNames.Intern(wanted);
+        internedMatches = std::count(cityCodes.begin(), cityCodes.end(), code);
+      });
+
+    size_t copiedBytes = 0;
+
+    for (size_t row = 0; row < cities.size(); ++row)
+    {
+      copiedBytes += sizeof(std::string) * 2 + (cities[row].capacity() > 15 ? cities[row].capacity() + 1 : 0) + (countries[row].capacity() > 15 ? countries[row].capacity() + 1 : 0);
+    }
+
+    size_t const internedBytes = (cityCodes.size() + countryCodes.size()) * sizeof(uint32_t);
+
+    printf("fetch   std::string %8.1f ms  interned %8.1f ms\n", copied, interned);
+    printf("compare std::string %8.1f ms  interned %8.1f ms  (%zu, %zu matches)\n", copiedCompare, internedCompare, copiedMatches, internedMatches);
+    printf("rows    std::string %8.1f MB  interned %8.1f MB  (%zu + %zu distinct values)\n", copiedBytes / 1e6, internedBytes / 1e6, cityNames.Size(), countryNames.Size());
+
+    bool same = cityCodes.size() == RowCount && countryCodes.size() == RowCount && cities.size() == RowCount;
+
+    for (size_t row = 0; same && row < cities.size(); ++row)
+    {
+      same = cityNames[cityCodes[row]] == cities[row] && countryNames[countryCodes[row]] == countries[row];
+    }
+
+    Check(same, "every code reads back the string of its row");
+    Check(cityNames.Size() == CityCount && countryNames.Size() == 20, "each distinct string gets one code");
+    Check(copiedMatches > 0 && internedMatches == copiedMatches, "comparing codes finds the rows comparing strings does");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
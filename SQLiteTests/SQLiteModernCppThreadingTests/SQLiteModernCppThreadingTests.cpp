@@ -0,0 +1,90 @@
+#include <iostream>
+#include <chrono>
+
+#include <SQLite.h>
+
+using namespace ModernCppSQLite;
+
+constexpr int32_t RowCount = 200'000;
+
+template <typename F>
+double NanosecondsPerOperation(int32_t const operations, F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / operations;
+}
+
+template <typename ThreadingPolicy>
+void Run(char const* const name)
+{
+  auto connection = BasicSQLiteConnection<ThreadingPolicy>::Memory();
+
+  Execute(connection, "Create Table Things ( Id Integer Primary Key, Content Integer )");
+
+  double const inserts = NanosecondsPerOperation(RowCount, [&]
+    {
+      Execute(connection, "Begin");
+
+      BasicSQLiteStatement<ThreadingPolicy> statement(connection, "Insert Into Things Values (?, ?)");
+
+      for (int32_t value = 1; value <= RowCount; ++value)
+      {
+        statement.Bind(1, value);
+        statement.Bind(2, value * 2);
+        statement.Execute();
+        statement.Reset();
+      }
+
+      Execute(connection, "Commit");
+    });
+
+  sqlite3_int64 sum = 0;
+
+  double const lookups = NanosecondsPerOperation(RowCount, [&]
+    {
+      BasicSQLiteStatement<ThreadingPolicy> statement(connection, "Select Content From Things Where Id = ?");
+
+      for (int32_t value = 1; value <= RowCount; ++value)
+      {
+        statement.Bind(1, value);
+
+        if (statement.Step())
+        {
+          sum += statement.GetInt64();
+        }
+
+        statement.Reset();
+      }
+    });
+
+  printf("%-16s insert: %8.1f ns/row  lookup: %8.1f ns/row  (%lld)\n", name, inserts, lookups, static_cast<long long>(sum));
+}
+
+int32_t main()
+{
+  try
+  {
+    // 1 = serialized, 2 = multi-thread (the SQLiteAmalgamation project), 0 = single-thread.
+    printf("sqlite3_threadsafe(): %d, SQLite %s\n", sqlite3_threadsafe(), sqlite3_libversion());
+
+#ifdef SQLITE_MODERN_CPP_THREADSAFE
+    if (sqlite3_threadsafe() != SQLITE_MODERN_CPP_THREADSAFE)
+    {
+      std::clog << "expected a library built with SQLITE_THREADSAFE=" << SQLITE_MODERN_CPP_THREADSAFE << std::endl;
+      return 1;
+    }
+#endif
+
+    Run<SQLiteShared>("shared");
+    Run<SQLiteThreadConfined>("thread-confined");
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <TimeSeries.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* RowsDatabaseName = "TimeSeriesRows.db";
+constexpr char const* ChunksDatabaseName = "TimeSeriesChunks.db";
+constexpr char const* RetryDatabaseName = "TimeSeriesRetry.db";
+constexpr int32_t SeriesCount = 50;
+constexpr int32_t SampleCount = 20'000;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string SeriesName(int32_t const series)
+{
+  return "host" + std::to_string(series) + ".cpu";
+}
+
+// A sample every 10 seconds with occasional jitter, values as a random walk with two decimals.
+template <typename F>
+void Generate(F&& append)
+{
+  std::mt19937_64 random(42);
+
+  for (int32_t series = 0; series < SeriesCount; ++series)
+  {
+    std::string const name = SeriesName(series);
+    int64_t time = 1'600'000'000'000;
+    double value = 50;
+
+    for (int32_t sample = 0; sample < SampleCount; ++sample)
+    {
+      time += 10'000 + (random() % 16 == 0 ? static_cast<int64_t>(random() % 50) : 0);
+      value = std::round((value + (static_cast<double>(random() % 201) - 100) / 100) * 100) / 100;
+      append(name, time, value);
+    }
+  }
+}
+
+int32_t main()
+{
+  try
+  {
+    std::filesystem::remove(RowsDatabaseName);
+    std::filesystem::remove(ChunksDatabaseName);
+
+    SQLiteConnection rows{ RowsDatabaseName };
+    SQLiteConnection chunks{ ChunksDatabaseName };
+
+    Execute(rows, "Create Table Samples ( Series Text, Time Integer, Value Real, Primary Key ( Series, Time ) ) Without RowId");
+
+    double const rowsIngest = Milliseconds([&]
+      {
+        SQLiteTransaction transaction(rows);
+        SQLiteStatement insert(rows, "Insert Or Replace Into Samples Values ( ?, ?, ? )");
+
+        Generate([&](std::string const& series, int64_t const time, double const value)
+          {
+            insert.Bind(1, series.c_str());
+            insert.Bind(2, time);
+            insert.Bind(3, value);
+            insert.Execute();
+            insert.Reset();
+          });
+
+        transaction.Commit();
+      });
+
+    TimeSeriesStore store(chunks);
+
+    double const chunksIngest = Milliseconds([&]
+      {
+        SQLiteTransaction transaction(chunks);
+
+        Generate([&](std::string const& series, int64_t const time, double const value)
+          {
+            store.Append(series, time, value);
+          });
+
+        store.Flush();
+        transaction.Commit();
+      });
+
+    Execute(rows, "Vacuum");
+    Execute(chunks, "Vacuum");
+
+    printf("%-8s ingest: %8.1f ms  size: %8.2f MB\n", "rows", rowsIngest, std::filesystem::file_size(RowsDatabaseName) / 1048576.0);
+    printf("%-8s ingest: %8.1f ms  size: %8.2f MB\n", "chunks", chunksIngest, std::filesystem::file_size(ChunksDatabaseName) / 1048576.0);
+
+    // Aggregates over the middle half of every series.
+    int64_t const first = 1'600'000'000'000 + SampleCount / 4 * 10'000;
+    int64_t const last = first + SampleCount / 2 * 10'000;
+    double sum[3] = { };
+
+    double const rowsScan = Milliseconds([&]
+      {
+        SQLiteStatement select(rows, "Select Sum(Value) From Samples Where Series = ? And Time Between ? And ?");
+
+        for (int32_t series = 0; series < SeriesCount; ++series)
+        {
+          select.BindAll(SeriesName(series), first, last);
+          select.Step();
+          sum[0] += select.GetDouble();
+          select.Reset();
+        }
+      });
+
+    double const storeScan = Milliseconds([&]
+      {
+        for (int32_t series = 0; series < SeriesCount; ++series)
+        {
+          sum[1] += store.Summarize(SeriesName(series), first, last).Sum;
+        }
+      });
+
+    store.CreateModule("series");
+
+    double const tableScan = Milliseconds([&]
+      {
+        SQLiteStatement select(chunks, "Select Sum(Value) From series(?) Where Time Between ? And ?");
+
+        for (int32_t series = 0; series < SeriesCount; ++series)
+        {
+          select.BindAll(SeriesName(series), first, last);
+          select.Step();
+          sum[2] += select.GetDouble();
+          select.Reset();
+        }
+      });
+
+    printf("%-20s scan: %8.1f ms  (%.2f)\n", "rows (SQL)", rowsScan, sum[0]);
+    printf("%-20s scan: %8.1f ms  (%.2f)\n", "chunks (Summarize)", storeScan, sum[1]);
+    printf("%-20s scan: %8.1f ms  (%.2f)\n", "chunks (SQL)", tableScan, sum[2]);
+
+    Check(std::abs(sum[1] - sum[0]) <= 1e-9 * std::abs(sum[0]), "Summarize adds up what the rows do");
+    Check(std::abs(sum[2] - sum[0]) <= 1e-9 * std::abs(sum[0]), "the table module adds up what the rows do");
+
+    // The compression is lossless: every sample of a series reads back exactly.
+    for (int32_t const series : { 0, SeriesCount - 1 })
+    {
+      std::vector<std::pair<int64_t, double>> expected;
+      std::vector<std::pair<int64_t, double>> stored;
+
+      for (SQLiteRow const& row : SQLiteStatement(rows, "Select Time, Value From Samples Where Series = ? Order By Time", SeriesName(series)))
+      {
+        expected.emplace_back(row.GetInt64(0), row.GetDouble(1));
+      }
+
+      store.Scan(SeriesName(series), std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), [&](std::span<int64_t const> const times, std::span<double const> const values)
+        {
+          for (size_t index = 0; index < times.size(); ++index)
+          {
+            stored.emplace_back(times[index], values[index]);
+          }
+        });
+
+      Check(expected.size() == SampleCount && stored == expected, "a series reads back the samples appended to it");
+    }
+
+    // A flush whose commit fails keeps its samples for the next one.
+    {
+      std::filesystem::remove(RetryDatabaseName);
+
+      SQLiteConnection writer{ RetryDatabaseName };
+      SQLiteConnection reader{ RetryDatabaseName };
+      TimeSeriesStore retried(writer);
+
+      for (int64_t time = 1; time <= 3; ++time)
+      {
+        retried.Append("retried", time, 0.5);
+      }
+
+      SQLiteStatement count(reader, "Select Count(*), Total(Count) From TimeSeries");
+      count.Step();
+      bool failed = false;
+
+      try
+      {
+        retried.Flush();
+      }
+      catch (SQLiteException const& ex)
+      {
+        failed = ex.ErrorCode == SQLITE_BUSY;
+      }
+
+      count.Reset();
+      Check(failed, "a flush cannot commit while a reader holds the database");
+
+      retried.Flush();
+      count.Step();
+      Check(count.GetInt64(0) == 1 && count.GetInt64(1) == 3, "the retried flush writes the samples once");
+      count.Reset();
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
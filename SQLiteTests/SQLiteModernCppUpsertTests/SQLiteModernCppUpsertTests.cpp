@@ -0,0 +1,161 @@
+#include <iostream>
+#include <chrono>
+
+#include <Schema.h>
+
+using namespace ModernCppSQLite;
+using namespace std::chrono;
+
+int32_t Failures = 0;
+
+void Check(bool const passed, char const* const what)
+{
+  printf("%s  %s\n", passed ? "ok    " : "FAILED", what);
+  Failures += passed ? 0 : 1;
+}
+
+template <typename F>
+double Milliseconds(F&& function)
+{
+  auto const start = steady_clock::now();
+  function();
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+struct Reading
+{
+  int64_t Sensor = 0;
+  int64_t Time = 0;
+  double Value = 0;
+  std::string Unit;
+  std::optional<int32_t> Quality;
+};
+
+using Readings = SQLiteTable<"Readings",
+  SQLiteKeyColumn<"Sensor", &Reading::Sensor>,
+  SQLiteKeyColumn<"Time", &Reading::Time>,
+  SQLiteColumn<"Value", &Reading::Value>,
+  SQLiteColumn<"Unit", &Reading::Unit>,
+  SQLiteColumn<"Quality", &Reading::Quality>>;
+
+template <>
+struct ModernCppSQLite::SQLiteTableOf<Reading>
+{
+  using Table = Readings;
+};
+
+std::vector<Reading> Generate(size_t const count, double const offset)
+{
+  std::vector<Reading> readings;
+
+  for (size_t index = 0; index < count; ++index)
+  {
+    readings.push_back({ static_cast<int64_t>(index % 16), static_cast<int64_t>(index / 16), static_cast<double>(index) + offset, index % 2 ? "C" : "F", index % 3 ? std::optional<int32_t>(static_cast<int32_t>(index % 100)) : std::nullopt });
+  }
+
+  return readings;
+}
+
+double Sum(SQLiteConnection const& connection)
+{
+  SQLiteStatement sum(connection, "Select Total(Value) + Count(*) + Total(Quality) From Readings");
+  sum.Step();
+  return sum.GetDouble();
+}
+
+// What a caller writes today without the mapper: one prepared statement, every member bound by
+// hand, in a transaction.
+void HandWritten(SQLiteConnection const& connection, std::vector<Reading> const& readings)
+{
+  SQLiteTransaction transaction(connection, SQLiteTransactionType::Immediate);
+  SQLiteStatement insert(connection, "Insert Or Replace Into Readings ( Sensor, Time, Value, Unit, Quality ) Values ( ?, ?, ?, ?, ? )");
+
+  for (Reading const& reading : readings)
+  {
+    insert.BindAll(reading.Sensor, reading.Time, reading.Value, reading.Unit, reading.Quality);
+    insert.Execute();
+    insert.Reset();
+  }
+
+  transaction.Commit();
+}
+
+int32_t main()
+{
+  try
+  {
+    auto connection = SQLiteConnection::Memory();
+    Execute(connection, Readings::Create.data());
+
+    std::vector<Reading> const first = Generate(1000, 0);
+    std::vector<Reading> const second = Generate(1500, 0.5);
+
+    Upsert<Reading>(connection, first);
+    Check(Sum(connection) == Sum([&] { auto expected = SQLiteConnection::Memory(); Execute(expected, Readings::Create.data()); HandWritten(expected, first); return expected; }()), "a multi-row upsert writes what a hand-written loop does");
+
+    Upsert<Reading>(connection, second, { .TransactionSize = 100, .MultiRow = false });
+
+    {
+      auto expected = SQLiteConnection::Memory();
+      Execute(expected, Readings::Create.data());
+      HandWritten(expected, first);
+      HandWritten(expected, second);
+      Check(Sum(connection) == Sum(expected), "a single-row upsert in small transactions replaces existing keys");
+    }
+
+    std::vector<Reading> duplicate{ first[0], first[1] };
+    duplicate[1].Unit.clear();
+
+    {
+      Execute(connection, "Create Trigger NoEmptyUnit Before Update On Readings When new.Unit = '' Begin Select Raise(Abort, 'empty unit'); End");
+      double const before = Sum(connection);
+      bool failed = false;
+
+      try
+      {
+        Upsert<Reading>(connection, duplicate);
+      }
+      catch (SQLiteException const&)
+      {
+        failed = true;
+      }
+
+      Check(failed && Sum(connection) == before, "a failed batch rolls back");
+      Execute(connection, "Drop Trigger NoEmptyUnit");
+    }
+
+    {
+      SQLiteTransaction transaction(connection);
+      TableAccessor<Readings> readings(connection);
+      readings.Upsert(first);
+      transaction.Rollback();
+      Check(Sum(connection) == Sum([&] { auto expected = SQLiteConnection::Memory(); Execute(expected, Readings::Create.data()); HandWritten(expected, first); HandWritten(expected, second); return expected; }()), "an upsert joins the caller's transaction");
+    }
+
+    // Timings against the hand-written loop, each into an empty table.
+    std::vector<Reading> const readings = Generate(200'000, 0);
+
+    auto const measure = [&](auto&& write)
+    {
+      auto database = SQLiteConnection::Memory();
+      Execute(database, Readings::Create.data());
+      return Milliseconds([&] { write(database); });
+    };
+
+    double const loop = measure([&](SQLiteConnection const& database) { HandWritten(database, readings); });
+    double const single = measure([&](SQLiteConnection const& database) { Upsert<Reading>(database, readings, { .TransactionSize = readings.size(), .MultiRow = false }); });
+    double const multi = measure([&](SQLiteConnection const& database) { Upsert<Reading>(database, readings, { .TransactionSize = readings.size() }); });
+    double const batched = measure([&](SQLiteConnection const& database) { Upsert<Reading>(database, readings); });
+
+    printf("\n%zu records: hand-written loop %.1f ms, single-row upsert %.1f ms, %d-row upsert %.1f ms, in transactions of 4096 %.1f ms\n",
+      readings.size(), loop, single, Readings::BatchRows, multi, batched);
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+
+  return Failures == 0 ? 0 : 1;
+}
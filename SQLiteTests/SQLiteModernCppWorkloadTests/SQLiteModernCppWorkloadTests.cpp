@@ -0,0 +1,154 @@
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <random>
+
+#include <Workload.h>
+
+using namespace ModernCppSQLite;
+
+constexpr char const* DatabaseName = "Workload.db";
+constexpr char const* CopyName = "Workload.copy.db";
+constexpr char const* LogName = "Workload.log";
+
+void Print(char const* const label, WorkloadReport const& report)
+{
+  printf("%s: %.1f ms\n", label, report.Milliseconds);
+  printf("  %8s %6s %10s %10s %10s %10s  %s\n", "count", "errors", "p50 us", "p90 us", "p99 us", "max us", "statement");
+
+  for (WorkloadLatency const& latency : report.Statements)
+  {
+    printf("  %8lld %6lld %10.1f %10.1f %10.1f %10.1f  %.50s\n", static_cast<long long>(latency.Count), static_cast<long long>(latency.Errors), latency.Median, latency.P90, latency.P99, latency.Max, latency.Sql.c_str());
+  }
+
+  printf("  %8lld %6lld %10.1f %10.1f %10.1f %10.1f  (all)\n", static_cast<long long>(report.All.Count), static_cast<long long>(report.All.Errors), report.All.Median, report.All.P90, report.All.P99, report.All.Max);
+}
+
+// Four clients, each with its own connection: orders are placed in small transactions and
+// looked up by customer, with a pause between requests.
+void Capture(WorkloadRecorder& recorder)
+{
+  std::vector<std::thread> clients;
+
+  for (int32_t client = 0; client < 4; ++client)
+  {
+    clients.emplace_back([&, client]
+      {
+        std::mt19937 random(client);
+        SQLiteConnection connection{ DatabaseName };
+        connection.SetBusyTimeout(std::chrono::seconds(5));
+        recorder.Attach(connection);
+
+        SQLiteStatement insert(connection, "Insert Into Orders ( Customer, Note, Amount ) Values ( ?, ?, ? )");
+        SQLiteStatement lookup(connection, "Select Count(*), Total(Amount) From Orders Where Customer = :customer");
+
+        for (int32_t request = 0; request < 500; ++request)
+        {
+          if (request % 4 == 0)
+          {
+            SQLiteTransaction transaction(connection, SQLiteTransactionType::Immediate);
+            insert.BindAll(static_cast<int32_t>(random() % 1000), "it's note " + std::to_string(request), (random() % 10'000) / 100.0);
+            insert.Execute();
+            insert.Reset();
+            transaction.Commit();
+          }
+          else
+          {
+            lookup.BindAll(static_cast<int32_t>(random() % 1000));
+            lookup.Step();
+            lookup.Reset();
+          }
+
+          std::this_thread::sleep_for(std::chrono::microseconds(random() % 2000));
+        }
+
+        recorder.Detach(connection);
+      });
+  }
+
+  for (std::thread& client : clients)
+  {
+    client.join();
+  }
+}
+
+// SQLiteModernCppWorkloadTests [log database [fast]] replays a log; without arguments a workload
+// is captured and replayed against a copy of the database it started from.
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  try
+  {
+    if (argc >= 3)
+    {
+      Print(argv[2], WorkloadReplayer::Replay(WorkloadLog::Read(argv[1]), argv[2], argc < 4));
+      return 0;
+    }
+
+    for (char const* const name : { DatabaseName, CopyName })
+    {
+      std::filesystem::remove(name);
+      std::filesystem::remove(std::string(name) + "-wal");
+      std::filesystem::remove(std::string(name) + "-shm");
+    }
+
+    {
+      SQLiteConnection connection{ DatabaseName };
+      connection.SetJournalMode("wal");
+      Execute(connection, "Create Table Orders ( Id Integer Primary Key, Customer Integer, Note Text, Amount Real )");
+      Execute(connection, "Create Index Orders_Customer On Orders ( Customer )");
+    }
+
+    std::filesystem::copy_file(DatabaseName, CopyName);
+
+    {
+      WorkloadRecorder recorder(LogName);
+      Capture(recorder);
+    }
+
+    WorkloadLog const log = WorkloadLog::Read(LogName);
+    printf("captured %zu executions of %zu statements in %lld bytes\n\n", log.Executions.size(), log.Statements.size(), static_cast<long long>(std::filesystem::file_size(LogName)));
+
+    Print("paced replay", WorkloadReplayer::Replay(log, CopyName, true));
+
+    {
+      SQLiteConnection original{ DatabaseName };
+      SQLiteConnection copy{ CopyName };
+      SQLiteStatement left(original, "Select Count(*), Sum(Cast(Round(Amount * 100) As Integer)), Max(Note) From Orders");
+      SQLiteStatement right(copy, "Select Count(*), Sum(Cast(Round(Amount * 100) As Integer)), Max(Note) From Orders");
+      left.Step();
+      right.Step();
+      printf("replayed database %s the original\n\n", left.GetInt64(0) == right.GetInt64(0) && left.GetInt64(1) == right.GetInt64(1) && std::string_view(left.GetString(2)) == right.GetString(2) ? "matches" : "differs from");
+    }
+
+    Print("fast replay", WorkloadReplayer::Replay(log, CopyName, false));
+
+    // An execution of statement 5 in a log that defines none.
+    {
+      std::ofstream corrupt(LogName, std::ios::binary | std::ios::trunc);
+      corrupt.write("SQLW\x01" "E\x05\x00\x00\x00\x00", 11);
+    }
+
+    try
+    {
+      WorkloadLog::Read(LogName);
+      printf("a log executing an unknown statement was read\n");
+      return 1;
+    }
+    catch (SQLiteException const& ex)
+    {
+      printf("a log executing an unknown statement is %s\n", ex.ErrorCode == SQLITE_CORRUPT ? "rejected" : "rejected with the wrong error");
+
+      if (ex.ErrorCode != SQLITE_CORRUPT)
+      {
+        return 1;
+      }
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+}
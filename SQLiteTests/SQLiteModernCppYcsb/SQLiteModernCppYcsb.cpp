@@ -0,0 +1,578 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <BulkLoader.h>
+
+using namespace ModernCppSQLite;
+
+// A YCSB style driver: loads a table of records with ten text fields, then runs a mix of reads,
+// updates, inserts, scans and read-modify-writes against it from several threads, and reports the
+// throughput and the latency percentiles of each operation.
+//
+//   SQLiteModernCppYcsb [--workload a|b|c|d|e|f] [--read P] [--update P] [--insert P] [--scan P]
+//     [--rmw P] [--distribution zipfian|uniform|latest] [--records N] [--operations N]
+//     [--threads N] [--field-length N] [--scan-length N] [--connections private|shared]
+//     [--batch N] [--cache-size KiB] [--mmap bytes] [--synchronous off|normal|full]
+//     [--database file] [--json file]
+//
+// The workloads are those of YCSB: a is half reads and half updates, b reads with 5% updates, c
+// only reads, d reads of the latest records with 5% inserts, e short scans with 5% inserts and f
+// half reads and half read-modify-writes. Proportions given after --workload replace its own.
+//
+// Private connections give each thread its own connection, as a pool would; a shared connection is
+// one SQLiteConnection that serializes the threads. Batch groups that many operations of a thread
+// in one transaction, which needs private connections.
+
+constexpr int32_t FieldCount = 10;
+
+enum class Operation
+{
+  Read,
+  Update,
+  Insert,
+  Scan,
+  ReadModifyWrite,
+};
+
+constexpr std::array<char const*, 5> OperationNames = { "read", "update", "insert", "scan", "rmw" };
+
+enum class Distribution
+{
+  Uniform,
+  Zipfian,
+  Latest,
+};
+
+struct YcsbOptions
+{
+  std::array<double, 5> Proportions = { 0.5, 0.5, 0, 0, 0 };
+  Distribution Keys = Distribution::Zipfian;
+  int64_t Records = 100'000;
+  int64_t Operations = 200'000;
+  int32_t Threads = 4;
+  int32_t FieldLength = 100;
+  int32_t ScanLength = 100;
+  bool SharedConnection = false;
+  int32_t Batch = 1;
+  int64_t CacheSize = 0;
+  int64_t MemoryMapSize = 0;
+  std::string Synchronous = "normal";
+  std::string Database = "Ycsb.db";
+  std::string Json;
+};
+
+uint64_t Fnv(uint64_t value)
+{
+  uint64_t hash = 0xCBF29CE484222325;
+
+  for (int32_t octet = 0; octet < 8; ++octet, value >>= 8)
+  {
+    hash = (hash ^ (value & 0xFF)) * 0x100000001B3;
+  }
+
+  return hash;
+}
+
+std::string Key(int64_t const number)
+{
+  return "user" + std::to_string(Fnv(static_cast<uint64_t>(number)));
+}
+
+// The generator of Gray et al., "Quickly Generating Billion-Record Synthetic Databases", as in
+// YCSB: item 0 is the most popular, with a constant of 0.99.
+class ZipfianGenerator
+{
+private:
+  static double Zeta(int64_t const items, double const theta)
+  {
+    double sum = 0;
+
+    for (int64_t item = 1; item <= items; ++item)
+    {
+      sum += 1 / std::pow(static_cast<double>(item), theta);
+    }
+
+    return sum;
+  }
+
+public:
+  explicit ZipfianGenerator(int64_t const items, double const theta = 0.99)
+    : m_Items(items)
+    , m_Theta(theta)
+    , m_Alpha(1 / (1 - theta))
+    , m_Zeta(Zeta(items, theta))
+    , m_Eta((1 - std::pow(2.0 / static_cast<double>(items), 1 - theta)) / (1 - Zeta(2, theta) / m_Zeta))
+  {
+  }
+
+  template <typename Random>
+  int64_t Next(Random& random) const
+  {
+    double const u = std::uniform_real_distribution<double>()(random);
+    double const uz = u * m_Zeta;
+
+    if (uz < 1) return 0;
+    if (uz < 1 + std::pow(0.5, m_Theta)) return 1;
+
+    return std::min(m_Items - 1, static_cast<int64_t>(static_cast<double>(m_Items) * std::pow(m_Eta * u - m_Eta + 1, m_Alpha)));
+  }
+
+private:
+  int64_t m_Items = 0;
+  double m_Theta = 0;
+  double m_Alpha = 0;
+  double m_Zeta = 0;
+  double m_Eta = 0;
+};
+
+template <typename Random>
+std::string Field(Random& random, int32_t const length)
+{
+  std::string value(static_cast<size_t>(length), ' ');
+
+  for (char& c : value)
+  {
+    c = static_cast<char>(' ' + random() % 95);
+  }
+
+  return value;
+}
+
+void Configure(SQLiteConnection const& connection, YcsbOptions const& options)
+{
+  connection.SetBusyTimeout(std::chrono::seconds(30));
+  Execute(connection, ("PRAGMA synchronous = " + options.Synchronous).c_str());
+
+  if (options.CacheSize > 0)
+  {
+    Execute(connection, ("PRAGMA cache_size = -" + std::to_string(options.CacheSize)).c_str());
+  }
+
+  if (options.MemoryMapSize > 0)
+  {
+    connection.SetMemoryMapSize(options.MemoryMapSize);
+  }
+}
+
+template <size_t ... Index>
+void Add(BulkLoader<>& loader, std::string const& key, std::array<std::string, FieldCount> const& fields, std::index_sequence<Index ...>)
+{
+  loader.Add(key, fields[Index] ...);
+}
+
+double Load(YcsbOptions const& options)
+{
+  for (char const* const suffix : { "", "-wal", "-shm" })
+  {
+    std::filesystem::remove(options.Database + suffix);
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  SQLiteConnection connection{ options.Database.c_str() };
+  connection.SetJournalMode("wal");
+  Configure(connection, options);
+
+  std::string create = "Create Table UserTable ( Key Text Primary Key";
+
+  for (int32_t field = 0; field < FieldCount; ++field)
+  {
+    create += ", Field" + std::to_string(field) + " Text";
+  }
+
+  Execute(connection, (create + " ) Without RowId").c_str());
+
+  std::mt19937_64 random(1);
+  BulkLoader loader(connection, "UserTable");
+  std::array<std::string, FieldCount> fields;
+
+  for (int64_t record = 0; record < options.Records; ++record)
+  {
+    for (std::string& field : fields)
+    {
+      field = Field(random, options.FieldLength);
+    }
+
+    Add(loader, Key(record), fields, std::make_index_sequence<FieldCount>());
+  }
+
+  loader.Finish();
+  SQLiteStatement checkpoint(connection, "PRAGMA wal_checkpoint(TRUNCATE)");
+
+  if (!checkpoint.Step() || checkpoint.GetInt64(0) != 0)
+  {
+    throw SQLiteException(SQLITE_BUSY, "the loaded log could not be checkpointed");
+  }
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Inserted keys are numbered from Records on; the others choose among the first Inserted, which
+// counts the inserts done so far, so a key still being inserted can be chosen and missed.
+struct Keyspace
+{
+  std::atomic<int64_t> Next;
+  std::atomic<int64_t> Inserted;
+};
+
+struct Latencies
+{
+  // Nanoseconds, per operation.
+  std::array<std::vector<int64_t>, 5> Operations;
+  int64_t Misses = 0;
+};
+
+void Client(YcsbOptions const& options, SQLiteConnection const* const shared, int32_t const thread, Keyspace& keyspace, Latencies& latencies)
+{
+  std::optional<SQLiteConnection> own;
+
+  if (!shared)
+  {
+    own.emplace(options.Database.c_str());
+    Configure(*own, options);
+  }
+
+  SQLiteConnection const& connection = shared ? *shared : *own;
+  std::mt19937_64 random(1000 + thread);
+
+  std::string fields = "Field0";
+  std::string values = "?";
+
+  for (int32_t field = 1; field < FieldCount; ++field)
+  {
+    fields += ", Field" + std::to_string(field);
+    values += ", ?";
+  }
+
+  SQLiteStatement read(connection, ("Select " + fields + " From UserTable Where Key = ?").c_str());
+  SQLiteStatement insert(connection, ("Insert Into UserTable ( Key, " + fields + " ) Values ( ?, " + values + " )").c_str());
+  SQLiteStatement scan(connection, ("Select Key, " + fields + " From UserTable Where Key >= ? Order By Key Limit ?").c_str());
+  std::array<SQLiteStatement, FieldCount> updates;
+
+  for (int32_t field = 0; field < FieldCount; ++field)
+  {
+    updates[field].Prepare(connection, ("Update UserTable Set Field" + std::to_string(field) + " = ? Where Key = ?").c_str());
+  }
+
+  ZipfianGenerator const zipfian(options.Records);
+  std::discrete_distribution<int32_t> choose(options.Proportions.begin(), options.Proportions.end());
+  int64_t const operations = options.Operations / options.Threads + (thread < options.Operations % options.Threads ? 1 : 0);
+  std::optional<SQLiteTransaction<SQLiteShared>> transaction;
+
+  auto const next = [&]
+  {
+    int64_t const count = keyspace.Inserted.load(std::memory_order_relaxed);
+
+    switch (options.Keys)
+    {
+      case Distribution::Uniform: return static_cast<int64_t>(random() % static_cast<uint64_t>(count));
+      case Distribution::Latest: return std::max<int64_t>(0, count - 1 - zipfian.Next(random));
+      default: return static_cast<int64_t>(Fnv(static_cast<uint64_t>(zipfian.Next(random))) % static_cast<uint64_t>(count));
+    }
+  };
+
+  auto const readRecord = [&](std::string const& key)
+  {
+    read.Bind(1, key);
+
+    if (!read.Step())
+    {
+      ++latencies.Misses;
+    }
+
+    int64_t length = 0;
+
+    for (int32_t field = 0; field < FieldCount; ++field)
+    {
+      length += read.GetStringLength(field);
+    }
+
+    read.Reset();
+    return length;
+  };
+
+  auto const update = [&](std::string const& key)
+  {
+    SQLiteStatement& statement = updates[random() % FieldCount];
+    statement.BindAll(Field(random, options.FieldLength), key);
+    statement.Execute();
+    statement.Reset();
+  };
+
+  for (auto& operation : latencies.Operations)
+  {
+    operation.reserve(static_cast<size_t>(operations));
+  }
+
+  for (int64_t index = 0; index < operations; ++index)
+  {
+    if (options.Batch > 1 && index % options.Batch == 0)
+    {
+      if (transaction)
+      {
+        transaction->Commit();
+      }
+
+      transaction.emplace(connection, SQLiteTransactionType::Immediate);
+    }
+
+    Operation const operation = static_cast<Operation>(choose(random));
+    auto const start = std::chrono::steady_clock::now();
+
+    switch (operation)
+    {
+      case Operation::Read: readRecord(Key(next())); break;
+      case Operation::Update: update(Key(next())); break;
+
+      case Operation::ReadModifyWrite:
+      {
+        std::string const key = Key(next());
+        readRecord(key);
+        update(key);
+        break;
+      }
+
+      case Operation::Insert:
+      {
+        insert.Bind(1, Key(keyspace.Next.fetch_add(1)));
+
+        for (int32_t field = 0; field < FieldCount; ++field)
+        {
+          insert.Bind(field + 2, Field(random, options.FieldLength));
+        }
+
+        insert.Execute();
+        insert.Reset();
+        ++keyspace.Inserted;
+        break;
+      }
+
+      case Operation::Scan:
+      {
+        scan.BindAll(Key(next()), static_cast<int32_t>(1 + random() % static_cast<uint64_t>(options.ScanLength)));
+        int64_t rows = 0;
+
+        while (scan.Step())
+        {
+          ++rows;
+        }
+
+        scan.Reset();
+        latencies.Misses += rows == 0 ? 1 : 0;
+        break;
+      }
+    }
+
+    latencies.Operations[static_cast<size_t>(operation)].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  if (transaction)
+  {
+    transaction->Commit();
+  }
+}
+
+struct Summary
+{
+  char const* Name = nullptr;
+  int64_t Count = 0;
+  double Throughput = 0;
+
+  // Microseconds.
+  double Median = 0;
+  double P99 = 0;
+  double P999 = 0;
+  double Max = 0;
+};
+
+Summary Summarize(char const* const name, std::vector<int64_t>& latencies, double const seconds)
+{
+  Summary summary{ name, static_cast<int64_t>(latencies.size()), static_cast<double>(latencies.size()) / seconds };
+
+  if (latencies.empty())
+  {
+    return summary;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  auto const at = [&](double const fraction) { return static_cast<double>(latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * static_cast<double>(latencies.size())))]) / 1000; };
+
+  summary.Median = at(0.5);
+  summary.P99 = at(0.99);
+  summary.P999 = at(0.999);
+  summary.Max = static_cast<double>(latencies.back()) / 1000;
+  return summary;
+}
+
+YcsbOptions Parse(int32_t const argc, char const* const* const argv)
+{
+  YcsbOptions options;
+
+  for (int32_t index = 1; index + 1 < argc; index += 2)
+  {
+    std::string_view const name = argv[index];
+    char const* const value = argv[index + 1];
+
+    if (name == "--workload")
+    {
+      switch (value[0])
+      {
+        case 'a': options.Proportions = { 0.5, 0.5, 0, 0, 0 }; options.Keys = Distribution::Zipfian; break;
+        case 'b': options.Proportions = { 0.95, 0.05, 0, 0, 0 }; options.Keys = Distribution::Zipfian; break;
+        case 'c': options.Proportions = { 1, 0, 0, 0, 0 }; options.Keys = Distribution::Zipfian; break;
+        case 'd': options.Proportions = { 0.95, 0, 0.05, 0, 0 }; options.Keys = Distribution::Latest; break;
+        case 'e': options.Proportions = { 0, 0, 0.05, 0.95, 0 }; options.Keys = Distribution::Zipfian; break;
+        case 'f': options.Proportions = { 0.5, 0, 0, 0, 0.5 }; options.Keys = Distribution::Zipfian; break;
+        default: throw SQLiteException(SQLITE_MISUSE, std::string("unknown workload ") + value);
+      }
+    }
+    else if (name == "--read") options.Proportions[0] = std::atof(value);
+    else if (name == "--update") options.Proportions[1] = std::atof(value);
+    else if (name == "--insert") options.Proportions[2] = std::atof(value);
+    else if (name == "--scan") options.Proportions[3] = std::atof(value);
+    else if (name == "--rmw") options.Proportions[4] = std::atof(value);
+    else if (name == "--distribution") options.Keys = value[0] == 'u' ? Distribution::Uniform : value[0] == 'l' ? Distribution::Latest : Distribution::Zipfian;
+    else if (name == "--records") options.Records = std::max<int64_t>(2, std::atoll(value));
+    else if (name == "--operations") options.Operations = std::max<int64_t>(1, std::atoll(value));
+    else if (name == "--threads") options.Threads = std::max(1, std::atoi(value));
+    else if (name == "--field-length") options.FieldLength = std::max(1, std::atoi(value));
+    else if (name == "--scan-length") options.ScanLength = std::max(1, std::atoi(value));
+    else if (name == "--connections") options.SharedConnection = std::strcmp(value, "shared") == 0;
+    else if (name == "--batch") options.Batch = std::max(1, std::atoi(value));
+    else if (name == "--cache-size") options.CacheSize = std::atoll(value);
+    else if (name == "--mmap") options.MemoryMapSize = std::atoll(value);
+    else if (name == "--synchronous") options.Synchronous = value;
+    else if (name == "--database") options.Database = value;
+    else if (name == "--json") options.Json = value;
+    else throw SQLiteException(SQLITE_MISUSE, "unknown option " + std::string(name));
+  }
+
+  if (options.SharedConnection && options.Batch > 1)
+  {
+    throw SQLiteException(SQLITE_MISUSE, "--batch needs private connections: the threads of a shared connection share its transaction");
+  }
+
+  return options;
+}
+
+int32_t main(int32_t const argc, char const* const* const argv)
+{
+  try
+  {
+    YcsbOptions const options = Parse(argc, argv);
+    double const load = Load(options);
+    printf("loaded %lld records in %.2f s\n", static_cast<long long>(options.Records), load);
+
+    std::optional<SQLiteConnection> shared;
+
+    if (options.SharedConnection)
+    {
+      shared.emplace(options.Database.c_str());
+      Configure(*shared, options);
+    }
+
+    Keyspace keyspace{ options.Records, options.Records };
+    std::vector<Latencies> latencies(static_cast<size_t>(options.Threads));
+    std::vector<std::thread> clients;
+    std::atomic<bool> failed{ false };
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int32_t thread = 0; thread < options.Threads; ++thread)
+    {
+      clients.emplace_back([&, thread]
+        {
+          try
+          {
+            Client(options, shared ? &*shared : nullptr, thread, keyspace, latencies[static_cast<size_t>(thread)]);
+          }
+          catch (SQLiteException const& ex)
+          {
+            std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+            std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+            failed = true;
+          }
+        });
+    }
+
+    for (std::thread& client : clients)
+    {
+      client.join();
+    }
+
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (failed)
+    {
+      return 1;
+    }
+
+    std::vector<int64_t> all;
+    std::vector<Summary> summaries;
+    int64_t misses = 0;
+
+    for (size_t operation = 0; operation < OperationNames.size(); ++operation)
+    {
+      std::vector<int64_t> merged;
+
+      for (Latencies const& thread : latencies)
+      {
+        merged.insert(merged.end(), thread.Operations[operation].begin(), thread.Operations[operation].end());
+      }
+
+      all.insert(all.end(), merged.begin(), merged.end());
+
+      if (!merged.empty())
+      {
+        summaries.push_back(Summarize(OperationNames[operation], merged, seconds));
+      }
+    }
+
+    for (Latencies const& thread : latencies)
+    {
+      misses += thread.Misses;
+    }
+
+    summaries.push_back(Summarize("all", all, seconds));
+
+    printf("%lld operations on %d threads (%s connections) in %.2f s, %lld misses\n\n", static_cast<long long>(options.Operations), options.Threads, options.SharedConnection ? "shared" : "private", seconds, static_cast<long long>(misses));
+    printf("%-8s %10s %12s %10s %10s %10s %10s\n", "", "count", "ops/s", "p50 us", "p99 us", "p999 us", "max us");
+
+    for (Summary const& summary : summaries)
+    {
+      printf("%-8s %10lld %12.0f %10.1f %10.1f %10.1f %10.1f\n", summary.Name, static_cast<long long>(summary.Count), summary.Throughput, summary.Median, summary.P99, summary.P999, summary.Max);
+    }
+
+    if (!options.Json.empty())
+    {
+      std::ofstream file(options.Json);
+      file << "{\n  \"records\": " << options.Records << ",\n  \"operations\": " << options.Operations << ",\n  \"threads\": " << options.Threads
+        << ",\n  \"connections\": \"" << (options.SharedConnection ? "shared" : "private") << "\",\n  \"seconds\": " << seconds << ",\n  \"benchmarks\": [\n";
+
+      for (size_t index = 0; Summary const& summary : summaries)
+      {
+        char line[256];
+        snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"count\": %lld, \"throughput\": %.1f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f, \"max_us\": %.3f }%s\n",
+          summary.Name, static_cast<long long>(summary.Count), summary.Throughput, summary.Median, summary.P99, summary.P999, summary.Max, ++index < summaries.size() ? "," : "");
+        file << line;
+      }
+
+      file << "  ]\n}\n";
+    }
+  }
+  catch (const SQLiteException& ex)
+  {
+    std::clog << "Error Code: " << ex.ErrorCode << std::endl;
+    std::clog << "Error Message: " << ex.ErrorMessage << std::endl;
+    return 1;
+  }
+}